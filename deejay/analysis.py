@@ -3,12 +3,24 @@ from __future__ import annotations
 
 import hashlib
 import json
+import os
+import shutil
+import struct
+import subprocess
+import sys
 import threading
+from array import array
 from concurrent.futures import Future, ThreadPoolExecutor
-from dataclasses import dataclass
+from dataclasses import dataclass, field
 from datetime import datetime
 from pathlib import Path
-from typing import Dict, Optional
+from typing import Dict, List, Optional, Union
+
+ANALYZER_ENV = "DEEJAY_ANALYZER_PATH"
+CACHE_MAGIC = b"DJAN"
+CACHE_VERSION = 1
+_HEADER = struct.Struct("<4sIdQIIddfI")
+_LEVEL = struct.Struct("<II")
 
 from .database import AnalysisDatabase
 
@@ -22,6 +34,79 @@ class AnalysisResult:
     updated_at: datetime
 
 
+@dataclass
+class PeakLevel:
+    frames_per_bin: int
+    minimum: array
+    maximum: array
+    rms: array
+
+
+@dataclass
+class AnalysisCache:
+    """Contents of a ``.dja`` file written by the native ``deejay_analyze`` tool.
+
+    Peak values are int16 full scale (32767 == 1.0); ``levels[0]`` is the finest.
+    A ``bpm`` of 0 means no tempo could be estimated.
+    """
+
+    sample_rate: float
+    channels: int
+    frame_count: int
+    bpm: float
+    first_beat_seconds: float
+    tempo_confidence: float
+    levels: List[PeakLevel] = field(default_factory=list)
+
+    def beat_grid(self, count: int = 32) -> List[float]:
+        if self.bpm <= 0:
+            return []
+        interval = 60.0 / self.bpm
+        return [round(self.first_beat_seconds + i * interval, 3) for i in range(count)]
+
+
+def read_analysis_cache(path: Union[str, Path]) -> AnalysisCache:
+    """Parse a binary analysis cache file (see src/TrackAnalyzer.h for the layout)."""
+    data = Path(path).read_bytes()
+    if len(data) < _HEADER.size:
+        raise ValueError(f"{path}: truncated analysis file")
+    magic, version, sample_rate, frame_count, channels, level_count, bpm, first_beat, confidence, _ = (
+        _HEADER.unpack_from(data, 0)
+    )
+    if magic != CACHE_MAGIC or version != CACHE_VERSION:
+        raise ValueError(f"{path}: not a version {CACHE_VERSION} analysis file")
+
+    offset = _HEADER.size
+    shapes = []
+    for _ in range(level_count):
+        if len(data) < offset + _LEVEL.size:
+            raise ValueError(f"{path}: truncated analysis file")
+        shapes.append(_LEVEL.unpack_from(data, offset))
+        offset += _LEVEL.size
+
+    levels = []
+    for frames_per_bin, bin_count in shapes:
+        end = offset + bin_count * 6
+        if len(data) < end:
+            raise ValueError(f"{path}: truncated analysis file")
+        values = array("h")
+        values.frombytes(data[offset:end])
+        if sys.byteorder == "big":
+            values.byteswap()
+        levels.append(PeakLevel(frames_per_bin, values[0::3], values[1::3], values[2::3]))
+        offset = end
+
+    return AnalysisCache(
+        sample_rate=sample_rate,
+        channels=channels,
+        frame_count=frame_count,
+        bpm=bpm,
+        first_beat_seconds=first_beat,
+        tempo_confidence=confidence,
+        levels=levels,
+    )
+
+
 class CacheLayout:
     def __init__(self, base_dir: Path):
         self.base_dir = Path(base_dir)
@@ -41,16 +126,32 @@ class CacheLayout:
     def beatgrid_path(self, track_id: str) -> Path:
         return self.ensure_track_dir(track_id) / "beatgrid.json"
 
+    def analysis_path(self, track_id: str) -> Path:
+        return self.ensure_track_dir(track_id) / "analysis.dja"
+
+    def band_waveform_path(self, track_id: str) -> Path:
+        return self.ensure_track_dir(track_id) / "waveform.djw"
+
 
 class BackgroundAnalyzer:
-    """Coordinates background analysis jobs and caches their outputs."""
+    """Coordinates background analysis jobs and caches their outputs.
+
+    WAV files are analyzed by the native ``deejay_analyze`` tool when it is
+    available (``analyzer_path``, the ``DEEJAY_ANALYZER_PATH`` environment
+    variable, or ``PATH``). The recorded waveform is then the band waveform
+    pyramid the deck displays map (``.djw``, see src/WaveformPyramid.h), and
+    peaks and beat grid share the ``.dja`` analysis file. Anything else falls
+    back to the JSON placeholders below.
+    """
 
     def __init__(
         self,
         cache_dir: Path = Path("cache"),
         db_path: Path = Path("data/analysis.sqlite"),
         max_workers: int = 4,
+        analyzer_path: Optional[Path] = None,
     ) -> None:
+        self.analyzer_path = self._find_analyzer(analyzer_path)
         self.cache_layout = CacheLayout(cache_dir)
         self.db = AnalysisDatabase(db_path)
         self.executor = ThreadPoolExecutor(max_workers=max_workers, thread_name_prefix="analysis")
@@ -95,7 +196,58 @@ class BackgroundAnalyzer:
             updated_at=updated_at,
         )
 
+    @staticmethod
+    def _find_analyzer(analyzer_path: Optional[Path]) -> Optional[Path]:
+        candidate = analyzer_path or os.environ.get(ANALYZER_ENV) or shutil.which("deejay_analyze")
+        if candidate and Path(candidate).is_file() and os.access(candidate, os.X_OK):
+            return Path(candidate)
+        return None
+
     def _run_analysis(self, track_id: str, audio_path: Path) -> AnalysisResult:
+        if self.analyzer_path and audio_path.suffix.lower() == ".wav":
+            result = self._run_native_analysis(track_id, audio_path)
+            if result:
+                return result
+        return self._run_placeholder_analysis(track_id, audio_path)
+
+    def _run_native_analysis(self, track_id: str, audio_path: Path) -> Optional[AnalysisResult]:
+        analysis_path = self.cache_layout.analysis_path(track_id)
+        waveform_path = self.cache_layout.band_waveform_path(track_id)
+        # The executor already runs one track per worker, so each tool run stays single-threaded.
+        completed = subprocess.run(
+            [
+                str(self.analyzer_path),
+                "--threads",
+                "1",
+                "--output",
+                str(analysis_path),
+                "--waveform",
+                str(waveform_path),
+                str(audio_path),
+            ],
+            capture_output=True,
+            text=True,
+        )
+        if completed.returncode != 0 or not (analysis_path.exists() and waveform_path.exists()):
+            return None
+
+        updated_at = datetime.utcnow()
+        self.db.upsert_analysis(
+            track_id,
+            waveform_path=waveform_path,
+            peaks_path=analysis_path,
+            beatgrid_path=analysis_path,
+            updated_at=updated_at.isoformat(),
+        )
+        return AnalysisResult(
+            track_id=track_id,
+            waveform_path=waveform_path,
+            peaks_path=analysis_path,
+            beatgrid_path=analysis_path,
+            updated_at=updated_at,
+        )
+
+    def _run_placeholder_analysis(self, track_id: str, audio_path: Path) -> AnalysisResult:
         cache_dir = self.cache_layout.ensure_track_dir(track_id)
         raw_bytes = audio_path.read_bytes()
 
@@ -1,7 +1,12 @@
 """Master clock and phase tracking utilities."""
 from __future__ import annotations
 
-from dataclasses import dataclass
+import json
+from dataclasses import dataclass, field
+from typing import Callable, Dict, List
+
+LatencyListener = Callable[[int, int, int], None]
+"""Called with ``(deck, previous_samples, current_samples)`` when a deck's latency changes."""
 
 
 @dataclass
@@ -11,6 +16,8 @@ class MasterClock:
     sample_rate: int = 48_000
     buffer_size: int = 512
     frame_counter: int = 0
+    deck_latency: Dict[int, int] = field(default_factory=dict)
+    _latency_listeners: List[LatencyListener] = field(default_factory=list, repr=False)
 
     def tick(self, buffers: int = 1) -> int:
         """Advance the master clock by one or more buffers."""
@@ -44,3 +51,42 @@ class MasterClock:
 
     def frames_to_seconds(self, frames: int) -> float:
         return frames / self.sample_rate
+
+    def on_latency_changed(self, listener: LatencyListener) -> Callable[[], None]:
+        """Subscribe to deck latency changes; returns a function that unsubscribes."""
+
+        self._latency_listeners.append(listener)
+        return lambda: self._latency_listeners.remove(listener)
+
+    def notify_latency_change(self, deck: int, previous: int, current: int) -> None:
+        """Record a deck's new processing latency and tell the subscribers."""
+
+        self.deck_latency[deck] = current
+        for listener in list(self._latency_listeners):
+            listener(deck, previous, current)
+
+    def handle_engine_line(self, line: str) -> bool:
+        """Apply a ``latencyChanged`` JSON line printed by ``deejay_audio``; returns False for any other line."""
+
+        try:
+            message = json.loads(line)
+        except ValueError:
+            return False
+        if not isinstance(message, dict) or message.get("type") != "latencyChanged":
+            return False
+        self.notify_latency_change(
+            int(message["deck"]), int(message["previousSamples"]), int(message["currentSamples"])
+        )
+        return True
+
+    def schedule_frame(self, frame: int, deck: int) -> int:
+        """Frame to schedule a deck event at so that it is heard at ``frame`` despite the deck's latency."""
+
+        return max(0, frame - self.deck_latency.get(deck, 0))
+
+    def latency_offset(self, deck: int) -> int:
+        """Frames a deck runs ahead of the slowest deck, i.e. the delay that lines it up with the others."""
+
+        if not self.deck_latency:
+            return 0
+        return max(self.deck_latency.values()) - self.deck_latency.get(deck, 0)
@@ -37,14 +37,29 @@ class Deck:
     pitch_semitones: float = 0.0
     scheduled_start_frame: Optional[int] = None
     _last_dsp_result: Optional[dsp.DSPResult] = field(default=None, init=False, repr=False)
+    _processor: Optional[dsp.DeckProcessor] = field(default=None, init=False, repr=False)
 
     def load(self, audio_file: Path) -> None:
-        """Load an audio file and cache metadata."""
+        """Load an audio file and cache metadata.
+
+        With the native extension built, the file is also decoded so that
+        process() renders real audio; see dsp.DeckProcessor.
+        """
 
         with wave.open(str(audio_file), "rb") as handle:
             self.total_frames = handle.getnframes()
             self.file_sample_rate = handle.getframerate()
         self.audio_path = Path(audio_file)
+        self._processor = None
+        if dsp.native is not None:
+            try:
+                sample_rate, channels, data = dsp.native.read_wav(str(audio_file))
+            except ValueError:
+                pass  # an encoding the native reader does not handle; metadata only
+            else:
+                self._processor = dsp.DeckProcessor(
+                    memoryview(data).cast("f"), channels, sample_rate, self.clock.buffer_size
+                )
         self.position_frames = 0
         self.playing = False
         self.scheduled_start_frame = None
@@ -58,6 +73,8 @@ class Deck:
     def seek(self, seconds: float) -> None:
         frames = min(self.clock.seconds_to_frames(seconds), self.total_frames)
         self.position_frames = frames
+        if self._processor is not None:
+            self._processor.reset()
 
     def play(self) -> int:
         """Schedule playback to start on the next buffer boundary."""
@@ -73,9 +90,15 @@ class Deck:
         self.playing = False
         self.position_frames = 0
         self.scheduled_start_frame = None
+        if self._processor is not None:
+            self._processor.reset()
 
     def process(self) -> Optional[dsp.DSPResult]:
-        """Simulate buffer processing and advance transport state."""
+        """Process one buffer and advance transport state.
+
+        The result carries the rendered audio in ``samples`` when the native
+        extension is available, and only metadata otherwise.
+        """
 
         if not self.playing:
             return None
@@ -88,7 +111,12 @@ class Deck:
         if self.scheduled_start_frame is not None:
             self.scheduled_start_frame = None
 
-        processed = dsp.process_buffer(self.clock.buffer_size, self.tempo_ratio, self.pitch_semitones)
+        if self._processor is not None:
+            processed = self._processor.process(
+                self.position_frames, self.clock.buffer_size, self.tempo_ratio, self.pitch_semitones
+            )
+        else:
+            processed = dsp.process_buffer(self.clock.buffer_size, self.tempo_ratio, self.pitch_semitones)
         self.position_frames += processed.stretched_frames
         self.position_frames = min(self.position_frames, self.total_frames)
         self._last_dsp_result = processed
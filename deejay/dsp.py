@@ -1,13 +1,58 @@
-"""Lightweight DSP stubs used by the deck transport layer.
-
-These helpers do not perform real audio processing. They simply return
-metadata that higher-level components can use to confirm that a tempo or
-pitch operation would be applied to a buffer.
+"""Tempo and pitch helpers used by the deck transport layer.
+
+The module-level functions only return metadata that higher-level components
+can use to confirm that a tempo or pitch operation would be applied to a
+buffer. When the ``deejay._native`` extension has been built (the
+``deejay_python`` CMake target), :class:`DeckProcessor` renders real audio
+through the C++ ``LatencyCompensatedProcessor``; buffers are shared with the
+engine without copies and the GIL is released while it processes.
 """
 from __future__ import annotations
 
+import importlib.machinery
+import importlib.util
+import os
+from array import array
 from dataclasses import dataclass
-from typing import List
+from pathlib import Path
+from typing import List, Optional
+
+NATIVE_ENV = "DEEJAY_NATIVE_PATH"
+_ROOT = Path(__file__).resolve().parents[1]
+
+
+def _load_native():
+    """Import the native extension: installed in the package, named by DEEJAY_NATIVE_PATH, or in build/."""
+
+    try:
+        from . import _native  # type: ignore[attr-defined]
+
+        return _native
+    except ImportError:
+        pass
+    candidates = [os.environ.get(NATIVE_ENV)]
+    candidates += [str(path) for path in sorted((_ROOT / "build").glob("_native*"))]
+    for candidate in candidates:
+        if not candidate or not os.path.isfile(candidate):
+            continue
+        loader = importlib.machinery.ExtensionFileLoader(f"{__package__}._native", candidate)
+        spec = importlib.util.spec_from_file_location(f"{__package__}._native", candidate, loader=loader)
+        if spec is None:
+            continue
+        module = importlib.util.module_from_spec(spec)
+        try:
+            loader.exec_module(module)
+        except ImportError:
+            continue
+        return module
+    return None
+
+
+native = _load_native()
+
+
+def native_available() -> bool:
+    return native is not None
 
 
 @dataclass
@@ -27,6 +72,8 @@ class DSPResult:
     pitch_semitones: float
     stretched_frames: int
     operations: List[DSPOperation]
+    # Rendered interleaved float32 audio, when a DeckProcessor produced the result.
+    samples: Optional[array] = None
 
     def describe(self) -> str:
         steps = ", ".join(f"{op.name}={op.value}" for op in self.operations)
@@ -79,3 +126,68 @@ def process_buffer(frames: int, tempo_ratio: float, pitch_semitones: float) -> D
         stretched_frames=stretched.stretched_frames,
         operations=operations,
     )
+
+
+class DeckProcessor:
+    """Real tempo and pitch processing of a decoded track, one buffer at a time.
+
+    ``track`` is interleaved float32 audio (anything exporting a float32
+    buffer: ``array('f')``, a numpy array, ``memoryview.cast('f')``). Each
+    call renders exactly ``frames`` frames through the native
+    ``LatencyCompensatedProcessor`` in pull mode, reading the track in place.
+    The processor's latency is rendered and discarded before the first
+    buffer after construction or reset(), as the offline renderer does, so
+    the output starts at the requested position. Requires the native
+    extension; see :func:`native_available`.
+
+    ``tempo_ratio`` here is the deck's playback speed, as everywhere in the
+    Python layer (1.1 plays 10% faster); the native processor takes a time
+    ratio, so it is handed the reciprocal.
+    """
+
+    def __init__(self, track, channels: int, sample_rate: float, block_frames: int) -> None:
+        if native is None:
+            raise RuntimeError("the deejay._native extension has not been built")
+        self.track = track
+        self.channels = channels
+        self.track_frames = len(memoryview(track).cast("B")) // (4 * channels)
+        self._processor = native.LatencyCompensatedProcessor(sample_rate, channels, max_block_frames=block_frames)
+        self._tempo_ratio = 1.0
+        self._pitch_semitones = 0.0
+        self._primed = False
+
+    @property
+    def latency_samples(self) -> int:
+        return self._processor.total_latency_samples
+
+    def reset(self) -> None:
+        """Drop buffered audio, as on a seek."""
+
+        self._processor.reset()
+        self._primed = False
+
+    def process(self, position: int, frames: int, tempo_ratio: float, pitch_semitones: float) -> DSPResult:
+        """Render ``frames`` frames starting at track frame ``position``.
+
+        ``stretched_frames`` of the result is the number of track frames the
+        stretcher consumed, so adding it to ``position`` gives the next one.
+        Control changes glide over the following buffers instead of jumping.
+        """
+
+        if tempo_ratio <= 0.0:
+            raise ValueError("tempo_ratio must be positive")
+        if tempo_ratio != self._tempo_ratio or pitch_semitones != self._pitch_semitones:
+            self._processor.update_controls(tempo_ratio=1.0 / tempo_ratio, pitch_semitones=pitch_semitones)
+            self._tempo_ratio = tempo_ratio
+            self._pitch_semitones = pitch_semitones
+        next_position = position
+        if not self._primed:
+            latency = array("f", bytes(4 * self._processor.total_latency_samples * self.channels))
+            _, next_position = self._processor.pull(self.track, next_position, latency)
+            self._primed = True
+        output = array("f", bytes(4 * frames * self.channels))
+        _, next_position = self._processor.pull(self.track, next_position, output)
+        result = process_buffer(frames, tempo_ratio, pitch_semitones)
+        result.stretched_frames = next_position - position
+        result.samples = output
+        return result
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Run the tempo/pitch matrix of docs/validation_plan.md on the offline null device and diff it across builds.
+
+Every cell renders through ``deejay_audio --offline`` and is summarized by the engine's offlineRender line:
+output hash, level, reported latency, real-time factor and callback timing. Renders are deterministic, so a
+hash that differs from the baseline means the audio changed; timing is compared with a tolerance.
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+# Material, tempo ratios and pitch steps, as in the validation plan's test matrix.
+MATRIX = {
+    "drums": ([0.5, 1.0, 1.5, 2.0], [-12, 0, 7]),
+    "vocal": ([0.75, 1.0, 1.25], [-3, 0, 3, 12]),
+    "keys": ([0.5, 1.0, 1.8], [-5, 0, 5]),
+}
+
+# Fast automation run per material: tempo and pitch jump every 50 ms across the plan's full ranges.
+AUTOMATION_STEP_SECONDS = 0.05
+AUTOMATION_TEMPI = [0.5, 2.5, 1.0, 1.8]
+AUTOMATION_PITCHES = [-12, 12, 0, 5]
+
+
+def render(engine: Path, output: Path, material: Path | None, tempo: float, pitch: float, args: argparse.Namespace,
+           events: list[str] | None = None) -> dict:
+    command = [
+        str(engine), "--offline", str(output),
+        "--duration-seconds", str(args.seconds),
+        "--frames", str(args.frames),
+        "--tempo", str(tempo),
+        "--pitch", str(pitch),
+    ]
+    if material is not None:
+        command += ["--input", str(material), "--loop"]
+    for event in events or []:
+        command += ["--event", event]
+    completed = subprocess.run(command, check=True, capture_output=True, text=True)
+    for line in completed.stdout.splitlines():
+        if line.startswith('{"type":"offlineRender"'):
+            return json.loads(line)
+    raise RuntimeError(f"no offlineRender line from: {' '.join(command)}")
+
+
+def automation_events(seconds: float) -> list[str]:
+    events = []
+    step = 0
+    while (step + 1) * AUTOMATION_STEP_SECONDS < seconds:
+        at = (step + 1) * AUTOMATION_STEP_SECONDS
+        events.append(f"{at:.3f}:tempo:0:{AUTOMATION_TEMPI[step % len(AUTOMATION_TEMPI)]}")
+        events.append(f"{at:.3f}:pitch:0:{AUTOMATION_PITCHES[step % len(AUTOMATION_PITCHES)]}")
+        step += 1
+    return events
+
+
+def run_sweep(args: argparse.Namespace) -> list[dict]:
+    materials = dict(item.split("=", 1) for item in args.material)
+    cells = []
+    with tempfile.TemporaryDirectory() as scratch:
+        output = Path(scratch) / "cell.wav"
+        for name, (tempi, pitches) in MATRIX.items():
+            material = Path(materials[name]) if name in materials else None
+            for tempo in tempi:
+                for pitch in pitches:
+                    result = render(args.engine, output, material, tempo, pitch, args)
+                    cells.append({"material": name, "tempo": tempo, "pitch": pitch, **result})
+            result = render(args.engine, output, material, 1.0, 0, args, automation_events(args.seconds))
+            cells.append({"material": name, "tempo": "automated", "pitch": "automated", **result})
+    return cells
+
+
+def cell_key(cell: dict) -> tuple:
+    return (cell["material"], str(cell["tempo"]), str(cell["pitch"]))
+
+
+def compare(cells: list[dict], baseline: list[dict], tolerance: float) -> list[str]:
+    """Describe every cell that sounds different from, or renders slower than, its baseline cell."""
+    previous = {cell_key(cell): cell for cell in baseline}
+    findings = []
+    for cell in cells:
+        label = "/".join(cell_key(cell))
+        before = previous.get(cell_key(cell))
+        if before is None:
+            findings.append(f"{label}: new cell")
+            continue
+        if cell["hash"] != before["hash"]:
+            findings.append(f"{label}: output changed (rms {before['rms']:.6f} -> {cell['rms']:.6f})")
+        if cell["latencySamples"] != before["latencySamples"]:
+            findings.append(f"{label}: latency {before['latencySamples']} -> {cell['latencySamples']} samples")
+        if cell["realtimeFactor"] < before["realtimeFactor"] * (1.0 - tolerance):
+            findings.append(f"{label}: real-time factor {before['realtimeFactor']:.1f} -> {cell['realtimeFactor']:.1f}")
+    return findings
+
+
+def parse_args(argv: list[str] | None = None) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--engine", type=Path, default=Path("build/deejay_audio"), help="deejay_audio executable")
+    parser.add_argument(
+        "--material",
+        action="append",
+        default=[],
+        metavar="NAME=WAV",
+        help="WAV file for a matrix row (drums, vocal, keys); rows without one use the engine's test tone",
+    )
+    parser.add_argument("--seconds", type=float, default=2.0, help="Render length per cell (default: 2)")
+    parser.add_argument("--frames", type=int, default=128, help="Frames per callback (default: 128)")
+    parser.add_argument("--output", type=Path, help="Write the sweep report (JSON) here")
+    parser.add_argument("--baseline", type=Path, help="Report of an earlier build to compare against")
+    parser.add_argument(
+        "--tolerance",
+        type=float,
+        default=0.2,
+        help="Allowed real-time factor drop relative to the baseline (default: 0.2)",
+    )
+    return parser.parse_args(argv)
+
+
+def main(argv: list[str] | None = None) -> int:
+    args = parse_args(argv)
+    cells = run_sweep(args)
+    for cell in cells:
+        print(
+            f"{cell['material']:6} tempo {cell['tempo']!s:9} pitch {cell['pitch']!s:9} "
+            f"rtf {cell['realtimeFactor']:8.1f}  p99 {cell['blockP99Us']:8.1f} us  over budget {cell['overBudget']:4}  "
+            f"latency {cell['latencySamples']:5}  {cell['hash']}"
+        )
+    if args.output:
+        args.output.write_text(json.dumps({"frames": args.frames, "seconds": args.seconds, "cells": cells}, indent=2))
+    if args.baseline:
+        findings = compare(cells, json.loads(args.baseline.read_text())["cells"], args.tolerance)
+        for finding in findings:
+            print(finding)
+        return 1 if findings else 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,77 @@
+#include "AdaptiveResampler.h"
+
+#include "Interleave.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace deejay {
+
+AdaptiveResampler::AdaptiveResampler(Settings settings)
+    : settings_(settings), filter_(settings.taps, settings.phases, settings.cutoff) {
+    settings_.taps = filter_.taps();
+    const size_t taps = settings_.taps;
+    coefficients_.assign(taps, 0.0f);
+
+    // Room for one block of input beyond what a block of output at the largest drift ratio reads.
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    historyCapacity_ = 2 * settings_.maxBlockFrames + 2 * taps;
+    history_.assign(historyCapacity_ * channels, 0.0f);
+    historyChannels_.resize(channels);
+}
+
+size_t AdaptiveResampler::inputFramesRequired(size_t outputFrames, double ratio) const noexcept {
+    if (outputFrames == 0) {
+        return 0;
+    }
+    const auto last = static_cast<size_t>(std::floor(position_ + static_cast<double>(outputFrames - 1) * ratio));
+    const size_t needed = last + settings_.taps;
+    return needed > historyFrames_ ? needed - historyFrames_ : 0;
+}
+
+size_t AdaptiveResampler::process(const float *input, size_t inputFrames, float *output, size_t outputFrames,
+                                  double ratio) noexcept {
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    const size_t taps = settings_.taps;
+    const size_t accepted = std::min(inputFrames, historyCapacity_ - historyFrames_);
+    for (size_t ch = 0; ch < channels; ++ch) {
+        historyChannels_[ch] = history_.data() + ch * historyCapacity_ + historyFrames_;
+    }
+    deinterleave(input, historyChannels_.data(), settings_.channelCount, accepted);
+    historyFrames_ += accepted;
+
+    size_t produced = 0;
+    for (; produced < outputFrames; ++produced) {
+        const double base = std::floor(position_);
+        const auto first = static_cast<size_t>(base);
+        if (first + taps > historyFrames_) {
+            break;
+        }
+        filter_.coefficients(position_ - base, coefficients_.data());
+        for (size_t ch = 0; ch < channels; ++ch) {
+            output[produced * channels + ch] =
+                PolyphaseSinc::dot(coefficients_.data(), history_.data() + ch * historyCapacity_ + first, taps);
+        }
+        position_ += ratio;
+    }
+
+    // Drop the input every later output frame is past.
+    const size_t consumed = std::min(static_cast<size_t>(std::floor(position_)), historyFrames_);
+    if (consumed > 0) {
+        for (size_t ch = 0; ch < channels; ++ch) {
+            float *start = history_.data() + ch * historyCapacity_;
+            std::memmove(start, start + consumed, (historyFrames_ - consumed) * sizeof(float));
+        }
+        historyFrames_ -= consumed;
+        position_ -= static_cast<double>(consumed);
+    }
+    return produced;
+}
+
+void AdaptiveResampler::reset() noexcept {
+    historyFrames_ = 0;
+    position_ = 0.0;
+}
+
+} // namespace deejay
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "PolyphaseSinc.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace deejay {
+
+// Asynchronous sample-rate converter for ratios close to 1, meant to absorb the clock drift between two sound
+// cards. A PolyphaseSinc filter is evaluated at a fractional read position that advances by `ratio` input frames
+// per output frame; the ratio may change on every call without clicks. Each output frame costs one coefficient
+// blend plus one SIMD dot product per channel. Realtime-safe after construction.
+class AdaptiveResampler {
+public:
+    struct Settings {
+        int channelCount{2};
+        // Largest process() call, in input and in output frames.
+        size_t maxBlockFrames{512};
+        // Filter length in input frames, rounded up to a multiple of 8. The resampler delays by taps / 2.
+        size_t taps{32};
+        size_t phases{256};
+        // Passband edge relative to Nyquist.
+        double cutoff{0.92};
+    };
+
+    explicit AdaptiveResampler(Settings settings);
+
+    int channelCount() const noexcept { return settings_.channelCount; }
+    size_t taps() const noexcept { return filter_.taps(); }
+    size_t latencyFrames() const noexcept { return filter_.taps() / 2; }
+
+    // Input frames process() needs on top of what it holds to produce `outputFrames` frames at `ratio`.
+    size_t inputFramesRequired(size_t outputFrames, double ratio) const noexcept;
+
+    // Appends `inputFrames` interleaved frames and renders up to `outputFrames` interleaved frames at `ratio`
+    // input frames per output frame. Returns the frames rendered; fewer than requested only when the input ran
+    // short. Both counts are at most maxBlockFrames.
+    size_t process(const float *input, size_t inputFrames, float *output, size_t outputFrames, double ratio) noexcept;
+
+    // Clears the history, as after an underrun.
+    void reset() noexcept;
+
+private:
+    Settings settings_;
+    PolyphaseSinc filter_;
+    std::vector<float> coefficients_; // blended row for the current output frame
+    std::vector<float> history_;      // planar, historyCapacity_ frames per channel
+    std::vector<float *> historyChannels_;
+    size_t historyCapacity_{0};
+    size_t historyFrames_{0};
+    double position_{0.0}; // read position inside the history, in input frames
+};
+
+} // namespace deejay
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace deejay {
+
+// Interleaved float32 frame provider that processors pull from on the audio thread.
+class AudioSource {
+public:
+    virtual ~AudioSource() = default;
+
+    virtual int channelCount() const noexcept = 0;
+
+    // Realtime-safe: copies up to `frames` interleaved frames and returns how many were available.
+    virtual size_t read(float *interleaved, size_t frames) noexcept = 0;
+
+    // Realtime-safe zero-copy variant for sources backed by stable memory: returns a pointer to `frames` or
+    // fewer contiguous interleaved frames, updates `frames` to that count and advances past them. The pointer
+    // stays valid until the next call. Sources that cannot lend their storage return nullptr; callers then
+    // fall back to read().
+    virtual const float *acquire(size_t &frames) noexcept {
+        frames = 0;
+        return nullptr;
+    }
+
+    // Realtime-safe jump to `frame` for the next read, used by scheduled cue jumps. The target must already be
+    // resident (e.g. a prefetched cue point). Sources that cannot seek on the audio thread return false.
+    virtual bool jumpTo(uint64_t frame) noexcept {
+        (void)frame;
+        return false;
+    }
+
+    // Tempo ratio and pitch shift the audio already carries, for sources pre-rendered through the offline
+    // stretcher (see StemCache). Deck controls stay absolute; the processor only applies the difference, so at
+    // the rendered values it runs at unity. Ordinary sources are 1 and 0.
+    virtual double renderedTempoRatio() const noexcept { return 1.0; }
+    virtual double renderedPitchSemitones() const noexcept { return 0.0; }
+
+    // Realtime-safe random access for sources that hold the whole decoded track in memory, which is what the jog
+    // wheel's VarispeedReader plays from: returns the interleaved track (channelCount() wide), its length in
+    // `frameCount`, and in `position` the next frame read() would return. Other sources return nullptr, and
+    // their decks cannot scratch.
+    virtual const float *trackFrames(uint64_t &frameCount, uint64_t &position) noexcept {
+        frameCount = 0;
+        position = 0;
+        return nullptr;
+    }
+};
+
+} // namespace deejay
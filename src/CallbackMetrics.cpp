@@ -0,0 +1,93 @@
+#include "CallbackMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace deejay {
+
+namespace {
+size_t bucketFor(double micros) noexcept {
+    if (!(micros >= CallbackMetrics::kFirstBucketMicros)) {
+        return 0;
+    }
+    const auto bucket = static_cast<size_t>(std::log2(micros / CallbackMetrics::kFirstBucketMicros)) + 1;
+    return std::min(bucket, CallbackMetrics::kHistogramBuckets - 1);
+}
+}
+
+void CallbackMetrics::recordCallback(uint64_t frames, double durationSeconds, double periodSeconds, bool underflow,
+                                     bool overflow, double outputLatencySeconds) noexcept {
+    const double micros = durationSeconds * 1e6;
+    const double utilization = periodSeconds > 0.0 ? durationSeconds / periodSeconds : 0.0;
+
+    callbacks_.fetch_add(1, std::memory_order_relaxed);
+    framesRendered_.fetch_add(frames, std::memory_order_relaxed);
+    histogram_[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+    if (underflow) {
+        underflows_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (overflow) {
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (utilization > 1.0) {
+        overBudget_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    lastDurationMicros_.store(micros, std::memory_order_relaxed);
+    budgetUtilization_.store(utilization, std::memory_order_relaxed);
+    // The sampler resets the peak concurrently, so raise it with a CAS instead of a plain store.
+    double peak = peakBudgetUtilization_.load(std::memory_order_relaxed);
+    while (utilization > peak &&
+           !peakBudgetUtilization_.compare_exchange_weak(peak, utilization, std::memory_order_relaxed)) {
+    }
+
+    if (outputLatencySeconds >= 0.0) {
+        outputLatency_.store(outputLatencySeconds, std::memory_order_relaxed);
+        if (baselineOutputLatency_.load(std::memory_order_relaxed) < 0.0) {
+            baselineOutputLatency_.store(outputLatencySeconds, std::memory_order_relaxed);
+        }
+    }
+}
+
+CallbackMetrics::Snapshot CallbackMetrics::sample() noexcept {
+    Snapshot snapshot;
+    snapshot.callbacks = callbacks_.load(std::memory_order_relaxed);
+    snapshot.framesRendered = framesRendered_.load(std::memory_order_relaxed);
+    snapshot.underflows = underflows_.load(std::memory_order_relaxed);
+    snapshot.overflows = overflows_.load(std::memory_order_relaxed);
+    snapshot.overBudget = overBudget_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kHistogramBuckets; ++i) {
+        snapshot.durationHistogram[i] = histogram_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.lastDurationMicros = lastDurationMicros_.load(std::memory_order_relaxed);
+    snapshot.budgetUtilization = budgetUtilization_.load(std::memory_order_relaxed);
+    snapshot.peakBudgetUtilization = peakBudgetUtilization_.exchange(0.0, std::memory_order_relaxed);
+    snapshot.outputLatencySeconds = outputLatency_.load(std::memory_order_relaxed);
+    const double baseline = baselineOutputLatency_.load(std::memory_order_relaxed);
+    snapshot.outputLatencyDriftSeconds = baseline < 0.0 ? 0.0 : snapshot.outputLatencySeconds - baseline;
+    return snapshot;
+}
+
+std::string CallbackMetrics::toJson(const Snapshot &snapshot) {
+    std::ostringstream json;
+    json << "{\"type\":\"callbackMetrics\""
+         << ",\"callbacks\":" << snapshot.callbacks
+         << ",\"framesRendered\":" << snapshot.framesRendered
+         << ",\"underflows\":" << snapshot.underflows
+         << ",\"overflows\":" << snapshot.overflows
+         << ",\"overBudget\":" << snapshot.overBudget
+         << ",\"histogramFirstBucketMicros\":" << kFirstBucketMicros
+         << ",\"durationHistogram\":[";
+    for (size_t i = 0; i < kHistogramBuckets; ++i) {
+        json << (i == 0 ? "" : ",") << snapshot.durationHistogram[i];
+    }
+    json << "],\"lastDurationMicros\":" << snapshot.lastDurationMicros
+         << ",\"budgetUtilization\":" << snapshot.budgetUtilization
+         << ",\"peakBudgetUtilization\":" << snapshot.peakBudgetUtilization
+         << ",\"outputLatencySeconds\":" << snapshot.outputLatencySeconds
+         << ",\"outputLatencyDriftSeconds\":" << snapshot.outputLatencyDriftSeconds << "}";
+    return json.str();
+}
+
+} // namespace deejay
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace deejay {
+
+// Instrumentation block written by the audio callback and read by a monitoring thread. The callback side only
+// does relaxed atomic loads, stores and adds, so it is realtime-safe; the reader takes snapshots whenever it
+// likes and never blocks the writer. Counters in a snapshot are cumulative; consumers diff them.
+class CallbackMetrics {
+public:
+    // Callback durations are bucketed on a log2 scale: bucket 0 holds everything under kFirstBucketMicros,
+    // bucket i holds [kFirstBucketMicros * 2^(i-1), kFirstBucketMicros * 2^i) and the last bucket is open-ended.
+    static constexpr size_t kHistogramBuckets = 12;
+    static constexpr double kFirstBucketMicros = 16.0;
+
+    struct Snapshot {
+        uint64_t callbacks{0};
+        uint64_t framesRendered{0};
+        uint64_t underflows{0};
+        uint64_t overflows{0};
+        // Callbacks that took longer than their buffer period.
+        uint64_t overBudget{0};
+        std::array<uint64_t, kHistogramBuckets> durationHistogram{};
+        double lastDurationMicros{0.0};
+        // Callback time divided by buffer period, for the latest callback and the worst one since the previous
+        // snapshot.
+        double budgetUtilization{0.0};
+        double peakBudgetUtilization{0.0};
+        // Output latency as reported by the device (DAC time minus callback time), and its change against the
+        // first callback of the stream.
+        double outputLatencySeconds{0.0};
+        double outputLatencyDriftSeconds{0.0};
+    };
+
+    // Audio thread: records one callback. `outputLatencySeconds` < 0 means the host did not report timing.
+    void recordCallback(uint64_t frames, double durationSeconds, double periodSeconds, bool underflow, bool overflow,
+                        double outputLatencySeconds) noexcept;
+
+    // Monitoring thread: reads the counters and restarts the peak-utilization window.
+    Snapshot sample() noexcept;
+
+    // One JSON object per snapshot, without a trailing newline: the line format EngineBindings ingests.
+    static std::string toJson(const Snapshot &snapshot);
+
+private:
+    std::atomic<uint64_t> callbacks_{0};
+    std::atomic<uint64_t> framesRendered_{0};
+    std::atomic<uint64_t> underflows_{0};
+    std::atomic<uint64_t> overflows_{0};
+    std::atomic<uint64_t> overBudget_{0};
+    std::array<std::atomic<uint64_t>, kHistogramBuckets> histogram_{};
+    std::atomic<double> lastDurationMicros_{0.0};
+    std::atomic<double> budgetUtilization_{0.0};
+    std::atomic<double> peakBudgetUtilization_{0.0};
+    std::atomic<double> outputLatency_{0.0};
+    std::atomic<double> baselineOutputLatency_{-1.0};
+};
+
+} // namespace deejay
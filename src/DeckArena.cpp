@@ -0,0 +1,125 @@
+#include "DeckArena.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace deejay {
+
+namespace {
+constexpr size_t kPageBytes = 4096;
+constexpr size_t kHugePageBytes = size_t{2} << 20;
+
+size_t roundUp(size_t value, size_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+}
+
+DeckArena::DeckArena(Settings settings) {
+    capacity_ = roundUp(std::max<size_t>(settings.bytes, kPageBytes), kPageBytes);
+#if defined(_WIN32)
+    // Large pages need SeLockMemoryPrivilege and are locked by definition; otherwise commit and lock normally.
+    void *memory = nullptr;
+    if (settings.hugePages && GetLargePageMinimum() > 0) {
+        mappedBytes_ = roundUp(capacity_, GetLargePageMinimum());
+        memory = VirtualAlloc(nullptr, mappedBytes_, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        hugePages_ = locked_ = memory != nullptr;
+    }
+    if (!memory) {
+        mappedBytes_ = capacity_;
+        memory = VirtualAlloc(nullptr, mappedBytes_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    if (!memory) {
+        throw std::runtime_error("Unable to allocate deck arena");
+    }
+    base_ = static_cast<unsigned char *>(memory);
+    if (settings.lockMemory && !locked_) {
+        locked_ = VirtualLock(memory, mappedBytes_) != 0;
+    }
+#else
+    void *memory = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    if (settings.hugePages) {
+        mappedBytes_ = roundUp(capacity_, kHugePageBytes);
+        memory = mmap(nullptr, mappedBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugePages_ = memory != MAP_FAILED;
+    }
+#endif
+    if (memory == MAP_FAILED) {
+        mappedBytes_ = capacity_;
+        memory = mmap(nullptr, mappedBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("Unable to map deck arena");
+        }
+#if defined(MADV_HUGEPAGE)
+        // No reserved huge pages: transparent huge pages still cut TLB misses where the kernel allows them.
+        if (settings.hugePages) {
+            madvise(memory, mappedBytes_, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    base_ = static_cast<unsigned char *>(memory);
+    if (settings.lockMemory) {
+        locked_ = mlock(memory, mappedBytes_) == 0;
+    }
+#endif
+    // mlock() faults the pages in; without it, touch every page so first use does not fault on the audio thread.
+    if (!locked_) {
+        for (size_t offset = 0; offset < mappedBytes_; offset += kPageBytes) {
+            base_[offset] = 0;
+        }
+    }
+    capacity_ = mappedBytes_;
+}
+
+DeckArena::DeckArena() : DeckArena(Settings{}) {}
+
+DeckArena::~DeckArena() {
+#if defined(_WIN32)
+    if (base_) {
+        VirtualFree(base_, 0, MEM_RELEASE);
+    }
+#else
+    if (base_) {
+        if (locked_) {
+            munlock(base_, mappedBytes_);
+        }
+        munmap(base_, mappedBytes_);
+    }
+#endif
+}
+
+void *DeckArena::do_allocate(size_t bytes, size_t alignment) {
+    size_t used = used_.load(std::memory_order_relaxed);
+    for (;;) {
+        const auto address = reinterpret_cast<uintptr_t>(base_) + used;
+        const size_t start = used + static_cast<size_t>(roundUp(address, alignment) - address);
+        if (start + bytes > capacity_ || start + bytes < start) {
+            break;
+        }
+        if (used_.compare_exchange_weak(used, start + bytes, std::memory_order_relaxed)) {
+            return base_ + start;
+        }
+    }
+    overflow_.fetch_add(bytes, std::memory_order_relaxed);
+    return upstream_->allocate(bytes, alignment);
+}
+
+void DeckArena::do_deallocate(void *pointer, size_t bytes, size_t alignment) {
+    // Arena memory is reclaimed all at once when the deck goes away.
+    if (!owns(pointer)) {
+        upstream_->deallocate(pointer, bytes, alignment);
+    }
+}
+
+bool DeckArena::owns(const void *pointer) const noexcept {
+    const auto address = reinterpret_cast<uintptr_t>(pointer);
+    const auto base = reinterpret_cast<uintptr_t>(base_);
+    return address >= base && address < base + capacity_;
+}
+
+} // namespace deejay
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace deejay {
+
+// One preallocated block of memory per deck that the deck's processor, FIFOs, delay line and scratch buffers
+// are carved from. The block is mapped once, faulted in and mlock()ed up front, so the audio thread never takes
+// a page fault on deck state after startup, everything a deck touches per block sits together, and unloading
+// the deck is a single unmap. Allocation is a bump pointer and deallocation is a no-op: engine state is sized
+// in prepare() and lives until the deck goes away. Requests beyond the block are served by the upstream
+// resource and counted, so an undersized arena costs locality rather than correctness.
+class DeckArena : public std::pmr::memory_resource {
+public:
+    struct Settings {
+        size_t bytes{1 << 20};
+        // Pin the block in RAM. Failure (RLIMIT_MEMLOCK, no privilege) is not fatal; see locked().
+        bool lockMemory{true};
+        // Back the block with huge pages when the system has them, falling back to normal pages otherwise.
+        bool hugePages{false};
+    };
+
+    explicit DeckArena(Settings settings);
+    DeckArena();
+    ~DeckArena() override;
+
+    DeckArena(const DeckArena &) = delete;
+    DeckArena &operator=(const DeckArena &) = delete;
+
+    // Constructs a T inside the arena. The object's destructor runs when the returned pointer is reset; the
+    // memory is reclaimed with the arena.
+    struct Destroy {
+        template <typename T>
+        void operator()(T *object) const noexcept {
+            object->~T();
+        }
+    };
+    template <typename T>
+    using Ptr = std::unique_ptr<T, Destroy>;
+
+    template <typename T, typename... Args>
+    Ptr<T> create(Args &&...args) {
+        void *memory = allocate(sizeof(T), alignof(T));
+        return Ptr<T>(new (memory) T(std::forward<Args>(args)...));
+    }
+
+    size_t capacity() const noexcept { return capacity_; }
+    size_t usedBytes() const noexcept { return used_.load(std::memory_order_relaxed); }
+    // Bytes that did not fit and came from the upstream resource instead.
+    size_t overflowBytes() const noexcept { return overflow_.load(std::memory_order_relaxed); }
+    bool locked() const noexcept { return locked_; }
+    bool hugePages() const noexcept { return hugePages_; }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    bool owns(const void *pointer) const noexcept;
+
+    unsigned char *base_{nullptr};
+    size_t capacity_{0};
+    size_t mappedBytes_{0};
+    std::atomic<size_t> used_{0};
+    std::atomic<size_t> overflow_{0};
+    bool locked_{false};
+    bool hugePages_{false};
+    std::pmr::memory_resource *upstream_{std::pmr::new_delete_resource()};
+};
+
+} // namespace deejay
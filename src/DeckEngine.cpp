@@ -0,0 +1,64 @@
+#include "DeckEngine.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace deejay {
+
+namespace {
+// Alignment padding between the allocations.
+constexpr size_t kArenaSlackBytes = 64 * 1024;
+}
+
+DeckEngine::DeckEngine(Settings settings) : settings_(settings), decks_(settings.deckCount), pool_(settings.pool) {
+    TimeStretchPitchProcessor::Options options;
+    options.singleThreaded = true;
+
+    const size_t samples = settings_.maxBlockFrames * static_cast<size_t>(settings_.channelCount);
+    DeckArena::Settings arenaSettings = settings_.arena;
+    if (arenaSettings.bytes == 0) {
+        arenaSettings.bytes = sizeof(LatencyCompensatedProcessor) +
+                              LatencyCompensatedProcessor::memoryBytes(settings_.channelCount, settings_.maxBlockFrames) +
+                              samples * sizeof(float) + kArenaSlackBytes;
+    }
+    for (auto &deck : decks_) {
+        deck.arena = std::make_unique<DeckArena>(arenaSettings);
+        options.memory = deck.arena.get();
+        deck.processor = deck.arena->create<LatencyCompensatedProcessor>(settings_.sampleRate, settings_.channelCount, options);
+        deck.processor->setUnityBypass(settings_.unityBypass);
+        deck.processor->prepare(settings_.maxBlockFrames);
+        deck.output = static_cast<float *>(deck.arena->allocate(samples * sizeof(float), 64));
+        std::fill(deck.output, deck.output + samples, 0.0f);
+    }
+}
+
+void DeckEngine::setSource(size_t index, AudioSource *source) noexcept {
+    decks_[index].source.store(source, std::memory_order_release);
+}
+
+DeckEngine::DeckLoad DeckEngine::deckLoad(size_t index) const noexcept {
+    const auto &deck = decks_[index];
+    return {deck.renderNanoseconds.load(std::memory_order_relaxed), deck.framesRendered.load(std::memory_order_relaxed)};
+}
+
+void DeckEngine::render(size_t frames) noexcept {
+    blockFrames_ = std::min(frames, settings_.maxBlockFrames);
+    pool_.run(&DeckEngine::renderDeck, this, decks_.size());
+}
+
+void DeckEngine::renderDeck(void *context, size_t index) noexcept {
+    auto &engine = *static_cast<DeckEngine *>(context);
+    auto &deck = engine.decks_[index];
+    AudioSource *source = deck.source.load(std::memory_order_acquire);
+    if (!source) {
+        std::fill(deck.output, deck.output + engine.settings_.maxBlockFrames * static_cast<size_t>(engine.settings_.channelCount), 0.0f);
+        return;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    deck.processor->pull(*source, deck.output, engine.blockFrames_);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+    deck.renderNanoseconds.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    deck.framesRendered.fetch_add(engine.blockFrames_, std::memory_order_relaxed);
+}
+
+} // namespace deejay
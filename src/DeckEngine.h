@@ -0,0 +1,80 @@
+#pragma once
+
+#include "AudioSource.h"
+#include "DeckArena.h"
+#include "LatencyCompensatedProcessor.h"
+#include "WorkerPool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace deejay {
+
+// Owns one LatencyCompensatedProcessor per deck and renders them in parallel on a fixed WorkerPool. Every
+// stretcher runs single-threaded, so the engine's thread count is the pool size regardless of deck count. Each
+// deck's processor, queues, delay line, FIFO, scratch and output live in one DeckArena of its own.
+class DeckEngine {
+public:
+    struct Settings {
+        double sampleRate{48'000.0};
+        int channelCount{2};
+        size_t deckCount{4};
+        size_t maxBlockFrames{512};
+        // Skip the stretcher on decks sitting at unity tempo and pitch; see TimeStretchPitchProcessor.
+        bool unityBypass{true};
+        WorkerPool::Settings pool{};
+        // Per-deck arena; bytes == 0 sizes it from the channel count and block size.
+        DeckArena::Settings arena{0, true, false};
+    };
+
+    explicit DeckEngine(Settings settings);
+
+    size_t deckCount() const noexcept { return decks_.size(); }
+    int channelCount() const noexcept { return settings_.channelCount; }
+    size_t maxBlockFrames() const noexcept { return settings_.maxBlockFrames; }
+
+    LatencyCompensatedProcessor &deck(size_t index) { return *decks_[index].processor; }
+    const DeckArena &deckArena(size_t index) const noexcept { return *decks_[index].arena; }
+
+    // Attaches the source a deck pulls from; nullptr silences the deck. Safe to call while rendering: the audio
+    // thread picks up the new pointer at the next block (the caller keeps the old source alive until then).
+    void setSource(size_t index, AudioSource *source) noexcept;
+    AudioSource *source(size_t index) const noexcept { return decks_[index].source.load(std::memory_order_acquire); }
+
+    // Audio thread: renders the next `frames` (<= maxBlockFrames) interleaved frames of every deck and returns
+    // once all decks are done.
+    void render(size_t frames) noexcept;
+
+    // Interleaved output of the last render() for one deck.
+    const float *deckOutput(size_t index) const noexcept { return decks_[index].output; }
+
+    // Cumulative render cost of one deck since construction, safe to read from any thread. Diff two readings
+    // and divide the time by the audio duration of the frames for the deck's share of the callback budget.
+    struct DeckLoad {
+        uint64_t renderNanoseconds{0};
+        uint64_t framesRendered{0};
+    };
+    DeckLoad deckLoad(size_t index) const noexcept;
+
+private:
+    struct Deck {
+        // Declared first so it outlives everything carved from it.
+        std::unique_ptr<DeckArena> arena;
+        DeckArena::Ptr<LatencyCompensatedProcessor> processor;
+        std::atomic<AudioSource *> source{nullptr};
+        float *output{nullptr}; // maxBlockFrames interleaved frames in the arena
+        std::atomic<uint64_t> renderNanoseconds{0};
+        std::atomic<uint64_t> framesRendered{0};
+    };
+
+    static void renderDeck(void *context, size_t index) noexcept;
+
+    Settings settings_;
+    std::vector<Deck> decks_;
+    WorkerPool pool_;
+    size_t blockFrames_{0};
+};
+
+} // namespace deejay
@@ -0,0 +1,69 @@
+#include "EngineAbi.h"
+
+#include "SharedControlRegion.h"
+
+using deejay::SharedControlRegion;
+
+extern "C" {
+
+size_t deejay_shared_bytes(const DeejaySharedLayout *layout) {
+    return layout ? SharedControlRegion::requiredBytes(*layout) : 0;
+}
+
+int deejay_shared_init(void *memory, size_t bytes, const DeejaySharedLayout *layout, const DeejayEndpoint *endpoints) {
+    if (!layout) {
+        return DEEJAY_ERROR_BAD_LAYOUT;
+    }
+    return SharedControlRegion::initialize(memory, bytes, *layout, endpoints);
+}
+
+int deejay_shared_validate(const void *memory, size_t bytes) { return SharedControlRegion::validate(memory, bytes); }
+
+const DeejaySharedHeader *deejay_shared_header(const void *memory) {
+    return static_cast<const DeejaySharedHeader *>(memory);
+}
+
+const DeejayEndpoint *deejay_shared_endpoints(const void *memory, uint32_t *count) {
+    const auto region = SharedControlRegion::view(const_cast<void *>(memory));
+    if (count) {
+        *count = region.header().endpointCount;
+    }
+    return region.endpoints();
+}
+
+int32_t deejay_hash_target(const char *key) { return key ? SharedControlRegion::hashTarget(key) : 0; }
+
+int deejay_queue_push(void *memory, uint32_t queue, int32_t target, double value) {
+    return SharedControlRegion::view(memory).push(queue, target, value) ? 1 : 0;
+}
+
+int deejay_queue_pop(void *memory, uint32_t queue, int32_t *target, double *value) {
+    deejay::ParameterChange change;
+    if (!SharedControlRegion::view(memory).pop(queue, change)) {
+        return 0;
+    }
+    if (target) {
+        *target = change.target;
+    }
+    if (value) {
+        *value = change.value;
+    }
+    return 1;
+}
+
+int deejay_read_meter(const void *memory, uint32_t index, DeejayMeter *meter) {
+    if (!meter) {
+        return DEEJAY_ERROR_BAD_INDEX;
+    }
+    return SharedControlRegion::view(const_cast<void *>(memory)).readMeter(index, *meter) ? DEEJAY_OK
+                                                                                         : DEEJAY_ERROR_BAD_INDEX;
+}
+
+uint32_t deejay_read_waveform(const void *memory, uint32_t deck, float *points, uint32_t maxPoints) {
+    if (!points) {
+        return 0;
+    }
+    return SharedControlRegion::view(const_cast<void *>(memory)).readWaveform(deck, points, maxPoints);
+}
+
+} // extern "C"
@@ -0,0 +1,137 @@
+/*
+ * C ABI over the engine's shared-memory control region, for shells that cannot link C++ (Electron native
+ * addons, Rust, Python ctypes). Everything in the region is plain data at fixed offsets, so a reader maps the
+ * region once and then reads endpoints, meters and waveforms in place; nothing is serialized per UI frame.
+ *
+ * Region layout (all offsets in bytes from the start of the region, every block 8-byte aligned):
+ *
+ *   DeejaySharedHeader                  at 0
+ *   DeejayEndpoint[endpointCount]       at endpointsOffset
+ *   parameter rings[queueCount]         at queuesOffset, queueStride bytes apart
+ *   DeejayMeter[meterCount]             at metersOffset: one per deck, then the master bus
+ *   waveform rings[deckCount]           at waveformsOffset, waveformStride bytes apart
+ *
+ * A parameter ring has exactly the layout of ParameterQueue in src/engine/parameterQueue.ts, so a
+ * SharedArrayBuffer view over it is a working queue: int32 head at 0 (consumer index), int32 tail at 4 (producer
+ * index), int32 targets[capacity] at 8 and float64 values[capacity] at 8 + 4 * capacity. Both indices run modulo
+ * capacity and one slot always stays empty. Targets are deejay_hash_target() of the endpoint key. Rings
+ * 0..deckCount-1 carry deck controls, ring deckCount carries transport and master controls.
+ *
+ * A waveform ring is a DeejayWaveformHeader followed by float32 points[waveformPoints]; each point is the peak
+ * magnitude of framesPerWaveformPoint frames, and point n lives at n % waveformPoints.
+ *
+ * Single-field values are written with 32-bit atomic stores; a meter or waveform read may mix two updates, which
+ * is fine for display.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEEJAY_SHARED_MAGIC 0x4D534A44u /* "DJSM" */
+#define DEEJAY_SHARED_VERSION 1u
+#define DEEJAY_ENDPOINT_KEY_BYTES 32
+#define DEEJAY_ENDPOINT_LABEL_BYTES 32
+
+#define DEEJAY_OK 0
+#define DEEJAY_ERROR_TOO_SMALL (-1)
+#define DEEJAY_ERROR_BAD_LAYOUT (-2)
+#define DEEJAY_ERROR_BAD_MAGIC (-3)
+#define DEEJAY_ERROR_BAD_INDEX (-4)
+
+/* Sizes the region; see deejay_shared_bytes(). queueCapacity must be even (float64 alignment) and >= 2. */
+typedef struct DeejaySharedLayout {
+    uint32_t deckCount;
+    uint32_t endpointCount;
+    uint32_t queueCapacity;
+    uint32_t waveformPoints;
+    uint32_t framesPerWaveformPoint;
+} DeejaySharedLayout;
+
+typedef struct DeejaySharedHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t totalBytes;
+    uint32_t deckCount;
+    uint32_t endpointCount;
+    uint32_t endpointsOffset;
+    uint32_t queueCount;
+    uint32_t queueCapacity;
+    uint32_t queuesOffset;
+    uint32_t queueStride;
+    uint32_t meterCount;
+    uint32_t metersOffset;
+    uint32_t waveformPoints;
+    uint32_t framesPerWaveformPoint;
+    uint32_t waveformsOffset;
+    uint32_t waveformStride;
+} DeejaySharedHeader;
+
+typedef enum DeejayEndpointKind { DEEJAY_ENDPOINT_SLIDER = 0, DEEJAY_ENDPOINT_NUMERIC = 1 } DeejayEndpointKind;
+
+typedef struct DeejayEndpoint {
+    /* deejay_hash_target(key): the target to write into the parameter ring. */
+    int32_t id;
+    /* Parameter ring that carries writes to this endpoint. */
+    int32_t queue;
+    /* DeejayEndpointKind. */
+    int32_t kind;
+    /* Engine-side control number; opaque to shells. */
+    int32_t control;
+    double minimum;
+    double maximum;
+    double defaultValue;
+    /* NUL-terminated UTF-8, e.g. "deckA.tempo". */
+    char key[DEEJAY_ENDPOINT_KEY_BYTES];
+    char label[DEEJAY_ENDPOINT_LABEL_BYTES];
+} DeejayEndpoint;
+
+typedef struct DeejayMeter {
+    /* Blocks measured so far; changes whenever peak and rms do. */
+    uint32_t updates;
+    /* Peak magnitude and RMS over all channels of the latest block, linear. */
+    float peak;
+    float rms;
+    uint32_t reserved;
+} DeejayMeter;
+
+typedef struct DeejayWaveformHeader {
+    /* Points written since the region was created. */
+    uint32_t pointsWritten;
+    uint32_t reserved;
+} DeejayWaveformHeader;
+
+/* Bytes needed for a region with this layout, or 0 when the layout is invalid. */
+size_t deejay_shared_bytes(const DeejaySharedLayout *layout);
+
+/* Lays out a fresh region in `memory` and copies the endpoint table into it. Returns DEEJAY_OK or an error. */
+int deejay_shared_init(void *memory, size_t bytes, const DeejaySharedLayout *layout, const DeejayEndpoint *endpoints);
+
+/* Checks that `memory` holds a region this library can read. Returns DEEJAY_OK or an error. */
+int deejay_shared_validate(const void *memory, size_t bytes);
+
+const DeejaySharedHeader *deejay_shared_header(const void *memory);
+const DeejayEndpoint *deejay_shared_endpoints(const void *memory, uint32_t *count);
+
+/* The 32-bit string hash ParameterQueue.hashTarget() uses: h = h * 31 + code unit, over UTF-16 code units. Keys
+ * are ASCII, so bytes and code units coincide. */
+int32_t deejay_hash_target(const char *key);
+
+/* Producer side of a parameter ring (one producer per ring). Returns 1 when queued, 0 when the ring is full or
+ * the index is out of range. */
+int deejay_queue_push(void *memory, uint32_t queue, int32_t target, double value);
+/* Consumer side (one consumer per ring). Returns 1 when a write was dequeued, 0 when the ring is empty. */
+int deejay_queue_pop(void *memory, uint32_t queue, int32_t *target, double *value);
+
+int deejay_read_meter(const void *memory, uint32_t index, DeejayMeter *meter);
+
+/* Copies up to maxPoints of the newest waveform points of `deck`, oldest first, and returns how many. */
+uint32_t deejay_read_waveform(const void *memory, uint32_t deck, float *points, uint32_t maxPoints);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,197 @@
+#include "EngineControlSurface.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace deejay {
+
+namespace {
+constexpr size_t kMaxDecks = 26;
+
+std::string deckName(size_t deck) { return std::string("deck") + static_cast<char>('A' + deck); }
+
+// Maps LatencyCompensatedProcessor::ControlEndpoint ids onto control numbers.
+bool deckControlFor(const std::string &id, EngineControlSurface::Control &control) {
+    if (id == "tempo") {
+        control = EngineControlSurface::Control::TempoRatio;
+    } else if (id == "pitch") {
+        control = EngineControlSurface::Control::PitchSemitones;
+    } else if (id == "manualLatency") {
+        control = EngineControlSurface::Control::ManualLatency;
+    } else if (id == "jogTouch") {
+        control = EngineControlSurface::Control::JogTouch;
+    } else if (id == "jogRate") {
+        control = EngineControlSurface::Control::JogRate;
+    } else {
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+EngineControlSurface::EngineControlSurface(DeckEngine &engine, MixerBus &mixer)
+    : EngineControlSurface(engine, mixer, Settings{}) {}
+
+EngineControlSurface::EngineControlSurface(DeckEngine &engine, MixerBus &mixer, Settings settings)
+    : engine_(engine), mixer_(mixer), settings_(settings), waveformPeaks_(engine.deckCount(), 0.0f),
+      waveformFrames_(engine.deckCount(), 0) {
+    const size_t decks = engine_.deckCount();
+    // Mixer inputs past the decks (the sampler) have no endpoints of their own.
+    if (decks > kMaxDecks || mixer_.deckCount() < decks) {
+        throw std::runtime_error("EngineControlSurface: unsupported deck count");
+    }
+
+    for (size_t deck = 0; deck < decks; ++deck) {
+        const std::string name = deckName(deck);
+        const auto queue = static_cast<int32_t>(deck);
+        for (const auto &endpoint : engine_.deck(deck).controlEndpoints()) {
+            Control control{};
+            if (!deckControlFor(endpoint.id, control)) {
+                continue;
+            }
+            const auto kind = endpoint.type == "numeric" ? DEEJAY_ENDPOINT_NUMERIC : DEEJAY_ENDPOINT_SLIDER;
+            addEndpoint(name + "." + endpoint.id, endpoint.label, kind, queue, control, endpoint.minimum,
+                        endpoint.maximum, endpoint.defaultValue);
+        }
+        addEndpoint(name + ".gain", "Gain", DEEJAY_ENDPOINT_SLIDER, queue, Control::DeckGain, 0.0, 2.0,
+                    mixer_.deckGain(deck));
+        addEndpoint(name + ".crossfaderSide", "Crossfader Side", DEEJAY_ENDPOINT_NUMERIC, queue, Control::CrossfaderSide,
+                    0.0, 2.0, static_cast<double>(mixer_.crossfaderSide(deck)));
+    }
+    const auto transport = static_cast<int32_t>(decks);
+    addEndpoint("transport.crossfade", "Crossfader", DEEJAY_ENDPOINT_SLIDER, transport, Control::Crossfader, -1.0, 1.0,
+                mixer_.crossfader() * 2.0 - 1.0);
+    addEndpoint("master.gain", "Master Gain", DEEJAY_ENDPOINT_SLIDER, transport, Control::MasterGain, 0.0, 2.0,
+                mixer_.masterGain());
+
+    std::sort(lookup_.begin(), lookup_.end());
+    if (std::adjacent_find(lookup_.begin(), lookup_.end(), [](const auto &a, const auto &b) {
+            return a.first == b.first;
+        }) != lookup_.end()) {
+        throw std::runtime_error("EngineControlSurface: two endpoint keys hash to the same target");
+    }
+}
+
+void EngineControlSurface::addEndpoint(const std::string &key, const std::string &label, DeejayEndpointKind kind,
+                                       int32_t queue, Control control, double minimum, double maximum,
+                                       double defaultValue) {
+    DeejayEndpoint endpoint{};
+    endpoint.id = SharedControlRegion::hashTarget(key.c_str());
+    endpoint.queue = queue;
+    endpoint.kind = kind;
+    endpoint.control = static_cast<int32_t>(control);
+    endpoint.minimum = minimum;
+    endpoint.maximum = maximum;
+    endpoint.defaultValue = defaultValue;
+    // Keys must round-trip exactly; labels are display text and may be cut short.
+    if (key.size() >= sizeof(endpoint.key)) {
+        throw std::runtime_error("EngineControlSurface: endpoint key too long: " + key);
+    }
+    std::memcpy(endpoint.key, key.c_str(), key.size());
+    std::memcpy(endpoint.label, label.c_str(), std::min(label.size(), sizeof(endpoint.label) - 1));
+    lookup_.emplace_back(endpoint.id, endpoints_.size());
+    endpoints_.push_back(endpoint);
+}
+
+DeejaySharedLayout EngineControlSurface::layout() const noexcept {
+    return {static_cast<uint32_t>(engine_.deckCount()), static_cast<uint32_t>(endpoints_.size()), settings_.queueCapacity,
+            settings_.waveformPoints, settings_.framesPerWaveformPoint};
+}
+
+void EngineControlSurface::attach(void *memory, size_t bytes) {
+    region_ = SharedControlRegion::create(memory, bytes, layout(), endpoints_);
+    attached_ = true;
+}
+
+void EngineControlSurface::applyControls() noexcept {
+    if (!attached_) {
+        return;
+    }
+    const size_t decks = engine_.deckCount();
+    ParameterChange change;
+    for (uint32_t queue = 0; queue <= decks; ++queue) {
+        while (region_.pop(queue, change)) {
+            const auto match = std::lower_bound(lookup_.begin(), lookup_.end(), std::make_pair(change.target, size_t{0}));
+            if (match == lookup_.end() || match->first != change.target || std::isnan(change.value)) {
+                ++unknownTargets_;
+                continue;
+            }
+            const DeejayEndpoint &endpoint = endpoints_[match->second];
+            apply(endpoint, static_cast<size_t>(endpoint.queue), std::clamp(change.value, endpoint.minimum, endpoint.maximum));
+        }
+    }
+}
+
+void EngineControlSurface::apply(const DeejayEndpoint &endpoint, size_t deck, double value) noexcept {
+    switch (static_cast<Control>(endpoint.control)) {
+    case Control::TempoRatio:
+    case Control::PitchSemitones:
+    case Control::ManualLatency:
+        engine_.deck(deck).postControl(static_cast<LatencyCompensatedProcessor::ControlId>(endpoint.control), value);
+        break;
+    case Control::JogTouch:
+        engine_.deck(deck).postControl(LatencyCompensatedProcessor::ControlId::JogTouch, value);
+        break;
+    case Control::JogRate:
+        engine_.deck(deck).postControl(LatencyCompensatedProcessor::ControlId::JogRate, value);
+        break;
+    case Control::DeckGain:
+        mixer_.setDeckGain(deck, static_cast<float>(value));
+        break;
+    case Control::CrossfaderSide:
+        mixer_.setCrossfaderSide(deck, static_cast<MixerBus::CrossfaderSide>(std::lround(value)));
+        break;
+    case Control::Crossfader:
+        mixer_.setCrossfader(static_cast<float>((value + 1.0) * 0.5));
+        break;
+    case Control::MasterGain:
+        mixer_.setMasterGain(static_cast<float>(value));
+        break;
+    }
+}
+
+void EngineControlSurface::meter(uint32_t index, const float *block, size_t samples) noexcept {
+    float peak = 0.0f;
+    float energy = 0.0f;
+    for (size_t i = 0; i < samples; ++i) {
+        peak = std::max(peak, std::abs(block[i]));
+        energy += block[i] * block[i];
+    }
+    const float rms = samples > 0 ? std::sqrt(energy / static_cast<float>(samples)) : 0.0f;
+    region_.writeMeter(index, peak, rms);
+}
+
+void EngineControlSurface::publish(const float *master, size_t frames) noexcept {
+    if (!attached_ || frames == 0) {
+        return;
+    }
+    const auto channels = static_cast<size_t>(engine_.channelCount());
+    const size_t decks = engine_.deckCount();
+    for (size_t deck = 0; deck < decks; ++deck) {
+        const float *block = engine_.deckOutput(deck);
+        meter(static_cast<uint32_t>(deck), block, frames * channels);
+
+        // Waveform points straddle blocks: carry the running peak until a point's frames are complete.
+        size_t frame = 0;
+        while (frame < frames) {
+            const size_t run = std::min<size_t>(frames - frame, settings_.framesPerWaveformPoint - waveformFrames_[deck]);
+            float peak = waveformPeaks_[deck];
+            for (size_t i = frame * channels; i < (frame + run) * channels; ++i) {
+                peak = std::max(peak, std::abs(block[i]));
+            }
+            frame += run;
+            waveformFrames_[deck] += static_cast<uint32_t>(run);
+            if (waveformFrames_[deck] == settings_.framesPerWaveformPoint) {
+                region_.writeWaveformPoint(static_cast<uint32_t>(deck), peak);
+                peak = 0.0f;
+                waveformFrames_[deck] = 0;
+            }
+            waveformPeaks_[deck] = peak;
+        }
+    }
+    meter(static_cast<uint32_t>(decks), master, frames * channels);
+}
+
+} // namespace deejay
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "DeckEngine.h"
+#include "MixerBus.h"
+#include "SharedControlRegion.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace deejay {
+
+// Connects a DeckEngine and its MixerBus to a shared control region. The endpoint table is built once from the
+// decks' controlEndpoints() plus the mixer controls and copied into the region as POD; from then on the audio
+// thread consumes parameter writes from the region's rings and publishes deck and master meters and deck
+// waveforms into it, so shells read everything in place.
+//
+// Endpoint keys follow the UI's target names: "deckA.tempo", "deckA.pitch", "deckA.manualLatency",
+// "deckA.jogTouch", "deckA.jogRate", "deckA.gain", "deckA.crossfaderSide" (0 thru, 1 A, 2 B) for every deck, then "transport.crossfade" (-1 all A to
+// 1 all B) and "master.gain". Writes are clamped to the endpoint range.
+class EngineControlSurface {
+public:
+    struct Settings {
+        uint32_t queueCapacity{256};
+        uint32_t waveformPoints{2048};
+        uint32_t framesPerWaveformPoint{256};
+    };
+
+    // Engine-side control numbers stored in DeejayEndpoint::control. The first three are the deck's
+    // LatencyCompensatedProcessor::ControlId values; the jog controls map onto theirs in apply().
+    enum class Control : int32_t {
+        TempoRatio = 0,
+        PitchSemitones = 1,
+        ManualLatency = 2,
+        DeckGain = 3,
+        CrossfaderSide = 4,
+        Crossfader = 5,
+        MasterGain = 6,
+        JogTouch = 7,
+        JogRate = 8
+    };
+
+    // Builds the endpoint table; throws std::runtime_error for more than 26 decks.
+    EngineControlSurface(DeckEngine &engine, MixerBus &mixer, Settings settings);
+    EngineControlSurface(DeckEngine &engine, MixerBus &mixer);
+
+    DeejaySharedLayout layout() const noexcept;
+    size_t requiredBytes() const noexcept { return SharedControlRegion::requiredBytes(layout()); }
+    const std::vector<DeejayEndpoint> &endpoints() const noexcept { return endpoints_; }
+
+    // Lays the region out in `memory` (at least requiredBytes()). Call before the stream starts; throws
+    // std::runtime_error when the memory is too small.
+    void attach(void *memory, size_t bytes);
+    bool attached() const noexcept { return attached_; }
+
+    // Audio thread, before DeckEngine::render(): applies the writes queued in every ring. While a region is
+    // attached the audio thread is the decks' control producer, so nothing else may post deck controls.
+    void applyControls() noexcept;
+
+    // Audio thread, after mixing `frames` frames into `master`: updates the meters and waveforms.
+    void publish(const float *master, size_t frames) noexcept;
+
+    // Writes that matched no endpoint, e.g. UI targets the engine does not implement yet.
+    uint64_t unknownTargets() const noexcept { return unknownTargets_; }
+
+private:
+    void addEndpoint(const std::string &key, const std::string &label, DeejayEndpointKind kind, int32_t queue,
+                     Control control, double minimum, double maximum, double defaultValue);
+    void apply(const DeejayEndpoint &endpoint, size_t deck, double value) noexcept;
+    void meter(uint32_t index, const float *block, size_t samples) noexcept;
+
+    DeckEngine &engine_;
+    MixerBus &mixer_;
+    Settings settings_;
+    std::vector<DeejayEndpoint> endpoints_;
+    // (endpoint id, index into endpoints_), sorted by id for lookups on the audio thread.
+    std::vector<std::pair<int32_t, size_t>> lookup_;
+    SharedControlRegion region_ = SharedControlRegion::view(nullptr);
+    bool attached_{false};
+    uint64_t unknownTargets_{0};
+
+    // Per-deck peak of the waveform point being accumulated and the frames it covers so far.
+    std::vector<float> waveformPeaks_;
+    std::vector<uint32_t> waveformFrames_;
+};
+
+} // namespace deejay
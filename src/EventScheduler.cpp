@@ -0,0 +1,98 @@
+#include "EventScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace deejay {
+
+EventScheduler::EventScheduler(double sampleRate, size_t capacity) : sampleRate_(sampleRate), ring_(capacity) {
+    pending_.reserve(ring_.capacity());
+}
+
+EventScheduler::EventScheduler(double sampleRate) : EventScheduler(sampleRate, 256) {}
+
+bool EventScheduler::schedule(const ScheduledEvent &event) noexcept {
+    if (ring_.write(&event, 1) != 1) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool EventScheduler::frameAt(double streamTime, uint64_t &frame) const noexcept {
+    uint64_t anchorFrame = 0;
+    double anchorTime = 0.0;
+    for (;;) {
+        const uint32_t sequence = clockSequence_.load(std::memory_order_acquire);
+        if (sequence & 1u) {
+            continue;
+        }
+        anchorFrame = anchorFrame_.load(std::memory_order_relaxed);
+        anchorTime = anchorTime_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (clockSequence_.load(std::memory_order_relaxed) == sequence) {
+            break;
+        }
+    }
+    if (anchorTime <= 0.0) {
+        return false;
+    }
+    const double offset = std::round((streamTime - anchorTime) * sampleRate_);
+    const double target = static_cast<double>(anchorFrame) + offset;
+    frame = target <= 0.0 ? 0 : static_cast<uint64_t>(target);
+    return true;
+}
+
+void EventScheduler::publishTimestamp(uint64_t frame, double dacTime) noexcept {
+    if (dacTime <= 0.0) {
+        return;
+    }
+    const uint32_t sequence = clockSequence_.load(std::memory_order_relaxed);
+    clockSequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    anchorFrame_.store(frame, std::memory_order_relaxed);
+    anchorTime_.store(dacTime, std::memory_order_relaxed);
+    clockSequence_.store(sequence + 2, std::memory_order_release);
+}
+
+void EventScheduler::collect() noexcept {
+    if (pendingHead_ > 0) {
+        pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(pendingHead_));
+        pendingHead_ = 0;
+    }
+    ScheduledEvent event;
+    while (ring_.read(&event, 1) == 1) {
+        // The list never grows past the capacity reserved up front, so inserting does not allocate.
+        if (pending_.size() == pending_.capacity()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        const auto position = std::upper_bound(pending_.begin(), pending_.end(), event.frame,
+                                               [](uint64_t frame, const ScheduledEvent &e) { return frame < e.frame; });
+        pending_.insert(position, event);
+    }
+}
+
+size_t EventScheduler::framesUntilNext(uint64_t position, size_t limit) const noexcept {
+    if (pendingHead_ == pending_.size()) {
+        return limit;
+    }
+    const uint64_t next = pending_[pendingHead_].frame;
+    if (next <= position) {
+        return 0;
+    }
+    return static_cast<size_t>(std::min<uint64_t>(next - position, limit));
+}
+
+bool EventScheduler::popDue(uint64_t position, ScheduledEvent &event) noexcept {
+    if (pendingHead_ == pending_.size() || pending_[pendingHead_].frame > position) {
+        return false;
+    }
+    event = pending_[pendingHead_++];
+    if (event.frame < position) {
+        late_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+} // namespace deejay
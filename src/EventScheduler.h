@@ -0,0 +1,93 @@
+#pragma once
+
+#include "SpscRingBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace deejay {
+
+// A control change pinned to an engine frame. Frames count output frames since the stream started, the same
+// timeline as CallbackData::framesRendered, so frame F is the F-th frame handed to the device.
+struct ScheduledEvent {
+    enum class Kind : int32_t {
+        TempoRatio = 0,     // value: stretch ratio
+        PitchSemitones = 1, // value: semitones
+        DeckGain = 2,       // value: linear gain
+        Crossfader = 3,     // value: 0 (side A) to 1 (side B); deck is ignored
+        MasterGain = 4,     // value: linear gain; deck is ignored
+        // value: source frame. The jump happens on the source, so the new position is audible after the deck's
+        // totalLatencySamples(); schedule it that many frames early to hear it at a given frame.
+        CueJump = 5,
+        // value: sampler sound id; deck is ignored. Starts the sound at full gain on the event frame.
+        SamplerTrigger = 6,
+        // value: 1 touches the jog wheel, 0 releases it. See LatencyCompensatedProcessor::ControlId.
+        JogTouch = 7,
+        // value: platter speed as a multiple of normal playback.
+        JogRate = 8
+    };
+
+    uint64_t frame{0};
+    Kind kind{Kind::TempoRatio};
+    uint32_t deck{0};
+    double value{0.0};
+};
+
+// Sample-accurate event queue for the audio callback. Control threads schedule events against the engine
+// timeline; the callback drains them once per buffer, splits its render loop at every event frame and applies
+// each event right before the first frame it covers. Beat-aligned transitions therefore land on the exact frame
+// instead of on the next buffer boundary, without shrinking the device buffer.
+//
+// The audio thread also publishes where the timeline meets the device clock (PortAudio's
+// outputBufferDacTime), so a control thread can turn a stream time into an engine frame with frameAt().
+class EventScheduler {
+public:
+    // `capacity` bounds both the handoff ring and the pending list.
+    EventScheduler(double sampleRate, size_t capacity);
+    explicit EventScheduler(double sampleRate);
+
+    // Control thread (single producer). Returns false and counts the event as dropped when the ring is full.
+    bool schedule(const ScheduledEvent &event) noexcept;
+
+    // Engine frame that reaches the DAC at `streamTime` (seconds on the device clock), or false while the
+    // audio thread has not published a timestamp yet. Safe from any thread.
+    bool frameAt(double streamTime, uint64_t &frame) const noexcept;
+
+    // Audio thread, once per callback: `frame` is the engine frame at the start of the buffer and `dacTime` the
+    // device time at which it is played. Hosts without timing report 0; those calls are ignored.
+    void publishTimestamp(uint64_t frame, double dacTime) noexcept;
+
+    // Audio thread, once per callback before rendering: moves newly scheduled events into the pending list,
+    // ordered by frame (events on the same frame keep their scheduling order).
+    void collect() noexcept;
+
+    // Audio thread: frames that can be rendered from `position` before the next pending event, at most `limit`.
+    // 0 means an event is due at `position`.
+    size_t framesUntilNext(uint64_t position, size_t limit) const noexcept;
+
+    // Audio thread: takes the next event due at or before `position`. Events whose frame has already passed are
+    // still delivered, at `position`, and counted as late.
+    bool popDue(uint64_t position, ScheduledEvent &event) noexcept;
+
+    size_t pendingCount() const noexcept { return pending_.size() - pendingHead_; }
+    uint64_t droppedEvents() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t lateEvents() const noexcept { return late_.load(std::memory_order_relaxed); }
+
+private:
+    double sampleRate_{48'000.0};
+    SpscRingBuffer<ScheduledEvent> ring_;
+    // Sorted by frame; entries before pendingHead_ were delivered and are compacted away in collect().
+    std::vector<ScheduledEvent> pending_;
+    size_t pendingHead_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> late_{0};
+
+    // Seqlock around the latest (frame, dacTime) pair: odd while the audio thread is writing.
+    std::atomic<uint32_t> clockSequence_{0};
+    std::atomic<uint64_t> anchorFrame_{0};
+    std::atomic<double> anchorTime_{0.0};
+};
+
+} // namespace deejay
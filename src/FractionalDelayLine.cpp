@@ -0,0 +1,90 @@
+#include "FractionalDelayLine.h"
+
+#include <algorithm>
+
+namespace deejay {
+
+void FractionalDelayLine::prepare(int channelCount, size_t maxDelayFrames) {
+    channelCount_ = channelCount;
+    maxDelayFrames_ = maxDelayFrames;
+
+    // One extra slot for the interpolation neighbour, rounded up so indices wrap with a mask.
+    size_t length = 1;
+    while (length < maxDelayFrames_ + 2) {
+        length <<= 1;
+    }
+    mask_ = length - 1;
+    history_.assign(length * static_cast<size_t>(channelCount_), 0.0f);
+    reset(targetDelay_);
+}
+
+void FractionalDelayLine::reset(double delayFrames) noexcept {
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    writeIndex_ = 0;
+    setTargetDelay(delayFrames);
+    currentDelay_ = targetDelay_;
+}
+
+void FractionalDelayLine::setTargetDelay(double delayFrames) noexcept {
+    targetDelay_ = std::clamp(delayFrames, 0.0, static_cast<double>(maxDelayFrames_));
+}
+
+void FractionalDelayLine::process(float *const *channels, size_t frames) noexcept {
+    dispatch<SampleLayout::Planar>(channels, nullptr, frames);
+}
+
+void FractionalDelayLine::process(float *interleaved, size_t frames) noexcept {
+    dispatch<SampleLayout::Interleaved>(nullptr, interleaved, frames);
+}
+
+template <SampleLayout Layout>
+void FractionalDelayLine::dispatch(float *const *channels, float *interleaved, size_t frames) noexcept {
+    if (history_.empty()) {
+        return;
+    }
+    switch (channelCount_) {
+    case 1:
+        processFrames<Layout, 1>(channels, interleaved, frames);
+        break;
+    case 2:
+        processFrames<Layout, 2>(channels, interleaved, frames);
+        break;
+    case 4:
+        processFrames<Layout, 4>(channels, interleaved, frames);
+        break;
+    default:
+        processFrames<Layout, 0>(channels, interleaved, frames);
+        break;
+    }
+}
+
+template <SampleLayout Layout, int Channels>
+void FractionalDelayLine::processFrames(float *const *channels, float *interleaved, size_t frames) noexcept {
+    const size_t stride = Channels > 0 ? static_cast<size_t>(Channels) : static_cast<size_t>(channelCount_);
+    float *history = history_.data();
+    for (size_t i = 0; i < frames; ++i) {
+        if (currentDelay_ != targetDelay_) {
+            const double step = std::clamp(targetDelay_ - currentDelay_, -kMaxSlewPerFrame, kMaxSlewPerFrame);
+            currentDelay_ += step;
+        }
+
+        const auto whole = static_cast<size_t>(currentDelay_);
+        const auto fraction = static_cast<float>(currentDelay_ - static_cast<double>(whole));
+        const size_t newer = (writeIndex_ - whole) & mask_;
+        const size_t older = (newer - 1) & mask_;
+
+        // History frames are interleaved, so one frame of every channel sits in adjacent slots. With whole == 0
+        // the newest frame is the one just written, hence the write before the read within each channel.
+        float *current = history + writeIndex_ * stride;
+        const float *newerFrame = history + newer * stride;
+        const float *olderFrame = history + older * stride;
+        for (size_t ch = 0; ch < stride; ++ch) {
+            float &sample = Layout == SampleLayout::Planar ? channels[ch][i] : interleaved[i * stride + ch];
+            current[ch] = sample;
+            sample = newerFrame[ch] + (olderFrame[ch] - newerFrame[ch]) * fraction;
+        }
+        writeIndex_ = (writeIndex_ + 1) & mask_;
+    }
+}
+
+} // namespace deejay
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Interleave.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace deejay {
+
+// Multichannel delay line with a fractional, slewed delay. Changing the target delay does not jump: the read
+// position glides at a bounded rate and is linearly interpolated, so latency corrections are inaudible instead
+// of producing a burst of silence or a click.
+class FractionalDelayLine {
+public:
+    // Largest change of delay per processed frame while gliding (2% varispeed).
+    static constexpr double kMaxSlewPerFrame = 0.02;
+
+    // History is allocated from `memory` in prepare().
+    explicit FractionalDelayLine(std::pmr::memory_resource *memory = std::pmr::get_default_resource()) : history_(memory) {}
+
+    // Allocates history for delays of up to maxDelayFrames. Not realtime-safe.
+    void prepare(int channelCount, size_t maxDelayFrames);
+
+    // Clears the history and jumps straight to delayFrames.
+    void reset(double delayFrames) noexcept;
+
+    void setTargetDelay(double delayFrames) noexcept;
+    double targetDelay() const noexcept { return targetDelay_; }
+    double currentDelay() const noexcept { return currentDelay_; }
+    size_t maxDelayFrames() const noexcept { return maxDelayFrames_; }
+    bool prepared() const noexcept { return !history_.empty(); }
+
+    // Delays `frames` frames in place. Planar channels are addressed through the channel table; interleaved
+    // frames are contiguous.
+    void process(float *const *channels, size_t frames) noexcept;
+    void process(float *interleaved, size_t frames) noexcept;
+
+private:
+    // Channels > 0 fixes the channel count at compile time so the per-frame channel loop unrolls; mono, stereo
+    // and quad dispatch to those instantiations and other counts use Channels == 0 with the runtime count.
+    template <SampleLayout Layout, int Channels>
+    void processFrames(float *const *channels, float *interleaved, size_t frames) noexcept;
+    template <SampleLayout Layout>
+    void dispatch(float *const *channels, float *interleaved, size_t frames) noexcept;
+
+    int channelCount_{0};
+    size_t maxDelayFrames_{0};
+    size_t mask_{0};
+    size_t writeIndex_{0};
+    double targetDelay_{0.0};
+    double currentDelay_{0.0};
+    std::pmr::vector<float> history_; // interleaved: frame f, channel ch at f * channelCount_ + ch
+};
+
+} // namespace deejay
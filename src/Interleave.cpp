@@ -0,0 +1,168 @@
+#include "Interleave.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define DEEJAY_INTERLEAVE_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace deejay {
+
+namespace {
+
+size_t deinterleaveStereo(const float *in, float *left, float *right, size_t frames) noexcept {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= frames; i += 8) {
+        const __m256 a = _mm256_loadu_ps(in + 2 * i);     // L0 R0 L1 R1 | L2 R2 L3 R3
+        const __m256 b = _mm256_loadu_ps(in + 2 * i + 8); // L4 R4 L5 R5 | L6 R6 L7 R7
+        const __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)); // L0 L1 L4 L5 | L2 L3 L6 L7
+        const __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm256_storeu_ps(left + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0))));
+        _mm256_storeu_ps(right + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+#elif defined(DEEJAY_INTERLEAVE_SSE2)
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(in + 2 * i);
+        const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4x2_t lr = vld2q_f32(in + 2 * i);
+        vst1q_f32(left + i, lr.val[0]);
+        vst1q_f32(right + i, lr.val[1]);
+    }
+#endif
+    return i;
+}
+
+size_t interleaveStereo(const float *left, const float *right, float *out, size_t frames) noexcept {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= frames; i += 8) {
+        const __m256 l = _mm256_loadu_ps(left + i);
+        const __m256 r = _mm256_loadu_ps(right + i);
+        const __m256 lo = _mm256_unpacklo_ps(l, r); // L0 R0 L1 R1 | L4 R4 L5 R5
+        const __m256 hi = _mm256_unpackhi_ps(l, r); // L2 R2 L3 R3 | L6 R6 L7 R7
+        _mm256_storeu_ps(out + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+#elif defined(DEEJAY_INTERLEAVE_SSE2)
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 l = _mm_loadu_ps(left + i);
+        const __m128 r = _mm_loadu_ps(right + i);
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t lr;
+        lr.val[0] = vld1q_f32(left + i);
+        lr.val[1] = vld1q_f32(right + i);
+        vst2q_f32(out + 2 * i, lr);
+    }
+#endif
+    return i;
+}
+
+// Four frames of four channels form a 4x4 matrix; a register transpose swaps the two layouts.
+size_t deinterleaveQuad(const float *in, float *const *planar, size_t frames) noexcept {
+    size_t i = 0;
+#if defined(__AVX2__) || defined(DEEJAY_INTERLEAVE_SSE2)
+    for (; i + 4 <= frames; i += 4) {
+        __m128 r0 = _mm_loadu_ps(in + 4 * i);
+        __m128 r1 = _mm_loadu_ps(in + 4 * i + 4);
+        __m128 r2 = _mm_loadu_ps(in + 4 * i + 8);
+        __m128 r3 = _mm_loadu_ps(in + 4 * i + 12);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(planar[0] + i, r0);
+        _mm_storeu_ps(planar[1] + i, r1);
+        _mm_storeu_ps(planar[2] + i, r2);
+        _mm_storeu_ps(planar[3] + i, r3);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4x4_t q = vld4q_f32(in + 4 * i);
+        for (int ch = 0; ch < 4; ++ch) {
+            vst1q_f32(planar[ch] + i, q.val[ch]);
+        }
+    }
+#else
+    (void)in;
+    (void)planar;
+    (void)frames;
+#endif
+    return i;
+}
+
+size_t interleaveQuad(const float *const *planar, float *out, size_t frames) noexcept {
+    size_t i = 0;
+#if defined(__AVX2__) || defined(DEEJAY_INTERLEAVE_SSE2)
+    for (; i + 4 <= frames; i += 4) {
+        __m128 c0 = _mm_loadu_ps(planar[0] + i);
+        __m128 c1 = _mm_loadu_ps(planar[1] + i);
+        __m128 c2 = _mm_loadu_ps(planar[2] + i);
+        __m128 c3 = _mm_loadu_ps(planar[3] + i);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_storeu_ps(out + 4 * i, c0);
+        _mm_storeu_ps(out + 4 * i + 4, c1);
+        _mm_storeu_ps(out + 4 * i + 8, c2);
+        _mm_storeu_ps(out + 4 * i + 12, c3);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x4_t q;
+        for (int ch = 0; ch < 4; ++ch) {
+            q.val[ch] = vld1q_f32(planar[ch] + i);
+        }
+        vst4q_f32(out + 4 * i, q);
+    }
+#else
+    (void)planar;
+    (void)out;
+    (void)frames;
+#endif
+    return i;
+}
+
+} // namespace
+
+void deinterleave(const float *interleaved, float *const *planar, int channelCount, size_t frames) noexcept {
+    size_t done = 0;
+    if (channelCount == 2) {
+        done = deinterleaveStereo(interleaved, planar[0], planar[1], frames);
+    } else if (channelCount == 4) {
+        done = deinterleaveQuad(interleaved, planar, frames);
+    }
+
+    const auto stride = static_cast<size_t>(channelCount);
+    for (size_t i = done; i < frames; ++i) {
+        for (int ch = 0; ch < channelCount; ++ch) {
+            planar[ch][i] = interleaved[i * stride + static_cast<size_t>(ch)];
+        }
+    }
+}
+
+void interleave(const float *const *planar, float *interleaved, int channelCount, size_t frames) noexcept {
+    size_t done = 0;
+    if (channelCount == 2) {
+        done = interleaveStereo(planar[0], planar[1], interleaved, frames);
+    } else if (channelCount == 4) {
+        done = interleaveQuad(planar, interleaved, frames);
+    }
+
+    const auto stride = static_cast<size_t>(channelCount);
+    for (size_t i = done; i < frames; ++i) {
+        for (int ch = 0; ch < channelCount; ++ch) {
+            interleaved[i * stride + static_cast<size_t>(ch)] = planar[ch][i];
+        }
+    }
+}
+
+} // namespace deejay
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace deejay {
+
+// Memory layout of a multichannel block. Planar blocks store each channel contiguously; interleaved blocks
+// store frames contiguously (L R L R ...), which is what PortAudio delivers for paFloat32 by default.
+enum class SampleLayout { Planar, Interleaved };
+
+// Converts between interleaved frames and per-channel arrays. Stereo and 4-channel blocks use SSE2/AVX2 or
+// NEON kernels when the target supports them; other channel counts fall back to a scalar loop.
+void deinterleave(const float *interleaved, float *const *planar, int channelCount, size_t frames) noexcept;
+void interleave(const float *const *planar, float *interleaved, int channelCount, size_t frames) noexcept;
+
+} // namespace deejay
@@ -1,25 +1,97 @@
 #include "LatencyCompensatedProcessor.h"
 
 #include <algorithm>
+#include <cmath>
 
 namespace deejay {
 
-LatencyCompensatedProcessor::LatencyCompensatedProcessor(double sampleRate, int channelCount)
-    : processor_(sampleRate, channelCount), channelCount_(channelCount) {
-    refreshPendingLatency();
+namespace {
+// Time constant of the tempo/pitch glide that is applied when a control write arrives.
+constexpr double kControlRampSeconds = 0.02;
+constexpr double kTempoSnapThreshold = 1e-5;
+constexpr double kPitchSnapThreshold = 1e-3;
+// Delay-line headroom: the manual latency range (4096) plus room for the stretcher latency to shrink.
+constexpr size_t kMaxCompensationFrames = 16384;
+// Pull-mode FIFO size in blocks, and how many stretcher passes one pull may run before giving up on a block.
+constexpr size_t kPullFifoBlocks = 8;
+constexpr size_t kMinPullFifoFrames = 4096;
+constexpr int kMaxPullPasses = 16;
+// Crossfade between the stretcher and the jog's varispeed reader on touch and release.
+constexpr double kJogFadeSeconds = 0.005;
+
+double rampTowards(double current, double target, double coefficient, double snapThreshold) {
+    const double next = current + (target - current) * coefficient;
+    return std::abs(target - next) < snapThreshold ? target : next;
+}
+
+std::pmr::memory_resource *memoryOf(const TimeStretchPitchProcessor::Options &options) {
+    return options.memory ? options.memory : std::pmr::get_default_resource();
+}
+}
+
+LatencyCompensatedProcessor::LatencyCompensatedProcessor(double sampleRate, int channelCount,
+                                                         TimeStretchPitchProcessor::Options options)
+    : processor_(sampleRate, channelCount, TimeStretchPitchProcessor::Parameters{}, options), sampleRate_(sampleRate),
+      controlQueue_(256, memoryOf(options)), compensation_(memoryOf(options)), latencyChanges_(64, memoryOf(options)),
+      channelCount_(channelCount), inputChannels_(static_cast<size_t>(channelCount), memoryOf(options)),
+      outputChannels_(static_cast<size_t>(channelCount), memoryOf(options)), pullInput_(memoryOf(options)),
+      pullFifo_(memoryOf(options)), jog_(memoryOf(options)), jogOutput_(memoryOf(options)) {
+    primeLatency();
+}
+
+bool LatencyCompensatedProcessor::postControl(ControlId id, double value) {
+    if (!controlQueue_.enqueue(static_cast<int32_t>(id), value)) {
+        droppedControlWrites_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    switch (id) {
+    case ControlId::TempoRatio:
+        requestedControls_.tempoRatio = value;
+        break;
+    case ControlId::PitchSemitones:
+        requestedControls_.pitchSemitones = value;
+        break;
+    case ControlId::ManualLatency:
+        requestedControls_.manualLatencySamples = static_cast<int>(value);
+        break;
+    case ControlId::JogTouch:
+    case ControlId::JogRate:
+        break;
+    }
+    return true;
 }
 
 void LatencyCompensatedProcessor::updateControls(const Controls &controls) {
-    controls_ = controls;
-    processor_.setParameters({controls.tempoRatio, controls.pitchSemitones, {}});
-    refreshPendingLatency();
+    postControl(ControlId::TempoRatio, controls.tempoRatio);
+    postControl(ControlId::PitchSemitones, controls.pitchSemitones);
+    postControl(ControlId::ManualLatency, controls.manualLatencySamples);
 }
 
-LatencyCompensatedProcessor::Controls LatencyCompensatedProcessor::currentControls() const { return controls_; }
+size_t LatencyCompensatedProcessor::memoryBytes(int channelCount, size_t maxBlockFrames) {
+    const auto channels = static_cast<size_t>(channelCount);
+    size_t delayFrames = 1;
+    while (delayFrames < kMaxCompensationFrames + 2) {
+        delayFrames <<= 1;
+    }
+    const size_t fifoFrames = std::max(maxBlockFrames * kPullFifoBlocks, kMinPullFifoFrames);
+    // Ring capacities are rounded up to powers of two; 256 and 64 already are.
+    return TimeStretchPitchProcessor::scratchBytes(channelCount, maxBlockFrames) + 2 * channels * sizeof(float *) +
+           (2 * maxBlockFrames + fifoFrames + delayFrames) * channels * sizeof(float) + 256 * sizeof(ParameterChange) +
+           64 * sizeof(LatencyChange) + VarispeedReader::memoryBytes(channelCount, maxBlockFrames);
+}
+
+LatencyCompensatedProcessor::Controls LatencyCompensatedProcessor::currentControls() const { return requestedControls_; }
 
 size_t LatencyCompensatedProcessor::processBlock(const float *input, size_t frames, std::vector<float> &output) {
+    applyPendingControls(frames, false);
+
     std::vector<float> processed;
     const size_t produced = processor_.process(input, frames, processed);
+    for (int ch = 0; ch < channelCount_; ++ch) {
+        outputChannels_[ch] = processed.data() + static_cast<size_t>(ch) * produced;
+    }
+    compensation_.process(outputChannels_.data(), produced);
 
     output.clear();
 
@@ -30,32 +102,371 @@ size_t LatencyCompensatedProcessor::processBlock(const float *input, size_t fram
         pendingLatencySamples_ -= pendingSamples;
     }
 
+    // Latency that did not fit in front of this block carries over to the next one.
     output.insert(output.end(), processed.begin(), processed.end());
+    return produced;
+}
+
+void LatencyCompensatedProcessor::prepare(size_t maxBlockFrames) {
+    processor_.prepare(maxBlockFrames);
+    compensation_.prepare(channelCount_, kMaxCompensationFrames);
+
+    const auto samplesPerFrame = static_cast<size_t>(channelCount_);
+    maxBlockFrames_ = maxBlockFrames;
+    fifoCapacityFrames_ = std::max(maxBlockFrames * kPullFifoBlocks, kMinPullFifoFrames);
+    pullInput_.assign(maxBlockFrames * samplesPerFrame, 0.0f);
+    pullFifo_.assign(fifoCapacityFrames_ * samplesPerFrame, 0.0f);
+    fifoReadFrame_ = 0;
+    fifoFrames_ = 0;
+    jog_.prepare(channelCount_, maxBlockFrames);
+    jogOutput_.assign(maxBlockFrames * samplesPerFrame, 0.0f);
+    jogFadeFrames_ = std::max<size_t>(1, static_cast<size_t>(std::lround(kJogFadeSeconds * sampleRate_)));
+
+    // Nothing is playing yet, so controls queued during setup take effect without a glide.
+    applyPendingControls(0, true);
+    primeLatency();
+}
+
+void LatencyCompensatedProcessor::reset() {
+    restartStretcher();
+    jogState_ = JogState::Off;
+    jogActive_.store(false, std::memory_order_relaxed);
+}
 
-    // If there is still latency remaining after this block, pad with extra zeros to preserve alignment.
-    if (pendingLatencySamples_ > 0) {
-        output.resize(output.size() + pendingLatencySamples_, 0.0f);
-        pendingLatencySamples_ = 0;
+void LatencyCompensatedProcessor::restartStretcher() {
+    processor_.reset();
+    fifoReadFrame_ = 0;
+    fifoFrames_ = 0;
+    primeLatency();
+}
+
+size_t LatencyCompensatedProcessor::processBlock(const float *input, size_t frames, float *output,
+                                                 size_t outputCapacity) {
+    return processBlock(input, frames, output, outputCapacity, SampleLayout::Planar);
+}
+
+size_t LatencyCompensatedProcessor::processBlock(const float *input, size_t frames, float *output,
+                                                 size_t outputCapacity, SampleLayout layout) {
+    applyPendingControls(frames, false);
+
+    const size_t silentFrames = std::min(pendingLatencySamples_, outputCapacity);
+    pendingLatencySamples_ -= silentFrames;
+
+    if (layout == SampleLayout::Interleaved) {
+        const auto samplesPerFrame = static_cast<size_t>(channelCount_);
+        std::fill(output, output + silentFrames * samplesPerFrame, 0.0f);
+        const size_t written = silentFrames + processor_.process(input, frames, output + silentFrames * samplesPerFrame,
+                                                                 outputCapacity - silentFrames, SampleLayout::Interleaved);
+        compensation_.process(output, written);
+        return written;
     }
 
-    return produced;
+    for (int ch = 0; ch < channelCount_; ++ch) {
+        float *channel = output + static_cast<size_t>(ch) * outputCapacity;
+        std::fill(channel, channel + silentFrames, 0.0f);
+        inputChannels_[ch] = input + static_cast<size_t>(ch) * frames;
+        outputChannels_[ch] = channel + silentFrames;
+    }
+
+    const size_t produced =
+        processor_.process(inputChannels_.data(), frames, outputChannels_.data(), outputCapacity - silentFrames);
+
+    for (int ch = 0; ch < channelCount_; ++ch) {
+        outputChannels_[ch] = output + static_cast<size_t>(ch) * outputCapacity;
+    }
+    compensation_.process(outputChannels_.data(), silentFrames + produced);
+    return silentFrames + produced;
 }
 
-size_t LatencyCompensatedProcessor::totalLatencySamples() const {
-    return processor_.getLatencySamples() + static_cast<size_t>(std::max(0, controls_.manualLatencySamples));
+size_t LatencyCompensatedProcessor::pull(AudioSource &source, float *output, size_t frames) {
+    const double renderedTempo = source.renderedTempoRatio() > 0.0 ? source.renderedTempoRatio() : 1.0;
+    const double renderedPitch = source.renderedPitchSemitones();
+    if (renderedTempo != rendered_.tempoRatio || renderedPitch != rendered_.pitchSemitones) {
+        rendered_.tempoRatio = renderedTempo;
+        rendered_.pitchSemitones = renderedPitch;
+        renderedChanged_ = true;
+    }
+    applyPendingControls(frames, false);
+
+    uint64_t trackFrameCount = 0;
+    uint64_t position = 0;
+    const float *track = source.trackFrames(trackFrameCount, position);
+    updateJog(source, track, position);
+    if (jogState_ == JogState::Off) {
+        return pullStretched(source, output, frames);
+    }
+
+    // Touched, the reader follows the platter; otherwise it carries the deck at tempo until the stretcher is back.
+    const bool touched = jogState_ == JogState::Entering || jogState_ == JogState::Scratching;
+    const double rate = touched ? jogRate_ * playbackRate() : playbackRate();
+    if (jogState_ == JogState::Scratching || (jogState_ == JogState::Resyncing && jogResyncFrames_ == 0)) {
+        jog_.render(track, trackFrameCount, output, frames, rate);
+        return frames;
+    }
+
+    pullStretched(source, output, frames);
+    jog_.render(track, trackFrameCount, jogOutput_.data(), frames, rate);
+    const auto samples = frames * static_cast<size_t>(channelCount_);
+    switch (jogState_) {
+    case JogState::Entering:
+        blendJog(output, frames, true);
+        jogProgressFrames_ += frames;
+        if (jogProgressFrames_ >= jogFadeFrames_) {
+            jogState_ = JogState::Scratching;
+        }
+        break;
+    case JogState::Resyncing:
+        std::copy(jogOutput_.begin(), jogOutput_.begin() + static_cast<std::ptrdiff_t>(samples), output);
+        jogProgressFrames_ += frames;
+        break;
+    case JogState::Leaving:
+        blendJog(output, frames, false);
+        jogProgressFrames_ += frames;
+        if (jogProgressFrames_ >= jogFadeFrames_) {
+            jogState_ = JogState::Off;
+            jogActive_.store(false, std::memory_order_relaxed);
+        }
+        break;
+    case JogState::Off:
+    case JogState::Scratching:
+        break;
+    }
+    return frames;
+}
+
+void LatencyCompensatedProcessor::updateJog(AudioSource &source, const float *track, uint64_t position) {
+    if (!track) {
+        if (jogState_ != JogState::Off) {
+            jogState_ = JogState::Off;
+            jogActive_.store(false, std::memory_order_relaxed);
+        }
+        return;
+    }
+    switch (jogState_) {
+    case JogState::Off:
+        if (jogTouched_) {
+            // Heard position: the source position less what the stretcher, the compensation delay and the FIFO
+            // still hold, to within the stretcher's own input buffering.
+            const double queued = static_cast<double>(totalLatencySamples() + fifoFrames_) * playbackRate();
+            jog_.setPosition(std::max(0.0, static_cast<double>(position) - queued));
+            jog_.setRate(playbackRate());
+            jogState_ = JogState::Entering;
+            jogProgressFrames_ = 0;
+            jogActive_.store(true, std::memory_order_relaxed);
+        }
+        break;
+    case JogState::Entering:
+    case JogState::Scratching:
+        if (!jogTouched_) {
+            // The first block ramps the reader to deck tempo; the stretcher restarts once it is there.
+            jogState_ = JogState::Resyncing;
+            jogResyncFrames_ = 0;
+            jogProgressFrames_ = 0;
+        }
+        break;
+    case JogState::Resyncing:
+        if (jogTouched_) {
+            jogState_ = JogState::Scratching;
+        } else if (jogResyncFrames_ == 0) {
+            // After a restart the stretcher's first audible frame comes one total latency after the primed leading
+            // silence, so start it where the reader will be by then.
+            restartStretcher();
+            const size_t restartDelay = pendingLatencySamples_ + totalLatencySamples();
+            jogResyncFrames_ = std::max<size_t>(1, restartDelay);
+            jogProgressFrames_ = 0;
+            const double start = jog_.position() + static_cast<double>(restartDelay) * playbackRate();
+            source.jumpTo(static_cast<uint64_t>(std::llround(std::max(0.0, start))));
+        } else if (jogProgressFrames_ >= jogResyncFrames_) {
+            jogState_ = JogState::Leaving;
+            jogProgressFrames_ = 0;
+        }
+        break;
+    case JogState::Leaving:
+        if (jogTouched_) {
+            // Fade back in from wherever the fade out got to.
+            jogState_ = JogState::Entering;
+            jogProgressFrames_ = jogFadeFrames_ - std::min(jogProgressFrames_, jogFadeFrames_);
+        }
+        break;
+    }
+}
+
+void LatencyCompensatedProcessor::blendJog(float *output, size_t frames, bool entering) noexcept {
+    const auto samplesPerFrame = static_cast<size_t>(channelCount_);
+    const double fade = static_cast<double>(jogFadeFrames_);
+    for (size_t frame = 0; frame < frames; ++frame) {
+        const double progress = std::min(1.0, static_cast<double>(jogProgressFrames_ + frame + 1) / fade);
+        const auto weight = static_cast<float>(entering ? progress : 1.0 - progress);
+        for (size_t ch = 0; ch < samplesPerFrame; ++ch) {
+            float &sample = output[frame * samplesPerFrame + ch];
+            sample += (jogOutput_[frame * samplesPerFrame + ch] - sample) * weight;
+        }
+    }
+}
+
+size_t LatencyCompensatedProcessor::pullStretched(AudioSource &source, float *output, size_t frames) {
+    const auto samplesPerFrame = static_cast<size_t>(channelCount_);
+    const size_t silentFrames = std::min(pendingLatencySamples_, frames);
+    std::fill(output, output + silentFrames * samplesPerFrame, 0.0f);
+    pendingLatencySamples_ -= silentFrames;
+
+    size_t written = silentFrames;
+    written += drainFifo(output + written * samplesPerFrame, frames - written);
+
+    // Whenever the block is still short the FIFO is empty, so each pass refills it from the front.
+    for (int pass = 0; written < frames && pass < kMaxPullPasses; ++pass) {
+        const size_t wanted = std::clamp<size_t>(processor_.inputFramesRequired(frames - written), 1, maxBlockFrames_);
+        size_t inputFrames = wanted;
+        const float *input = source.acquire(inputFrames);
+        if (!input) {
+            const size_t read = source.read(pullInput_.data(), wanted);
+            std::fill(pullInput_.begin() + static_cast<std::ptrdiff_t>(read * samplesPerFrame),
+                      pullInput_.begin() + static_cast<std::ptrdiff_t>(wanted * samplesPerFrame), 0.0f);
+            input = pullInput_.data();
+            inputFrames = wanted;
+        }
+
+        const size_t produced =
+            processor_.process(input, inputFrames, pullFifo_.data(), fifoCapacityFrames_, SampleLayout::Interleaved);
+        compensation_.process(pullFifo_.data(), produced);
+        fifoReadFrame_ = 0;
+        fifoFrames_ = produced;
+
+        written += drainFifo(output + written * samplesPerFrame, frames - written);
+    }
+
+    std::fill(output + written * samplesPerFrame, output + frames * samplesPerFrame, 0.0f);
+    return written;
+}
+
+size_t LatencyCompensatedProcessor::drainFifo(float *output, size_t frames) noexcept {
+    const auto samplesPerFrame = static_cast<size_t>(channelCount_);
+    const size_t count = std::min(frames, fifoFrames_);
+    const float *start = pullFifo_.data() + fifoReadFrame_ * samplesPerFrame;
+    std::copy(start, start + count * samplesPerFrame, output);
+    fifoReadFrame_ += count;
+    fifoFrames_ -= count;
+    return count;
 }
 
 std::vector<LatencyCompensatedProcessor::ControlEndpoint> LatencyCompensatedProcessor::controlEndpoints() const {
     return {
-        {"tempo", "Tempo", "slider", 0.5, 2.5, controls_.tempoRatio, "User-facing tempo slider bound to time-stretch ratio."},
-        {"pitch", "Pitch", "slider", -12.0, 12.0, controls_.pitchSemitones, "Pitch slider or numeric input in semitones."},
-        {"manualLatency", "Manual Latency", "numeric", 0.0, 4096.0, static_cast<double>(controls_.manualLatencySamples),
-         "Additional latency compensation in samples, editable via numeric input."}
+        {"tempo", "Tempo", "slider", 0.5, 2.5, requestedControls_.tempoRatio, "User-facing tempo slider bound to time-stretch ratio."},
+        {"pitch", "Pitch", "slider", -12.0, 12.0, requestedControls_.pitchSemitones, "Pitch slider or numeric input in semitones."},
+        {"manualLatency", "Manual Latency", "numeric", 0.0, 4096.0, static_cast<double>(requestedControls_.manualLatencySamples),
+         "Additional latency compensation in samples, editable via numeric input."},
+        {"jogTouch", "Jog Touch", "numeric", 0.0, 1.0, 0.0, "1 while the jog wheel is touched; the deck scratches from the track in memory."},
+        {"jogRate", "Jog Rate", "slider", -VarispeedReader::kMaxRate, VarispeedReader::kMaxRate, 1.0,
+         "Platter speed while the jog is touched, as a multiple of normal playback; negative plays backwards."}
     };
 }
 
-void LatencyCompensatedProcessor::refreshPendingLatency() {
-    pendingLatencySamples_ = totalLatencySamples();
+void LatencyCompensatedProcessor::setControlTarget(ControlId id, double value) noexcept {
+    targetChanged_ = applyTarget(id, value) || targetChanged_;
+}
+
+bool LatencyCompensatedProcessor::applyTarget(ControlId id, double value) noexcept {
+    switch (id) {
+    case ControlId::TempoRatio:
+        if (value > 0.0) {
+            targetControls_.tempoRatio = value;
+        }
+        return true;
+    case ControlId::PitchSemitones:
+        targetControls_.pitchSemitones = value;
+        return true;
+    case ControlId::ManualLatency:
+        targetControls_.manualLatencySamples = static_cast<int>(value);
+        return true;
+    // Jog state moves at the next pull() and latency alignment is untouched, so these report no change.
+    case ControlId::JogTouch:
+        jogTouched_ = value != 0.0;
+        return false;
+    case ControlId::JogRate:
+        jogRate_ = value;
+        return false;
+    }
+    return false;
+}
+
+void LatencyCompensatedProcessor::applyPendingControls(size_t frames, bool snap) {
+    bool targetChanged = targetChanged_;
+    targetChanged_ = false;
+    ParameterChange change;
+    while (controlQueue_.dequeue(change)) {
+        targetChanged = applyTarget(static_cast<ControlId>(change.target), change.value) || targetChanged;
+    }
+
+    controls_.manualLatencySamples = targetControls_.manualLatencySamples;
+
+    double tempo = targetControls_.tempoRatio;
+    double pitch = targetControls_.pitchSemitones;
+    if (!snap) {
+        const double coefficient = 1.0 - std::exp(-static_cast<double>(frames) / (kControlRampSeconds * sampleRate_));
+        tempo = rampTowards(controls_.tempoRatio, tempo, coefficient, kTempoSnapThreshold);
+        pitch = rampTowards(controls_.pitchSemitones, pitch, coefficient, kPitchSnapThreshold);
+    }
+
+    // Only touch the stretcher when the applied value actually moves; settled ramps cost nothing. A pre-rendered
+    // source already carries part of the stretch, and at exactly its values the stretcher sees unity (x / x and
+    // x - x are exact), which lets the unity bypass take over.
+    if (tempo != controls_.tempoRatio || pitch != controls_.pitchSemitones || renderedChanged_) {
+        controls_.tempoRatio = tempo;
+        controls_.pitchSemitones = pitch;
+        renderedChanged_ = false;
+        auto parameters = processor_.getParameters();
+        parameters.tempoRatio = tempo / rendered_.tempoRatio;
+        parameters.pitchSemitones = pitch - rendered_.pitchSemitones;
+        processor_.setParameters(parameters);
+    }
+
+    // A quality swap replaces the stretcher underneath us, so its latency can move without a control write.
+    if (targetChanged || processor_.getLatencySamples() != trackedLatencySamples_) {
+        trackLatencyChange();
+    }
+}
+
+void LatencyCompensatedProcessor::primeLatency() {
+    const size_t stretcherLatency = processor_.getLatencySamples();
+    const auto manualLatency = static_cast<size_t>(std::max(0, controls_.manualLatencySamples));
+    referenceLatencySamples_ = stretcherLatency;
+    trackedLatencySamples_ = stretcherLatency;
+
+    if (!compensation_.prepared()) {
+        pendingLatencySamples_ = stretcherLatency + manualLatency;
+    } else {
+        // Stretcher latency is primed as leading silence; manual latency lives in the delay line from the start.
+        pendingLatencySamples_ = stretcherLatency;
+        compensation_.reset(static_cast<double>(manualLatency));
+    }
+    publishLatency();
+}
+
+void LatencyCompensatedProcessor::trackLatencyChange() {
+    // Absorb the delta between the primed and the current stretcher latency in the delay line. If the stretcher
+    // latency grows past what the delay can give back, the delay bottoms out at zero and alignment shifts.
+    trackedLatencySamples_ = processor_.getLatencySamples();
+    const double delta = static_cast<double>(referenceLatencySamples_) - static_cast<double>(trackedLatencySamples_);
+    compensation_.setTargetDelay(std::max(0, controls_.manualLatencySamples) + delta);
+    publishLatency();
+}
+
+void LatencyCompensatedProcessor::publishLatency() noexcept {
+    size_t latency = processor_.getLatencySamples();
+    if (!compensation_.prepared()) {
+        latency += static_cast<size_t>(std::max(0, controls_.manualLatencySamples));
+    } else {
+        // The compensation delay absorbs stretcher latency changes, so this stays at the primed alignment.
+        latency += static_cast<size_t>(std::lround(compensation_.targetDelay()));
+    }
+    const size_t previous = totalLatencySamples_.exchange(latency, std::memory_order_relaxed);
+    if (latency == previous) {
+        return;
+    }
+    const LatencyChange change{previous, latency};
+    if (latencyChanges_.write(&change, 1) != 1) {
+        droppedLatencyChanges_.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 } // namespace deejay
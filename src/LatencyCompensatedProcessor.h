@@ -1,7 +1,14 @@
 #pragma once
 
+#include "AudioSource.h"
+#include "FractionalDelayLine.h"
+#include "ParameterQueue.h"
+#include "SpscRingBuffer.h"
 #include "TimeStretchPitchProcessor.h"
+#include "VarispeedReader.h"
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 namespace deejay {
@@ -24,23 +31,153 @@ public:
         std::string description;
     };
 
-    LatencyCompensatedProcessor(double sampleRate, int channelCount);
+    // One change of totalLatencySamples(), raised by the audio thread.
+    struct LatencyChange {
+        size_t previousSamples{0};
+        size_t currentSamples{0};
+    };
+
+    // Target IDs carried through the control queue. JogTouch is 1 while a hand is on the jog wheel and 0 once
+    // it lets go; JogRate is the platter speed while touched, as a multiple of normal playback (0 holds the
+    // record still, negative plays backwards).
+    enum class ControlId : int32_t { TempoRatio = 0, PitchSemitones = 1, ManualLatency = 2, JogTouch = 3, JogRate = 4 };
+
+    // Queues, delay line and pull buffers are allocated from options.memory along with the stretcher's scratch.
+    LatencyCompensatedProcessor(double sampleRate, int channelCount, TimeStretchPitchProcessor::Options options = {});
 
+    // Control-thread entry points (single producer). Writes are queued lock-free and the audio thread applies
+    // them at the start of the next block: the last write per target wins, and tempo/pitch glide towards the
+    // new value instead of jumping. postControl() returns false when the queue was full and the write dropped.
+    bool postControl(ControlId id, double value);
     void updateControls(const Controls &controls);
+    // Most recently requested controls, as seen by the control thread.
     Controls currentControls() const;
+    uint64_t droppedControlWrites() const noexcept { return droppedControlWrites_.load(std::memory_order_relaxed); }
+
+    // Audio thread, between blocks: sets a control target directly, bypassing the queue, for writes that must
+    // land at an exact frame (see EventScheduler). It takes effect at the start of the next block, and tempo and
+    // pitch glide from there as for queued writes. currentControls() does not reflect it.
+    void setControlTarget(ControlId id, double value) noexcept;
+
+    // Sizes the scratch channel tables and the wrapped stretcher for blocks of up to maxBlockFrames.
+    // Must be called from a non-realtime thread before the realtime processBlock() overload is used.
+    void prepare(size_t maxBlockFrames);
+
+    // Clears the stretcher and re-primes latency compensation; call on seek or track load. Audio thread only.
+    // Control changes never re-prime: a change in reported latency is absorbed by the compensation delay line.
+    void reset();
+
+    // Upper bound of what construction and prepare(maxBlockFrames) allocate from options.memory, the stretcher's
+    // scratch included; DeckEngine sizes its deck arenas with it.
+    static size_t memoryBytes(int channelCount, size_t maxBlockFrames);
 
     size_t processBlock(const float *input, size_t frames, std::vector<float> &output);
-    size_t totalLatencySamples() const;
+
+    // Realtime-safe after prepare(): input holds `frames` planar frames, output is a caller-owned planar span
+    // where channel ch starts at output + ch * outputCapacity. Pending latency is written as leading silence
+    // and carried into later blocks instead of growing the output. Returns the number of frames written.
+    size_t processBlock(const float *input, size_t frames, float *output, size_t outputCapacity);
+
+    // Same contract with an explicit layout; interleaved output frames are contiguous starting at output.
+    size_t processBlock(const float *input, size_t frames, float *output, size_t outputCapacity, SampleLayout layout);
+
+    // Pull mode, realtime-safe after prepare(): renders exactly `frames` interleaved frames into output and reads
+    // as much input from `source` as the stretcher asks for. Priming silence and stretcher output beyond the
+    // request wait in an internal preallocated FIFO, so every call yields a constant block. Returns the frames
+    // that were rendered before any shortfall was filled with silence. Sources that implement acquire() are fed
+    // to the stretcher straight from their storage instead of being copied into the pull buffer first. For a
+    // pre-rendered source (AudioSource::renderedTempoRatio()) the stretcher only applies what the controls ask
+    // for beyond what the source already carries.
+    //
+    // For sources that expose their whole track (AudioSource::trackFrames()), touching the jog crossfades from
+    // the stretcher to a zero-latency VarispeedReader that starts where the deck was heard and follows JogRate.
+    // On release the reader runs at the deck's tempo while the stretcher restarts from where the reader will be
+    // once the stretcher's latency has passed, then fades back, so keylock and latency alignment resume without
+    // a jump.
+    size_t pull(AudioSource &source, float *output, size_t frames);
+
+    // True while the deck plays from the jog's varispeed reader, including the fades in and out. Any thread.
+    bool jogActive() const noexcept { return jogActive_.load(std::memory_order_relaxed); }
+
+    // Cached and safe from any thread: recomputed only when controls, the stretcher or its quality tier change, so
+    // per-block sync math does not reach into the stretcher.
+    size_t totalLatencySamples() const noexcept { return totalLatencySamples_.load(std::memory_order_relaxed); }
+
+    // Control thread (single consumer): takes the oldest latency change not yet seen, so deck sync can adjust
+    // incrementally instead of polling. Returns false when there is none. Changes raised while the queue is full
+    // are dropped and counted; the next one still carries the current value.
+    bool popLatencyChange(LatencyChange &change) noexcept { return latencyChanges_.read(&change, 1) == 1; }
+    uint64_t droppedLatencyChanges() const noexcept { return droppedLatencyChanges_.load(std::memory_order_relaxed); }
+
+    // Quality tier of the wrapped stretcher; see TimeStretchPitchProcessor::requestQuality(). Safe from the
+    // control thread. A tier change that alters the stretcher latency is absorbed like a control change.
+    void requestQuality(const StretchQuality &quality) noexcept { processor_.requestQuality(quality); }
+    StretchQuality activeQuality() const noexcept { return processor_.activeQuality(); }
+    bool qualitySwapPending() const noexcept { return processor_.qualitySwapPending(); }
+    // See TimeStretchPitchProcessor::setUnityBypass(); the bypass keeps the stretcher latency, so alignment holds.
+    void setUnityBypass(bool enabled) noexcept { processor_.setUnityBypass(enabled); }
+    bool unityBypassEnabled() const noexcept { return processor_.unityBypassEnabled(); }
+    bool unityBypassActive() const noexcept { return processor_.unityBypassActive(); }
 
     std::vector<ControlEndpoint> controlEndpoints() const;
 
 private:
-    void refreshPendingLatency();
+    // Jog phases of pull(): the stretcher alone; fading to the reader; the reader alone; the reader at deck
+    // tempo while the restarted stretcher catches up; fading back to the stretcher.
+    enum class JogState : uint8_t { Off, Entering, Scratching, Resyncing, Leaving };
+
+    size_t pullStretched(AudioSource &source, float *output, size_t frames);
+    void updateJog(AudioSource &source, const float *track, uint64_t position);
+    void blendJog(float *output, size_t frames, bool entering) noexcept;
+    // Track frames per output frame; tempo ratios are time ratios, so a longer ratio plays slower.
+    double playbackRate() const noexcept { return rendered_.tempoRatio / controls_.tempoRatio; }
+    size_t drainFifo(float *output, size_t frames) noexcept;
+    void primeLatency();
+    void restartStretcher();
+    void trackLatencyChange();
+    void publishLatency() noexcept;
+    void applyPendingControls(size_t frames, bool snap);
+    bool applyTarget(ControlId id, double value) noexcept;
 
     TimeStretchPitchProcessor processor_;
-    Controls controls_{};
+    double sampleRate_{0.0};
+    ParameterQueue controlQueue_;
+    std::atomic<uint64_t> droppedControlWrites_{0};
+    Controls requestedControls_{}; // control thread
+    Controls targetControls_{};    // audio thread: coalesced destination of the ramps
+    Controls controls_{};          // audio thread: values currently applied to the stretcher
+    bool targetChanged_{false};    // audio thread: setControlTarget() since the last block
+    Controls rendered_{};          // audio thread: tempo and pitch the pulled source was rendered at
+    bool renderedChanged_{false};  // audio thread: rendered_ moved since the stretcher was last configured
     size_t pendingLatencySamples_{0};
+    size_t referenceLatencySamples_{0}; // stretcher latency at the last prime
+    size_t trackedLatencySamples_{0};   // stretcher latency the delay line currently accounts for
+    FractionalDelayLine compensation_;
+    std::atomic<size_t> totalLatencySamples_{0};
+    SpscRingBuffer<LatencyChange> latencyChanges_;
+    std::atomic<uint64_t> droppedLatencyChanges_{0};
     int channelCount_{0};
+    std::pmr::vector<const float *> inputChannels_;
+    std::pmr::vector<float *> outputChannels_;
+
+    // Pull-mode state, sized in prepare(). The FIFO holds interleaved stretcher output not yet handed out.
+    size_t maxBlockFrames_{0};
+    std::pmr::vector<float> pullInput_;
+    std::pmr::vector<float> pullFifo_;
+    size_t fifoCapacityFrames_{0};
+    size_t fifoReadFrame_{0};
+    size_t fifoFrames_{0};
+
+    // Jog, audio thread unless noted.
+    VarispeedReader jog_;
+    std::pmr::vector<float> jogOutput_;
+    JogState jogState_{JogState::Off};
+    bool jogTouched_{false};
+    double jogRate_{1.0};
+    size_t jogFadeFrames_{0};       // length of the jog crossfades
+    size_t jogProgressFrames_{0};   // frames into the current fade or resync
+    size_t jogResyncFrames_{0};     // stretcher latency to wait out after a restart; 0 until it restarted
+    std::atomic<bool> jogActive_{false}; // any thread
 };
 
 } // namespace deejay
@@ -0,0 +1,141 @@
+#include "LoadGovernor.h"
+
+#include <sstream>
+
+namespace deejay {
+
+LoadGovernor::LoadGovernor(DeckEngine &engine, double sampleRate) : LoadGovernor(engine, sampleRate, Settings{}) {}
+
+LoadGovernor::LoadGovernor(DeckEngine &engine, double sampleRate, Settings settings)
+    : engine_(engine), sampleRate_(sampleRate), settings_(settings) {
+    const size_t decks = engine_.deckCount();
+    report_.decks.resize(decks);
+    for (size_t deck = 0; deck < decks; ++deck) {
+        baseQuality_.push_back(engine_.deck(deck).activeQuality());
+        baseBypass_.push_back(engine_.deck(deck).unityBypassEnabled());
+        lastLoad_.push_back(engine_.deckLoad(deck));
+    }
+}
+
+void LoadGovernor::update(const CallbackMetrics::Snapshot &snapshot) {
+    sampleDeckLoad();
+
+    const double load = snapshot.peakBudgetUtilization;
+    report_.peakBudgetUtilization = load;
+    hotSamples_ = load > settings_.degradeAbove ? hotSamples_ + 1 : 0;
+    coolSamples_ = load < settings_.restoreBelow ? coolSamples_ + 1 : 0;
+
+    // One step per decision, then start counting again: a quality swap takes a few tens of milliseconds to land
+    // and the next snapshot should see its effect before anything else moves.
+    if (hotSamples_ >= settings_.degradeAfterSamples && degradeOne()) {
+        ++report_.degradations;
+        hotSamples_ = 0;
+    } else if (coolSamples_ >= settings_.restoreAfterSamples && restoreOne()) {
+        ++report_.restorations;
+        coolSamples_ = 0;
+    }
+}
+
+void LoadGovernor::sampleDeckLoad() {
+    for (size_t deck = 0; deck < report_.decks.size(); ++deck) {
+        const auto load = engine_.deckLoad(deck);
+        const auto &last = lastLoad_[deck];
+        const uint64_t frames = load.framesRendered - last.framesRendered;
+        const double audioNanoseconds = static_cast<double>(frames) / sampleRate_ * 1e9;
+        auto &report = report_.decks[deck];
+        report.budgetShare =
+            audioNanoseconds > 0.0 ? static_cast<double>(load.renderNanoseconds - last.renderNanoseconds) / audioNanoseconds : 0.0;
+        report.bypassActive = engine_.deck(deck).unityBypassActive();
+        report.qualitySwapPending = engine_.deck(deck).qualitySwapPending();
+        lastLoad_[deck] = load;
+    }
+}
+
+bool LoadGovernor::degradeOne() {
+    size_t chosen = report_.decks.size();
+    for (size_t deck = 0; deck < report_.decks.size(); ++deck) {
+        const auto &report = report_.decks[deck];
+        // A deck still swapping stretchers has not shown the effect of its last step yet.
+        if (report.stage == Stage::UnityBypass || report.qualitySwapPending) {
+            continue;
+        }
+        if (chosen == report_.decks.size() || report.budgetShare > report_.decks[chosen].budgetShare) {
+            chosen = deck;
+        }
+    }
+    if (chosen == report_.decks.size()) {
+        return false;
+    }
+    apply(chosen, static_cast<Stage>(static_cast<int>(report_.decks[chosen].stage) + 1));
+    return true;
+}
+
+bool LoadGovernor::restoreOne() {
+    size_t chosen = report_.decks.size();
+    for (size_t deck = 0; deck < report_.decks.size(); ++deck) {
+        const auto &report = report_.decks[deck];
+        if (report.stage == Stage::Full || report.qualitySwapPending) {
+            continue;
+        }
+        if (chosen == report_.decks.size() || report.stage > report_.decks[chosen].stage ||
+            (report.stage == report_.decks[chosen].stage && report.budgetShare < report_.decks[chosen].budgetShare)) {
+            chosen = deck;
+        }
+    }
+    if (chosen == report_.decks.size()) {
+        return false;
+    }
+    apply(chosen, static_cast<Stage>(static_cast<int>(report_.decks[chosen].stage) - 1));
+    return true;
+}
+
+void LoadGovernor::apply(size_t deck, Stage stage) {
+    StretchQuality quality = baseQuality_[deck];
+    if (stage >= Stage::NoFormants) {
+        quality.formantPreservation = 0.0f;
+    }
+    if (stage >= Stage::HighSpeed) {
+        quality.highQuality = false;
+    }
+
+    auto &processor = engine_.deck(deck);
+    processor.requestQuality(quality);
+    processor.setUnityBypass(stage >= Stage::UnityBypass || baseBypass_[deck]);
+    report_.decks[deck].stage = stage;
+}
+
+const char *LoadGovernor::stageName(Stage stage) noexcept {
+    switch (stage) {
+    case Stage::Full:
+        return "full";
+    case Stage::NoFormants:
+        return "noFormants";
+    case Stage::HighSpeed:
+        return "highSpeed";
+    case Stage::UnityBypass:
+        return "unityBypass";
+    }
+    return "unknown";
+}
+
+std::string LoadGovernor::toJson(const Report &report) {
+    std::ostringstream json;
+    json << "{\"type\":\"loadGovernor\""
+         << ",\"peakBudgetUtilization\":" << report.peakBudgetUtilization
+         << ",\"degradations\":" << report.degradations
+         << ",\"restorations\":" << report.restorations
+         << ",\"decks\":[";
+    for (size_t deck = 0; deck < report.decks.size(); ++deck) {
+        const auto &entry = report.decks[deck];
+        json << (deck > 0 ? "," : "")
+             << "{\"stage\":" << static_cast<int>(entry.stage)
+             << ",\"stageName\":\"" << stageName(entry.stage) << "\""
+             << ",\"budgetShare\":" << entry.budgetShare
+             << ",\"bypassActive\":" << (entry.bypassActive ? "true" : "false")
+             << ",\"qualitySwapPending\":" << (entry.qualitySwapPending ? "true" : "false") << "}";
+    }
+    json << "]}";
+    return json.str();
+}
+
+} // namespace deejay
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CallbackMetrics.h"
+#include "DeckEngine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace deejay {
+
+// Trades stretcher quality for headroom while the audio callback runs close to its deadline, and gives it back
+// once load has stayed low for a while. Each step moves one deck one stage: degradations go to the deck that
+// costs the most, restorations to the most degraded one, so the saving is spread across decks. All changes go
+// through the decks' thread-safe quality and bypass controls; the audio thread never waits on the governor.
+class LoadGovernor {
+public:
+    enum class Stage : int {
+        Full = 0,        // the deck's own quality settings
+        NoFormants = 1,  // formant preservation off
+        HighSpeed = 2,   // Rubber Band's high-speed pitch mode as well
+        UnityBypass = 3, // stretcher skipped while tempo and pitch sit exactly at unity
+    };
+
+    struct Settings {
+        // Peak callback budget utilization that counts as overloaded, and as comfortable.
+        double degradeAbove{0.8};
+        double restoreBelow{0.5};
+        // Consecutive snapshots beyond a threshold before the governor acts. Restoring is deliberately slower
+        // than degrading so a deck does not flap around one load level.
+        int degradeAfterSamples{2};
+        int restoreAfterSamples{10};
+    };
+
+    struct DeckReport {
+        Stage stage{Stage::Full};
+        // Deck render time over the audio duration rendered since the previous snapshot.
+        double budgetShare{0.0};
+        bool bypassActive{false};
+        bool qualitySwapPending{false};
+    };
+
+    struct Report {
+        double peakBudgetUtilization{0.0};
+        uint64_t degradations{0};
+        uint64_t restorations{0};
+        std::vector<DeckReport> decks;
+    };
+
+    // Captures every deck's current quality and bypass setting as its Full stage.
+    LoadGovernor(DeckEngine &engine, double sampleRate);
+    LoadGovernor(DeckEngine &engine, double sampleRate, Settings settings);
+
+    // Monitoring thread: feed one snapshot per sampling interval.
+    void update(const CallbackMetrics::Snapshot &snapshot);
+
+    const Report &report() const noexcept { return report_; }
+
+    // One JSON object per report, without a trailing newline, in the same line protocol as CallbackMetrics.
+    static std::string toJson(const Report &report);
+    static const char *stageName(Stage stage) noexcept;
+
+private:
+    void sampleDeckLoad();
+    bool degradeOne();
+    bool restoreOne();
+    void apply(size_t deck, Stage stage);
+
+    DeckEngine &engine_;
+    double sampleRate_{0.0};
+    Settings settings_;
+    std::vector<StretchQuality> baseQuality_;
+    std::vector<bool> baseBypass_;
+    std::vector<DeckEngine::DeckLoad> lastLoad_;
+    Report report_;
+    int hotSamples_{0};
+    int coolSamples_{0};
+};
+
+} // namespace deejay
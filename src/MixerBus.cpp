@@ -0,0 +1,221 @@
+#include "MixerBus.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define DEEJAY_MIXER_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace deejay {
+
+namespace {
+
+constexpr float kHalfPi = 1.57079632679f;
+
+// One register of samples. Lane counts are powers of two, so every channel count that divides the lane count
+// (mono, stereo, quad) lines whole frames up with the register.
+#if defined(__AVX2__)
+#define DEEJAY_MIXER_SIMD 1
+using Vec = __m256;
+constexpr size_t kLanes = 8;
+inline Vec loadVec(const float *p) noexcept { return _mm256_loadu_ps(p); }
+inline void storeVec(float *p, Vec v) noexcept { _mm256_storeu_ps(p, v); }
+inline Vec splat(float value) noexcept { return _mm256_set1_ps(value); }
+inline Vec zeroVec() noexcept { return _mm256_setzero_ps(); }
+inline Vec addVec(Vec a, Vec b) noexcept { return _mm256_add_ps(a, b); }
+// a * b + c
+inline Vec mulAdd(Vec a, Vec b, Vec c) noexcept {
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+#elif defined(DEEJAY_MIXER_SSE2)
+#define DEEJAY_MIXER_SIMD 1
+using Vec = __m128;
+constexpr size_t kLanes = 4;
+inline Vec loadVec(const float *p) noexcept { return _mm_loadu_ps(p); }
+inline void storeVec(float *p, Vec v) noexcept { _mm_storeu_ps(p, v); }
+inline Vec splat(float value) noexcept { return _mm_set1_ps(value); }
+inline Vec zeroVec() noexcept { return _mm_setzero_ps(); }
+inline Vec addVec(Vec a, Vec b) noexcept { return _mm_add_ps(a, b); }
+inline Vec mulAdd(Vec a, Vec b, Vec c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+#elif defined(__ARM_NEON)
+#define DEEJAY_MIXER_SIMD 1
+using Vec = float32x4_t;
+constexpr size_t kLanes = 4;
+inline Vec loadVec(const float *p) noexcept { return vld1q_f32(p); }
+inline void storeVec(float *p, Vec v) noexcept { vst1q_f32(p, v); }
+inline Vec splat(float value) noexcept { return vdupq_n_f32(value); }
+inline Vec zeroVec() noexcept { return vdupq_n_f32(0.0f); }
+inline Vec addVec(Vec a, Vec b) noexcept { return vaddq_f32(a, b); }
+inline Vec mulAdd(Vec a, Vec b, Vec c) noexcept { return vmlaq_f32(c, a, b); }
+#endif
+
+// Deck d's gain on frame f of the block is start[d] + step[d] * (f + 1): the ramp lands on the target on the
+// last frame, and a deck without a ramp (step 0) gets exactly its gain. Computing it per frame instead of
+// accumulating steps keeps the vector body and the scalar tail on the same ramp without drift.
+size_t mixVectorized(const float *const *inputs, const float *start, const float *step, size_t deckCount,
+                     int channelCount, float *out, size_t frames) noexcept {
+#if defined(DEEJAY_MIXER_SIMD)
+    const auto channels = static_cast<size_t>(channelCount);
+    if (kLanes % channels != 0) {
+        return 0;
+    }
+    // Frame number (+1) of every lane within one register.
+    float laneFrames[kLanes];
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+        laneFrames[lane] = static_cast<float>(lane / channels + 1);
+    }
+    const Vec lanes = loadVec(laneFrames);
+
+    // Two registers per step share the per-deck broadcasts and give the adds two independent chains.
+    const Vec nextLanes = addVec(lanes, splat(static_cast<float>(kLanes / channels)));
+    const size_t samples = frames * channels;
+    size_t i = 0;
+    for (; i + 2 * kLanes <= samples; i += 2 * kLanes) {
+        const Vec base = splat(static_cast<float>(i / channels));
+        const Vec frame0 = addVec(lanes, base);
+        const Vec frame1 = addVec(nextLanes, base);
+        Vec sum0 = zeroVec();
+        Vec sum1 = zeroVec();
+        for (size_t d = 0; d < deckCount; ++d) {
+            const Vec slope = splat(step[d]);
+            const Vec offset = splat(start[d]);
+            const float *in = inputs[d] + i;
+            sum0 = mulAdd(loadVec(in), mulAdd(slope, frame0, offset), sum0);
+            sum1 = mulAdd(loadVec(in + kLanes), mulAdd(slope, frame1, offset), sum1);
+        }
+        storeVec(out + i, sum0);
+        storeVec(out + i + kLanes, sum1);
+    }
+    for (; i + kLanes <= samples; i += kLanes) {
+        const Vec frame = addVec(lanes, splat(static_cast<float>(i / channels)));
+        Vec sum = zeroVec();
+        for (size_t d = 0; d < deckCount; ++d) {
+            sum = mulAdd(loadVec(inputs[d] + i), mulAdd(splat(step[d]), frame, splat(start[d])), sum);
+        }
+        storeVec(out + i, sum);
+    }
+    return i / channels;
+#else
+    (void)inputs;
+    (void)start;
+    (void)step;
+    (void)deckCount;
+    (void)channelCount;
+    (void)out;
+    (void)frames;
+    return 0;
+#endif
+}
+
+} // namespace
+
+MixerBus::MixerBus(int channelCount, size_t deckCount)
+    : channelCount_(channelCount), decks_(deckCount), currentGains_(deckCount, 0.0f), targetScratch_(deckCount, 0.0f),
+      startScratch_(deckCount, 0.0f), stepScratch_(deckCount, 0.0f), inputScratch_(deckCount, nullptr) {
+    reset();
+}
+
+void MixerBus::setDeckGain(size_t deck, float gain) noexcept {
+    decks_[deck].gain.store(std::max(0.0f, gain), std::memory_order_relaxed);
+}
+
+void MixerBus::setCrossfaderSide(size_t deck, CrossfaderSide side) noexcept {
+    decks_[deck].side.store(side, std::memory_order_relaxed);
+}
+
+void MixerBus::setCrossfader(float position) noexcept {
+    crossfader_.store(std::clamp(position, 0.0f, 1.0f), std::memory_order_relaxed);
+}
+
+void MixerBus::setMasterGain(float gain) noexcept {
+    masterGain_.store(std::max(0.0f, gain), std::memory_order_relaxed);
+}
+
+void MixerBus::crossfaderGains(float position, float &a, float &b) noexcept {
+    const float theta = std::clamp(position, 0.0f, 1.0f) * kHalfPi;
+    a = std::cos(theta);
+    b = std::sin(theta);
+}
+
+void MixerBus::targetGains(float *gains) const noexcept {
+    float sideA = 1.0f;
+    float sideB = 1.0f;
+    crossfaderGains(crossfader(), sideA, sideB);
+    const float master = masterGain();
+    for (size_t d = 0; d < decks_.size(); ++d) {
+        float gain = deckGain(d) * master;
+        switch (crossfaderSide(d)) {
+        case CrossfaderSide::A:
+            gain *= sideA;
+            break;
+        case CrossfaderSide::B:
+            gain *= sideB;
+            break;
+        case CrossfaderSide::Thru:
+            break;
+        }
+        gains[d] = gain;
+    }
+}
+
+void MixerBus::reset() noexcept {
+    targetGains(currentGains_.data());
+}
+
+void MixerBus::mix(const float *const *deckOutputs, float *output, size_t frames) noexcept {
+    const auto channels = static_cast<size_t>(channelCount_);
+    if (frames == 0) {
+        return;
+    }
+    targetGains(targetScratch_.data());
+
+    // Compact to the decks that contribute anything, so silent or muted decks cost nothing in the kernel.
+    size_t active = 0;
+    const float frameCount = static_cast<float>(frames);
+    for (size_t d = 0; d < decks_.size(); ++d) {
+        const float from = currentGains_[d];
+        const float to = targetScratch_[d];
+        currentGains_[d] = to;
+        if (!deckOutputs[d] || (from == 0.0f && to == 0.0f)) {
+            continue;
+        }
+        inputScratch_[active] = deckOutputs[d];
+        startScratch_[active] = from;
+        stepScratch_[active] = (to - from) / frameCount;
+        ++active;
+    }
+    const float *const *inputs = inputScratch_.data();
+    const float *start = startScratch_.data();
+    const float *step = stepScratch_.data();
+
+    if (active == 0) {
+        std::fill(output, output + frames * channels, 0.0f);
+        return;
+    }
+
+    size_t frame = mixVectorized(inputs, start, step, active, channelCount_, output, frames);
+    for (; frame < frames; ++frame) {
+        const auto position = static_cast<float>(frame + 1);
+        for (size_t ch = 0; ch < channels; ++ch) {
+            const size_t i = frame * channels + ch;
+            float sum = 0.0f;
+            for (size_t d = 0; d < active; ++d) {
+                sum += inputs[d][i] * (start[d] + step[d] * position);
+            }
+            output[i] = sum;
+        }
+    }
+}
+
+} // namespace deejay
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace deejay {
+
+// Sums the interleaved deck outputs of a DeckEngine into the device buffer. Per-deck gain, the crossfader and
+// the master gain fold into one gain per deck, and all decks are accumulated in a single SIMD pass (AVX2, SSE2
+// or NEON, as for Interleave.h), so the output is written exactly once per block. The gain law matches
+// SummingBus in src/lib.rs: the crossfader is equal-power, cos/sin of position * pi/2 for sides A and B.
+//
+// Gain changes never jump: every mix() ramps each deck linearly from the gain it ended the previous block on
+// to the gain of the current controls, reaching it on the block's last frame.
+class MixerBus {
+public:
+    // Which crossfader side a deck is on; Thru decks ignore the crossfader.
+    enum class CrossfaderSide : int { Thru = 0, A = 1, B = 2 };
+
+    MixerBus(int channelCount, size_t deckCount);
+
+    int channelCount() const noexcept { return channelCount_; }
+    size_t deckCount() const noexcept { return decks_.size(); }
+
+    // Control side, safe from any thread; the audio thread picks the values up at its next mix(). Gains are
+    // linear and clamped to >= 0, the crossfader position to [0, 1] (0 is all A, 1 all B).
+    void setDeckGain(size_t deck, float gain) noexcept;
+    void setCrossfaderSide(size_t deck, CrossfaderSide side) noexcept;
+    void setCrossfader(float position) noexcept;
+    void setMasterGain(float gain) noexcept;
+
+    float deckGain(size_t deck) const noexcept { return decks_[deck].gain.load(std::memory_order_relaxed); }
+    CrossfaderSide crossfaderSide(size_t deck) const noexcept {
+        return decks_[deck].side.load(std::memory_order_relaxed);
+    }
+    float crossfader() const noexcept { return crossfader_.load(std::memory_order_relaxed); }
+    float masterGain() const noexcept { return masterGain_.load(std::memory_order_relaxed); }
+
+    // Equal-power crossfader gains for sides A and B at `position`.
+    static void crossfaderGains(float position, float &a, float &b) noexcept;
+
+    // Audio thread, realtime-safe: overwrites `frames` interleaved frames of output with the mix of
+    // deckOutputs[0..deckCount()), each holding `frames` interleaved frames. Null deck pointers are silent.
+    void mix(const float *const *deckOutputs, float *output, size_t frames) noexcept;
+
+    // Snaps every deck to the gain of the current controls, so the next mix() does not ramp. Audio thread.
+    void reset() noexcept;
+
+private:
+    struct Deck {
+        std::atomic<float> gain{1.0f};
+        std::atomic<CrossfaderSide> side{CrossfaderSide::Thru};
+    };
+
+    // Effective gain of every deck for the current controls.
+    void targetGains(float *gains) const noexcept;
+
+    int channelCount_{0};
+    std::vector<Deck> decks_;
+    std::atomic<float> crossfader_{0.5f};
+    std::atomic<float> masterGain_{1.0f};
+
+    // Audio-thread state: the gain each deck ended the last block on, and per-block scratch.
+    std::vector<float> currentGains_;
+    std::vector<float> targetScratch_;
+    std::vector<float> startScratch_;
+    std::vector<float> stepScratch_;
+    std::vector<const float *> inputScratch_;
+};
+
+} // namespace deejay
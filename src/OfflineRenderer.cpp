@@ -0,0 +1,122 @@
+#include "OfflineRenderer.h"
+
+#include "Interleave.h"
+#include "WavFileReader.h"
+#include "WavFileWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <thread>
+
+namespace deejay {
+
+OfflineRenderer::OfflineRenderer(Settings settings) : settings_(settings) {
+    settings_.chunkFrames = std::max<size_t>(settings_.chunkFrames, 1024);
+    if (settings_.threads == 0) {
+        settings_.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+OfflineRenderer::Result OfflineRenderer::render(const Job &job) const {
+    Result result;
+    const auto started = std::chrono::steady_clock::now();
+
+    try {
+        WavFileReader reader(job.inputPath);
+        const int channels = reader.channelCount();
+        const size_t chunk = settings_.chunkFrames;
+        result.inputFrames = reader.totalFrames();
+        result.sampleRate = reader.sampleRate();
+
+        TimeStretchPitchProcessor::Parameters parameters;
+        parameters.tempoRatio = job.tempoRatio;
+        parameters.pitchSemitones = job.pitchSemitones;
+        parameters.quality = job.quality;
+        TimeStretchPitchProcessor::Options options;
+        options.offline = true;
+        // Parallelism comes from rendering several tracks at once, not from threads inside each stretcher.
+        options.singleThreaded = settings_.threads > 1;
+
+        TimeStretchPitchProcessor processor(reader.sampleRate(), channels, parameters, options);
+        processor.prepare(chunk);
+        processor.setExpectedInputDuration(static_cast<size_t>(reader.totalFrames()));
+
+        std::vector<float> interleaved(chunk * static_cast<size_t>(channels));
+        std::vector<float> planar(interleaved.size());
+        std::vector<float *> channelPointers(static_cast<size_t>(channels));
+        for (int ch = 0; ch < channels; ++ch) {
+            channelPointers[static_cast<size_t>(ch)] = planar.data() + static_cast<size_t>(ch) * chunk;
+        }
+        const float *const *input = channelPointers.data();
+
+        // The reader's frame count comes from the header; treat a short read as end of input in both passes.
+        auto readChunk = [&](bool &final) {
+            const size_t frames = reader.readFrames(interleaved.data(), chunk);
+            final = frames < chunk || reader.position() >= reader.totalFrames();
+            deinterleave(interleaved.data(), channelPointers.data(), channels, frames);
+            return frames;
+        };
+
+        bool final = false;
+        while (!final) {
+            const size_t frames = readChunk(final);
+            processor.study(input, frames, final);
+        }
+
+        reader.seek(0);
+        WavFileWriter writer(job.outputPath, reader.sampleRate(), channels);
+        auto drain = [&] {
+            while (true) {
+                const size_t retrieved = processor.retrieve(channelPointers.data(), chunk);
+                if (retrieved == 0) {
+                    return;
+                }
+                interleave(input, interleaved.data(), channels, retrieved);
+                writer.writeFrames(interleaved.data(), retrieved);
+            }
+        };
+
+        final = false;
+        while (!final) {
+            const size_t frames = readChunk(final);
+            processor.push(input, frames, final);
+            drain();
+        }
+        drain();
+
+        writer.close();
+        result.outputFrames = writer.framesWritten();
+        result.ok = true;
+    } catch (const std::exception &error) {
+        result.error = error.what();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+std::vector<OfflineRenderer::Result> OfflineRenderer::renderAll(const std::vector<Job> &jobs) const {
+    std::vector<Result> results(jobs.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t index = next.fetch_add(1); index < jobs.size(); index = next.fetch_add(1)) {
+            results[index] = render(jobs[index]);
+        }
+    };
+
+    const size_t threadCount = std::min(settings_.threads, jobs.size());
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount > 0 ? threadCount - 1 : 0);
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return results;
+}
+
+} // namespace deejay
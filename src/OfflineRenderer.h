@@ -0,0 +1,54 @@
+#pragma once
+
+#include "TimeStretchPitchProcessor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace deejay {
+
+// Batch renderer for whole tracks: reads a WAV file, runs the stretcher in offline mode (a study pass over the
+// complete input followed by a processing pass) and writes the result as float32 WAV. Tracks are rendered in
+// parallel, one single-threaded stretcher per track, so a crate scales with the number of cores.
+class OfflineRenderer {
+public:
+    struct Job {
+        std::string inputPath;
+        std::string outputPath;
+        double tempoRatio{1.0};
+        double pitchSemitones{0.0};
+        StretchQuality quality{};
+    };
+
+    struct Result {
+        bool ok{false};
+        std::string error;
+        uint64_t inputFrames{0};
+        uint64_t outputFrames{0};
+        double sampleRate{0.0};
+        double seconds{0.0};
+    };
+
+    struct Settings {
+        // Frames handed to the stretcher per study/process call; large chunks keep per-call overhead negligible.
+        size_t chunkFrames{65'536};
+        // Tracks rendered concurrently; 0 uses every hardware thread.
+        size_t threads{0};
+    };
+
+    explicit OfflineRenderer(Settings settings);
+
+    // Renders one track on the calling thread. Failures are reported through Result rather than thrown, so one
+    // unreadable file does not abort a crate.
+    Result render(const Job &job) const;
+
+    // Renders every job and returns results in job order.
+    std::vector<Result> renderAll(const std::vector<Job> &jobs) const;
+
+private:
+    Settings settings_;
+};
+
+} // namespace deejay
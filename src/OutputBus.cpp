@@ -0,0 +1,160 @@
+#include "OutputBus.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace deejay {
+
+OutputBus::OutputBus(Settings settings) : settings_(settings) {
+    if (settings_.channelCount <= 0 || settings_.firstChannel < 0 ||
+        settings_.firstChannel + settings_.channelCount > settings_.deviceChannels) {
+        throw std::runtime_error("Output bus channels do not fit the device");
+    }
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    scratch_.assign(settings_.maxBlockFrames * channels, 0.0f);
+    alignment_.prepare(settings_.channelCount,
+                       static_cast<size_t>(std::ceil(settings_.maxAlignmentSeconds * settings_.sampleRate)));
+    alignment_.reset(0.0);
+    if (settings_.separateDevice) {
+        settings_.ringFrames = std::max(settings_.ringFrames, settings_.targetFillFrames + settings_.maxBlockFrames);
+        ring_ = std::make_unique<SpscRingBuffer<float>>(settings_.ringFrames * channels);
+        AdaptiveResampler::Settings resamplerSettings;
+        resamplerSettings.channelCount = settings_.channelCount;
+        resamplerSettings.maxBlockFrames = settings_.maxBlockFrames;
+        resamplerSettings.taps = settings_.resamplerTaps;
+        resampler_ = std::make_unique<AdaptiveResampler>(resamplerSettings);
+        // The first block after a reset also fills the filter history; later ones read ratio * frames, plus one.
+        readScratch_.assign((settings_.maxBlockFrames + resampler_->taps() + 4) * channels, 0.0f);
+        resampleScratch_.assign(settings_.maxBlockFrames * channels, 0.0f);
+    }
+}
+
+void OutputBus::setAlignmentDelay(double frames) noexcept {
+    requestedDelay_.store(std::max(0.0, frames), std::memory_order_relaxed);
+}
+
+void OutputBus::write(float *deviceOutput, size_t frames, double streamTime) noexcept {
+    const double delay = requestedDelay_.load(std::memory_order_relaxed);
+    if (delay != appliedDelay_) {
+        appliedDelay_ = delay;
+        alignment_.setTargetDelay(delay);
+    }
+    // An idle delay line at zero is a pure copy; skip it.
+    if (alignment_.targetDelay() != 0.0 || alignment_.currentDelay() != 0.0) {
+        alignment_.process(scratch_.data(), frames);
+    }
+
+    if (!ring_) {
+        place(scratch_.data(), deviceOutput, frames);
+        return;
+    }
+    // A block that does not fit is dropped whole, like RecorderTap, so the device only ever misses whole blocks.
+    const size_t samples = frames * static_cast<size_t>(settings_.channelCount);
+    if (ring_->writeAvailable() < samples) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring_->write(scratch_.data(), samples);
+
+    const uint32_t sequence = writeSequence_.load(std::memory_order_relaxed);
+    writeSequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    writtenFrames_.store(writtenFrames_.load(std::memory_order_relaxed) + frames, std::memory_order_relaxed);
+    lastWriteFrames_.store(frames, std::memory_order_relaxed);
+    lastWriteTime_.store(streamTime, std::memory_order_relaxed);
+    writeSequence_.store(sequence + 2, std::memory_order_release);
+}
+
+size_t OutputBus::read(float *deviceOutput, size_t frames, double streamTime) noexcept {
+    const auto deviceChannels = static_cast<size_t>(settings_.deviceChannels);
+    std::fill(deviceOutput, deviceOutput + frames * deviceChannels, 0.0f);
+    if (!ring_) {
+        return 0;
+    }
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    if (!playing_) {
+        if (ring_->readAvailable() < settings_.targetFillFrames * channels) {
+            return 0;
+        }
+        playing_ = true;
+        resampler_->reset();
+        smoothedFill_ = estimateFill(streamTime);
+    } else {
+        // A light low-pass on top of the estimate, well inside the loop's own time constant.
+        const double seconds = static_cast<double>(frames) / settings_.sampleRate;
+        const double alpha = seconds / (seconds + settings_.steerSeconds / 8.0);
+        smoothedFill_ += alpha * (estimateFill(streamTime) - smoothedFill_);
+    }
+    steer(smoothedFill_, static_cast<double>(frames) / settings_.sampleRate);
+    const double ratio = ratio_.load(std::memory_order_relaxed);
+
+    const size_t scratchFrames = readScratch_.size() / channels;
+    size_t delivered = 0;
+    while (delivered < frames) {
+        const size_t count = std::min(frames - delivered, settings_.maxBlockFrames);
+        const size_t wanted = std::min(resampler_->inputFramesRequired(count, ratio), scratchFrames);
+        const size_t read = ring_->read(readScratch_.data(), wanted * channels) / channels;
+        readFrames_ += read;
+        const size_t rendered = resampler_->process(readScratch_.data(), read, resampleScratch_.data(), count, ratio);
+        place(resampleScratch_.data(), deviceOutput + delivered * deviceChannels, rendered);
+        delivered += rendered;
+        if (rendered < count) {
+            // Ran dry: wait for the target fill again so the latency the alignment assumed is restored.
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+            playing_ = false;
+            break;
+        }
+    }
+    return delivered;
+}
+
+double OutputBus::estimateFill(double streamTime) const noexcept {
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    const auto raw = static_cast<double>(ring_->readAvailable() / channels);
+    const uint32_t before = writeSequence_.load(std::memory_order_acquire);
+    const uint64_t written = writtenFrames_.load(std::memory_order_relaxed);
+    const uint64_t block = lastWriteFrames_.load(std::memory_order_relaxed);
+    const double writeTime = lastWriteTime_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint32_t after = writeSequence_.load(std::memory_order_relaxed);
+    // Mid-write, no timestamps, or two clocks that are not comparable: the raw fill, sawtooth and all.
+    if ((before & 1U) != 0 || before != after || streamTime <= 0.0 || writeTime <= 0.0 ||
+        std::abs(streamTime - writeTime) > 1.0) {
+        return raw;
+    }
+    // Treat the last block as arriving steadily over its own duration rather than all at once.
+    const double arrived =
+        std::clamp((streamTime - writeTime) * settings_.sampleRate, 0.0, static_cast<double>(block));
+    return static_cast<double>(written - block) + arrived - static_cast<double>(readFrames_);
+}
+
+void OutputBus::steer(double fill, double seconds) noexcept {
+    // PI loop on the fill error, critically damped at 1 / steerSeconds. The ring integrates the rate
+    // mismatch, so d(error)/dt = -sampleRate * (ratio - 1 - drift).
+    const double omega = 1.0 / settings_.steerSeconds;
+    const double proportional = 2.0 * omega / settings_.sampleRate;
+    const double integralGain = omega * omega / settings_.sampleRate;
+    const double maxDeviation = settings_.maxDriftPpm * 1e-6;
+    const double error = fill - static_cast<double>(settings_.targetFillFrames);
+    integral_ = std::clamp(integral_ + error * seconds, -maxDeviation / integralGain, maxDeviation / integralGain);
+    const double drift = integralGain * integral_;
+    ratio_.store(std::clamp(1.0 + proportional * error + drift, 1.0 - maxDeviation, 1.0 + maxDeviation),
+                 std::memory_order_relaxed);
+    driftPpm_.store(drift * 1e6, std::memory_order_relaxed);
+}
+
+void OutputBus::place(const float *mix, float *deviceOutput, size_t frames) const noexcept {
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    const auto deviceChannels = static_cast<size_t>(settings_.deviceChannels);
+    if (channels == deviceChannels) {
+        std::copy(mix, mix + frames * channels, deviceOutput);
+        return;
+    }
+    float *target = deviceOutput + settings_.firstChannel;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        std::copy(mix + frame * channels, mix + (frame + 1) * channels, target + frame * deviceChannels);
+    }
+}
+
+} // namespace deejay
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "AdaptiveResampler.h"
+#include "FractionalDelayLine.h"
+#include "SpscRingBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace deejay {
+
+// One output destination of the engine, e.g. the master or the headphone cue mix. A MixerBus mixes the shared
+// deck outputs into scratch(); write() then delays that block to line up with the other destinations and
+// places it on `channelCount` channels starting at `firstChannel` of a device frame `deviceChannels` wide. A
+// destination on the engine's own device is written straight into the callback buffer. One on a separate
+// device goes through a lock-free ring that the device's own callback drains with read(); playback starts,
+// and restarts after an underrun, once the ring holds `targetFillFrames`.
+//
+// Two sound cards never run at exactly the same rate, so a fixed ring would slowly fill up or run dry. The
+// separate device therefore reads the ring through an AdaptiveResampler whose ratio a PI loop steers to keep
+// the fill at `targetFillFrames`. The fill is estimated from the stream times the two callbacks pass in, as if
+// the engine wrote continuously instead of a block per callback, so callback jitter does not modulate the ratio.
+class OutputBus {
+public:
+    struct Settings {
+        int channelCount{2};
+        int deviceChannels{2};
+        int firstChannel{0};
+        double sampleRate{48'000.0};
+        size_t maxBlockFrames{512};
+        // Largest alignment delay; covers the output latency differences of real devices.
+        double maxAlignmentSeconds{0.25};
+        // Separate device only: ring capacity and the fill level read() keeps between the two callbacks.
+        bool separateDevice{false};
+        size_t ringFrames{8192};
+        size_t targetFillFrames{1024};
+        // Drift correction: time constant of the fill loop and the largest correction applied.
+        double steerSeconds{4.0};
+        double maxDriftPpm{2000.0};
+        size_t resamplerTaps{32};
+    };
+
+    explicit OutputBus(Settings settings);
+
+    int channelCount() const noexcept { return settings_.channelCount; }
+    int deviceChannels() const noexcept { return settings_.deviceChannels; }
+    bool separateDevice() const noexcept { return settings_.separateDevice; }
+
+    // maxBlockFrames interleaved frames for the mixer to render into; write() delays them in place.
+    float *scratch() noexcept { return scratch_.data(); }
+
+    // Control side, any thread: delay in frames applied on top of the device's own output latency. The delay
+    // glides to a new value (FractionalDelayLine) instead of jumping.
+    void setAlignmentDelay(double frames) noexcept;
+    double alignmentDelay() const noexcept { return requestedDelay_.load(std::memory_order_relaxed); }
+    // Frames the bus itself holds before the device: the ring fill and the resampler delay for a separate
+    // device, otherwise 0.
+    size_t bufferedFrames() const noexcept {
+        return resampler_ ? settings_.targetFillFrames + resampler_->latencyFrames() : 0;
+    }
+
+    // Engine callback: delivers `frames` frames of scratch(). For a bus on the engine's device, `deviceOutput`
+    // is the callback buffer at the block's first frame; for a separate device it is ignored. `streamTime` is
+    // the engine stream's time at the block (PaStreamCallbackTimeInfo::currentTime), 0 if unknown.
+    void write(float *deviceOutput, size_t frames, double streamTime = 0.0) noexcept;
+
+    // Separate device's callback: fills `frames` device frames (deviceChannels wide), silence where the ring
+    // ran dry. `streamTime` is the device stream's currentTime; without it, or when the two streams' clocks are
+    // not comparable, the loop steers on the raw ring fill. Returns the frames rendered from the ring.
+    size_t read(float *deviceOutput, size_t frames, double streamTime = 0.0) noexcept;
+
+    // Input frames the separate device consumes per output frame; above 1 when the engine's card runs fast.
+    double resampleRatio() const noexcept { return ratio_.load(std::memory_order_relaxed); }
+    // Settled part of the correction, i.e. the measured clock drift between the two cards.
+    double driftPpm() const noexcept { return driftPpm_.load(std::memory_order_relaxed); }
+
+    uint64_t underruns() const noexcept { return underruns_.load(std::memory_order_relaxed); }
+    uint64_t overruns() const noexcept { return overruns_.load(std::memory_order_relaxed); }
+
+private:
+    void place(const float *mix, float *deviceOutput, size_t frames) const noexcept;
+    double estimateFill(double streamTime) const noexcept;
+    void steer(double fill, double seconds) noexcept;
+
+    Settings settings_;
+    std::vector<float> scratch_;
+    FractionalDelayLine alignment_;
+    std::atomic<double> requestedDelay_{0.0};
+    double appliedDelay_{0.0}; // engine callback
+    std::unique_ptr<SpscRingBuffer<float>> ring_;
+    // Engine callback publishes where it stands, under a sequence count: total frames queued, the size of the
+    // last block and the stream time it was written at.
+    std::atomic<uint32_t> writeSequence_{0};
+    std::atomic<uint64_t> writtenFrames_{0};
+    std::atomic<uint64_t> lastWriteFrames_{0};
+    std::atomic<double> lastWriteTime_{0.0};
+    // Device callback.
+    std::unique_ptr<AdaptiveResampler> resampler_;
+    std::vector<float> readScratch_;
+    std::vector<float> resampleScratch_;
+    uint64_t readFrames_{0};
+    bool playing_{false}; // ring reached its target fill
+    double smoothedFill_{0.0};
+    double integral_{0.0};
+    std::atomic<double> ratio_{1.0};
+    std::atomic<double> driftPpm_{0.0};
+    std::atomic<uint64_t> underruns_{0};
+    std::atomic<uint64_t> overruns_{0};
+};
+
+} // namespace deejay
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "SpscRingBuffer.h"
+
+#include <cstdint>
+
+namespace deejay {
+
+// One control write: an integer target ID plus a double value, the same record the Electron ParameterQueue
+// stores in its Int32/Float64 SharedArrayBuffer slots.
+struct ParameterChange {
+    int32_t target{0};
+    double value{0.0};
+};
+
+// Lock-free single-producer/single-consumer queue of control writes. The control thread enqueues; the audio
+// thread drains once per block. Neither side blocks, and a full queue rejects the write instead of waiting.
+class ParameterQueue {
+public:
+    explicit ParameterQueue(size_t capacity = 256, std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+        : ring_(capacity, memory) {}
+
+    bool enqueue(int32_t target, double value) noexcept {
+        const ParameterChange change{target, value};
+        return ring_.write(&change, 1) == 1;
+    }
+
+    bool dequeue(ParameterChange &change) noexcept { return ring_.read(&change, 1) == 1; }
+
+    size_t capacity() const noexcept { return ring_.capacity(); }
+
+private:
+    SpscRingBuffer<ParameterChange> ring_;
+};
+
+} // namespace deejay
@@ -0,0 +1,129 @@
+#include "PolyphaseSinc.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define DEEJAY_SINC_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace deejay {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr size_t kTapMultiple = 8;
+
+size_t roundedTaps(size_t taps) { return std::max(kTapMultiple, (taps + kTapMultiple - 1) / kTapMultiple * kTapMultiple); }
+
+// Blends two filter rows: out = a + (b - a) * weight.
+void blend(const float *a, const float *b, float weight, float *out, size_t taps) noexcept {
+    size_t t = 0;
+#if defined(__AVX2__)
+    const __m256 w = _mm256_set1_ps(weight);
+    for (; t + 8 <= taps; t += 8) {
+        const __m256 va = _mm256_loadu_ps(a + t);
+        _mm256_storeu_ps(out + t, _mm256_add_ps(va, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(b + t), va), w)));
+    }
+#elif defined(DEEJAY_SINC_SSE2)
+    const __m128 w = _mm_set1_ps(weight);
+    for (; t + 4 <= taps; t += 4) {
+        const __m128 va = _mm_loadu_ps(a + t);
+        _mm_storeu_ps(out + t, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + t), va), w)));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t w = vdupq_n_f32(weight);
+    for (; t + 4 <= taps; t += 4) {
+        const float32x4_t va = vld1q_f32(a + t);
+        vst1q_f32(out + t, vmlaq_f32(va, vsubq_f32(vld1q_f32(b + t), va), w));
+    }
+#endif
+    for (; t < taps; ++t) {
+        out[t] = a[t] + (b[t] - a[t]) * weight;
+    }
+}
+
+} // namespace
+
+PolyphaseSinc::PolyphaseSinc(size_t taps, size_t phases, double cutoff, std::pmr::memory_resource *memory)
+    : taps_(roundedTaps(taps)), phases_(std::max<size_t>(phases, 1)), table_(memory) {
+    // Row p interpolates at fraction p / phases past the centre tap; x is the distance of tap t from that point.
+    // Rows are normalized to unity DC gain so a steady signal does not ripple as the phase moves.
+    table_.assign((phases_ + 1) * taps_, 0.0f);
+    const double centre = static_cast<double>(taps_) / 2.0 - 1.0;
+    const double length = static_cast<double>(taps_);
+    std::vector<double> row(taps_);
+    for (size_t p = 0; p <= phases_; ++p) {
+        const double fraction = static_cast<double>(p) / static_cast<double>(phases_);
+        double sum = 0.0;
+        for (size_t t = 0; t < taps_; ++t) {
+            const double x = static_cast<double>(t) - centre - fraction;
+            const double argument = kPi * cutoff * x;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(argument) / argument;
+            const double window =
+                0.42 + 0.5 * std::cos(2.0 * kPi * x / length) + 0.08 * std::cos(4.0 * kPi * x / length);
+            row[t] = sinc * std::max(0.0, window);
+            sum += row[t];
+        }
+        for (size_t t = 0; t < taps_; ++t) {
+            table_[p * taps_ + t] = static_cast<float>(row[t] / sum);
+        }
+    }
+}
+
+size_t PolyphaseSinc::memoryBytes(size_t taps, size_t phases) {
+    return (std::max<size_t>(phases, 1) + 1) * roundedTaps(taps) * sizeof(float);
+}
+
+void PolyphaseSinc::coefficients(double fraction, float *out) const noexcept {
+    const double phase = fraction * static_cast<double>(phases_);
+    const auto row = std::min(static_cast<size_t>(phase), phases_ - 1);
+    blend(table_.data() + row * taps_, table_.data() + (row + 1) * taps_,
+          static_cast<float>(phase - static_cast<double>(row)), out, taps_);
+}
+
+float PolyphaseSinc::dot(const float *coefficients, const float *samples, size_t taps) noexcept {
+    size_t t = 0;
+    float sum = 0.0f;
+#if defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; t + 8 <= taps; t += 8) {
+#if defined(__FMA__)
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(coefficients + t), _mm256_loadu_ps(samples + t), acc);
+#else
+        acc = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(coefficients + t), _mm256_loadu_ps(samples + t)), acc);
+#endif
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    sum = _mm_cvtss_f32(half);
+#elif defined(DEEJAY_SINC_SSE2)
+    __m128 acc = _mm_setzero_ps();
+    for (; t + 4 <= taps; t += 4) {
+        acc = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(coefficients + t), _mm_loadu_ps(samples + t)), acc);
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; t + 4 <= taps; t += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(coefficients + t), vld1q_f32(samples + t));
+    }
+    const float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+    for (; t < taps; ++t) {
+        sum += coefficients[t] * samples[t];
+    }
+    return sum;
+}
+
+} // namespace deejay
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace deejay {
+
+// Blackman-windowed sinc interpolation table shared by the resamplers (AdaptiveResampler, VarispeedReader). A
+// point `fraction` (0 <= fraction < 1) past input frame n is interpolated from the taps() frames starting at
+// n - centre(). Coefficients for a point blend the two nearest of `phases` precomputed rows; the blend and the
+// dot product run in SIMD (AVX2, SSE2 or NEON, as for MixerBus). Rows are normalized to unity DC gain.
+class PolyphaseSinc {
+public:
+    // Taps are rounded up to a multiple of 8 so the kernels have no scalar tail. Not realtime-safe.
+    PolyphaseSinc(size_t taps, size_t phases, double cutoff,
+                  std::pmr::memory_resource *memory = std::pmr::get_default_resource());
+
+    size_t taps() const noexcept { return taps_; }
+    size_t centre() const noexcept { return taps_ / 2 - 1; }
+
+    // Writes taps() coefficients for a point `fraction` past the centre tap.
+    void coefficients(double fraction, float *out) const noexcept;
+
+    static float dot(const float *coefficients, const float *samples, size_t taps) noexcept;
+
+    // Table bytes for a filter of this size, allocated from `memory` at construction.
+    static size_t memoryBytes(size_t taps, size_t phases);
+
+private:
+    size_t taps_{0};
+    size_t phases_{0};
+    std::pmr::vector<float> table_; // (phases + 1) rows of taps coefficients
+};
+
+} // namespace deejay
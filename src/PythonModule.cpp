@@ -0,0 +1,771 @@
+// deejay._native: CPython bindings for TimeStretchPitchProcessor and LatencyCompensatedProcessor.
+//
+// Audio crosses the boundary through the buffer protocol, so numpy float32 arrays, array('f') and
+// memoryview.cast('f') are all processed in place without a copy. Buffers are interleaved, frames * channels
+// float32 values, C-contiguous. The GIL is released while audio is processed; each processor serializes its own
+// calls with a mutex, so separate processors run in parallel on separate Python threads. As in the C++ API,
+// tempo_ratio is a Rubber Band time ratio: 2.0 plays at half speed and doubles the output.
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "AudioSource.h"
+#include "LatencyCompensatedProcessor.h"
+#include "TimeStretchPitchProcessor.h"
+#include "WavFileReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+using deejay::LatencyCompensatedProcessor;
+using deejay::SampleLayout;
+using deejay::TimeStretchPitchProcessor;
+
+namespace {
+
+constexpr Py_ssize_t kDefaultMaxBlockFrames = 1024;
+
+// Holds a float32 view of a Python object for the duration of a call.
+class FloatBuffer {
+public:
+    FloatBuffer() { std::memset(&view_, 0, sizeof(view_)); }
+    ~FloatBuffer() {
+        if (view_.obj) {
+            PyBuffer_Release(&view_);
+        }
+    }
+    FloatBuffer(const FloatBuffer &) = delete;
+    FloatBuffer &operator=(const FloatBuffer &) = delete;
+
+    // Sets a Python exception and returns false unless `object` is a C-contiguous float32 buffer holding whole
+    // frames of `channels` samples.
+    bool acquire(PyObject *object, bool writable, int channels, const char *name) {
+        const int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+        if (PyObject_GetBuffer(object, &view_, flags) != 0) {
+            return false;
+        }
+        const char *format = view_.format ? view_.format : "B";
+        if (view_.itemsize != sizeof(float) || !isFloatFormat(format)) {
+            PyErr_Format(PyExc_TypeError, "%s must be a float32 buffer, got format '%s'", name, format);
+            return false;
+        }
+        const auto samples = static_cast<size_t>(view_.len) / sizeof(float);
+        if (samples % static_cast<size_t>(channels) != 0) {
+            PyErr_Format(PyExc_ValueError, "%s holds %zu samples, not a whole number of %d-channel frames", name,
+                         samples, channels);
+            return false;
+        }
+        frames_ = samples / static_cast<size_t>(channels);
+        return true;
+    }
+
+    float *data() const noexcept { return static_cast<float *>(view_.buf); }
+    size_t frames() const noexcept { return frames_; }
+
+private:
+    static bool isFloatFormat(const char *format) {
+        // Native or little-endian float; numpy and array('f') export "f".
+        if (format[0] == '@' || format[0] == '=' || format[0] == '<') {
+            ++format;
+        }
+        return std::strcmp(format, "f") == 0;
+    }
+
+    Py_buffer view_;
+    size_t frames_{0};
+};
+
+bool setPythonError(const std::exception &error) {
+    if (dynamic_cast<const std::bad_alloc *>(&error)) {
+        PyErr_NoMemory();
+    } else {
+        PyErr_SetString(PyExc_RuntimeError, error.what());
+    }
+    return false;
+}
+
+bool validateFormat(double sampleRate, int channels, Py_ssize_t maxBlockFrames) {
+    if (sampleRate <= 0.0) {
+        PyErr_SetString(PyExc_ValueError, "sample_rate must be positive");
+        return false;
+    }
+    if (channels <= 0) {
+        PyErr_SetString(PyExc_ValueError, "channels must be positive");
+        return false;
+    }
+    if (maxBlockFrames <= 0) {
+        PyErr_SetString(PyExc_ValueError, "max_block_frames must be positive");
+        return false;
+    }
+    return true;
+}
+
+// Plays a Python buffer, the whole decoded track, to LatencyCompensatedProcessor::pull() for one call. It lends
+// its storage (acquire) and exposes the whole track, so pulls are zero-copy and the jog controls work.
+class BufferSource : public deejay::AudioSource {
+public:
+    BufferSource(const float *track, uint64_t frames, uint64_t position, int channels)
+        : track_(track), frames_(frames), position_(std::min(position, frames)), channels_(channels) {}
+
+    int channelCount() const noexcept override { return channels_; }
+
+    size_t read(float *interleaved, size_t frames) noexcept override {
+        frames = static_cast<size_t>(std::min<uint64_t>(frames, frames_ - position_));
+        const float *source = track_ + position_ * static_cast<uint64_t>(channels_);
+        std::copy(source, source + frames * static_cast<size_t>(channels_), interleaved);
+        position_ += frames;
+        return frames;
+    }
+
+    // As MappedTrackSource does: nullptr at the end of the track, so pull() zero-fills the rest through read().
+    const float *acquire(size_t &frames) noexcept override {
+        frames = static_cast<size_t>(std::min<uint64_t>(frames, frames_ - position_));
+        if (frames == 0) {
+            return nullptr;
+        }
+        const float *source = track_ + position_ * static_cast<uint64_t>(channels_);
+        position_ += frames;
+        return source;
+    }
+
+    bool jumpTo(uint64_t frame) noexcept override {
+        position_ = std::min(frame, frames_);
+        return true;
+    }
+
+    const float *trackFrames(uint64_t &frameCount, uint64_t &position) noexcept override {
+        frameCount = frames_;
+        position = position_;
+        return track_;
+    }
+
+    uint64_t position() const noexcept { return position_; }
+
+private:
+    const float *track_;
+    uint64_t frames_;
+    uint64_t position_;
+    int channels_;
+};
+
+PyObject *endpointDict(const std::string &id, const std::string &label, const char *type, double minimum,
+                       double maximum, double defaultValue, const std::string &description) {
+    return Py_BuildValue("{s:s#,s:s#,s:s,s:d,s:d,s:d,s:s#}", "id", id.data(), static_cast<Py_ssize_t>(id.size()),
+                         "label", label.data(), static_cast<Py_ssize_t>(label.size()), "type", type, "minimum",
+                         minimum, "maximum", maximum, "default", defaultValue, "description", description.data(),
+                         static_cast<Py_ssize_t>(description.size()));
+}
+
+template <typename Item, typename Convert>
+PyObject *listOf(const std::vector<Item> &items, Convert convert) {
+    PyObject *list = PyList_New(static_cast<Py_ssize_t>(items.size()));
+    if (!list) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < items.size(); ++i) {
+        PyObject *item = convert(items[i]);
+        if (!item) {
+            Py_DECREF(list);
+            return nullptr;
+        }
+        PyList_SET_ITEM(list, static_cast<Py_ssize_t>(i), item);
+    }
+    return list;
+}
+
+// TimeStretchPitchProcessor ----------------------------------------------------------------------------------
+
+struct Stretcher {
+    Stretcher(double sampleRate, int channels, TimeStretchPitchProcessor::Parameters parameters,
+              TimeStretchPitchProcessor::Options options)
+        : processor(sampleRate, channels, parameters, options) {}
+
+    std::mutex mutex;
+    TimeStretchPitchProcessor processor;
+};
+
+struct StretcherObject {
+    PyObject_HEAD
+    Stretcher *native;
+};
+
+int Stretcher_init(StretcherObject *self, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"sample_rate",     "channels",         "tempo_ratio", "pitch_semitones",
+                                     "max_block_frames", "single_threaded", nullptr};
+    double sampleRate = 0.0;
+    int channels = 0;
+    TimeStretchPitchProcessor::Parameters parameters;
+    Py_ssize_t maxBlockFrames = kDefaultMaxBlockFrames;
+    int singleThreaded = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "di|ddnp", const_cast<char **>(keywords), &sampleRate, &channels,
+                                     &parameters.tempoRatio, &parameters.pitchSemitones, &maxBlockFrames,
+                                     &singleThreaded)) {
+        return -1;
+    }
+    if (!validateFormat(sampleRate, channels, maxBlockFrames)) {
+        return -1;
+    }
+
+    TimeStretchPitchProcessor::Options options;
+    options.singleThreaded = singleThreaded != 0;
+    try {
+        auto native = std::make_unique<Stretcher>(sampleRate, channels, parameters, options);
+        native->processor.prepare(static_cast<size_t>(maxBlockFrames));
+        delete self->native;
+        self->native = native.release();
+    } catch (const std::exception &error) {
+        setPythonError(error);
+        return -1;
+    }
+    return 0;
+}
+
+void Stretcher_dealloc(StretcherObject *self) {
+    delete self->native;
+    PyTypeObject *type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+bool checkStretcher(StretcherObject *self) {
+    if (!self->native) {
+        PyErr_SetString(PyExc_RuntimeError, "TimeStretchPitchProcessor.__init__ was not called");
+        return false;
+    }
+    return true;
+}
+
+PyObject *Stretcher_process(StretcherObject *self, PyObject *args) {
+    PyObject *inputObject = nullptr;
+    PyObject *outputObject = nullptr;
+    if (!PyArg_ParseTuple(args, "OO:process", &inputObject, &outputObject) || !checkStretcher(self)) {
+        return nullptr;
+    }
+    auto &native = *self->native;
+    const int channels = native.processor.channelCount();
+    FloatBuffer input;
+    FloatBuffer output;
+    if (!input.acquire(inputObject, false, channels, "input") || !output.acquire(outputObject, true, channels, "output")) {
+        return nullptr;
+    }
+
+    // Input longer than the prepared block is fed in block-sized pieces; output that does not fit stays queued.
+    size_t written = 0;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(native.mutex);
+        const auto samplesPerFrame = static_cast<size_t>(channels);
+        const size_t block = native.processor.maxBlockFrames();
+        for (size_t offset = 0; offset < input.frames(); offset += block) {
+            const size_t frames = std::min(block, input.frames() - offset);
+            written += native.processor.process(input.data() + offset * samplesPerFrame, frames,
+                                                output.data() + written * samplesPerFrame, output.frames() - written,
+                                                SampleLayout::Interleaved);
+        }
+    }
+    Py_END_ALLOW_THREADS
+    return PyLong_FromSize_t(written);
+}
+
+PyObject *Stretcher_set_parameters(StretcherObject *self, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"tempo_ratio", "pitch_semitones", nullptr};
+    if (!checkStretcher(self)) {
+        return nullptr;
+    }
+    auto &native = *self->native;
+    TimeStretchPitchProcessor::Parameters parameters;
+    {
+        std::lock_guard<std::mutex> lock(native.mutex);
+        parameters = native.processor.getParameters();
+    }
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|dd:set_parameters", const_cast<char **>(keywords),
+                                     &parameters.tempoRatio, &parameters.pitchSemitones)) {
+        return nullptr;
+    }
+    if (parameters.tempoRatio <= 0.0) {
+        PyErr_SetString(PyExc_ValueError, "tempo_ratio must be positive");
+        return nullptr;
+    }
+    // Rubber Band may rebuild its stretcher here, so errors are caught before the GIL is taken back.
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        std::lock_guard<std::mutex> lock(native.mutex);
+        native.processor.setParameters(parameters);
+    } catch (const std::exception &exception) {
+        error = exception.what();
+    }
+    Py_END_ALLOW_THREADS
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *Stretcher_input_frames_required(StretcherObject *self, PyObject *args) {
+    Py_ssize_t outputFrames = 0;
+    if (!PyArg_ParseTuple(args, "n:input_frames_required", &outputFrames) || !checkStretcher(self)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(self->native->mutex);
+    return PyLong_FromSize_t(self->native->processor.inputFramesRequired(static_cast<size_t>(std::max<Py_ssize_t>(outputFrames, 0))));
+}
+
+PyObject *Stretcher_reset(StretcherObject *self, PyObject *) {
+    if (!checkStretcher(self)) {
+        return nullptr;
+    }
+    auto &native = *self->native;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(native.mutex);
+        native.processor.reset();
+    }
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+PyObject *Stretcher_endpoints(StretcherObject *self, PyObject *) {
+    if (!checkStretcher(self)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(self->native->mutex);
+    return listOf(self->native->processor.describeEndpoints(),
+                  [](const TimeStretchPitchProcessor::EndpointDescriptor &endpoint) {
+                      return endpointDict(endpoint.id, endpoint.label, endpoint.integer ? "integer" : "slider",
+                                          endpoint.minimum, endpoint.maximum, endpoint.defaultValue,
+                                          endpoint.description);
+                  });
+}
+
+PyObject *Stretcher_get_tempo_ratio(StretcherObject *self, void *) {
+    if (!checkStretcher(self)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(self->native->mutex);
+    return PyFloat_FromDouble(self->native->processor.getParameters().tempoRatio);
+}
+
+PyObject *Stretcher_get_pitch_semitones(StretcherObject *self, void *) {
+    if (!checkStretcher(self)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(self->native->mutex);
+    return PyFloat_FromDouble(self->native->processor.getParameters().pitchSemitones);
+}
+
+PyObject *Stretcher_get_latency_samples(StretcherObject *self, void *) {
+    return checkStretcher(self) ? PyLong_FromSize_t(self->native->processor.getLatencySamples()) : nullptr;
+}
+
+PyObject *Stretcher_get_channels(StretcherObject *self, void *) {
+    return checkStretcher(self) ? PyLong_FromLong(self->native->processor.channelCount()) : nullptr;
+}
+
+PyObject *Stretcher_get_sample_rate(StretcherObject *self, void *) {
+    return checkStretcher(self) ? PyFloat_FromDouble(self->native->processor.sampleRate()) : nullptr;
+}
+
+PyObject *Stretcher_get_max_block_frames(StretcherObject *self, void *) {
+    return checkStretcher(self) ? PyLong_FromSize_t(self->native->processor.maxBlockFrames()) : nullptr;
+}
+
+PyMethodDef Stretcher_methods[] = {
+    {"process", reinterpret_cast<PyCFunction>(Stretcher_process), METH_VARARGS,
+     "process(input, output) -> int\n\nStretches interleaved float32 `input` into the writable float32 buffer "
+     "`output` and returns the frames written. Output beyond the buffer stays queued for the next call."},
+    {"set_parameters", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(Stretcher_set_parameters)),
+     METH_VARARGS | METH_KEYWORDS,
+     "set_parameters(tempo_ratio=None, pitch_semitones=None)\n\n`tempo_ratio` is a time ratio (output length over "
+     "input length)."},
+    {"input_frames_required", reinterpret_cast<PyCFunction>(Stretcher_input_frames_required), METH_VARARGS,
+     "input_frames_required(output_frames) -> int"},
+    {"reset", reinterpret_cast<PyCFunction>(Stretcher_reset), METH_NOARGS, "Clears the stretcher."},
+    {"endpoints", reinterpret_cast<PyCFunction>(Stretcher_endpoints), METH_NOARGS,
+     "Control endpoint descriptors as dicts."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyGetSetDef Stretcher_getset[] = {
+    {"tempo_ratio", reinterpret_cast<getter>(Stretcher_get_tempo_ratio), nullptr, nullptr, nullptr},
+    {"pitch_semitones", reinterpret_cast<getter>(Stretcher_get_pitch_semitones), nullptr, nullptr, nullptr},
+    {"latency_samples", reinterpret_cast<getter>(Stretcher_get_latency_samples), nullptr, nullptr, nullptr},
+    {"channels", reinterpret_cast<getter>(Stretcher_get_channels), nullptr, nullptr, nullptr},
+    {"sample_rate", reinterpret_cast<getter>(Stretcher_get_sample_rate), nullptr, nullptr, nullptr},
+    {"max_block_frames", reinterpret_cast<getter>(Stretcher_get_max_block_frames), nullptr, nullptr, nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+PyType_Slot Stretcher_slots[] = {
+    {Py_tp_doc, const_cast<char *>("TimeStretchPitchProcessor(sample_rate, channels, tempo_ratio=1.0, "
+                                   "pitch_semitones=0.0, max_block_frames=1024, single_threaded=True)\n\n"
+                                   "`tempo_ratio` is a time ratio: 2.0 plays at half speed.")},
+    {Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew)},
+    {Py_tp_init, reinterpret_cast<void *>(Stretcher_init)},
+    {Py_tp_dealloc, reinterpret_cast<void *>(Stretcher_dealloc)},
+    {Py_tp_methods, Stretcher_methods},
+    {Py_tp_getset, Stretcher_getset},
+    {0, nullptr},
+};
+
+PyType_Spec Stretcher_spec = {"deejay._native.TimeStretchPitchProcessor", sizeof(StretcherObject), 0,
+                              Py_TPFLAGS_DEFAULT, Stretcher_slots};
+
+// LatencyCompensatedProcessor --------------------------------------------------------------------------------
+
+struct Compensated {
+    Compensated(double sampleRate, int channels, TimeStretchPitchProcessor::Options options)
+        : processor(sampleRate, channels, options), channels(channels) {}
+
+    // Held by process(), pull() and reset(), the processor's audio-thread side. Control writes go through its
+    // lock-free queue under the GIL, which keeps them single-producer.
+    std::mutex mutex;
+    LatencyCompensatedProcessor processor;
+    int channels{0};
+    size_t maxBlockFrames{0};
+};
+
+struct CompensatedObject {
+    PyObject_HEAD
+    Compensated *native;
+};
+
+int Compensated_init(CompensatedObject *self, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"sample_rate", "channels", "max_block_frames", "single_threaded", nullptr};
+    double sampleRate = 0.0;
+    int channels = 0;
+    Py_ssize_t maxBlockFrames = kDefaultMaxBlockFrames;
+    int singleThreaded = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "di|np", const_cast<char **>(keywords), &sampleRate, &channels,
+                                     &maxBlockFrames, &singleThreaded)) {
+        return -1;
+    }
+    if (!validateFormat(sampleRate, channels, maxBlockFrames)) {
+        return -1;
+    }
+
+    TimeStretchPitchProcessor::Options options;
+    options.singleThreaded = singleThreaded != 0;
+    try {
+        auto native = std::make_unique<Compensated>(sampleRate, channels, options);
+        native->maxBlockFrames = static_cast<size_t>(maxBlockFrames);
+        native->processor.prepare(native->maxBlockFrames);
+        delete self->native;
+        self->native = native.release();
+    } catch (const std::exception &error) {
+        setPythonError(error);
+        return -1;
+    }
+    return 0;
+}
+
+void Compensated_dealloc(CompensatedObject *self) {
+    delete self->native;
+    PyTypeObject *type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+bool checkCompensated(CompensatedObject *self) {
+    if (!self->native) {
+        PyErr_SetString(PyExc_RuntimeError, "LatencyCompensatedProcessor.__init__ was not called");
+        return false;
+    }
+    return true;
+}
+
+PyObject *Compensated_process(CompensatedObject *self, PyObject *args) {
+    PyObject *inputObject = nullptr;
+    PyObject *outputObject = nullptr;
+    if (!PyArg_ParseTuple(args, "OO:process", &inputObject, &outputObject) || !checkCompensated(self)) {
+        return nullptr;
+    }
+    auto &native = *self->native;
+    FloatBuffer input;
+    FloatBuffer output;
+    if (!input.acquire(inputObject, false, native.channels, "input") ||
+        !output.acquire(outputObject, true, native.channels, "output")) {
+        return nullptr;
+    }
+
+    size_t written = 0;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(native.mutex);
+        const auto samplesPerFrame = static_cast<size_t>(native.channels);
+        for (size_t offset = 0; offset < input.frames(); offset += native.maxBlockFrames) {
+            const size_t frames = std::min(native.maxBlockFrames, input.frames() - offset);
+            written += native.processor.processBlock(input.data() + offset * samplesPerFrame, frames,
+                                                     output.data() + written * samplesPerFrame,
+                                                     output.frames() - written, SampleLayout::Interleaved);
+        }
+    }
+    Py_END_ALLOW_THREADS
+    return PyLong_FromSize_t(written);
+}
+
+PyObject *Compensated_pull(CompensatedObject *self, PyObject *args) {
+    PyObject *trackObject = nullptr;
+    unsigned long long position = 0;
+    PyObject *outputObject = nullptr;
+    if (!PyArg_ParseTuple(args, "OKO:pull", &trackObject, &position, &outputObject) || !checkCompensated(self)) {
+        return nullptr;
+    }
+    auto &native = *self->native;
+    FloatBuffer track;
+    FloatBuffer output;
+    if (!track.acquire(trackObject, false, native.channels, "track") ||
+        !output.acquire(outputObject, true, native.channels, "output")) {
+        return nullptr;
+    }
+
+    // Fills the whole output, block by block.
+    size_t rendered = 0;
+    uint64_t next = 0;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(native.mutex);
+        BufferSource source(track.data(), track.frames(), position, native.channels);
+        const auto samplesPerFrame = static_cast<size_t>(native.channels);
+        for (size_t offset = 0; offset < output.frames(); offset += native.maxBlockFrames) {
+            const size_t frames = std::min(native.maxBlockFrames, output.frames() - offset);
+            rendered += native.processor.pull(source, output.data() + offset * samplesPerFrame, frames);
+        }
+        next = source.position();
+    }
+    Py_END_ALLOW_THREADS
+    return Py_BuildValue("(nK)", static_cast<Py_ssize_t>(rendered), static_cast<unsigned long long>(next));
+}
+
+const struct {
+    const char *name;
+    LatencyCompensatedProcessor::ControlId id;
+} kControlNames[] = {
+    {"tempo", LatencyCompensatedProcessor::ControlId::TempoRatio},
+    {"pitch", LatencyCompensatedProcessor::ControlId::PitchSemitones},
+    {"manualLatency", LatencyCompensatedProcessor::ControlId::ManualLatency},
+    {"jogTouch", LatencyCompensatedProcessor::ControlId::JogTouch},
+    {"jogRate", LatencyCompensatedProcessor::ControlId::JogRate},
+};
+
+PyObject *Compensated_post_control(CompensatedObject *self, PyObject *args) {
+    const char *name = nullptr;
+    double value = 0.0;
+    if (!PyArg_ParseTuple(args, "sd:post_control", &name, &value) || !checkCompensated(self)) {
+        return nullptr;
+    }
+    for (const auto &control : kControlNames) {
+        if (std::strcmp(control.name, name) == 0) {
+            return PyBool_FromLong(self->native->processor.postControl(control.id, value));
+        }
+    }
+    PyErr_Format(PyExc_KeyError, "unknown control '%s'", name);
+    return nullptr;
+}
+
+PyObject *Compensated_update_controls(CompensatedObject *self, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"tempo_ratio", "pitch_semitones", "manual_latency_samples", nullptr};
+    if (!checkCompensated(self)) {
+        return nullptr;
+    }
+    auto controls = self->native->processor.currentControls();
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ddi:update_controls", const_cast<char **>(keywords),
+                                     &controls.tempoRatio, &controls.pitchSemitones, &controls.manualLatencySamples)) {
+        return nullptr;
+    }
+    if (controls.tempoRatio <= 0.0) {
+        PyErr_SetString(PyExc_ValueError, "tempo_ratio must be positive");
+        return nullptr;
+    }
+    self->native->processor.updateControls(controls);
+    Py_RETURN_NONE;
+}
+
+PyObject *Compensated_reset(CompensatedObject *self, PyObject *) {
+    if (!checkCompensated(self)) {
+        return nullptr;
+    }
+    auto &native = *self->native;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(native.mutex);
+        native.processor.reset();
+    }
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+PyObject *Compensated_control_endpoints(CompensatedObject *self, PyObject *) {
+    if (!checkCompensated(self)) {
+        return nullptr;
+    }
+    return listOf(self->native->processor.controlEndpoints(),
+                  [](const LatencyCompensatedProcessor::ControlEndpoint &endpoint) {
+                      return endpointDict(endpoint.id, endpoint.label, endpoint.type.c_str(), endpoint.minimum,
+                                          endpoint.maximum, endpoint.defaultValue, endpoint.description);
+                  });
+}
+
+PyObject *Compensated_get_controls(CompensatedObject *self, void *) {
+    if (!checkCompensated(self)) {
+        return nullptr;
+    }
+    const auto controls = self->native->processor.currentControls();
+    return Py_BuildValue("{s:d,s:d,s:i}", "tempo_ratio", controls.tempoRatio, "pitch_semitones",
+                         controls.pitchSemitones, "manual_latency_samples", controls.manualLatencySamples);
+}
+
+PyObject *Compensated_get_total_latency_samples(CompensatedObject *self, void *) {
+    return checkCompensated(self) ? PyLong_FromSize_t(self->native->processor.totalLatencySamples()) : nullptr;
+}
+
+PyObject *Compensated_get_jog_active(CompensatedObject *self, void *) {
+    return checkCompensated(self) ? PyBool_FromLong(self->native->processor.jogActive()) : nullptr;
+}
+
+PyObject *Compensated_get_channels(CompensatedObject *self, void *) {
+    return checkCompensated(self) ? PyLong_FromLong(self->native->channels) : nullptr;
+}
+
+PyObject *Compensated_get_max_block_frames(CompensatedObject *self, void *) {
+    return checkCompensated(self) ? PyLong_FromSize_t(self->native->maxBlockFrames) : nullptr;
+}
+
+PyMethodDef Compensated_methods[] = {
+    {"process", reinterpret_cast<PyCFunction>(Compensated_process), METH_VARARGS,
+     "process(input, output) -> int\n\nPush mode: processes interleaved float32 `input` into the writable "
+     "float32 buffer `output`, latency priming included, and returns the frames written."},
+    {"pull", reinterpret_cast<PyCFunction>(Compensated_pull), METH_VARARGS,
+     "pull(track, position, output) -> (frames, position)\n\nPull mode: fills `output` from the interleaved "
+     "float32 `track`, starting at frame `position`, without copying the track. Past the end of the track the "
+     "stretcher is fed silence, which flushes its tail out. Returns the frames rendered (short only if the "
+     "stretcher fell behind) and the frame the next pull starts from."},
+    {"post_control", reinterpret_cast<PyCFunction>(Compensated_post_control), METH_VARARGS,
+     "post_control(endpoint_id, value) -> bool\n\nQueues a write to one of control_endpoints(); False when the "
+     "queue was full."},
+    {"update_controls", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(Compensated_update_controls)),
+     METH_VARARGS | METH_KEYWORDS, "update_controls(tempo_ratio=None, pitch_semitones=None, "
+                                   "manual_latency_samples=None)\n\n`tempo_ratio` is a time ratio: 2.0 plays at "
+                                   "half speed, so a deck's playback speed s is 1 / s."},
+    {"reset", reinterpret_cast<PyCFunction>(Compensated_reset), METH_NOARGS,
+     "Clears the stretcher and re-primes latency compensation, as on a seek."},
+    {"control_endpoints", reinterpret_cast<PyCFunction>(Compensated_control_endpoints), METH_NOARGS,
+     "Control endpoint descriptors as dicts."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyGetSetDef Compensated_getset[] = {
+    {"controls", reinterpret_cast<getter>(Compensated_get_controls), nullptr, nullptr, nullptr},
+    {"total_latency_samples", reinterpret_cast<getter>(Compensated_get_total_latency_samples), nullptr, nullptr,
+     nullptr},
+    {"jog_active", reinterpret_cast<getter>(Compensated_get_jog_active), nullptr, nullptr, nullptr},
+    {"channels", reinterpret_cast<getter>(Compensated_get_channels), nullptr, nullptr, nullptr},
+    {"max_block_frames", reinterpret_cast<getter>(Compensated_get_max_block_frames), nullptr, nullptr, nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+PyType_Slot Compensated_slots[] = {
+    {Py_tp_doc, const_cast<char *>("LatencyCompensatedProcessor(sample_rate, channels, max_block_frames=1024, "
+                                   "single_threaded=True)")},
+    {Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew)},
+    {Py_tp_init, reinterpret_cast<void *>(Compensated_init)},
+    {Py_tp_dealloc, reinterpret_cast<void *>(Compensated_dealloc)},
+    {Py_tp_methods, Compensated_methods},
+    {Py_tp_getset, Compensated_getset},
+    {0, nullptr},
+};
+
+PyType_Spec Compensated_spec = {"deejay._native.LatencyCompensatedProcessor", sizeof(CompensatedObject), 0,
+                                Py_TPFLAGS_DEFAULT, Compensated_slots};
+
+// Module -----------------------------------------------------------------------------------------------------
+
+// Decodes a whole WAV file with WavFileReader, without the GIL.
+PyObject *read_wav(PyObject *, PyObject *args) {
+    PyObject *pathObject = nullptr;
+    if (!PyArg_ParseTuple(args, "O&:read_wav", PyUnicode_FSConverter, &pathObject)) {
+        return nullptr;
+    }
+    const std::string path = PyBytes_AS_STRING(pathObject);
+    Py_DECREF(pathObject);
+
+    double sampleRate = 0.0;
+    int channels = 0;
+    std::vector<float> samples;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        deejay::WavFileReader reader(path);
+        sampleRate = reader.sampleRate();
+        channels = reader.channelCount();
+        samples.resize(static_cast<size_t>(reader.totalFrames()) * static_cast<size_t>(channels));
+        const size_t frames = reader.readFrames(samples.data(), static_cast<size_t>(reader.totalFrames()));
+        samples.resize(frames * static_cast<size_t>(channels));
+    } catch (const std::exception &exception) {
+        error = exception.what();
+    }
+    Py_END_ALLOW_THREADS
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_ValueError, error.c_str());
+        return nullptr;
+    }
+
+    PyObject *data = PyByteArray_FromStringAndSize(reinterpret_cast<const char *>(samples.data()),
+                                                   static_cast<Py_ssize_t>(samples.size() * sizeof(float)));
+    if (!data) {
+        return nullptr;
+    }
+    return Py_BuildValue("(diN)", sampleRate, channels, data);
+}
+
+PyMethodDef moduleMethods[] = {
+    {"read_wav", read_wav, METH_VARARGS,
+     "read_wav(path) -> (sample_rate, channels, bytearray)\n\nDecodes a 16/24/32-bit PCM or float WAV file to "
+     "interleaved float32; view the samples with memoryview(data).cast('f')."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+int addType(PyObject *module, PyType_Spec *spec, const char *name) {
+    PyObject *type = PyType_FromSpec(spec);
+    if (!type) {
+        return -1;
+    }
+    if (PyModule_AddObject(module, name, type) != 0) {
+        Py_DECREF(type);
+        return -1;
+    }
+    return 0;
+}
+
+PyModuleDef moduleDefinition = {
+    PyModuleDef_HEAD_INIT, "deejay._native",
+    "Native tempo/pitch processing for the deejay package; see src/PythonModule.cpp.", -1, moduleMethods,
+    nullptr, nullptr, nullptr, nullptr,
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit__native() {
+    PyObject *module = PyModule_Create(&moduleDefinition);
+    if (!module) {
+        return nullptr;
+    }
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    const int rubberBand = 1;
+#else
+    const int rubberBand = 0;
+#endif
+    if (addType(module, &Stretcher_spec, "TimeStretchPitchProcessor") != 0 ||
+        addType(module, &Compensated_spec, "LatencyCompensatedProcessor") != 0 ||
+        PyModule_AddIntConstant(module, "HAVE_RUBBERBAND", rubberBand) != 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
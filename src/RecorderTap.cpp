@@ -0,0 +1,201 @@
+#include "RecorderTap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+
+namespace deejay {
+
+namespace {
+constexpr auto kWriterIdleSleep = std::chrono::milliseconds(20);
+
+void writeJsonString(std::ostringstream &json, const std::string &text) {
+    json << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            json << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            json << ' ';
+        } else {
+            json << c;
+        }
+    }
+    json << '"';
+}
+}
+
+RecorderTap::RecorderTap(Settings settings)
+    : settings_(settings),
+      ring_(static_cast<size_t>(std::max(settings.bufferSeconds, 0.1) * std::max(settings.sampleRate, 1.0)) *
+            static_cast<size_t>(std::max(settings.channelCount, 1))) {
+    if (settings_.channelCount <= 0 || settings_.sampleRate <= 0.0) {
+        throw std::runtime_error("RecorderTap needs a positive channel count and sample rate");
+    }
+    settings_.chunkFrames = std::max<size_t>(settings_.chunkFrames, 1);
+    settings_.framesPerPreviewPeak = std::max<size_t>(settings_.framesPerPreviewPeak, 1);
+    writer_ = std::make_unique<WavFileWriter>(settings_.path, settings_.sampleRate, settings_.channelCount);
+    chunk_.resize(settings_.chunkFrames * static_cast<size_t>(settings_.channelCount));
+    running_.store(true, std::memory_order_relaxed);
+    thread_ = std::thread([this] { run(); });
+}
+
+RecorderTap::~RecorderTap() { stop(); }
+
+void RecorderTap::capture(const float *interleaved, size_t frames) noexcept {
+    if (failed_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const size_t samples = frames * static_cast<size_t>(settings_.channelCount);
+    if (ring_.writeAvailable() < samples) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+        overrunFrames_.fetch_add(frames, std::memory_order_relaxed);
+        return;
+    }
+    ring_.write(interleaved, samples);
+    framesCaptured_.fetch_add(frames, std::memory_order_relaxed);
+}
+
+void RecorderTap::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    running_.store(false, std::memory_order_relaxed);
+    thread_.join();
+    try {
+        writer_->close();
+    } catch (const std::exception &ex) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = ex.what();
+        failed_.store(true, std::memory_order_relaxed);
+    }
+}
+
+std::string RecorderTap::error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+void RecorderTap::run() {
+    const size_t chunkSamples = chunk_.size();
+    for (;;) {
+        const bool running = running_.load(std::memory_order_relaxed);
+        // Wait for a full chunk while recording; after stop(), flush whatever is left.
+        if (running && ring_.readAvailable() < chunkSamples) {
+            std::this_thread::sleep_for(kWriterIdleSleep);
+            continue;
+        }
+        if (writeChunk() == 0 && !running) {
+            return;
+        }
+    }
+}
+
+size_t RecorderTap::writeChunk() {
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    const size_t frames = ring_.read(chunk_.data(), chunk_.size()) / channels;
+    if (frames == 0 || failed_.load(std::memory_order_relaxed)) {
+        return frames;
+    }
+    try {
+        writer_->writeFrames(chunk_.data(), frames);
+    } catch (const std::exception &ex) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = ex.what();
+        failed_.store(true, std::memory_order_relaxed);
+        return frames;
+    }
+    framesWritten_.fetch_add(frames, std::memory_order_relaxed);
+    updatePreview(chunk_.data(), frames);
+    return frames;
+}
+
+void RecorderTap::updatePreview(const float *interleaved, size_t frames) {
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    const float scale = 1.0f / static_cast<float>(channels);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t frame = 0; frame < frames; ++frame) {
+        float sum = 0.0f;
+        for (size_t ch = 0; ch < channels; ++ch) {
+            sum += interleaved[frame * channels + ch];
+        }
+        currentPeak_ = std::max(currentPeak_, std::abs(sum * scale));
+        if (++currentPeakFrames_ == settings_.framesPerPreviewPeak) {
+            previewPeaks_.push_back(currentPeak_);
+            currentPeak_ = 0.0f;
+            currentPeakFrames_ = 0;
+        }
+    }
+}
+
+std::vector<float> RecorderTap::preview(size_t buckets) const {
+    std::vector<float> result(buckets, 0.0f);
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<float> peaks = previewPeaks_;
+    if (currentPeakFrames_ > 0) {
+        peaks.push_back(currentPeak_);
+    }
+    if (buckets == 0 || peaks.empty()) {
+        return result;
+    }
+
+    // Same slicing as numpy.array_split: the first (count % buckets) slices hold one peak more.
+    const size_t count = peaks.size();
+    const size_t base = count / buckets;
+    const size_t extra = count % buckets;
+    size_t start = 0;
+    float maximum = 0.0f;
+    for (size_t b = 0; b < buckets; ++b) {
+        const size_t length = base + (b < extra ? 1 : 0);
+        for (size_t i = start; i < start + length; ++i) {
+            result[b] = std::max(result[b], peaks[i]);
+        }
+        maximum = std::max(maximum, result[b]);
+        start += length;
+    }
+    if (maximum == 0.0f) {
+        std::fill(result.begin(), result.end(), 0.0f);
+        return result;
+    }
+    for (auto &value : result) {
+        value /= maximum;
+    }
+    return result;
+}
+
+RecorderTap::Report RecorderTap::report(size_t previewBuckets) const {
+    Report report;
+    report.path = settings_.path;
+    report.sampleRate = settings_.sampleRate;
+    report.channelCount = settings_.channelCount;
+    report.framesWritten = framesWritten();
+    report.overruns = overruns();
+    report.overrunFrames = overrunFrames();
+    report.error = error();
+    report.preview = preview(previewBuckets);
+    return report;
+}
+
+std::string RecorderTap::toJson(const Report &report) {
+    std::ostringstream json;
+    json << "{\"type\":\"recording\",\"path\":";
+    writeJsonString(json, report.path);
+    json << ",\"sampleRate\":" << report.sampleRate
+         << ",\"channels\":" << report.channelCount
+         << ",\"frames\":" << report.framesWritten
+         << ",\"duration\":" << static_cast<double>(report.framesWritten) / report.sampleRate
+         << ",\"overruns\":" << report.overruns
+         << ",\"overrunFrames\":" << report.overrunFrames
+         << ",\"error\":";
+    writeJsonString(json, report.error);
+    json << ",\"preview\":[";
+    for (size_t i = 0; i < report.preview.size(); ++i) {
+        json << (i > 0 ? "," : "") << report.preview[i];
+    }
+    json << "]}";
+    return json.str();
+}
+
+} // namespace deejay
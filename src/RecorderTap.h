@@ -0,0 +1,104 @@
+#pragma once
+
+#include "SpscRingBuffer.h"
+#include "WavFileWriter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace deejay {
+
+// Records the master output to disk without file I/O on the audio thread. The callback copies each mixed block
+// into a large lock-free ring; a writer thread drains it in big chunks into a float32 WAV file and builds the
+// waveform preview src/deejay/recorder.py computes, incrementally as the audio arrives. A block that does not
+// fit in the ring is dropped whole and counted as an overrun, so the file only ever misses complete blocks.
+class RecorderTap {
+public:
+    struct Settings {
+        std::string path;
+        double sampleRate{48'000.0};
+        int channelCount{2};
+        // Ring capacity; covers writer stalls (disk hiccups, page cache flushes) of up to this long.
+        double bufferSeconds{10.0};
+        // Frames handed to the file per write once that many are buffered.
+        size_t chunkFrames{16'384};
+        // Frames per preview peak; preview() reduces these peaks to its buckets.
+        size_t framesPerPreviewPeak{1'024};
+    };
+
+    // Creates the file and starts the writer thread. Throws std::runtime_error when the file cannot be created.
+    explicit RecorderTap(Settings settings);
+    ~RecorderTap();
+
+    RecorderTap(const RecorderTap &) = delete;
+    RecorderTap &operator=(const RecorderTap &) = delete;
+
+    // Audio thread: queues `frames` interleaved frames of the master output. Never blocks or allocates.
+    void capture(const float *interleaved, size_t frames) noexcept;
+
+    // Writes everything still buffered, finalizes the file and joins the writer. Idempotent; capture() must not
+    // run concurrently with or after it.
+    void stop();
+
+    uint64_t framesCaptured() const noexcept { return framesCaptured_.load(std::memory_order_relaxed); }
+    uint64_t framesWritten() const noexcept { return framesWritten_.load(std::memory_order_relaxed); }
+    // Blocks dropped because the ring was full, and the frames they held.
+    uint64_t overruns() const noexcept { return overruns_.load(std::memory_order_relaxed); }
+    uint64_t overrunFrames() const noexcept { return overrunFrames_.load(std::memory_order_relaxed); }
+
+    // Empty while recording works; otherwise the write error that stopped the file.
+    std::string error() const;
+
+    // Peak-normalized absolute amplitude of the channel mean in `buckets` equal slices of the recording so far,
+    // as recorder.py's _compute_preview(); all zeros for a silent or empty recording. Safe from any thread.
+    std::vector<float> preview(size_t buckets = 200) const;
+
+    const Settings &settings() const noexcept { return settings_; }
+
+    struct Report {
+        std::string path;
+        double sampleRate{0.0};
+        int channelCount{0};
+        uint64_t framesWritten{0};
+        uint64_t overruns{0};
+        uint64_t overrunFrames{0};
+        std::string error;
+        std::vector<float> preview;
+    };
+    Report report(size_t previewBuckets = 200) const;
+    // One JSON line ({"type":"recording",...}) for the shell to store the take and its preview.
+    static std::string toJson(const Report &report);
+
+private:
+    void run();
+    // Writes up to one chunk from the ring; returns the frames written.
+    size_t writeChunk();
+    void updatePreview(const float *interleaved, size_t frames);
+
+    Settings settings_;
+    std::unique_ptr<WavFileWriter> writer_;
+    SpscRingBuffer<float> ring_;
+    std::vector<float> chunk_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> failed_{false};
+    std::atomic<uint64_t> framesCaptured_{0};
+    std::atomic<uint64_t> framesWritten_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> overrunFrames_{0};
+
+    // Writer thread state for the preview, guarded by mutex_ together with error_.
+    mutable std::mutex mutex_;
+    std::string error_;
+    std::vector<float> previewPeaks_;
+    float currentPeak_{0.0f};
+    size_t currentPeakFrames_{0};
+};
+
+} // namespace deejay
@@ -0,0 +1,290 @@
+#include "SamplerEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define DEEJAY_SAMPLER_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifdef DEEJAY_HAVE_SQLITE3
+#include <sqlite3.h>
+#endif
+
+namespace deejay {
+
+namespace {
+
+// out[i] += in[i] * (gain + step * i). The gain is computed from the index rather than accumulated, so the vector
+// body and the scalar tail stay on the same ramp.
+void addRamp(const float *in, float *out, size_t count, float gain, float step) noexcept {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 slope = _mm256_set1_ps(step);
+    const __m256 offset = _mm256_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        const __m256 index = _mm256_add_ps(lanes, _mm256_set1_ps(static_cast<float>(i)));
+        const __m256 gains = _mm256_add_ps(offset, _mm256_mul_ps(slope, index));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), gains)));
+    }
+#elif defined(DEEJAY_SAMPLER_SSE2)
+    const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 slope = _mm_set1_ps(step);
+    const __m128 offset = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 index = _mm_add_ps(lanes, _mm_set1_ps(static_cast<float>(i)));
+        const __m128 gains = _mm_add_ps(offset, _mm_mul_ps(slope, index));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), gains)));
+    }
+#elif defined(__ARM_NEON)
+    const float laneValues[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    const float32x4_t lanes = vld1q_f32(laneValues);
+    const float32x4_t slope = vdupq_n_f32(step);
+    const float32x4_t offset = vdupq_n_f32(gain);
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t index = vaddq_f32(lanes, vdupq_n_f32(static_cast<float>(i)));
+        const float32x4_t gains = vaddq_f32(offset, vmulq_f32(slope, index));
+        vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), vmulq_f32(vld1q_f32(in + i), gains)));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] += in[i] * (gain + step * static_cast<float>(i));
+    }
+}
+
+size_t envelopeFrames(double milliseconds, double sampleRate) {
+    return std::max<size_t>(1, static_cast<size_t>(milliseconds * sampleRate / 1000.0));
+}
+
+} // namespace
+
+SamplerEngine::SamplerEngine(Settings settings)
+    : settings_(settings), attackFrames_(envelopeFrames(settings.attackMs, settings.sampleRate)),
+      releaseFrames_(envelopeFrames(settings.releaseMs, settings.sampleRate)), voices_(settings.maxVoices),
+      triggers_(settings.triggerQueueCapacity), mix_(settings.maxBlockFrames, 0.0f),
+      output_(settings.maxBlockFrames * static_cast<size_t>(std::max(settings.channelCount, 0)), 0.0f) {
+    if (settings_.maxVoices == 0 || settings_.channelCount <= 0 || settings_.sampleRate <= 0.0) {
+        throw std::runtime_error("SamplerEngine needs at least one voice, one channel and a positive sample rate");
+    }
+    stopAll();
+}
+
+void SamplerEngine::loadSound(int32_t id, const float *mono, size_t frames, double sampleRate) {
+    std::vector<float> samples;
+    if (sampleRate <= 0.0 || sampleRate == settings_.sampleRate || frames < 2) {
+        samples.assign(mono, mono + frames);
+    } else {
+        // Linear interpolation is plenty for one-shots and keeps loading cheap; the pitch is what matters.
+        const double step = sampleRate / settings_.sampleRate;
+        const auto outFrames = static_cast<size_t>(std::ceil(static_cast<double>(frames - 1) / step)) + 1;
+        samples.resize(outFrames);
+        for (size_t i = 0; i < outFrames; ++i) {
+            const double position = std::min(static_cast<double>(i) * step, static_cast<double>(frames - 1));
+            const auto index = std::min(static_cast<size_t>(position), frames - 2);
+            const auto fraction = static_cast<float>(position - static_cast<double>(index));
+            samples[i] = mono[index] + (mono[index + 1] - mono[index]) * fraction;
+        }
+    }
+
+    const auto found = std::lower_bound(lookup_.begin(), lookup_.end(), id,
+                                        [](const std::pair<int32_t, size_t> &entry, int32_t key) { return entry.first < key; });
+    if (found != lookup_.end() && found->first == id) {
+        sounds_[found->second].samples = std::move(samples);
+        return;
+    }
+    lookup_.insert(found, {id, sounds_.size()});
+    sounds_.push_back(Sound{id, std::move(samples)});
+}
+
+size_t SamplerEngine::loadSounds(const std::string &databasePath) {
+#ifdef DEEJAY_HAVE_SQLITE3
+    sqlite3 *handle = nullptr;
+    const int opened = sqlite3_open_v2(databasePath.c_str(), &handle, SQLITE_OPEN_READONLY, nullptr);
+    std::unique_ptr<sqlite3, int (*)(sqlite3 *)> database(handle, &sqlite3_close);
+    if (opened != SQLITE_OK) {
+        throw std::runtime_error("Failed to open sound database " + databasePath + ": " +
+                                 (handle ? sqlite3_errmsg(handle) : "out of memory"));
+    }
+
+    sqlite3_stmt *statement = nullptr;
+    if (sqlite3_prepare_v2(handle, "SELECT id, sample_rate, data FROM sounds", -1, &statement, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("Failed to query sounds in " + databasePath + ": " + sqlite3_errmsg(handle));
+    }
+    std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt *)> query(statement, &sqlite3_finalize);
+
+    size_t loaded = 0;
+    std::vector<float> samples;
+    int step = SQLITE_OK;
+    while ((step = sqlite3_step(statement)) == SQLITE_ROW) {
+        const auto id = static_cast<int32_t>(sqlite3_column_int(statement, 0));
+        const double sampleRate = sqlite3_column_double(statement, 1);
+        const void *blob = sqlite3_column_blob(statement, 2);
+        const auto bytes = static_cast<size_t>(sqlite3_column_bytes(statement, 2));
+        if (bytes % sizeof(float) != 0) {
+            throw std::runtime_error("Sound " + std::to_string(id) + " is not float32 PCM");
+        }
+        // The PCM is little-endian, as are all hosts the engine builds for.
+        samples.resize(bytes / sizeof(float));
+        if (bytes > 0) {
+            std::memcpy(samples.data(), blob, bytes);
+        }
+        loadSound(id, samples.data(), samples.size(), sampleRate);
+        ++loaded;
+    }
+    if (step != SQLITE_DONE) {
+        throw std::runtime_error("Failed to read sounds from " + databasePath + ": " + sqlite3_errmsg(handle));
+    }
+    return loaded;
+#else
+    throw std::runtime_error("Cannot load " + databasePath + ": this build has no SQLite support");
+#endif
+}
+
+const SamplerEngine::Sound *SamplerEngine::findSound(int32_t id) const noexcept {
+    const auto found = std::lower_bound(lookup_.begin(), lookup_.end(), id,
+                                        [](const std::pair<int32_t, size_t> &entry, int32_t key) { return entry.first < key; });
+    return found != lookup_.end() && found->first == id ? &sounds_[found->second] : nullptr;
+}
+
+bool SamplerEngine::trigger(int32_t id, float gain) { return triggers_.enqueue(id, gain); }
+
+bool SamplerEngine::start(int32_t id, float gain) noexcept {
+    const Sound *sound = findSound(id);
+    if (!sound) {
+        unknown_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    int index = free_;
+    if (index >= 0) {
+        free_ = voices_[static_cast<size_t>(index)].next;
+        activeCount_.store(activeCount_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    } else {
+        // Pool full: the list head is the voice that started first.
+        index = oldest_;
+        unlink(index);
+        stolen_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Voice &voice = voices_[static_cast<size_t>(index)];
+    voice.sound = sound;
+    voice.position = 0;
+    voice.gain = gain;
+    voice.previous = newest_;
+    voice.next = -1;
+    if (newest_ >= 0) {
+        voices_[static_cast<size_t>(newest_)].next = index;
+    } else {
+        oldest_ = index;
+    }
+    newest_ = index;
+    return true;
+}
+
+void SamplerEngine::stopAll() noexcept {
+    oldest_ = -1;
+    newest_ = -1;
+    free_ = -1;
+    for (size_t i = voices_.size(); i-- > 0;) {
+        voices_[i] = Voice{};
+        voices_[i].next = free_;
+        free_ = static_cast<int>(i);
+    }
+    activeCount_.store(0, std::memory_order_relaxed);
+}
+
+void SamplerEngine::unlink(int index) noexcept {
+    Voice &voice = voices_[static_cast<size_t>(index)];
+    if (voice.previous >= 0) {
+        voices_[static_cast<size_t>(voice.previous)].next = voice.next;
+    } else {
+        oldest_ = voice.next;
+    }
+    if (voice.next >= 0) {
+        voices_[static_cast<size_t>(voice.next)].previous = voice.previous;
+    } else {
+        newest_ = voice.previous;
+    }
+    voice.previous = -1;
+    voice.next = -1;
+}
+
+void SamplerEngine::release(int index) noexcept {
+    unlink(index);
+    Voice &voice = voices_[static_cast<size_t>(index)];
+    voice.sound = nullptr;
+    voice.next = free_;
+    free_ = index;
+    activeCount_.store(activeCount_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+bool SamplerEngine::renderVoice(Voice &voice, size_t frames) noexcept {
+    const std::vector<float> &samples = voice.sound->samples;
+    const size_t total = samples.size();
+    const size_t count = std::min(frames, total - std::min(voice.position, total));
+    const size_t releaseStart = total > releaseFrames_ ? total - releaseFrames_ : 0;
+    const float attackStep = 1.0f / static_cast<float>(attackFrames_);
+    const float releaseStep = 1.0f / static_cast<float>(releaseFrames_);
+
+    // The envelope is linear within the attack, sustain and release segments; render each as one ramp. As in
+    // sampler.py, the attack takes precedence where it overlaps the release of a very short sound.
+    size_t done = 0;
+    while (done < count) {
+        const size_t index = voice.position + done;
+        size_t length = count - done;
+        float gain = 1.0f;
+        float step = 0.0f;
+        if (index < attackFrames_) {
+            length = std::min(length, attackFrames_ - index);
+            gain = static_cast<float>(index) * attackStep;
+            step = attackStep;
+        } else if (index >= releaseStart) {
+            gain = static_cast<float>(total - index - 1) * releaseStep;
+            step = -releaseStep;
+        } else {
+            length = std::min(length, releaseStart - index);
+        }
+        addRamp(samples.data() + index, mix_.data() + done, length, gain * voice.gain, step * voice.gain);
+        done += length;
+    }
+    voice.position += count;
+    return voice.position < total;
+}
+
+void SamplerEngine::render(size_t frames) noexcept {
+    frames = std::min(frames, settings_.maxBlockFrames);
+    ParameterChange change;
+    while (triggers_.dequeue(change)) {
+        start(change.target, static_cast<float>(change.value));
+    }
+
+    std::fill(mix_.begin(), mix_.begin() + static_cast<std::ptrdiff_t>(frames), 0.0f);
+    for (int index = oldest_; index >= 0;) {
+        Voice &voice = voices_[static_cast<size_t>(index)];
+        const int next = voice.next;
+        if (!renderVoice(voice, frames)) {
+            release(index);
+        }
+        index = next;
+    }
+
+    const auto channels = static_cast<size_t>(settings_.channelCount);
+    float *out = output_.data();
+    for (size_t frame = 0; frame < frames; ++frame) {
+        for (size_t ch = 0; ch < channels; ++ch) {
+            out[frame * channels + ch] = mix_[frame];
+        }
+    }
+}
+
+} // namespace deejay
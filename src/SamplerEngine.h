@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ParameterQueue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace deejay {
+
+// Polyphonic one-shot sampler for the audio thread, the native counterpart of src/sampler.py. Sounds are mono
+// float32, converted to the engine rate once at load time and kept contiguous. Voices come from a fixed pool
+// linked in start order, so allocating, retiring and stealing the oldest voice are all O(1) and nothing
+// allocates while rendering. Every voice gets sampler.py's envelope: a linear attack from the first sample and a
+// linear release over the last samples of the sound.
+//
+// The rendered block is interleaved with all channels equal, ready to be one more input of the MixerBus.
+class SamplerEngine {
+public:
+    struct Settings {
+        double sampleRate{48'000.0};
+        int channelCount{2};
+        size_t maxVoices{8};
+        size_t maxBlockFrames{512};
+        double attackMs{2.0};
+        double releaseMs{8.0};
+        // Capacity of the control-thread trigger queue.
+        size_t triggerQueueCapacity{64};
+    };
+
+    explicit SamplerEngine(Settings settings);
+
+    // Loading is not realtime-safe and must finish before the stream starts: the audio thread reads the sound
+    // table without synchronization. Reloading an id replaces its sound.
+    void loadSound(int32_t id, const float *mono, size_t frames, double sampleRate);
+    // Loads every row of a sampler.py `sounds` table (id, sample_rate, data as little-endian float32 PCM).
+    // Returns the number of sounds loaded; throws std::runtime_error when the database cannot be read or the
+    // build has no SQLite support.
+    size_t loadSounds(const std::string &databasePath);
+    bool hasSound(int32_t id) const noexcept { return findSound(id) != nullptr; }
+    size_t soundCount() const noexcept { return sounds_.size(); }
+
+    // Control thread (single producer): starts `id` at the beginning of the next block. Returns false when the
+    // trigger queue is full. Use EventScheduler for a trigger on an exact frame.
+    bool trigger(int32_t id, float gain = 1.0f);
+
+    // Audio thread: starts `id` with the next rendered frame, stealing the oldest voice when the pool is full.
+    // Returns false for an unknown sound.
+    bool start(int32_t id, float gain) noexcept;
+    void stopAll() noexcept;
+
+    // Audio thread: renders `frames` (<= maxBlockFrames) frames of every active voice into output().
+    void render(size_t frames) noexcept;
+    const float *output() const noexcept { return output_.data(); }
+
+    size_t activeVoices() const noexcept { return activeCount_.load(std::memory_order_relaxed); }
+    uint64_t stolenVoices() const noexcept { return stolen_.load(std::memory_order_relaxed); }
+    uint64_t unknownSounds() const noexcept { return unknown_.load(std::memory_order_relaxed); }
+
+private:
+    struct Sound {
+        int32_t id{0};
+        std::vector<float> samples;
+    };
+
+    struct Voice {
+        const Sound *sound{nullptr};
+        size_t position{0};
+        float gain{1.0f};
+        // Neighbours in start order (active voices) or the next free voice; -1 ends the list.
+        int previous{-1};
+        int next{-1};
+    };
+
+    const Sound *findSound(int32_t id) const noexcept;
+    void unlink(int index) noexcept;
+    void release(int index) noexcept;
+    // Adds the voice's next `frames` samples, enveloped, to mix_; returns false once the sound has ended.
+    bool renderVoice(Voice &voice, size_t frames) noexcept;
+
+    Settings settings_;
+    size_t attackFrames_{1};
+    size_t releaseFrames_{1};
+    std::vector<Sound> sounds_;
+    // (id, index into sounds_), sorted by id.
+    std::vector<std::pair<int32_t, size_t>> lookup_;
+
+    std::vector<Voice> voices_;
+    int oldest_{-1};
+    int newest_{-1};
+    int free_{-1};
+    ParameterQueue triggers_;
+
+    std::vector<float> mix_;
+    std::vector<float> output_;
+    std::atomic<size_t> activeCount_{0};
+    std::atomic<uint64_t> stolen_{0};
+    std::atomic<uint64_t> unknown_{0};
+};
+
+} // namespace deejay
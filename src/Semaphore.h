@@ -0,0 +1,56 @@
+#pragma once
+
+#if defined(__linux__)
+#include <semaphore.h>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <cerrno>
+#include <climits>
+
+namespace deejay {
+
+// Counting semaphore on the native primitive. post() never blocks or allocates, so the audio thread may use it
+// to wake a helper thread.
+class Semaphore {
+public:
+#if defined(__linux__)
+    Semaphore() { sem_init(&semaphore_, 0, 0); }
+    ~Semaphore() { sem_destroy(&semaphore_); }
+    void post() noexcept { sem_post(&semaphore_); }
+    void wait() noexcept {
+        while (sem_wait(&semaphore_) != 0 && errno == EINTR) {
+        }
+    }
+
+private:
+    sem_t semaphore_;
+#elif defined(__APPLE__)
+    Semaphore() : semaphore_(dispatch_semaphore_create(0)) {}
+    ~Semaphore() { dispatch_release(semaphore_); }
+    void post() noexcept { dispatch_semaphore_signal(semaphore_); }
+    void wait() noexcept { dispatch_semaphore_wait(semaphore_, DISPATCH_TIME_FOREVER); }
+
+private:
+    dispatch_semaphore_t semaphore_;
+#elif defined(_WIN32)
+    Semaphore() : semaphore_(CreateSemaphoreA(nullptr, 0, LONG_MAX, nullptr)) {}
+    ~Semaphore() { CloseHandle(semaphore_); }
+    void post() noexcept { ReleaseSemaphore(semaphore_, 1, nullptr); }
+    void wait() noexcept { WaitForSingleObject(semaphore_, INFINITE); }
+
+private:
+    HANDLE semaphore_;
+#else
+#error "Semaphore needs an implementation for this platform"
+#endif
+
+public:
+    Semaphore(const Semaphore &) = delete;
+    Semaphore &operator=(const Semaphore &) = delete;
+};
+
+} // namespace deejay
@@ -0,0 +1,313 @@
+#include "SharedControlRegion.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace deejay {
+
+namespace {
+static_assert(sizeof(DeejaySharedHeader) == 64, "shared header layout changed");
+static_assert(sizeof(DeejayEndpoint) == 104, "shared endpoint layout changed");
+static_assert(sizeof(DeejayMeter) == 16, "shared meter layout changed");
+static_assert(sizeof(DeejayWaveformHeader) == 8, "shared waveform layout changed");
+// Fields other processes update are accessed through std::atomic overlays of the plain C fields.
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "32-bit atomics must be lock-free and unpadded to live in shared memory");
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t) && std::atomic<int32_t>::is_always_lock_free,
+              "32-bit atomics must be lock-free and unpadded to live in shared memory");
+
+constexpr size_t kAlignment = 8;
+
+uint64_t alignUp(uint64_t value) { return (value + kAlignment - 1) / kAlignment * kAlignment; }
+
+template <typename T>
+std::atomic<T> &atomicAt(const void *address) {
+    return *reinterpret_cast<std::atomic<T> *>(const_cast<void *>(address));
+}
+
+void storeFloat(void *address, float value) noexcept {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    atomicAt<uint32_t>(address).store(bits, std::memory_order_relaxed);
+}
+
+float loadFloat(const void *address) noexcept {
+    const uint32_t bits = atomicAt<uint32_t>(address).load(std::memory_order_relaxed);
+    float value = 0.0f;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Header for `layout`, with every offset filled in; totalBytes is 0 when the layout is invalid.
+DeejaySharedHeader headerFor(const DeejaySharedLayout &layout) noexcept {
+    DeejaySharedHeader header{};
+    if (layout.queueCapacity < 2 || layout.queueCapacity % 2 != 0 || layout.waveformPoints == 0 ||
+        layout.framesPerWaveformPoint == 0) {
+        return header;
+    }
+    header.magic = DEEJAY_SHARED_MAGIC;
+    header.version = DEEJAY_SHARED_VERSION;
+    header.deckCount = layout.deckCount;
+    header.endpointCount = layout.endpointCount;
+    header.queueCount = layout.deckCount + 1;
+    header.queueCapacity = layout.queueCapacity;
+    header.meterCount = layout.deckCount + 1;
+    header.waveformPoints = layout.waveformPoints;
+    header.framesPerWaveformPoint = layout.framesPerWaveformPoint;
+
+    // Computed in 64 bits so oversized layouts are rejected instead of wrapping.
+    const uint64_t queueStride = alignUp(8 + 12 * static_cast<uint64_t>(layout.queueCapacity));
+    const uint64_t waveformStride = alignUp(sizeof(DeejayWaveformHeader) + 4 * static_cast<uint64_t>(layout.waveformPoints));
+    const uint64_t endpointsOffset = sizeof(DeejaySharedHeader);
+    const uint64_t queuesOffset = alignUp(endpointsOffset + sizeof(DeejayEndpoint) * static_cast<uint64_t>(layout.endpointCount));
+    const uint64_t metersOffset = queuesOffset + queueStride * header.queueCount;
+    const uint64_t waveformsOffset = metersOffset + sizeof(DeejayMeter) * static_cast<uint64_t>(header.meterCount);
+    const uint64_t totalBytes = waveformsOffset + waveformStride * layout.deckCount;
+    if (totalBytes > std::numeric_limits<uint32_t>::max()) {
+        return DeejaySharedHeader{};
+    }
+    header.endpointsOffset = static_cast<uint32_t>(endpointsOffset);
+    header.queuesOffset = static_cast<uint32_t>(queuesOffset);
+    header.queueStride = static_cast<uint32_t>(queueStride);
+    header.metersOffset = static_cast<uint32_t>(metersOffset);
+    header.waveformsOffset = static_cast<uint32_t>(waveformsOffset);
+    header.waveformStride = static_cast<uint32_t>(waveformStride);
+    header.totalBytes = static_cast<uint32_t>(totalBytes);
+    return header;
+}
+} // namespace
+
+size_t SharedControlRegion::requiredBytes(const DeejaySharedLayout &layout) noexcept { return headerFor(layout).totalBytes; }
+
+int SharedControlRegion::initialize(void *memory, size_t bytes, const DeejaySharedLayout &layout,
+                                    const DeejayEndpoint *endpoints) noexcept {
+    const DeejaySharedHeader header = headerFor(layout);
+    if (header.totalBytes == 0 || (layout.endpointCount > 0 && !endpoints)) {
+        return DEEJAY_ERROR_BAD_LAYOUT;
+    }
+    if (!memory || bytes < header.totalBytes) {
+        return DEEJAY_ERROR_TOO_SMALL;
+    }
+    auto *base = static_cast<unsigned char *>(memory);
+    std::memset(base, 0, header.totalBytes);
+    if (layout.endpointCount > 0) {
+        std::memcpy(base + header.endpointsOffset, endpoints, sizeof(DeejayEndpoint) * layout.endpointCount);
+    }
+    // Write the magic last so a reader polling the region never sees a half-built one as valid.
+    DeejaySharedHeader published = header;
+    published.magic = 0;
+    std::memcpy(base, &published, sizeof(published));
+    atomicAt<uint32_t>(base).store(header.magic, std::memory_order_release);
+    return DEEJAY_OK;
+}
+
+int SharedControlRegion::validate(const void *memory, size_t bytes) noexcept {
+    if (!memory || bytes < sizeof(DeejaySharedHeader)) {
+        return DEEJAY_ERROR_TOO_SMALL;
+    }
+    if (atomicAt<uint32_t>(memory).load(std::memory_order_acquire) != DEEJAY_SHARED_MAGIC) {
+        return DEEJAY_ERROR_BAD_MAGIC;
+    }
+    DeejaySharedHeader header{};
+    std::memcpy(&header, memory, sizeof(header));
+    if (header.version != DEEJAY_SHARED_VERSION) {
+        return DEEJAY_ERROR_BAD_MAGIC;
+    }
+    const DeejaySharedLayout layout{header.deckCount, header.endpointCount, header.queueCapacity, header.waveformPoints,
+                                    header.framesPerWaveformPoint};
+    const DeejaySharedHeader expected = headerFor(layout);
+    if (expected.totalBytes == 0 || std::memcmp(&expected, &header, sizeof(header)) != 0) {
+        return DEEJAY_ERROR_BAD_LAYOUT;
+    }
+    return bytes < header.totalBytes ? DEEJAY_ERROR_TOO_SMALL : DEEJAY_OK;
+}
+
+SharedControlRegion SharedControlRegion::create(void *memory, size_t bytes, const DeejaySharedLayout &layout,
+                                                const std::vector<DeejayEndpoint> &endpoints) {
+    if (endpoints.size() != layout.endpointCount) {
+        throw std::runtime_error("Shared control region: endpoint count does not match the layout");
+    }
+    const int result = initialize(memory, bytes, layout, endpoints.data());
+    if (result == DEEJAY_ERROR_TOO_SMALL) {
+        throw std::runtime_error("Shared control region: buffer is too small for the layout");
+    }
+    if (result != DEEJAY_OK) {
+        throw std::runtime_error("Shared control region: invalid layout");
+    }
+    return SharedControlRegion(memory);
+}
+
+SharedControlRegion SharedControlRegion::attach(void *memory, size_t bytes) {
+    if (validate(memory, bytes) != DEEJAY_OK) {
+        throw std::runtime_error("Shared control region: memory does not hold a valid region");
+    }
+    return SharedControlRegion(memory);
+}
+
+int32_t SharedControlRegion::hashTarget(const char *key) noexcept {
+    // Wrapping 32-bit arithmetic, as `hash |= 0` does in JavaScript.
+    uint32_t hash = 0;
+    for (const char *c = key; *c; ++c) {
+        hash = (hash << 5) - hash + static_cast<unsigned char>(*c);
+    }
+    return static_cast<int32_t>(hash);
+}
+
+const DeejayEndpoint *SharedControlRegion::endpoints() const noexcept {
+    return reinterpret_cast<const DeejayEndpoint *>(base_ + header().endpointsOffset);
+}
+
+bool SharedControlRegion::push(uint32_t queue, int32_t target, double value) noexcept {
+    const auto &info = header();
+    if (queue >= info.queueCount) {
+        return false;
+    }
+    unsigned char *ring = base_ + info.queuesOffset + static_cast<size_t>(queue) * info.queueStride;
+    const auto capacity = static_cast<int32_t>(info.queueCapacity);
+    const int32_t head = atomicAt<int32_t>(ring).load(std::memory_order_acquire);
+    const int32_t tail = atomicAt<int32_t>(ring + 4).load(std::memory_order_relaxed);
+    const int32_t nextTail = (tail + 1) % capacity;
+    if (nextTail == head) {
+        return false;
+    }
+    std::memcpy(ring + 8 + 4 * static_cast<size_t>(tail), &target, sizeof(target));
+    std::memcpy(ring + 8 + 4 * static_cast<size_t>(capacity) + 8 * static_cast<size_t>(tail), &value, sizeof(value));
+    atomicAt<int32_t>(ring + 4).store(nextTail, std::memory_order_release);
+    return true;
+}
+
+bool SharedControlRegion::pop(uint32_t queue, ParameterChange &change) noexcept {
+    const auto &info = header();
+    if (queue >= info.queueCount) {
+        return false;
+    }
+    unsigned char *ring = base_ + info.queuesOffset + static_cast<size_t>(queue) * info.queueStride;
+    const auto capacity = static_cast<int32_t>(info.queueCapacity);
+    const int32_t head = atomicAt<int32_t>(ring).load(std::memory_order_relaxed);
+    const int32_t tail = atomicAt<int32_t>(ring + 4).load(std::memory_order_acquire);
+    // A producer in another process can leave anything in the indices; treat out-of-range ones as empty.
+    if (head == tail || head < 0 || head >= capacity) {
+        return false;
+    }
+    std::memcpy(&change.target, ring + 8 + 4 * static_cast<size_t>(head), sizeof(change.target));
+    std::memcpy(&change.value, ring + 8 + 4 * static_cast<size_t>(capacity) + 8 * static_cast<size_t>(head),
+                sizeof(change.value));
+    atomicAt<int32_t>(ring).store((head + 1) % capacity, std::memory_order_release);
+    return true;
+}
+
+void SharedControlRegion::writeMeter(uint32_t index, float peak, float rms) noexcept {
+    const auto &info = header();
+    if (index >= info.meterCount) {
+        return;
+    }
+    unsigned char *meter = base_ + info.metersOffset + sizeof(DeejayMeter) * index;
+    storeFloat(meter + offsetof(DeejayMeter, peak), peak);
+    storeFloat(meter + offsetof(DeejayMeter, rms), rms);
+    atomicAt<uint32_t>(meter + offsetof(DeejayMeter, updates)).fetch_add(1, std::memory_order_release);
+}
+
+bool SharedControlRegion::readMeter(uint32_t index, DeejayMeter &meter) const noexcept {
+    const auto &info = header();
+    if (index >= info.meterCount) {
+        return false;
+    }
+    const unsigned char *source = base_ + info.metersOffset + sizeof(DeejayMeter) * index;
+    meter.updates = atomicAt<uint32_t>(source + offsetof(DeejayMeter, updates)).load(std::memory_order_acquire);
+    meter.peak = loadFloat(source + offsetof(DeejayMeter, peak));
+    meter.rms = loadFloat(source + offsetof(DeejayMeter, rms));
+    meter.reserved = 0;
+    return true;
+}
+
+void SharedControlRegion::writeWaveformPoint(uint32_t deck, float peak) noexcept {
+    const auto &info = header();
+    if (deck >= info.deckCount) {
+        return;
+    }
+    unsigned char *ring = base_ + info.waveformsOffset + static_cast<size_t>(deck) * info.waveformStride;
+    auto &written = atomicAt<uint32_t>(ring + offsetof(DeejayWaveformHeader, pointsWritten));
+    const uint32_t point = written.load(std::memory_order_relaxed);
+    storeFloat(ring + sizeof(DeejayWaveformHeader) + 4 * static_cast<size_t>(point % info.waveformPoints), peak);
+    written.store(point + 1, std::memory_order_release);
+}
+
+uint32_t SharedControlRegion::readWaveform(uint32_t deck, float *points, uint32_t maxPoints) const noexcept {
+    const auto &info = header();
+    if (deck >= info.deckCount) {
+        return 0;
+    }
+    const unsigned char *ring = base_ + info.waveformsOffset + static_cast<size_t>(deck) * info.waveformStride;
+    const uint32_t written =
+        atomicAt<uint32_t>(ring + offsetof(DeejayWaveformHeader, pointsWritten)).load(std::memory_order_acquire);
+    const uint32_t count = std::min({maxPoints, written, info.waveformPoints});
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t point = written - count + i;
+        points[i] = loadFloat(ring + sizeof(DeejayWaveformHeader) + 4 * static_cast<size_t>(point % info.waveformPoints));
+    }
+    return count;
+}
+
+SharedMemoryFile::SharedMemoryFile(const std::string &path, size_t bytes) : bytes_(bytes) {
+#if defined(_WIN32)
+    fileHandle_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle_ == INVALID_HANDLE_VALUE) {
+        fileHandle_ = nullptr;
+        throw std::runtime_error("Unable to open shared memory file: " + path);
+    }
+    const auto size = static_cast<unsigned long long>(bytes);
+    mappingHandle_ = CreateFileMappingA(fileHandle_, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                        static_cast<DWORD>(size & 0xffffffffu), nullptr);
+    if (mappingHandle_) {
+        mapping_ = MapViewOfFile(mappingHandle_, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    }
+    if (!mapping_) {
+        if (mappingHandle_) {
+            CloseHandle(mappingHandle_);
+        }
+        CloseHandle(fileHandle_);
+        throw std::runtime_error("Unable to map shared memory file: " + path);
+    }
+#else
+    const int descriptor = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (descriptor < 0) {
+        throw std::runtime_error("Unable to open shared memory file: " + path);
+    }
+    if (ftruncate(descriptor, static_cast<off_t>(bytes)) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("Unable to size shared memory file: " + path);
+    }
+    void *mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    // The mapping keeps the file referenced after the descriptor is closed.
+    ::close(descriptor);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Unable to map shared memory file: " + path);
+    }
+    mapping_ = mapping;
+#endif
+}
+
+SharedMemoryFile::~SharedMemoryFile() {
+#if defined(_WIN32)
+    UnmapViewOfFile(mapping_);
+    CloseHandle(mappingHandle_);
+    CloseHandle(fileHandle_);
+#else
+    munmap(mapping_, bytes_);
+#endif
+}
+
+} // namespace deejay
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "EngineAbi.h"
+#include "ParameterQueue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace deejay {
+
+// C++ view of the shared control region laid out in EngineAbi.h. The view does not own the memory; it only
+// knows where the header, endpoints, rings, meters and waveforms sit inside it. Ring, meter and waveform
+// accessors are lock-free and realtime-safe.
+class SharedControlRegion {
+public:
+    // Bytes needed for a region with `layout`, or 0 when the layout is invalid.
+    static size_t requiredBytes(const DeejaySharedLayout &layout) noexcept;
+
+    // Lays out a fresh region in `memory`; `endpoints` holds layout.endpointCount entries. Returns DEEJAY_OK or
+    // one of the DEEJAY_ERROR codes, for the C ABI.
+    static int initialize(void *memory, size_t bytes, const DeejaySharedLayout &layout,
+                          const DeejayEndpoint *endpoints) noexcept;
+    static int validate(const void *memory, size_t bytes) noexcept;
+
+    // Throwing counterparts: lay out a new region, or attach to one that validates. Throw std::runtime_error.
+    static SharedControlRegion create(void *memory, size_t bytes, const DeejaySharedLayout &layout,
+                                      const std::vector<DeejayEndpoint> &endpoints);
+    static SharedControlRegion attach(void *memory, size_t bytes);
+
+    // Unchecked view for callers that validated the region already.
+    static SharedControlRegion view(void *memory) noexcept { return SharedControlRegion(memory); }
+
+    // ParameterQueue.hashTarget() from parameterQueue.ts.
+    static int32_t hashTarget(const char *key) noexcept;
+
+    const DeejaySharedHeader &header() const noexcept { return *reinterpret_cast<const DeejaySharedHeader *>(base_); }
+    const DeejayEndpoint *endpoints() const noexcept;
+
+    // Ring `queue`, in the parameterQueue.ts format. Each ring has one producer and one consumer. Both return
+    // false for an out-of-range ring.
+    bool push(uint32_t queue, int32_t target, double value) noexcept;
+    bool pop(uint32_t queue, ParameterChange &change) noexcept;
+
+    void writeMeter(uint32_t index, float peak, float rms) noexcept;
+    bool readMeter(uint32_t index, DeejayMeter &meter) const noexcept;
+
+    void writeWaveformPoint(uint32_t deck, float peak) noexcept;
+    // Newest points of `deck`, oldest first; returns how many were copied.
+    uint32_t readWaveform(uint32_t deck, float *points, uint32_t maxPoints) const noexcept;
+
+private:
+    explicit SharedControlRegion(void *memory) noexcept : base_(static_cast<unsigned char *>(memory)) {}
+
+    unsigned char *base_{nullptr};
+};
+
+// Read-write file mapping that backs a shared control region, e.g. a file under /dev/shm that a shell maps as
+// well. The file is created or resized to `bytes`. Throws std::runtime_error when it cannot be mapped.
+class SharedMemoryFile {
+public:
+    SharedMemoryFile(const std::string &path, size_t bytes);
+    ~SharedMemoryFile();
+
+    SharedMemoryFile(const SharedMemoryFile &) = delete;
+    SharedMemoryFile &operator=(const SharedMemoryFile &) = delete;
+
+    void *data() const noexcept { return mapping_; }
+    size_t size() const noexcept { return bytes_; }
+
+private:
+    void *mapping_{nullptr};
+    size_t bytes_{0};
+#if defined(_WIN32)
+    void *fileHandle_{nullptr};
+    void *mappingHandle_{nullptr};
+#endif
+};
+
+} // namespace deejay
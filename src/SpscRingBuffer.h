@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace deejay {
+
+// Bounded single-producer/single-consumer ring buffer. One thread may call write(), one other thread may call
+// read(); neither side blocks or allocates once constructed. Capacity is rounded up to a power of two. Storage
+// comes from `memory`, e.g. a DeckArena.
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t capacity, std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+        : buffer_(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2)), T{}, memory) {
+        mask_ = buffer_.size() - 1;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    size_t capacity() const noexcept { return buffer_.size(); }
+
+    // Items the consumer can read right now.
+    size_t readAvailable() const noexcept {
+        return writeIndex_.load(std::memory_order_acquire) - readIndex_.load(std::memory_order_relaxed);
+    }
+
+    // Free slots the producer can fill right now.
+    size_t writeAvailable() const noexcept {
+        return capacity() - (writeIndex_.load(std::memory_order_relaxed) - readIndex_.load(std::memory_order_acquire));
+    }
+
+    // Producer side. Copies up to count items and returns how many were accepted.
+    size_t write(const T *items, size_t count) noexcept {
+        const size_t writeIndex = writeIndex_.load(std::memory_order_relaxed);
+        const size_t readIndex = readIndex_.load(std::memory_order_acquire);
+        const size_t accepted = std::min(count, capacity() - (writeIndex - readIndex));
+
+        const size_t start = writeIndex & mask_;
+        const size_t firstPart = std::min(accepted, capacity() - start);
+        std::copy(items, items + firstPart, buffer_.data() + start);
+        std::copy(items + firstPart, items + accepted, buffer_.data());
+
+        writeIndex_.store(writeIndex + accepted, std::memory_order_release);
+        return accepted;
+    }
+
+    // Consumer side. Copies up to count items and returns how many were read.
+    size_t read(T *items, size_t count) noexcept {
+        const size_t readIndex = readIndex_.load(std::memory_order_relaxed);
+        const size_t writeIndex = writeIndex_.load(std::memory_order_acquire);
+        const size_t delivered = std::min(count, writeIndex - readIndex);
+
+        const size_t start = readIndex & mask_;
+        const size_t firstPart = std::min(delivered, capacity() - start);
+        std::copy(buffer_.data() + start, buffer_.data() + start + firstPart, items);
+        std::copy(buffer_.data(), buffer_.data() + (delivered - firstPart), items + firstPart);
+
+        readIndex_.store(readIndex + delivered, std::memory_order_release);
+        return delivered;
+    }
+
+private:
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::pmr::vector<T> buffer_;
+    size_t mask_{0};
+    // Indices grow monotonically and are masked on access; keep them on separate cache lines.
+    alignas(64) std::atomic<size_t> writeIndex_{0};
+    alignas(64) std::atomic<size_t> readIndex_{0};
+};
+
+} // namespace deejay
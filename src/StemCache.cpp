@@ -0,0 +1,128 @@
+#include "StemCache.h"
+
+#include "OfflineRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace deejay {
+
+namespace {
+TrackStore::Settings storeSettings(const StemCache::Settings &settings) {
+    TrackStore::Settings store;
+    store.cacheDirectory = settings.cacheDirectory;
+    store.populateSeconds = settings.populateSeconds;
+    return store;
+}
+}
+
+StemSource::StemSource(std::shared_ptr<const MappedTrack> stem, int channelCount, bool loop, double tempoRatio,
+                       double pitchSemitones)
+    : MappedTrackSource(std::move(stem), channelCount, loop), tempoRatio_(tempoRatio), pitchSemitones_(pitchSemitones) {}
+
+StemCache::StemCache(Settings settings) : settings_(std::move(settings)), store_(storeSettings(settings_)) {}
+
+StemCache::StemCache() : StemCache(Settings{}) {}
+
+std::string StemCache::stemKey(const std::string &fileUuid, double tempoRatio, double pitchSemitones) {
+    std::ostringstream key;
+    key << fileUuid << "_t" << std::setprecision(10) << tempoRatio << "_p" << pitchSemitones;
+    return key.str();
+}
+
+std::string StemCache::cachePath(const Request &request) const {
+    return store_.cachePath(stemKey(request.fileUuid, request.tempoRatio, request.pitchSemitones));
+}
+
+std::string StemCache::renderPath(const Request &request) const {
+    return cachePath(request) + ".wav";
+}
+
+bool StemCache::contains(const Request &request) const {
+    std::error_code error;
+    const auto stemTime = std::filesystem::last_write_time(cachePath(request), error);
+    if (error) {
+        return false;
+    }
+    const auto sourceTime = std::filesystem::last_write_time(request.sourcePath, error);
+    // Like TrackStore, an unreachable source leaves the cached stem as the best audio available.
+    return error || stemTime >= sourceTime;
+}
+
+std::vector<StemCache::Result> StemCache::prepareAll(const std::vector<Request> &requests) {
+    std::vector<Result> results(requests.size());
+    std::vector<OfflineRenderer::Job> jobs;
+    std::vector<size_t> jobRequests;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (requests[i].tempoRatio <= 0.0) {
+            results[i].error = "Stem tempo ratio must be positive";
+            continue;
+        }
+        if (contains(requests[i])) {
+            results[i].ok = true;
+            continue;
+        }
+        OfflineRenderer::Job job;
+        job.inputPath = requests[i].sourcePath;
+        job.outputPath = renderPath(requests[i]);
+        job.tempoRatio = requests[i].tempoRatio;
+        job.pitchSemitones = requests[i].pitchSemitones;
+        job.quality = settings_.quality;
+        jobs.push_back(job);
+        jobRequests.push_back(i);
+    }
+
+    OfflineRenderer::Settings rendererSettings;
+    rendererSettings.chunkFrames = settings_.chunkFrames;
+    rendererSettings.threads = settings_.threads;
+    const auto rendered = OfflineRenderer(rendererSettings).renderAll(jobs);
+
+    // The renderer writes WAV; the stem is kept only in TrackStore's mappable form. Its header stamps the
+    // intermediate WAV, which is gone afterwards, so later opens take the entry as is and contains() alone
+    // decides when it is stale.
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        Result &result = results[jobRequests[j]];
+        result.seconds = rendered[j].seconds;
+        result.rendered = rendered[j].ok;
+        if (rendered[j].ok) {
+            const Request &request = requests[jobRequests[j]];
+            const auto started = std::chrono::steady_clock::now();
+            try {
+                store_.prepare(stemKey(request.fileUuid, request.tempoRatio, request.pitchSemitones),
+                               jobs[j].outputPath);
+                result.ok = true;
+            } catch (const std::exception &ex) {
+                result.error = ex.what();
+            }
+            result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        } else {
+            result.error = rendered[j].error;
+        }
+        std::error_code error;
+        std::filesystem::remove(jobs[j].outputPath, error);
+    }
+    return results;
+}
+
+std::shared_ptr<const MappedTrack> StemCache::open(const Request &request, const std::vector<double> &cueSeconds) {
+    const auto results = prepareAll({request});
+    if (!results.front().ok) {
+        throw std::runtime_error("Unable to render keylock stem of " + request.sourcePath + ": " +
+                                 results.front().error);
+    }
+    std::vector<double> stemCues;
+    stemCues.reserve(cueSeconds.size());
+    for (const double cue : cueSeconds) {
+        stemCues.push_back(cue * request.tempoRatio);
+    }
+    return store_.open(stemKey(request.fileUuid, request.tempoRatio, request.pitchSemitones), renderPath(request),
+                       stemCues);
+}
+
+} // namespace deejay
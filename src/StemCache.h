@@ -0,0 +1,84 @@
+#pragma once
+
+#include "TimeStretchPitchProcessor.h"
+#include "TrackStore.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace deejay {
+
+// MappedTrackSource over a keylock stem: reports the tempo and pitch the stem was rendered at, so the deck's
+// processor treats its controls as relative to them (see AudioSource::renderedTempoRatio()).
+class StemSource : public MappedTrackSource {
+public:
+    StemSource(std::shared_ptr<const MappedTrack> stem, int channelCount, bool loop, double tempoRatio,
+               double pitchSemitones);
+
+    double renderedTempoRatio() const noexcept override { return tempoRatio_; }
+    double renderedPitchSemitones() const noexcept override { return pitchSemitones_; }
+
+private:
+    double tempoRatio_{1.0};
+    double pitchSemitones_{0.0};
+};
+
+// Opt-in cache of "keylock stems": tracks rendered ahead of a set through the offline stretcher at the planned
+// tempo ratio and pitch. Stems are keyed on the track UUID plus both parameters and stored as TrackStore entries
+// in their own directory, so decks map them like any decoded track. A deck playing one through StemSource at the
+// planned controls runs its stretcher at unity, which the unity bypass skips entirely; once the fader moves off
+// the planned ratio, only the difference is stretched live. A stem is stale once its source changes.
+class StemCache {
+public:
+    struct Settings {
+        std::string cacheDirectory{"cache/stems"};
+        StretchQuality quality{};
+        // Passed to the OfflineRenderer that renders missing stems.
+        size_t chunkFrames{65'536};
+        size_t threads{0};
+        // See TrackStore::Settings.
+        double populateSeconds{2.0};
+    };
+
+    struct Request {
+        std::string fileUuid;
+        std::string sourcePath;
+        double tempoRatio{1.0};
+        double pitchSemitones{0.0};
+    };
+
+    struct Result {
+        bool ok{false};
+        // False when a current stem was already cached.
+        bool rendered{false};
+        std::string error;
+        double seconds{0.0};
+    };
+
+    explicit StemCache(Settings settings);
+    StemCache();
+
+    // Cache key of one stem, e.g. "<uuid>_t1.05_p-1".
+    static std::string stemKey(const std::string &fileUuid, double tempoRatio, double pitchSemitones);
+    std::string cachePath(const Request &request) const;
+    // True when the stem exists and is at least as new as its source (or the source is unreadable).
+    bool contains(const Request &request) const;
+
+    // Non-realtime: renders every missing or stale stem, several tracks in parallel, and returns results in
+    // request order. Failures are reported per request rather than thrown.
+    std::vector<Result> prepareAll(const std::vector<Request> &requests);
+
+    // Non-realtime: renders the stem if needed and maps it. `cueSeconds` are positions in the source track; they
+    // are moved to where they land in the stem before being populated. Throws std::runtime_error on failure.
+    std::shared_ptr<const MappedTrack> open(const Request &request, const std::vector<double> &cueSeconds = {});
+
+private:
+    std::string renderPath(const Request &request) const;
+
+    Settings settings_;
+    TrackStore store_;
+};
+
+} // namespace deejay
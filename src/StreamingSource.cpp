@@ -0,0 +1,116 @@
+#include "StreamingSource.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+namespace deejay {
+
+namespace {
+constexpr double kTwoPi = 6.283185307179586;
+constexpr auto kWorkerIdleSleep = std::chrono::milliseconds(2);
+}
+
+StreamingSource::StreamingSource(Settings settings)
+    : settings_(std::move(settings)),
+      ring_(settings_.bufferFrames * static_cast<size_t>(std::max(1, settings_.channelCount))) {
+    if (!settings_.path.empty()) {
+        reader_ = std::make_unique<WavFileReader>(settings_.path);
+        decodeScratch_.resize(settings_.decodeChunkFrames * static_cast<size_t>(reader_->channelCount()));
+    }
+    channelScratch_.resize(settings_.decodeChunkFrames * static_cast<size_t>(settings_.channelCount));
+}
+
+StreamingSource::~StreamingSource() { stop(); }
+
+void StreamingSource::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    // Prime synchronously so the first callbacks have audio instead of counting as underruns.
+    fill();
+    worker_ = std::thread([this] { run(); });
+}
+
+void StreamingSource::fill() {
+    while (ring_.writeAvailable() >= channelScratch_.size() && !exhausted_.load(std::memory_order_relaxed)) {
+        decodeChunk();
+    }
+}
+
+void StreamingSource::stop() {
+    running_.store(false);
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+size_t StreamingSource::read(float *interleaved, size_t frames) noexcept {
+    const size_t channels = static_cast<size_t>(settings_.channelCount);
+    const size_t delivered = ring_.read(interleaved, frames * channels) / channels;
+    if (delivered < frames && !exhausted_.load(std::memory_order_relaxed)) {
+        underruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return delivered;
+}
+
+double StreamingSource::sourceSampleRate() const noexcept {
+    return reader_ ? reader_->sampleRate() : settings_.sampleRate;
+}
+
+bool StreamingSource::finished() const noexcept {
+    return exhausted_.load(std::memory_order_relaxed) && ring_.readAvailable() == 0;
+}
+
+void StreamingSource::run() {
+    while (running_.load(std::memory_order_relaxed) && !exhausted_.load(std::memory_order_relaxed)) {
+        if (ring_.writeAvailable() < channelScratch_.size()) {
+            std::this_thread::sleep_for(kWorkerIdleSleep);
+            continue;
+        }
+        decodeChunk();
+    }
+}
+
+size_t StreamingSource::decodeChunk() {
+    const size_t chunk = settings_.decodeChunkFrames;
+    const size_t outChannels = static_cast<size_t>(settings_.channelCount);
+    size_t frames = 0;
+
+    if (!reader_) {
+        const double increment = kTwoPi * settings_.toneFrequency / settings_.sampleRate;
+        for (size_t i = 0; i < chunk; ++i) {
+            const auto value = static_cast<float>(0.25 * std::sin(tonePhase_));
+            tonePhase_ = std::fmod(tonePhase_ + increment, kTwoPi);
+            std::fill_n(channelScratch_.data() + i * outChannels, outChannels, value);
+        }
+        frames = chunk;
+    } else {
+        frames = reader_->readFrames(decodeScratch_.data(), chunk);
+        if (frames < chunk && settings_.loop && reader_->totalFrames() > 0) {
+            reader_->seek(0);
+            const size_t fileChannels = static_cast<size_t>(reader_->channelCount());
+            frames += reader_->readFrames(decodeScratch_.data() + frames * fileChannels, chunk - frames);
+        }
+
+        // Map file channels onto the output layout: extra outputs repeat the last file channel.
+        const size_t fileChannels = static_cast<size_t>(reader_->channelCount());
+        for (size_t i = 0; i < frames; ++i) {
+            for (size_t ch = 0; ch < outChannels; ++ch) {
+                channelScratch_[i * outChannels + ch] = decodeScratch_[i * fileChannels + std::min(ch, fileChannels - 1)];
+            }
+        }
+    }
+
+    if (frames == 0) {
+        exhausted_.store(true, std::memory_order_relaxed);
+        return 0;
+    }
+
+    ring_.write(channelScratch_.data(), frames * outChannels);
+    return frames;
+}
+
+} // namespace deejay
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "AudioSource.h"
+#include "SpscRingBuffer.h"
+#include "WavFileReader.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace deejay {
+
+// Decodes audio on a worker thread into a lock-free ring buffer so the audio callback only ever copies
+// ready frames. Without a file the worker generates a test tone, which keeps the engine runnable anywhere.
+class StreamingSource : public AudioSource {
+public:
+    struct Settings {
+        std::string path;              // WAV file to stream; empty selects the generated tone
+        int channelCount{2};           // channel count delivered to read(), independent of the file layout
+        double sampleRate{48'000.0};
+        size_t bufferFrames{1 << 15};  // ring capacity, roughly 0.7s at 48kHz
+        size_t decodeChunkFrames{1024};
+        bool loop{false};
+        double toneFrequency{440.0};
+    };
+
+    explicit StreamingSource(Settings settings);
+    ~StreamingSource() override;
+
+    StreamingSource(const StreamingSource &) = delete;
+    StreamingSource &operator=(const StreamingSource &) = delete;
+
+    // Starts the decode thread and blocks until the ring is primed or the source is exhausted.
+    void start();
+    void stop();
+
+    // Offline use instead of start(): decodes on the calling thread until the ring is full or the source is
+    // exhausted. Called between callbacks, it makes a render independent of thread timing.
+    void fill();
+
+    // Realtime-safe: copies up to `frames` interleaved frames and returns how many were available.
+    size_t read(float *interleaved, size_t frames) noexcept override;
+
+    int channelCount() const noexcept override { return settings_.channelCount; }
+    double sourceSampleRate() const noexcept;
+    bool finished() const noexcept;
+    uint64_t underrunCount() const noexcept { return underruns_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    size_t decodeChunk();
+
+    Settings settings_;
+    std::unique_ptr<WavFileReader> reader_;
+    SpscRingBuffer<float> ring_;
+    std::vector<float> decodeScratch_;
+    std::vector<float> channelScratch_;
+    double tonePhase_{0.0};
+    std::thread worker_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> exhausted_{false};
+    std::atomic<uint64_t> underruns_{0};
+};
+
+} // namespace deejay
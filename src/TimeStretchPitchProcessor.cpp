@@ -1,12 +1,23 @@
 #include "TimeStretchPitchProcessor.h"
 
+#include "Interleave.h"
+
 #ifdef DEEJAY_HAVE_RUBBERBAND
+#include "Semaphore.h"
+#include "SpscRingBuffer.h"
+
 #include <rubberband/RubberBandStretcher.h>
 #endif
 
 #include <algorithm>
 #include <cmath>
 
+#ifdef DEEJAY_HAVE_RUBBERBAND
+#include <chrono>
+#include <mutex>
+#include <thread>
+#endif
+
 namespace deejay {
 
 namespace {
@@ -18,17 +29,19 @@ constexpr double semitonesToRatio(double semitones) {
 #ifdef DEEJAY_HAVE_RUBBERBAND
 class TimeStretchPitchProcessor::RubberBandAdapter {
 public:
-    RubberBandAdapter(double sampleRate, int channelCount, const Parameters &parameters)
-        : channelCount_(channelCount) {
+    RubberBandAdapter(double sampleRate, int channelCount, const Parameters &parameters, const Options &engineOptions)
+        : channelCount_(channelCount), inputChannels_(static_cast<size_t>(channelCount)),
+          outputChannels_(static_cast<size_t>(channelCount)) {
         using RubberBand::RubberBandStretcher;
 
-        int options = RubberBandStretcher::OptionProcessRealTime |
-                      RubberBandStretcher::OptionPitchHighQuality |
-                      RubberBandStretcher::OptionThreadingAuto;
-
-        if (!parameters.quality.highQuality) {
-            options |= RubberBandStretcher::OptionPitchHighSpeed;
-        }
+        // OptionPitchHighSpeed is the zero value of the pitch option group, so it is selected by leaving
+        // OptionPitchHighQuality out rather than by OR-ing it in.
+        int options = (engineOptions.offline ? RubberBandStretcher::OptionProcessOffline
+                                             : RubberBandStretcher::OptionProcessRealTime) |
+                      (parameters.quality.highQuality ? RubberBandStretcher::OptionPitchHighQuality
+                                                      : RubberBandStretcher::OptionPitchHighSpeed) |
+                      (engineOptions.singleThreaded ? RubberBandStretcher::OptionThreadingNever
+                                                    : RubberBandStretcher::OptionThreadingAuto);
 
         if (parameters.quality.transientSensitivity > 0.6f) {
             options |= RubberBandStretcher::OptionTransientsSmooth;
@@ -43,60 +56,498 @@ public:
     }
 
     void setParameters(const Parameters &parameters) {
+        // Reconfiguring the stretcher is not free, so skip values that did not change.
+        if (!configured_ || parameters.pitchSemitones != parameters_.pitchSemitones) {
+            stretcher_->setPitchScale(semitonesToRatio(parameters.pitchSemitones));
+        }
+        if (!configured_ || parameters.tempoRatio != parameters_.tempoRatio) {
+            stretcher_->setTimeRatio(parameters.tempoRatio);
+        }
         parameters_ = parameters;
-        stretcher_->setPitchScale(semitonesToRatio(parameters_.pitchSemitones));
-        stretcher_->setTimeRatio(parameters_.tempoRatio);
+        configured_ = true;
     }
 
     Parameters getParameters() const { return parameters_; }
 
+    void prepare(size_t maxBlockFrames) { stretcher_->setMaxProcessSize(maxBlockFrames); }
+
     size_t process(const float *input, size_t frames, std::vector<float> &output) {
-        std::vector<const float *> channels(channelCount_);
         for (int ch = 0; ch < channelCount_; ++ch) {
-            channels[ch] = input + ch * frames;
+            inputChannels_[ch] = input + ch * frames;
         }
 
-        stretcher_->process(channels.data(), frames, false);
-        const auto available = static_cast<size_t>(stretcher_->available());
+        stretcher_->process(inputChannels_.data(), frames, false);
+        pushedFrames_ += frames;
+        const auto available = static_cast<size_t>(std::max(0, stretcher_->available()));
 
         output.resize(available * static_cast<size_t>(channelCount_));
-        std::vector<float *> outputChannels(channelCount_);
         for (int ch = 0; ch < channelCount_; ++ch) {
-            outputChannels[ch] = output.data() + static_cast<size_t>(ch) * available;
+            outputChannels_[ch] = output.data() + static_cast<size_t>(ch) * available;
         }
 
-        stretcher_->retrieve(outputChannels.data(), available);
+        stretcher_->retrieve(outputChannels_.data(), available);
+        retrievedInput_ += static_cast<double>(available) / parameters_.tempoRatio;
         return available;
     }
 
+    void push(const float *const *input, size_t frames, bool final = false) {
+        stretcher_->process(input, frames, final);
+        pushedFrames_ += frames;
+    }
+
+    void study(const float *const *input, size_t frames, bool final) { stretcher_->study(input, frames, final); }
+
+    void setExpectedInputDuration(size_t frames) { stretcher_->setExpectedInputDuration(frames); }
+
+    size_t available() const { return static_cast<size_t>(std::max(0, stretcher_->available())); }
+
+    size_t retrieve(float *const *output, size_t frames) {
+        const size_t retrieved = stretcher_->retrieve(output, std::min(available(), frames));
+        retrievedInput_ += static_cast<double>(retrieved) / parameters_.tempoRatio;
+        return retrieved;
+    }
+
+    // Input frames pushed since the last reset whose output has not been retrieved yet. Together with the latency
+    // it places the next output frame in the input. Output is counted back into input frames at the time ratio it
+    // was produced at; away from unity the two counts drift apart by the ratio.
+    uint64_t backlog() const noexcept {
+        const auto covered = static_cast<uint64_t>(std::llround(retrievedInput_));
+        return pushedFrames_ > covered ? pushedFrames_ - covered : 0;
+    }
+
+    size_t samplesRequired() const { return stretcher_->getSamplesRequired(); }
+
     size_t latency() const { return static_cast<size_t>(stretcher_->getLatency()); }
 
-    void reset() { stretcher_->reset(); }
+    void reset() {
+        stretcher_->reset();
+        pushedFrames_ = 0;
+        retrievedInput_ = 0.0;
+    }
 
 private:
     int channelCount_;
+    uint64_t pushedFrames_{0};
+    double retrievedInput_{0.0};
     Parameters parameters_{};
+    bool configured_{false};
+    // Channel pointer tables for the vector overload, sized once so no block allocates them.
+    std::vector<const float *> inputChannels_;
+    std::vector<float *> outputChannels_;
     std::unique_ptr<RubberBand::RubberBandStretcher> stretcher_;
 };
+
+namespace {
+// Input kept for priming a replacement stretcher: comfortably more than Rubber Band's analysis window and
+// latency at 48 kHz, so the replacement's output has settled by the time it is heard.
+constexpr size_t kHistoryFrames = 16384;
+constexpr double kCrossfadeSeconds = 0.02;
+// Extra handoff room for blocks that arrive while the builder is still working through the history.
+constexpr size_t kHandoffSlackBlocks = 32;
+// Replacement output buffered during a crossfade: enough for one Rubber Band hop of misalignment plus a few
+// blocks, on top of which the stretcher's own output buffer absorbs the rest.
+constexpr size_t kPendingFrames = 8192;
+// Candidate output consumed at zero gain before the fade starts. A candidate whose hops land later than the old
+// stretcher's cannot supply every aligned frame on time; the shortfall shows up within one hop, and absorbing
+// it here (where it is inaudible) keeps the fade itself from ever running dry.
+constexpr size_t kSettleFrames = 4096;
+// Input replayed into a reset stretcher ahead of the point where the unity bypass hands back to it, and how many
+// blocks' worth of history each block may push while catching up.
+constexpr size_t kPrimeFrames = 4096;
+constexpr size_t kPrimeBlocksPerCall = 4;
+// Blocks a caught-up stretcher may spend short of the read point before the bypass hands back anyway. Faster than
+// unity the stretcher's latency reaches further back in input than the bypass delay does, so it can never line up
+// exactly; without a limit the deck would stay pinned at unity.
+constexpr size_t kPrimeTimeoutBlocks = 4;
+
+// Work item of the shared builder thread. service() runs on that thread and returns true while it wants to
+// be polled again without a fresh wake-up.
+class BackgroundTask {
+public:
+    virtual ~BackgroundTask() = default;
+    virtual bool service() = 0;
+};
+
+// One process-wide thread builds and destroys replacement stretchers for every processor, so quality
+// swaps add no per-deck threads and never allocate on the audio thread.
+class StretcherBuilder {
+public:
+    static StretcherBuilder &instance() {
+        static StretcherBuilder builder;
+        return builder;
+    }
+
+    void add(const std::shared_ptr<BackgroundTask> &task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(task);
+    }
+
+    // Realtime-safe.
+    void wake() noexcept { wake_.post(); }
+
+private:
+    StretcherBuilder() : thread_([this] { run(); }) {}
+
+    ~StretcherBuilder() {
+        running_.store(false, std::memory_order_release);
+        wake_.post();
+        thread_.join();
+    }
+
+    void run() {
+        while (running_.load(std::memory_order_acquire)) {
+            wake_.wait();
+            bool busy = true;
+            while (busy && running_.load(std::memory_order_acquire)) {
+                busy = false;
+                for (const auto &task : liveTasks()) {
+                    busy = task->service() || busy;
+                }
+                if (busy) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<BackgroundTask>> liveTasks() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::shared_ptr<BackgroundTask>> live;
+        auto keep = tasks_.begin();
+        for (auto &task : tasks_) {
+            if (auto locked = task.lock()) {
+                live.push_back(std::move(locked));
+                *keep++ = task;
+            }
+        }
+        tasks_.erase(keep, tasks_.end());
+        return live;
+    }
+
+    std::mutex mutex_;
+    std::vector<std::weak_ptr<BackgroundTask>> tasks_;
+    Semaphore wake_;
+    std::atomic<bool> running_{true};
+    std::thread thread_;
+};
+}
+
+// Shared between the audio thread and the builder. The stage field hands ownership of `candidate` and of the
+// consumer side of `handoff` back and forth:
+//   Requested   builder builds the candidate, then publishes Feeding
+//   Feeding     audio thread dumps its input history into `handoff` and appends every block; the builder pushes
+//               it all through the candidate and publishes Ready once it has caught up
+//   Ready       audio thread feeds the last frames itself and starts the crossfade (Crossfading); until it can,
+//               it keeps appending every block to `handoff`
+//   Crossfading audio thread runs both stretchers and fades to the candidate, swaps them and publishes Retire.
+//               The two stretchers emit output for a given input position at different times (their hops are
+//               out of phase), so candidate output is aligned by backlog and latency and buffered in `pending`.
+//   Retire      builder destroys the old stretcher, then goes Idle or starts the next request
+//   Aborted     the handoff overflowed or the processor was reset; the builder discards and retries
+struct TimeStretchPitchProcessor::QualitySwap : BackgroundTask {
+    enum Stage : int { Idle, Requested, Feeding, Ready, Crossfading, Retire, Aborted };
+
+    QualitySwap(double rate, int channels, Options engineOptions)
+        : sampleRate(rate), channelCount(channels), options(engineOptions) {}
+
+    bool service() override {
+        try {
+            return serviceStage();
+        } catch (...) {
+            // Construction failed (out of memory, bad options): stay on the current stretcher.
+            candidate.reset();
+            stage.store(Idle, std::memory_order_release);
+            return false;
+        }
+    }
+
+    bool serviceStage() {
+        switch (stage.load(std::memory_order_acquire)) {
+        case Requested: {
+            const size_t blockFrames = maxBlockFrames.load(std::memory_order_acquire);
+            if (blockFrames == 0) {
+                return false; // prepare() wakes the builder again
+            }
+            builtGeneration = generation.load(std::memory_order_acquire);
+            Parameters parameters;
+            parameters.quality = requested.load();
+            candidateQuality = parameters.quality;
+            candidate = std::make_unique<RubberBandAdapter>(sampleRate, channelCount, parameters, options);
+            candidate->prepare(blockFrames);
+
+            const auto samples = blockFrames * static_cast<size_t>(channelCount);
+            builderInterleaved.assign(samples, 0.0f);
+            builderPlanar.assign(samples, 0.0f);
+            builderChannels.resize(static_cast<size_t>(channelCount));
+            for (int ch = 0; ch < channelCount; ++ch) {
+                builderChannels[static_cast<size_t>(ch)] = builderPlanar.data() + static_cast<size_t>(ch) * blockFrames;
+            }
+            drainHandoff();
+            consumedFrames = 0;
+            historyPublished.store(false, std::memory_order_relaxed);
+            stage.store(Feeding, std::memory_order_release);
+            return true;
+        }
+        case Feeding:
+            feedCandidate();
+            return stage.load(std::memory_order_acquire) == Feeding;
+        case Aborted:
+            candidate.reset();
+            drainHandoff();
+            stage.store(Requested, std::memory_order_release);
+            return true;
+        case Retire:
+            candidate.reset();
+            if (generation.load(std::memory_order_acquire) != builtGeneration) {
+                stage.store(Requested, std::memory_order_release);
+                return true;
+            }
+            stage.store(Idle, std::memory_order_release);
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    void feedCandidate() {
+        if (!historyPublished.load(std::memory_order_acquire)) {
+            return;
+        }
+        const size_t blockFrames = builderChannels.empty() ? 0 : builderPlanar.size() / builderChannels.size();
+        const auto channels = static_cast<size_t>(channelCount);
+        while (true) {
+            const size_t frames = std::min(handoff->readAvailable() / channels, blockFrames);
+            if (frames == 0) {
+                break;
+            }
+            handoff->read(builderInterleaved.data(), frames * channels);
+            deinterleave(builderInterleaved.data(), builderChannels.data(), channelCount, frames);
+            const float *const *input = builderChannels.data();
+            candidate->push(input, frames);
+            // Priming output is discarded; only what follows the handover is heard.
+            while (candidate->retrieve(builderChannels.data(), blockFrames) > 0) {
+            }
+            consumedFrames += frames;
+        }
+
+        if (consumedFrames >= historyFrames.load(std::memory_order_relaxed) &&
+            handoff->readAvailable() / channels < blockFrames) {
+            int expected = Feeding;
+            stage.compare_exchange_strong(expected, Ready, std::memory_order_acq_rel);
+        }
+    }
+
+    void drainHandoff() {
+        if (!handoff) {
+            return;
+        }
+        std::vector<float> sink(4096);
+        while (handoff->read(sink.data(), sink.size()) > 0) {
+        }
+    }
+
+    // Configuration, fixed at construction or published by prepare().
+    const double sampleRate;
+    const int channelCount;
+    const Options options;
+    std::atomic<size_t> maxBlockFrames{0};
+
+    std::atomic<int> stage{Idle};
+    SharedQuality requested;
+    std::atomic<uint32_t> generation{0};
+    std::unique_ptr<RubberBandAdapter> candidate;
+    StretchQuality candidateQuality{};
+    std::unique_ptr<SpscRingBuffer<float>> handoff;
+    std::atomic<size_t> historyFrames{0};
+    std::atomic<bool> historyPublished{false};
+
+    // Builder thread only.
+    uint32_t builtGeneration{0};
+    size_t consumedFrames{0};
+    std::vector<float> builderInterleaved;
+    std::vector<float> builderPlanar;
+    std::vector<float *> builderChannels;
+
+    // Copies `frames` history frames starting at absolute input frame `from` into planar channels. The range must
+    // lie within the last historyFill frames. Audio thread only.
+    void readHistory(uint64_t from, size_t frames, float *const *output) const noexcept {
+        for (size_t done = 0; done < frames;) {
+            const auto start = static_cast<size_t>((from + done) % kHistoryFrames);
+            const size_t run = std::min(frames - done, kHistoryFrames - start);
+            for (size_t ch = 0; ch < static_cast<size_t>(channelCount); ++ch) {
+                const float *source = history.data() + ch * kHistoryFrames + start;
+                std::copy(source, source + run, output[ch] + done);
+            }
+            done += run;
+        }
+    }
+
+    // Audio thread only, sized in prepare(). History is planar: channel ch occupies [ch * kHistoryFrames, ...);
+    // historyEnd counts every input frame recorded since prepare().
+    std::vector<float> history;
+    size_t historyWrite{0};
+    size_t historyFill{0};
+    uint64_t historyEnd{0};
+    bool feeding{false};
+    std::vector<const float *> historyChannels;
+    std::vector<float> handoffScratch;
+    std::vector<float> crossfadeScratch;
+    std::vector<float *> crossfadeChannels;
+    std::vector<float *> offsetChannels;
+    size_t crossfadeFrames{0};
+    size_t crossfadePosition{0};
+    // Candidate output that has been retrieved but not mixed yet, planar with kPendingFrames per channel.
+    std::vector<float> pending;
+    std::vector<float *> pendingChannels;
+    size_t pendingRead{0};
+    size_t pendingCount{0};
+    // Alignment at the start of a crossfade: candidate frames to drop, or old frames to emit before mixing.
+    uint64_t discardFrames{0};
+    uint64_t holdFrames{0};
+    size_t settleFrames{0};
+};
+
+// Audio-thread state of the unity bypass. Bypassed output is read from the quality swap's input history, which
+// doubles as the matched delay line:
+//   Off        the stretcher produces the output
+//   Engaging   both run; the output fades from the stretcher to the delayed input
+//   Engaged    the stretcher is idle; output is the input delayed by what the stretcher held when it stopped
+//   Priming    the stretcher has been reset and replays recent history to catch up, output still bypassed
+//   Releasing  both run; the output fades back to the stretcher
+struct TimeStretchPitchProcessor::UnityBypass {
+    enum Stage { Off, Engaging, Engaged, Priming, Releasing };
+
+    Stage stage{Off};
+    // Absolute history frame that the next bypassed output frame comes from.
+    uint64_t readPosition{0};
+    uint64_t delayFrames{0};
+    uint64_t primeStart{0};
+    uint64_t primePosition{0};
+    size_t primeBlocks{0}; // blocks spent caught up with the history but short of the read point
+    size_t fadeFrames{0};
+    size_t fadePosition{0};
+    std::vector<float> scratch;
+    std::vector<float *> channels;
+    std::vector<float *> offsetChannels;
+};
 #endif
 
+void TimeStretchPitchProcessor::SharedQuality::store(const StretchQuality &quality) noexcept {
+    formantPreservation.store(quality.formantPreservation, std::memory_order_relaxed);
+    transientSensitivity.store(quality.transientSensitivity, std::memory_order_relaxed);
+    highQuality.store(quality.highQuality, std::memory_order_relaxed);
+}
+
+StretchQuality TimeStretchPitchProcessor::SharedQuality::load() const noexcept {
+    StretchQuality quality;
+    quality.formantPreservation = formantPreservation.load(std::memory_order_relaxed);
+    quality.transientSensitivity = transientSensitivity.load(std::memory_order_relaxed);
+    quality.highQuality = highQuality.load(std::memory_order_relaxed);
+    return quality;
+}
+
+namespace {
+bool sameQuality(const StretchQuality &a, const StretchQuality &b) {
+    return a.formantPreservation == b.formantPreservation && a.transientSensitivity == b.transientSensitivity &&
+           a.highQuality == b.highQuality;
+}
+
+std::pmr::memory_resource *memoryOf(const TimeStretchPitchProcessor::Options &options) {
+    return options.memory ? options.memory : std::pmr::get_default_resource();
+}
+}
+
+TimeStretchPitchProcessor::TimeStretchPitchProcessor(double sampleRate, int channelCount)
+    : TimeStretchPitchProcessor(sampleRate, channelCount, Parameters{}) {}
+
 TimeStretchPitchProcessor::TimeStretchPitchProcessor(double sampleRate, int channelCount, Parameters defaults)
-    : sampleRate_(sampleRate), channelCount_(channelCount), parameters_(defaults) {
+    : TimeStretchPitchProcessor(sampleRate, channelCount, defaults, Options{}) {}
+
+TimeStretchPitchProcessor::TimeStretchPitchProcessor(double sampleRate, int channelCount, Parameters defaults,
+                                                     Options options)
+    : sampleRate_(sampleRate), channelCount_(channelCount), parameters_(defaults), options_(options),
+      inputChannels_(static_cast<size_t>(channelCount), memoryOf(options)),
+      outputChannels_(static_cast<size_t>(channelCount), memoryOf(options)), layoutScratch_(memoryOf(options)),
+      scratchChannels_(static_cast<size_t>(channelCount), memoryOf(options)) {
+    requestedQuality_.store(defaults.quality);
+    activeQuality_.store(defaults.quality);
     configureProcessor();
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    if (!options_.offline) {
+        swap_ = std::make_shared<QualitySwap>(sampleRate_, channelCount_, options_);
+        swap_->requested.store(defaults.quality);
+        StretcherBuilder::instance().add(swap_);
+        bypass_ = std::make_unique<UnityBypass>();
+    }
+#endif
 }
 
+TimeStretchPitchProcessor::~TimeStretchPitchProcessor() = default;
+
 void TimeStretchPitchProcessor::setParameters(const Parameters &parameters) {
     parameters_ = parameters;
+    if (!sameQuality(parameters.quality, requestedQuality_.load())) {
+        requestQuality(parameters.quality);
+    }
 #ifdef DEEJAY_HAVE_RUBBERBAND
     if (processor_) {
         processor_->setParameters(parameters_);
+        latencySamples_ = processor_->latency();
+    }
+    if (swap_ && swap_->stage.load(std::memory_order_relaxed) == QualitySwap::Crossfading) {
+        swap_->candidate->setParameters(parameters_);
+    }
+#else
+    atUnity_.store(parameters.tempoRatio == 1.0 && parameters.pitchSemitones == 0.0, std::memory_order_relaxed);
+    latencySamples_ = static_cast<size_t>(sampleRate_ * 0.01); // 10ms placeholder
+#endif
+}
+
+TimeStretchPitchProcessor::Parameters TimeStretchPitchProcessor::getParameters() const {
+    Parameters parameters = parameters_;
+    parameters.quality = requestedQuality_.load();
+    return parameters;
+}
+
+void TimeStretchPitchProcessor::requestQuality(const StretchQuality &quality) noexcept {
+    requestedQuality_.store(quality);
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    if (!swap_) {
+        return;
+    }
+    swap_->requested.store(quality);
+    swap_->generation.fetch_add(1, std::memory_order_acq_rel);
+    int expected = QualitySwap::Idle;
+    if (!sameQuality(quality, activeQuality_.load()) &&
+        swap_->stage.compare_exchange_strong(expected, QualitySwap::Requested, std::memory_order_acq_rel)) {
+        StretcherBuilder::instance().wake();
     }
 #else
-    simulatedLatencySamples_ = static_cast<size_t>(sampleRate_ * 0.01); // 10ms placeholder
+    activeQuality_.store(quality);
+#endif
+}
+
+StretchQuality TimeStretchPitchProcessor::activeQuality() const noexcept { return activeQuality_.load(); }
+
+void TimeStretchPitchProcessor::setUnityBypass(bool enabled) noexcept {
+    unityBypassEnabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool TimeStretchPitchProcessor::unityBypassActive() const noexcept {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    return unityBypassActive_.load(std::memory_order_relaxed);
+#else
+    return unityBypassEnabled() && atUnity_.load(std::memory_order_relaxed);
 #endif
 }
 
-TimeStretchPitchProcessor::Parameters TimeStretchPitchProcessor::getParameters() const { return parameters_; }
+bool TimeStretchPitchProcessor::qualitySwapPending() const noexcept {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    return swap_ && swap_->stage.load(std::memory_order_acquire) != QualitySwap::Idle;
+#else
+    return false;
+#endif
+}
 
 std::vector<TimeStretchPitchProcessor::EndpointDescriptor> TimeStretchPitchProcessor::describeEndpoints() const {
     return {
@@ -120,27 +571,600 @@ size_t TimeStretchPitchProcessor::process(const float *input, size_t frames, std
 #endif
 }
 
-size_t TimeStretchPitchProcessor::getLatencySamples() const {
+void TimeStretchPitchProcessor::prepare(size_t maxBlockFrames) {
+    maxBlockFrames_ = maxBlockFrames;
 #ifdef DEEJAY_HAVE_RUBBERBAND
-    return processor_ ? processor_->latency() : 0;
+    if (!processor_) {
+        configureProcessor();
+    }
+    processor_->prepare(maxBlockFrames_);
+    latencySamples_ = processor_->latency();
+
+    // Interleaved blocks pass through this planar staging area on their way into and out of the stretcher.
+    const auto channels = static_cast<size_t>(channelCount_);
+    layoutScratch_.assign(maxBlockFrames_ * channels, 0.0f);
+    for (int ch = 0; ch < channelCount_; ++ch) {
+        scratchChannels_[ch] = layoutScratch_.data() + static_cast<size_t>(ch) * maxBlockFrames_;
+    }
+
+    if (swap_) {
+        auto &swap = *swap_;
+        swap.history.assign(kHistoryFrames * channels, 0.0f);
+        swap.historyWrite = 0;
+        swap.historyFill = 0;
+        swap.historyEnd = 0;
+        swap.historyChannels.resize(channels);
+        swap.handoffScratch.assign(maxBlockFrames_ * channels, 0.0f);
+        swap.crossfadeScratch.assign(maxBlockFrames_ * channels, 0.0f);
+        swap.crossfadeChannels.resize(channels);
+        swap.offsetChannels.resize(channels);
+        for (size_t ch = 0; ch < channels; ++ch) {
+            swap.crossfadeChannels[ch] = swap.crossfadeScratch.data() + ch * maxBlockFrames_;
+        }
+        swap.crossfadeFrames = std::max<size_t>(1, static_cast<size_t>(sampleRate_ * kCrossfadeSeconds));
+        swap.pending.assign(kPendingFrames * channels, 0.0f);
+        swap.pendingChannels.resize(channels);
+        swap.pendingRead = 0;
+        swap.pendingCount = 0;
+        swap.handoff = std::make_unique<SpscRingBuffer<float>>((kHistoryFrames + kHandoffSlackBlocks * maxBlockFrames_) * channels);
+        swap.maxBlockFrames.store(maxBlockFrames_, std::memory_order_release);
+
+        auto &bypass = *bypass_;
+        bypass.stage = UnityBypass::Off;
+        bypass.fadeFrames = swap.crossfadeFrames;
+        bypass.scratch.assign(maxBlockFrames_ * channels, 0.0f);
+        bypass.channels.resize(channels);
+        bypass.offsetChannels.resize(channels);
+        for (size_t ch = 0; ch < channels; ++ch) {
+            bypass.channels[ch] = bypass.scratch.data() + ch * maxBlockFrames_;
+        }
+        unityBypassActive_.store(false, std::memory_order_relaxed);
+        if (swap.stage.load(std::memory_order_acquire) == QualitySwap::Requested) {
+            StretcherBuilder::instance().wake();
+        }
+    }
+#endif
+}
+
+size_t TimeStretchPitchProcessor::process(const float *const *input, size_t frames, float *const *output,
+                                          size_t outputCapacity) {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    beginBlock(input, frames);
+    return retrieveMixed(output, outputCapacity);
+#else
+    const size_t copied = std::min(frames, outputCapacity);
+    for (int ch = 0; ch < channelCount_; ++ch) {
+        std::copy(input[ch], input[ch] + copied, output[ch]);
+    }
+    return copied;
+#endif
+}
+
+size_t TimeStretchPitchProcessor::process(const float *input, size_t frames, float *output, size_t outputCapacity,
+                                          SampleLayout layout) {
+    if (layout == SampleLayout::Planar) {
+        for (int ch = 0; ch < channelCount_; ++ch) {
+            inputChannels_[ch] = input + static_cast<size_t>(ch) * frames;
+            outputChannels_[ch] = output + static_cast<size_t>(ch) * outputCapacity;
+        }
+        return process(inputChannels_.data(), frames, outputChannels_.data(), outputCapacity);
+    }
+
+    const auto samplesPerFrame = static_cast<size_t>(channelCount_);
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    deinterleave(input, scratchChannels_.data(), channelCount_, frames);
+    beginBlock(scratchChannels_.data(), frames);
+
+    size_t written = 0;
+    while (written < outputCapacity) {
+        const size_t retrieved =
+            retrieveMixed(scratchChannels_.data(), std::min(outputCapacity - written, maxBlockFrames_));
+        if (retrieved == 0) {
+            break;
+        }
+        interleave(scratchChannels_.data(), output + written * samplesPerFrame, channelCount_, retrieved);
+        written += retrieved;
+    }
+    return written;
+#else
+    const size_t copied = std::min(frames, outputCapacity);
+    std::copy(input, input + copied * samplesPerFrame, output);
+    return copied;
+#endif
+}
+
+size_t TimeStretchPitchProcessor::inputFramesRequired(size_t outputFrames) const {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    if (bypass_ && (bypass_->stage == UnityBypass::Engaged || bypass_->stage == UnityBypass::Priming)) {
+        return outputFrames;
+    }
+    if (processor_) {
+        const size_t required = processor_->samplesRequired();
+        if (required > 0) {
+            return required;
+        }
+    }
+    return static_cast<size_t>(std::ceil(static_cast<double>(outputFrames) / parameters_.tempoRatio));
+#else
+    return outputFrames;
+#endif
+}
+
+void TimeStretchPitchProcessor::setExpectedInputDuration(size_t frames) {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    processor_->setExpectedInputDuration(frames);
+#else
+    (void)frames;
+#endif
+}
+
+void TimeStretchPitchProcessor::study(const float *const *input, size_t frames, bool final) {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    processor_->study(input, frames, final);
+#else
+    (void)input;
+    (void)frames;
+    (void)final;
+#endif
+}
+
+void TimeStretchPitchProcessor::push(const float *const *input, size_t frames, bool final) {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    processor_->push(input, frames, final);
+#else
+    (void)final;
+    offlinePending_.resize(static_cast<size_t>(channelCount_));
+    for (int ch = 0; ch < channelCount_; ++ch) {
+        auto &pending = offlinePending_[ch];
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(offlineReadFrame_));
+        pending.insert(pending.end(), input[ch], input[ch] + frames);
+    }
+    offlineReadFrame_ = 0;
+#endif
+}
+
+size_t TimeStretchPitchProcessor::available() const {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    return processor_->available();
+#else
+    return offlinePending_.empty() ? 0 : offlinePending_.front().size() - offlineReadFrame_;
+#endif
+}
+
+size_t TimeStretchPitchProcessor::retrieve(float *const *output, size_t frames) {
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    return processor_->retrieve(output, frames);
 #else
-    return simulatedLatencySamples_;
+    const size_t count = std::min(frames, available());
+    for (int ch = 0; ch < channelCount_ && count > 0; ++ch) {
+        const float *start = offlinePending_[ch].data() + offlineReadFrame_;
+        std::copy(start, start + count, output[ch]);
+    }
+    offlineReadFrame_ += count;
+    return count;
 #endif
 }
 
+size_t TimeStretchPitchProcessor::scratchBytes(int channelCount, size_t maxBlockFrames) {
+    const auto channels = static_cast<size_t>(channelCount);
+    return 3 * channels * sizeof(float *) + maxBlockFrames * channels * sizeof(float);
+}
+
 void TimeStretchPitchProcessor::reset() {
 #ifdef DEEJAY_HAVE_RUBBERBAND
+    if (swap_) {
+        // Old input is meaningless after a seek: finish a crossfade outright and restart a pending build.
+        auto &swap = *swap_;
+        const int stage = swap.stage.load(std::memory_order_acquire);
+        if (stage == QualitySwap::Crossfading) {
+            finishSwap();
+        } else if (stage == QualitySwap::Feeding || stage == QualitySwap::Ready) {
+            int expected = stage;
+            if (swap.stage.compare_exchange_strong(expected, QualitySwap::Aborted, std::memory_order_acq_rel) ||
+                (expected == QualitySwap::Ready &&
+                 swap.stage.compare_exchange_strong(expected, QualitySwap::Aborted, std::memory_order_acq_rel))) {
+                StretcherBuilder::instance().wake();
+            }
+        }
+        swap.feeding = false;
+        swap.historyFill = 0;
+        swap.pendingCount = 0;
+        bypass_->stage = UnityBypass::Off;
+        unityBypassActive_.store(false, std::memory_order_relaxed);
+    }
     if (processor_) {
         processor_->reset();
     }
+#else
+    offlinePending_.clear();
+    offlineReadFrame_ = 0;
 #endif
 }
 
+#ifdef DEEJAY_HAVE_RUBBERBAND
+void TimeStretchPitchProcessor::beginBlock(const float *const *input, size_t frames) noexcept {
+    if (swap_ && !swap_->history.empty()) {
+        auto &swap = *swap_;
+        const auto channels = static_cast<size_t>(channelCount_);
+
+        // Keep the most recent kHistoryFrames of input for priming a replacement.
+        for (size_t done = 0; done < frames;) {
+            const size_t run = std::min(frames - done, kHistoryFrames - swap.historyWrite);
+            for (size_t ch = 0; ch < channels; ++ch) {
+                std::copy(input[ch] + done, input[ch] + done + run, swap.history.data() + ch * kHistoryFrames + swap.historyWrite);
+            }
+            swap.historyWrite = (swap.historyWrite + run) % kHistoryFrames;
+            done += run;
+        }
+        swap.historyFill = std::min(kHistoryFrames, swap.historyFill + frames);
+        swap.historyEnd += frames;
+        updateBypass(frames);
+        const auto bypassStage = bypass_->stage;
+
+        auto pushToHandoff = [&](const float *const *planar, size_t count) {
+            if (!swap.feeding) {
+                return;
+            }
+            if (swap.handoff->writeAvailable() < count * channels) {
+                // The builder fell too far behind, or Ready waited too long; start over rather than prime with a gap.
+                int expected = swap.stage.load(std::memory_order_acquire);
+                if ((expected == QualitySwap::Feeding || expected == QualitySwap::Ready) &&
+                    swap.stage.compare_exchange_strong(expected, QualitySwap::Aborted, std::memory_order_acq_rel)) {
+                    StretcherBuilder::instance().wake();
+                }
+                swap.feeding = false;
+                return;
+            }
+            interleave(planar, swap.handoffScratch.data(), channelCount_, count);
+            swap.handoff->write(swap.handoffScratch.data(), count * channels);
+        };
+
+        const int stage = swap.stage.load(std::memory_order_acquire);
+        if (stage == QualitySwap::Feeding && !swap.feeding) {
+            // First block of a build: hand over the whole history, oldest frames first; it includes this block.
+            swap.feeding = true;
+            size_t start = (swap.historyWrite + kHistoryFrames - swap.historyFill) % kHistoryFrames;
+            for (size_t remaining = swap.historyFill; remaining > 0 && swap.feeding;) {
+                const size_t run = std::min({remaining, kHistoryFrames - start, maxBlockFrames_});
+                for (size_t ch = 0; ch < channels; ++ch) {
+                    swap.historyChannels[ch] = swap.history.data() + ch * kHistoryFrames + start;
+                }
+                pushToHandoff(swap.historyChannels.data(), run);
+                start = (start + run) % kHistoryFrames;
+                remaining -= run;
+            }
+            swap.historyFrames.store(swap.historyFill, std::memory_order_relaxed);
+            swap.historyPublished.store(true, std::memory_order_release);
+        } else if (stage == QualitySwap::Feeding) {
+            pushToHandoff(input, frames);
+        } else if (stage == QualitySwap::Ready && bypassStage == UnityBypass::Engaged) {
+            // Nothing of the old stretcher is audible, so the replacement takes over outright. Leaving the bypass
+            // re-primes it from history like any other stretcher.
+            swap.feeding = false;
+            swap.candidate->setParameters(parameters_);
+            finishSwap();
+        } else if (stage == QualitySwap::Ready && swap.pendingCount == 0 && bypassStage == UnityBypass::Off) {
+            // The builder has stopped reading; feed the frames it left behind, then start the crossfade with the
+            // current block going to both stretchers. Waiting for `pending` to drain keeps the previous swap's
+            // leftover output in order.
+            swap.feeding = false;
+            while (true) {
+                const size_t count = std::min(swap.handoff->readAvailable() / channels, maxBlockFrames_);
+                if (count == 0) {
+                    break;
+                }
+                swap.handoff->read(swap.handoffScratch.data(), count * channels);
+                deinterleave(swap.handoffScratch.data(), swap.crossfadeChannels.data(), channelCount_, count);
+                swap.candidate->push(swap.crossfadeChannels.data(), count);
+            }
+            swap.candidate->setParameters(parameters_);
+
+            // Both have seen input up to this block, so each one's next output frame is the input frame its
+            // backlog plus its latency (in output frames, hence divided by the ratio) before here. How far the
+            // candidate trails, in its own output frames:
+            const double ratio = parameters_.tempoRatio;
+            const auto trailing = [ratio](const RubberBandAdapter &stretcher) {
+                return static_cast<double>(stretcher.backlog()) * ratio + static_cast<double>(stretcher.latency());
+            };
+            const auto offset = std::llround(trailing(*swap.candidate) - trailing(*processor_));
+            swap.discardFrames = offset > 0 ? static_cast<uint64_t>(offset) : 0;
+            swap.holdFrames = offset < 0 ? static_cast<uint64_t>(-offset) : 0;
+            swap.pendingRead = 0;
+            swap.pendingCount = 0;
+            swap.settleFrames = kSettleFrames;
+            swap.crossfadePosition = 0;
+            swap.stage.store(QualitySwap::Crossfading, std::memory_order_release);
+        } else if (stage == QualitySwap::Ready) {
+            // The crossfade has to wait (leftover output from the previous swap, or a bypass fade). Keep queueing
+            // input for the replacement; the backlog alignment cannot account for frames it never saw.
+            pushToHandoff(input, frames);
+        }
+
+        if (swap.stage.load(std::memory_order_relaxed) == QualitySwap::Crossfading) {
+            swap.candidate->push(input, frames);
+        }
+
+        if (bypassStage == UnityBypass::Engaged) {
+            return;
+        }
+        if (bypassStage == UnityBypass::Priming) {
+            primeFromHistory();
+            return;
+        }
+    }
+    processor_->push(input, frames);
+}
+
+void TimeStretchPitchProcessor::updateBypass(size_t frames) noexcept {
+    auto &bypass = *bypass_;
+    auto &swap = *swap_;
+    const bool wanted = unityBypassEnabled_.load(std::memory_order_relaxed) && parameters_.tempoRatio == 1.0 &&
+                        parameters_.pitchSemitones == 0.0;
+
+    switch (bypass.stage) {
+    case UnityBypass::Off: {
+        if (!wanted || swap.stage.load(std::memory_order_acquire) == QualitySwap::Crossfading || swap.pendingCount > 0) {
+            break;
+        }
+        // At unity the stretcher's next output frame is the input frame `backlog + latency` frames before this
+        // block; the bypass picks up from there. Wait until the history reaches back that far.
+        const uint64_t lag = processor_->backlog() + processor_->latency();
+        if (lag + frames <= swap.historyFill) {
+            bypass.readPosition = swap.historyEnd - frames - lag;
+            bypass.fadePosition = 0;
+            bypass.stage = UnityBypass::Engaging;
+        }
+        break;
+    }
+    case UnityBypass::Engaged:
+        if (!wanted) {
+            // Restart the stretcher a little before the bypass read point so its output has settled by then.
+            processor_->reset();
+            const uint64_t oldest = swap.historyEnd - swap.historyFill;
+            bypass.primeStart = std::max(oldest, bypass.readPosition > kPrimeFrames ? bypass.readPosition - kPrimeFrames : 0);
+            bypass.primePosition = bypass.primeStart;
+            bypass.primeBlocks = 0;
+            bypass.stage = UnityBypass::Priming;
+        }
+        break;
+    case UnityBypass::Priming:
+        if (wanted) {
+            bypass.stage = UnityBypass::Engaged;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void TimeStretchPitchProcessor::primeFromHistory() noexcept {
+    auto &bypass = *bypass_;
+    auto &swap = *swap_;
+
+    const uint64_t limit = std::min<uint64_t>(swap.historyEnd, bypass.primePosition + kPrimeBlocksPerCall * maxBlockFrames_);
+    while (bypass.primePosition < limit) {
+        const auto count = static_cast<size_t>(std::min<uint64_t>(limit - bypass.primePosition, maxBlockFrames_));
+        swap.readHistory(bypass.primePosition, count, bypass.channels.data());
+        processor_->push(bypass.channels.data(), count);
+        bypass.primePosition += count;
+    }
+
+    // The reset stretcher's next output frame comes from history frame primePosition - backlog - latency / ratio
+    // (its latency is in output frames, which cover 1 / ratio input frames each); everything before the bypass
+    // read point is warm-up. Working in input frames keeps this right at any ratio, and while the ratio glides.
+    const double ratio = parameters_.tempoRatio;
+    double behind = 0.0;
+    while (true) {
+        const double next = static_cast<double>(bypass.primePosition - processor_->backlog()) -
+                            static_cast<double>(processor_->latency()) / ratio;
+        behind = static_cast<double>(bypass.readPosition) - next;
+        if (behind < 1.0) {
+            break;
+        }
+        const auto wanted = std::clamp<size_t>(static_cast<size_t>(behind * ratio), 1, maxBlockFrames_);
+        if (processor_->retrieve(bypass.channels.data(), wanted) == 0) {
+            break;
+        }
+    }
+
+    if (bypass.primePosition == swap.historyEnd && (behind < 1.0 || ++bypass.primeBlocks >= kPrimeTimeoutBlocks)) {
+        bypass.fadePosition = 0;
+        bypass.stage = UnityBypass::Releasing;
+    }
+}
+
+size_t TimeStretchPitchProcessor::retrieveBypassed(float *const *output, size_t frames) noexcept {
+    auto &bypass = *bypass_;
+    const auto &swap = *swap_;
+    const auto channels = static_cast<size_t>(channelCount_);
+    const auto fadeLength = static_cast<float>(bypass.fadeFrames);
+
+    size_t written = 0;
+    while (written < frames) {
+        for (size_t ch = 0; ch < channels; ++ch) {
+            bypass.offsetChannels[ch] = output[ch] + written;
+        }
+
+        if (bypass.stage == UnityBypass::Off) {
+            return written + processor_->retrieve(bypass.offsetChannels.data(), frames - written);
+        }
+
+        if (bypass.stage == UnityBypass::Engaged || bypass.stage == UnityBypass::Priming) {
+            // Hand out input at a constant delay: as many frames as came in since the bypass engaged.
+            const uint64_t queued = swap.historyEnd - bypass.readPosition;
+            const auto count = static_cast<size_t>(
+                queued > bypass.delayFrames ? std::min<uint64_t>(frames - written, queued - bypass.delayFrames) : 0);
+            if (count == 0) {
+                break;
+            }
+            swap.readHistory(bypass.readPosition, count, bypass.offsetChannels.data());
+            bypass.readPosition += count;
+            written += count;
+            continue;
+        }
+
+        // Fading: the stretcher sets the pace and the delayed input follows frame for frame, so the two stay
+        // aligned however the stretcher's hops fall.
+        const size_t count = processor_->retrieve(bypass.offsetChannels.data(), std::min(frames - written, maxBlockFrames_));
+        if (count == 0) {
+            break;
+        }
+        swap.readHistory(bypass.readPosition, count, bypass.channels.data());
+        bypass.readPosition += count;
+        const bool engaging = bypass.stage == UnityBypass::Engaging;
+        for (size_t ch = 0; ch < channels; ++ch) {
+            float *target = bypass.offsetChannels[ch];
+            const float *delayed = bypass.channels[ch];
+            for (size_t i = 0; i < count; ++i) {
+                const float gain = std::min(1.0f, static_cast<float>(bypass.fadePosition + i) / fadeLength);
+                const float from = engaging ? target[i] : delayed[i];
+                const float to = engaging ? delayed[i] : target[i];
+                target[i] = from + (to - from) * gain;
+            }
+        }
+        bypass.fadePosition += count;
+        written += count;
+
+        if (bypass.fadePosition >= bypass.fadeFrames) {
+            if (engaging) {
+                bypass.delayFrames = swap.historyEnd - bypass.readPosition;
+                bypass.stage = UnityBypass::Engaged;
+                unityBypassActive_.store(true, std::memory_order_relaxed);
+            } else {
+                bypass.stage = UnityBypass::Off;
+                unityBypassActive_.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+    return written;
+}
+
+size_t TimeStretchPitchProcessor::retrieveMixed(float *const *output, size_t frames) noexcept {
+    if (bypass_ && bypass_->stage != UnityBypass::Off) {
+        return retrieveBypassed(output, frames);
+    }
+    if (!swap_ || (swap_->stage.load(std::memory_order_relaxed) != QualitySwap::Crossfading && swap_->pendingCount == 0)) {
+        return processor_->retrieve(output, frames);
+    }
+
+    auto &swap = *swap_;
+    const auto channels = static_cast<size_t>(channelCount_);
+    const auto fadeLength = static_cast<float>(swap.crossfadeFrames);
+
+    // Moves candidate output into `pending`, dropping what precedes the alignment point.
+    auto fillPending = [&] {
+        while (swap.discardFrames > 0) {
+            const size_t dropped = swap.candidate->retrieve(
+                swap.crossfadeChannels.data(), static_cast<size_t>(std::min<uint64_t>(swap.discardFrames, maxBlockFrames_)));
+            if (dropped == 0) {
+                return;
+            }
+            swap.discardFrames -= dropped;
+        }
+        while (swap.pendingCount < kPendingFrames) {
+            const size_t write = (swap.pendingRead + swap.pendingCount) % kPendingFrames;
+            const size_t space = std::min(kPendingFrames - swap.pendingCount, kPendingFrames - write);
+            for (size_t ch = 0; ch < channels; ++ch) {
+                swap.pendingChannels[ch] = swap.pending.data() + ch * kPendingFrames + write;
+            }
+            const size_t retrieved = swap.candidate->retrieve(swap.pendingChannels.data(), space);
+            if (retrieved == 0) {
+                return;
+            }
+            swap.pendingCount += retrieved;
+        }
+    };
+
+    // Mixes (fade), copies (after the swap) or, while settling, drops `count` pending frames at `offset`.
+    auto consumePending = [&](size_t offset, size_t count, bool fade) {
+        for (size_t done = 0; done < count;) {
+            const size_t run = std::min(count - done, kPendingFrames - swap.pendingRead);
+            for (size_t ch = 0; ch < channels && (!fade || swap.settleFrames == 0); ++ch) {
+                const float *replacement = swap.pending.data() + ch * kPendingFrames + swap.pendingRead;
+                float *target = output[ch] + offset + done;
+                if (!fade) {
+                    std::copy(replacement, replacement + run, target);
+                    continue;
+                }
+                for (size_t i = 0; i < run; ++i) {
+                    const float gain = std::min(1.0f, static_cast<float>(swap.crossfadePosition + i) / fadeLength);
+                    target[i] += (replacement[i] - target[i]) * gain;
+                }
+            }
+            if (fade && swap.settleFrames > 0) {
+                swap.settleFrames -= run;
+            } else if (fade) {
+                swap.crossfadePosition += run;
+            }
+            swap.pendingRead = (swap.pendingRead + run) % kPendingFrames;
+            swap.pendingCount -= run;
+            done += run;
+        }
+    };
+
+    size_t written = 0;
+    while (written < frames) {
+        if (swap.stage.load(std::memory_order_relaxed) != QualitySwap::Crossfading) {
+            // The replacement is live: hand out what it produced during the fade before asking it for more.
+            const size_t drained = std::min(swap.pendingCount, frames - written);
+            consumePending(written, drained, false);
+            written += drained;
+            if (written < frames) {
+                for (size_t ch = 0; ch < channels; ++ch) {
+                    swap.offsetChannels[ch] = output[ch] + written;
+                }
+                written += processor_->retrieve(swap.offsetChannels.data(), frames - written);
+            }
+            break;
+        }
+
+        for (size_t ch = 0; ch < channels; ++ch) {
+            swap.offsetChannels[ch] = output[ch] + written;
+        }
+        const size_t count = processor_->retrieve(swap.offsetChannels.data(), std::min(frames - written, maxBlockFrames_));
+        if (count == 0) {
+            break;
+        }
+
+        // Both stretchers have seen the same input, so a linear fade between aligned outputs stays click-free.
+        // Frames the candidate cannot supply yet are played from the old stretcher alone, which delays the
+        // candidate by less than one hop; that only happens while settling, after which `pending` covers it.
+        fillPending();
+        const size_t held = static_cast<size_t>(std::min<uint64_t>(swap.holdFrames, count));
+        swap.holdFrames -= held;
+        const size_t available = swap.discardFrames > 0 ? 0 : std::min(swap.pendingCount, count - held);
+        const size_t settled = std::min(swap.settleFrames, available);
+        consumePending(written + held, settled, true);
+        consumePending(written + held + settled, available - settled, true);
+        written += count;
+
+        if (swap.crossfadePosition >= swap.crossfadeFrames) {
+            finishSwap();
+        }
+    }
+    return written;
+}
+
+void TimeStretchPitchProcessor::finishSwap() noexcept {
+    auto &swap = *swap_;
+    std::swap(processor_, swap.candidate);
+    latencySamples_ = processor_->latency();
+    activeQuality_.store(swap.candidateQuality);
+    // The retired stretcher is destroyed by the builder, off the audio thread.
+    swap.stage.store(QualitySwap::Retire, std::memory_order_release);
+    StretcherBuilder::instance().wake();
+}
+#endif
+
 void TimeStretchPitchProcessor::configureProcessor() {
 #ifdef DEEJAY_HAVE_RUBBERBAND
-    processor_ = std::make_unique<RubberBandAdapter>(sampleRate_, channelCount_, parameters_);
+    processor_ = std::make_unique<RubberBandAdapter>(sampleRate_, channelCount_, parameters_, options_);
+    if (maxBlockFrames_ > 0) {
+        processor_->prepare(maxBlockFrames_);
+    }
+    latencySamples_ = processor_->latency();
 #else
-    simulatedLatencySamples_ = static_cast<size_t>(sampleRate_ * 0.01);
+    latencySamples_ = static_cast<size_t>(sampleRate_ * 0.01);
 #endif
 }
 
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "Interleave.h"
+
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -22,6 +26,19 @@ public:
         StretchQuality quality{};
     };
 
+    // Construction-time engine settings; unlike Parameters these cannot change while streaming.
+    struct Options {
+        // Keep the stretcher on the calling thread instead of letting Rubber Band spawn its own workers.
+        // DeckEngine sets this and schedules decks on its fixed pool, so the thread count stays bounded.
+        bool singleThreaded{false};
+        // Offline mode trades latency for quality: the whole input is studied before it is processed, which
+        // is what batch rendering wants. Only the study/push/retrieve API below is meaningful in this mode.
+        bool offline{false};
+        // Where the processor's own channel tables and scratch are allocated (a DeckArena in the engine);
+        // nullptr uses the default resource. Rubber Band's internal state is always heap-allocated.
+        std::pmr::memory_resource *memory{nullptr};
+    };
+
     struct EndpointDescriptor {
         std::string id;
         std::string label;
@@ -32,15 +49,74 @@ public:
         std::string description;
     };
 
-    TimeStretchPitchProcessor(double sampleRate, int channelCount, Parameters defaults = {});
+    TimeStretchPitchProcessor(double sampleRate, int channelCount);
+    TimeStretchPitchProcessor(double sampleRate, int channelCount, Parameters defaults);
+    TimeStretchPitchProcessor(double sampleRate, int channelCount, Parameters defaults, Options options);
+    ~TimeStretchPitchProcessor();
 
+    // Not synchronized: call from the thread that runs process(), or before streaming starts.
+    // LatencyCompensatedProcessor routes control-thread writes through its lock-free queue instead.
+    // A quality that differs from the last requested one is forwarded to requestQuality().
     void setParameters(const Parameters &parameters);
+    // Tempo and pitch as applied, with the most recently requested quality.
     Parameters getParameters() const;
 
+    // Thread-safe and realtime-safe. Quality settings are fixed per Rubber Band instance, so a change is applied
+    // by building a replacement stretcher on a background thread, priming it with recent input and crossfading
+    // to it inside the realtime process() overloads, which drive the swap; the audio thread never constructs or
+    // destroys a stretcher. Requests made while a swap is under way are coalesced and applied after it. Offline
+    // processors keep their construction-time quality, and the stub build applies the quality immediately.
+    void requestQuality(const StretchQuality &quality) noexcept;
+    // Quality of the stretcher currently producing output.
+    StretchQuality activeQuality() const noexcept;
+    bool qualitySwapPending() const noexcept;
+
+    // Thread-safe; enabled by default. While enabled, a realtime processor whose tempo ratio is exactly 1 and
+    // pitch exactly 0 stops running the stretcher and plays its input through a delay matched to the
+    // stretcher's, crossfading on the way in and out, so getLatencySamples() does not change. Leaving the bypass
+    // re-primes the stretcher from recent input over a few blocks before fading back. The stub build is already
+    // a plain copy and only reports the state.
+    void setUnityBypass(bool enabled) noexcept;
+    bool unityBypassEnabled() const noexcept { return unityBypassEnabled_.load(std::memory_order_relaxed); }
+    // True while the stretcher is skipped.
+    bool unityBypassActive() const noexcept;
+    const Options &options() const noexcept { return options_; }
+
     std::vector<EndpointDescriptor> describeEndpoints() const;
 
+    // Preallocates everything the realtime process() overload needs for blocks of up to maxBlockFrames.
+    // Call from a non-realtime thread before streaming starts.
+    void prepare(size_t maxBlockFrames);
+    size_t maxBlockFrames() const noexcept { return maxBlockFrames_; }
+
     size_t process(const float *input, size_t frames, std::vector<float> &output);
-    size_t getLatencySamples() const;
+
+    // Realtime-safe after prepare(): reads `frames` planar input frames (frames <= maxBlockFrames()) through
+    // the input channel table and writes at most outputCapacity frames through the output channel table.
+    // Returns the number of frames written; anything beyond the capacity stays queued in the stretcher.
+    size_t process(const float *const *input, size_t frames, float *const *output, size_t outputCapacity);
+
+    // Layout-aware variant of the realtime overload; input and output share `layout`. Planar channels start at
+    // ch * frames (input) and ch * outputCapacity (output). Interleaved blocks are converted by the SIMD kernels
+    // in Interleave.h on their way into and out of the stretcher, so device buffers can be handed over directly.
+    size_t process(const float *input, size_t frames, float *output, size_t outputCapacity, SampleLayout layout);
+
+    // Input frames to feed before roughly `outputFrames` more output frames become available.
+    size_t inputFramesRequired(size_t outputFrames) const;
+
+    // Offline mode (Options::offline). Announce the input length, study() every chunk of the complete input
+    // (final on the last one), then push() the same input again and drain the output with retrieve().
+    void setExpectedInputDuration(size_t frames);
+    void study(const float *const *input, size_t frames, bool final);
+    void push(const float *const *input, size_t frames, bool final);
+    size_t available() const;
+    size_t retrieve(float *const *output, size_t frames);
+
+    // Cached: refreshed whenever the parameters change or a quality swap hands over a new stretcher, so per-block
+    // callers do not query the library.
+    size_t getLatencySamples() const noexcept { return latencySamples_; }
+    // Upper bound of what construction and prepare(maxBlockFrames) allocate from Options::memory.
+    static size_t scratchBytes(int channelCount, size_t maxBlockFrames);
     void reset();
 
     int channelCount() const noexcept { return channelCount_; }
@@ -52,12 +128,51 @@ private:
     double sampleRate_{0.0};
     int channelCount_{0};
     Parameters parameters_{};
+    Options options_{};
+    size_t maxBlockFrames_{0};
+    size_t latencySamples_{0};
+    std::pmr::vector<const float *> inputChannels_;
+    std::pmr::vector<float *> outputChannels_;
+    std::pmr::vector<float> layoutScratch_;
+    std::pmr::vector<float *> scratchChannels_;
+
+    // Quality fields as atomics so requestQuality() and activeQuality() work from any thread. A reader may see a
+    // mix of two back-to-back requests for an instant; the swap machinery re-reads after every change.
+    struct SharedQuality {
+        std::atomic<float> formantPreservation{0.5f};
+        std::atomic<float> transientSensitivity{0.5f};
+        std::atomic<bool> highQuality{true};
+
+        void store(const StretchQuality &quality) noexcept;
+        StretchQuality load() const noexcept;
+    };
+    SharedQuality requestedQuality_;
+    SharedQuality activeQuality_;
+    std::atomic<bool> unityBypassEnabled_{true};
+    std::atomic<bool> unityBypassActive_{false};
 
 #ifdef DEEJAY_HAVE_RUBBERBAND
     class RubberBandAdapter;
+    struct QualitySwap;
+    struct UnityBypass;
+
+    // Audio-thread halves of the quality swap and the unity bypass: record input history, hand a replacement
+    // stretcher over, step the bypass, crossfade.
+    void beginBlock(const float *const *input, size_t frames) noexcept;
+    size_t retrieveMixed(float *const *output, size_t frames) noexcept;
+    void finishSwap() noexcept;
+    void updateBypass(size_t frames) noexcept;
+    void primeFromHistory() noexcept;
+    size_t retrieveBypassed(float *const *output, size_t frames) noexcept;
+
     std::unique_ptr<RubberBandAdapter> processor_;
+    std::shared_ptr<QualitySwap> swap_;
+    std::unique_ptr<UnityBypass> bypass_;
 #else
-    size_t simulatedLatencySamples_{0};
+    std::atomic<bool> atUnity_{true};
+    // Offline frames pushed but not yet retrieved, one vector per channel.
+    std::vector<std::vector<float>> offlinePending_;
+    size_t offlineReadFrame_{0};
 #endif
 };
 
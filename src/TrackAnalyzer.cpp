@@ -0,0 +1,613 @@
+#include "TrackAnalyzer.h"
+
+#include "WavFileReader.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define DEEJAY_ANALYZER_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace deejay {
+
+namespace {
+
+constexpr char kMagic[4] = {'D', 'J', 'A', 'N'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderBytes = 56;
+// Onset envelope compression: log(1 + kOnsetCompression * energy) keeps quiet intros from vanishing.
+constexpr double kOnsetCompression = 1000.0;
+constexpr double kBpmStep = 0.01;
+constexpr int kCombHarmonics = 4;
+// Grid refinement around the autocorrelation estimate: +-1 % of the tempo, phase in quarter hops.
+constexpr double kRefineRange = 0.01;
+constexpr double kPhaseStep = 0.25;
+
+struct BinStats {
+    float minimum;
+    float maximum;
+    float sumSquares;
+};
+
+// Min, max and sum of squares of `count` contiguous samples.
+BinStats binStats(const float *samples, size_t count) noexcept {
+    float minimum = std::numeric_limits<float>::infinity();
+    float maximum = -std::numeric_limits<float>::infinity();
+    float sumSquares = 0.0f;
+    size_t i = 0;
+#if defined(__AVX2__)
+    if (count >= 8) {
+        __m256 lo = _mm256_loadu_ps(samples);
+        __m256 hi = lo;
+        __m256 squares = _mm256_mul_ps(lo, lo);
+        for (i = 8; i + 8 <= count; i += 8) {
+            const __m256 v = _mm256_loadu_ps(samples + i);
+            lo = _mm256_min_ps(lo, v);
+            hi = _mm256_max_ps(hi, v);
+            squares = _mm256_add_ps(squares, _mm256_mul_ps(v, v));
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, lo);
+        minimum = *std::min_element(lanes, lanes + 8);
+        _mm256_storeu_ps(lanes, hi);
+        maximum = *std::max_element(lanes, lanes + 8);
+        _mm256_storeu_ps(lanes, squares);
+        sumSquares = std::accumulate(lanes, lanes + 8, 0.0f);
+    }
+#elif defined(DEEJAY_ANALYZER_SSE2)
+    if (count >= 4) {
+        __m128 lo = _mm_loadu_ps(samples);
+        __m128 hi = lo;
+        __m128 squares = _mm_mul_ps(lo, lo);
+        for (i = 4; i + 4 <= count; i += 4) {
+            const __m128 v = _mm_loadu_ps(samples + i);
+            lo = _mm_min_ps(lo, v);
+            hi = _mm_max_ps(hi, v);
+            squares = _mm_add_ps(squares, _mm_mul_ps(v, v));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, lo);
+        minimum = *std::min_element(lanes, lanes + 4);
+        _mm_storeu_ps(lanes, hi);
+        maximum = *std::max_element(lanes, lanes + 4);
+        _mm_storeu_ps(lanes, squares);
+        sumSquares = std::accumulate(lanes, lanes + 4, 0.0f);
+    }
+#elif defined(__ARM_NEON)
+    if (count >= 4) {
+        float32x4_t lo = vld1q_f32(samples);
+        float32x4_t hi = lo;
+        float32x4_t squares = vmulq_f32(lo, lo);
+        for (i = 4; i + 4 <= count; i += 4) {
+            const float32x4_t v = vld1q_f32(samples + i);
+            lo = vminq_f32(lo, v);
+            hi = vmaxq_f32(hi, v);
+            squares = vmlaq_f32(squares, v, v);
+        }
+        float lanes[4];
+        vst1q_f32(lanes, lo);
+        minimum = *std::min_element(lanes, lanes + 4);
+        vst1q_f32(lanes, hi);
+        maximum = *std::max_element(lanes, lanes + 4);
+        vst1q_f32(lanes, squares);
+        sumSquares = std::accumulate(lanes, lanes + 4, 0.0f);
+    }
+#endif
+    for (; i < count; ++i) {
+        minimum = std::min(minimum, samples[i]);
+        maximum = std::max(maximum, samples[i]);
+        sumSquares += samples[i] * samples[i];
+    }
+    return {minimum, maximum, sumSquares};
+}
+
+int16_t quantize(float value) noexcept {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+int8_t quantizeBand(float value, float scale) noexcept {
+    return static_cast<int8_t>(std::lround(std::clamp(value * scale, -1.0f, 1.0f) * 127.0f));
+}
+
+// Merges every `factor` consecutive bins into one; the last one may cover fewer.
+std::vector<BinStats> mergeBins(const std::vector<BinStats> &bins, size_t factor) {
+    std::vector<BinStats> merged;
+    merged.reserve(bins.size() / factor + 1);
+    for (size_t b = 0; b < bins.size(); b += factor) {
+        BinStats stats = bins[b];
+        for (size_t i = b + 1; i < std::min(bins.size(), b + factor); ++i) {
+            stats.minimum = std::min(stats.minimum, bins[i].minimum);
+            stats.maximum = std::max(stats.maximum, bins[i].maximum);
+            stats.sumSquares += bins[i].sumSquares;
+        }
+        merged.push_back(stats);
+    }
+    return merged;
+}
+
+// Three-way split for the deck display: low is a 12 dB/octave low-pass at the first crossover, high the signal
+// minus a 12 dB/octave low-pass at the second, and mid what is left. The bands sum back to the input.
+class BandSplitter {
+public:
+    BandSplitter(double sampleRate, float lowHz, float highHz)
+        : lowCoefficient_(coefficient(sampleRate, lowHz)), highCoefficient_(coefficient(sampleRate, highHz)) {}
+
+    void split(const float *input, size_t frames, float *low, float *mid, float *high) noexcept {
+        for (size_t f = 0; f < frames; ++f) {
+            low1_ += lowCoefficient_ * (input[f] - low1_);
+            low2_ += lowCoefficient_ * (low1_ - low2_);
+            belowHigh1_ += highCoefficient_ * (input[f] - belowHigh1_);
+            belowHigh2_ += highCoefficient_ * (belowHigh1_ - belowHigh2_);
+            low[f] = low2_;
+            high[f] = input[f] - belowHigh2_;
+            mid[f] = belowHigh2_ - low2_;
+        }
+    }
+
+private:
+    static float coefficient(double sampleRate, float cutoffHz) noexcept {
+        const double kPi = 3.14159265358979323846;
+        return static_cast<float>(1.0 - std::exp(-2.0 * kPi * cutoffHz / sampleRate));
+    }
+
+    float lowCoefficient_;
+    float highCoefficient_;
+    float low1_{0.0f};
+    float low2_{0.0f};
+    float belowHigh1_{0.0f};
+    float belowHigh2_{0.0f};
+};
+
+// Linearly interpolated read of `values` at a fractional index; 0 past the end.
+double sampleAt(const std::vector<double> &values, double index) noexcept {
+    const auto whole = static_cast<size_t>(index);
+    if (whole + 1 >= values.size()) {
+        return whole < values.size() ? values[whole] : 0.0;
+    }
+    const double fraction = index - static_cast<double>(whole);
+    return values[whole] + (values[whole + 1] - values[whole]) * fraction;
+}
+
+// Mean onset strength on the grid of `period` hops at its best phase, which is returned in `phase`.
+double gridStrength(const std::vector<double> &onset, double period, double &phase) noexcept {
+    double best = -1.0;
+    for (double offset = 0.0; offset < period; offset += kPhaseStep) {
+        double strength = 0.0;
+        size_t beats = 0;
+        for (double position = offset; position < static_cast<double>(onset.size()); position += period, ++beats) {
+            strength += sampleAt(onset, position);
+        }
+        strength /= static_cast<double>(std::max<size_t>(beats, 1));
+        if (strength > best) {
+            best = strength;
+            phase = offset;
+        }
+    }
+    return best;
+}
+
+struct TempoEstimate {
+    double bpm{0.0};
+    double firstBeatSeconds{0.0};
+    float confidence{0.0f};
+};
+
+// Tempo from the autocorrelation of the onset envelope, scored as a comb over the first few multiples of each
+// candidate period and weighted towards 120 BPM to settle octave ambiguity; then the grid phase that collects
+// the most onset strength.
+TempoEstimate estimateTempo(const std::vector<float> &hopEnergy, double hopRate, double minimumBpm,
+                            double maximumBpm) {
+    TempoEstimate estimate;
+    const size_t hops = hopEnergy.size();
+    const double longestPeriod = 60.0 * hopRate / minimumBpm;
+    const auto maxLag = static_cast<size_t>(std::ceil(longestPeriod * kCombHarmonics)) + 2;
+    if (hops < 2 * maxLag) {
+        return estimate;
+    }
+
+    std::vector<double> onset(hops, 0.0);
+    double previous = std::log1p(kOnsetCompression * hopEnergy[0]);
+    for (size_t h = 1; h < hops; ++h) {
+        const double current = std::log1p(kOnsetCompression * hopEnergy[h]);
+        onset[h] = std::max(0.0, current - previous);
+        previous = current;
+    }
+    const double mean = std::accumulate(onset.begin(), onset.end(), 0.0) / static_cast<double>(hops);
+    if (mean <= 0.0) {
+        return estimate;
+    }
+    std::vector<double> centered(hops);
+    for (size_t h = 0; h < hops; ++h) {
+        centered[h] = onset[h] - mean;
+    }
+
+    std::vector<double> autocorrelation(maxLag + 1, 0.0);
+    for (size_t lag = 1; lag <= maxLag; ++lag) {
+        double sum = 0.0;
+        for (size_t h = 0; h + lag < hops; ++h) {
+            sum += centered[h] * centered[h + lag];
+        }
+        autocorrelation[lag] = sum / static_cast<double>(hops - lag);
+    }
+
+    double bestScore = -std::numeric_limits<double>::infinity();
+    double scoreSum = 0.0;
+    size_t candidates = 0;
+    for (double bpm = minimumBpm; bpm <= maximumBpm; bpm += kBpmStep) {
+        const double period = 60.0 * hopRate / bpm;
+        double score = 0.0;
+        for (int k = 1; k <= kCombHarmonics; ++k) {
+            score += sampleAt(autocorrelation, period * k);
+        }
+        const double octaves = std::log2(bpm / 120.0);
+        score *= std::exp(-0.5 * octaves * octaves);
+        if (score > bestScore) {
+            bestScore = score;
+            estimate.bpm = bpm;
+        }
+        scoreSum += std::max(score, 0.0);
+        ++candidates;
+    }
+    if (bestScore <= 0.0) {
+        estimate.bpm = 0.0;
+        return estimate;
+    }
+    estimate.confidence = static_cast<float>(bestScore / (scoreSum / static_cast<double>(candidates)));
+
+    // The autocorrelation peak is only as sharp as a hop; fitting the whole grid against the onsets pins the
+    // tempo down to where the beats of a long track stay in phase from the first to the last.
+    const double coarseBpm = estimate.bpm;
+    double bestStrength = -1.0;
+    double bestPhase = 0.0;
+    for (double bpm = coarseBpm * (1.0 - kRefineRange); bpm <= coarseBpm * (1.0 + kRefineRange); bpm += kBpmStep) {
+        double phase = 0.0;
+        const double strength = gridStrength(onset, 60.0 * hopRate / bpm, phase);
+        if (strength > bestStrength) {
+            bestStrength = strength;
+            bestPhase = phase;
+            estimate.bpm = bpm;
+        }
+    }
+    estimate.bpm = std::round(estimate.bpm * 100.0) / 100.0;
+    // An onset lands somewhere inside its hop; centre it, and keep the first beat within the first period.
+    const double period = 60.0 * hopRate / estimate.bpm;
+    estimate.firstBeatSeconds = std::fmod(bestPhase + 0.5, period) / hopRate;
+    return estimate;
+}
+
+void putLe32(unsigned char *bytes, uint32_t value) noexcept {
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void putLe64(unsigned char *bytes, uint64_t value) noexcept {
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void putDouble(unsigned char *bytes, double value) noexcept {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putLe64(bytes, bits);
+}
+
+uint32_t readLe32(const unsigned char *bytes) noexcept {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+uint64_t readLe64(const unsigned char *bytes) noexcept {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+double readDouble(const unsigned char *bytes) noexcept {
+    const uint64_t bits = readLe64(bytes);
+    double value = 0.0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+TrackAnalyzer::TrackAnalyzer(Settings settings) : settings_(settings) {
+    settings_.baseFramesPerBin = std::max<uint32_t>(settings_.baseFramesPerBin, 1);
+    settings_.levelFactor = std::max<uint32_t>(settings_.levelFactor, 2);
+    settings_.levelCount = std::max<uint32_t>(settings_.levelCount, 1);
+    settings_.onsetHopFrames = std::max<uint32_t>(settings_.onsetHopFrames, 1);
+    // Chunks end on both a bin and a hop boundary, so only the last chunk of a track has partial ones.
+    const size_t boundary = std::lcm<size_t>(settings_.baseFramesPerBin, settings_.onsetHopFrames);
+    settings_.chunkFrames = (std::max(settings_.chunkFrames, boundary) + boundary - 1) / boundary * boundary;
+    if (settings_.threads == 0) {
+        settings_.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+TrackAnalyzer::TrackAnalyzer() : TrackAnalyzer(Settings{}) {}
+
+TrackAnalyzer::Analysis TrackAnalyzer::analyze(const std::string &path) const {
+    WavFileReader reader(path);
+    const auto channels = static_cast<size_t>(reader.channelCount());
+    const size_t chunk = settings_.chunkFrames;
+    const size_t binFrames = settings_.baseFramesPerBin;
+    const size_t hopFrames = settings_.onsetHopFrames;
+
+    Analysis analysis;
+    analysis.sampleRate = reader.sampleRate();
+    analysis.channelCount = static_cast<uint32_t>(channels);
+    analysis.frameCount = reader.totalFrames();
+
+    const auto binCount = static_cast<size_t>((analysis.frameCount + binFrames - 1) / binFrames);
+    std::vector<BinStats> bins;
+    bins.reserve(binCount);
+    std::vector<float> hopEnergy;
+    hopEnergy.reserve(static_cast<size_t>(analysis.frameCount / hopFrames + 1));
+    std::array<std::vector<BinStats>, WaveformPyramid::kBandCount> bandBins;
+    for (auto &band : bandBins) {
+        band.reserve(binCount);
+    }
+
+    std::vector<float> interleaved(chunk * channels);
+    std::vector<float> mono(chunk);
+    std::array<std::vector<float>, WaveformPyramid::kBandCount> bands;
+    for (auto &band : bands) {
+        band.resize(chunk);
+    }
+    BandSplitter splitter(analysis.sampleRate, settings_.lowCrossoverHz, settings_.highCrossoverHz);
+    const float channelScale = 1.0f / static_cast<float>(channels);
+    float previousSample = 0.0f;
+    for (;;) {
+        const size_t frames = reader.readFrames(interleaved.data(), chunk);
+        if (frames == 0) {
+            break;
+        }
+        for (size_t f = 0; f < frames; ++f) {
+            float sum = 0.0f;
+            for (size_t ch = 0; ch < channels; ++ch) {
+                sum += interleaved[f * channels + ch];
+            }
+            mono[f] = sum * channelScale;
+        }
+        splitter.split(mono.data(), frames, bands[0].data(), bands[1].data(), bands[2].data());
+        for (size_t start = 0; start < frames; start += binFrames) {
+            const size_t count = std::min(binFrames, frames - start);
+            bins.push_back(binStats(mono.data() + start, count));
+            for (size_t band = 0; band < bands.size(); ++band) {
+                bandBins[band].push_back(binStats(bands[band].data() + start, count));
+            }
+        }
+        // Energy of the first difference: a cheap high-pass that makes percussive onsets stand out of the bass.
+        for (size_t start = 0; start < frames; start += hopFrames) {
+            const size_t end = std::min(start + hopFrames, frames);
+            float energy = 0.0f;
+            for (size_t f = start; f < end; ++f) {
+                const float difference = mono[f] - previousSample;
+                energy += difference * difference;
+                previousSample = mono[f];
+            }
+            hopEnergy.push_back(energy / static_cast<float>(end - start));
+        }
+    }
+
+    // Level 0 comes straight from the bins; every further level merges `levelFactor` bins of the one below.
+    std::vector<BinStats> level = std::move(bins);
+    uint64_t framesPerBin = binFrames;
+    for (uint32_t index = 0; index < settings_.levelCount && !level.empty(); ++index) {
+        PeakLevel peaks;
+        peaks.framesPerBin = static_cast<uint32_t>(framesPerBin);
+        peaks.minimum.resize(level.size());
+        peaks.maximum.resize(level.size());
+        peaks.rms.resize(level.size());
+        for (size_t b = 0; b < level.size(); ++b) {
+            const uint64_t first = b * framesPerBin;
+            const uint64_t covered = std::min<uint64_t>(framesPerBin, analysis.frameCount - first);
+            peaks.minimum[b] = quantize(level[b].minimum);
+            peaks.maximum[b] = quantize(level[b].maximum);
+            peaks.rms[b] = quantize(std::sqrt(level[b].sumSquares / static_cast<float>(covered)));
+        }
+        analysis.levels.push_back(std::move(peaks));
+
+        level = mergeBins(level, settings_.levelFactor);
+        framesPerBin *= settings_.levelFactor;
+    }
+
+    WaveformPyramid &waveform = analysis.waveform;
+    waveform.sampleRate = analysis.sampleRate;
+    waveform.frameCount = analysis.frameCount;
+    waveform.levelFactor = settings_.levelFactor;
+    waveform.crossoverHz = {{settings_.lowCrossoverHz, settings_.highCrossoverHz}};
+    std::array<float, WaveformPyramid::kBandCount> bandScale{};
+    for (size_t band = 0; band < bandBins.size(); ++band) {
+        float peak = 0.0f;
+        for (const auto &bin : bandBins[band]) {
+            peak = std::max({peak, -bin.minimum, bin.maximum});
+        }
+        waveform.bandPeak[band] = peak;
+        bandScale[band] = peak > 0.0f ? 1.0f / peak : 0.0f;
+    }
+    framesPerBin = binFrames;
+    for (uint32_t index = 0; index < settings_.levelCount && !bandBins[0].empty(); ++index) {
+        WaveformPyramid::Level bandLevel;
+        bandLevel.framesPerBin = static_cast<uint32_t>(framesPerBin);
+        bandLevel.values.resize(bandBins[0].size() * WaveformPyramid::kBandCount * 2);
+        int8_t *value = bandLevel.values.data();
+        for (size_t b = 0; b < bandBins[0].size(); ++b) {
+            for (size_t band = 0; band < bandBins.size(); ++band) {
+                *value++ = quantizeBand(bandBins[band][b].minimum, bandScale[band]);
+                *value++ = quantizeBand(bandBins[band][b].maximum, bandScale[band]);
+            }
+        }
+        waveform.levels.push_back(std::move(bandLevel));
+        for (auto &band : bandBins) {
+            band = mergeBins(band, settings_.levelFactor);
+        }
+        framesPerBin *= settings_.levelFactor;
+    }
+
+    const double hopRate = analysis.sampleRate / static_cast<double>(hopFrames);
+    const TempoEstimate tempo = estimateTempo(hopEnergy, hopRate, settings_.minimumBpm, settings_.maximumBpm);
+    analysis.bpm = tempo.bpm;
+    analysis.firstBeatSeconds = tempo.firstBeatSeconds;
+    analysis.tempoConfidence = tempo.confidence;
+    return analysis;
+}
+
+TrackAnalyzer::Result TrackAnalyzer::run(const Job &job) const {
+    Result result;
+    const auto started = std::chrono::steady_clock::now();
+    try {
+        Analysis analysis = analyze(job.inputPath);
+        write(analysis, job.outputPath);
+        if (!job.waveformPath.empty()) {
+            WaveformPyramid::write(analysis.waveform, job.waveformPath);
+        }
+        analysis.levels.clear();
+        analysis.waveform.levels.clear();
+        result.analysis = std::move(analysis);
+        result.ok = true;
+    } catch (const std::exception &ex) {
+        result.error = ex.what();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+std::vector<TrackAnalyzer::Result> TrackAnalyzer::runAll(const std::vector<Job> &jobs) const {
+    std::vector<Result> results(jobs.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t index = next.fetch_add(1); index < jobs.size(); index = next.fetch_add(1)) {
+            results[index] = run(jobs[index]);
+        }
+    };
+
+    const size_t threadCount = std::min(settings_.threads, jobs.size());
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount > 0 ? threadCount - 1 : 0);
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return results;
+}
+
+void TrackAnalyzer::write(const Analysis &analysis, const std::string &path) {
+    std::vector<unsigned char> bytes(kHeaderBytes + analysis.levels.size() * 8);
+    std::memcpy(bytes.data(), kMagic, sizeof(kMagic));
+    putLe32(bytes.data() + 4, kVersion);
+    putDouble(bytes.data() + 8, analysis.sampleRate);
+    putLe64(bytes.data() + 16, analysis.frameCount);
+    putLe32(bytes.data() + 24, analysis.channelCount);
+    putLe32(bytes.data() + 28, static_cast<uint32_t>(analysis.levels.size()));
+    putDouble(bytes.data() + 32, analysis.bpm);
+    putDouble(bytes.data() + 40, analysis.firstBeatSeconds);
+    uint32_t confidenceBits = 0;
+    std::memcpy(&confidenceBits, &analysis.tempoConfidence, sizeof(confidenceBits));
+    putLe32(bytes.data() + 48, confidenceBits);
+    putLe32(bytes.data() + 52, 0);
+    for (size_t i = 0; i < analysis.levels.size(); ++i) {
+        putLe32(bytes.data() + kHeaderBytes + i * 8, analysis.levels[i].framesPerBin);
+        putLe32(bytes.data() + kHeaderBytes + i * 8 + 4, static_cast<uint32_t>(analysis.levels[i].minimum.size()));
+    }
+    for (const auto &level : analysis.levels) {
+        for (size_t b = 0; b < level.minimum.size(); ++b) {
+            for (const int16_t value : {level.minimum[b], level.maximum[b], level.rms[b]}) {
+                const auto bits = static_cast<uint16_t>(value);
+                bytes.push_back(static_cast<unsigned char>(bits & 0xFF));
+                bytes.push_back(static_cast<unsigned char>(bits >> 8));
+            }
+        }
+    }
+
+    // Write next to the target and rename, so a reader never sees a half-written cache entry.
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!stream) {
+            throw std::runtime_error("Failed to write analysis file: " + temporary);
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Failed to move analysis file into place: " + path);
+    }
+}
+
+TrackAnalyzer::Analysis TrackAnalyzer::read(const std::string &path) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        throw std::runtime_error("Unable to open analysis file: " + path);
+    }
+    const std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    if (bytes.size() < kHeaderBytes || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0 ||
+        readLe32(bytes.data() + 4) != kVersion) {
+        throw std::runtime_error("Not a version 1 analysis file: " + path);
+    }
+
+    Analysis analysis;
+    analysis.sampleRate = readDouble(bytes.data() + 8);
+    analysis.frameCount = readLe64(bytes.data() + 16);
+    analysis.channelCount = readLe32(bytes.data() + 24);
+    const uint32_t levelCount = readLe32(bytes.data() + 28);
+    analysis.bpm = readDouble(bytes.data() + 32);
+    analysis.firstBeatSeconds = readDouble(bytes.data() + 40);
+    const uint32_t confidenceBits = readLe32(bytes.data() + 48);
+    std::memcpy(&analysis.tempoConfidence, &confidenceBits, sizeof(confidenceBits));
+
+    size_t offset = kHeaderBytes + static_cast<size_t>(levelCount) * 8;
+    if (bytes.size() < offset) {
+        throw std::runtime_error("Truncated analysis file: " + path);
+    }
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        PeakLevel level;
+        level.framesPerBin = readLe32(bytes.data() + kHeaderBytes + i * 8);
+        const uint32_t binCount = readLe32(bytes.data() + kHeaderBytes + i * 8 + 4);
+        if (bytes.size() - offset < static_cast<size_t>(binCount) * 6) {
+            throw std::runtime_error("Truncated analysis file: " + path);
+        }
+        level.minimum.resize(binCount);
+        level.maximum.resize(binCount);
+        level.rms.resize(binCount);
+        for (uint32_t b = 0; b < binCount; ++b, offset += 6) {
+            const auto value = [&](size_t at) {
+                return static_cast<int16_t>(static_cast<uint16_t>(bytes[at] | (bytes[at + 1] << 8)));
+            };
+            level.minimum[b] = value(offset);
+            level.maximum[b] = value(offset + 2);
+            level.rms[b] = value(offset + 4);
+        }
+        analysis.levels.push_back(std::move(level));
+    }
+    return analysis;
+}
+
+} // namespace deejay
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "WaveformPyramid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace deejay {
+
+// Waveform and tempo analysis for the library. A track is decoded in chunks, never loaded whole, and reduced to
+// a min/max/RMS peak pyramid of its channel mean plus an onset envelope, from which the tempo and the phase of
+// the beat grid are estimated. Tracks are analyzed in parallel, one per thread, like OfflineRenderer.
+//
+// Results are stored as one compact binary file per track (see write()), replacing the JSON placeholders of
+// deejay/analysis.py, plus optionally the per-band WaveformPyramid the deck displays draw from.
+class TrackAnalyzer {
+public:
+    struct Settings {
+        size_t chunkFrames{65'536};
+        // Tracks analyzed concurrently; 0 uses every hardware thread.
+        size_t threads{0};
+        // Finest pyramid level; every further level covers `levelFactor` times as many frames per bin.
+        uint32_t baseFramesPerBin{64};
+        uint32_t levelFactor{4};
+        uint32_t levelCount{6};
+        // Frames per onset envelope value.
+        uint32_t onsetHopFrames{512};
+        double minimumBpm{70.0};
+        double maximumBpm{180.0};
+        // Band edges of the display waveform: low below the first, high above the second.
+        float lowCrossoverHz{200.0f};
+        float highCrossoverHz{2'000.0f};
+    };
+
+    // One pyramid level. Values are quantized to int16 full scale (32767 = 1.0).
+    struct PeakLevel {
+        uint32_t framesPerBin{0};
+        std::vector<int16_t> minimum;
+        std::vector<int16_t> maximum;
+        std::vector<int16_t> rms;
+    };
+
+    struct Analysis {
+        double sampleRate{0.0};
+        uint32_t channelCount{0};
+        uint64_t frameCount{0};
+        // 0 when no tempo could be estimated (silence, tracks shorter than a few beats).
+        double bpm{0.0};
+        double firstBeatSeconds{0.0};
+        // Strength of the chosen tempo relative to the average candidate; below ~1.5 the grid is a guess.
+        float tempoConfidence{0.0f};
+        std::vector<PeakLevel> levels;
+        // Same bin ladder as `levels`, split into bands.
+        WaveformPyramid waveform;
+    };
+
+    struct Job {
+        std::string inputPath;
+        std::string outputPath;
+        // Where to write the display waveform; empty skips it.
+        std::string waveformPath{};
+    };
+
+    struct Result {
+        bool ok{false};
+        std::string error;
+        Analysis analysis;
+        double seconds{0.0};
+    };
+
+    explicit TrackAnalyzer(Settings settings);
+    TrackAnalyzer();
+
+    // Analyzes one WAV file on the calling thread. Throws std::runtime_error when it cannot be decoded.
+    Analysis analyze(const std::string &path) const;
+
+    // Analyzes and writes one job; failures are reported through Result rather than thrown. The returned
+    // analysis keeps only the header fields, not the pyramids, so a crate's results stay small.
+    Result run(const Job &job) const;
+    std::vector<Result> runAll(const std::vector<Job> &jobs) const;
+
+    // Binary cache file, little-endian:
+    //   "DJAN", uint32 version (1), float64 sampleRate, uint64 frameCount, uint32 channelCount, uint32 levelCount,
+    //   float64 bpm, float64 firstBeatSeconds, float32 tempoConfidence, uint32 reserved (0)      -- 56 bytes
+    //   levelCount x { uint32 framesPerBin, uint32 binCount }
+    //   per level: binCount x { int16 min, int16 max, int16 rms }
+    // Both throw std::runtime_error on I/O errors or malformed files.
+    static void write(const Analysis &analysis, const std::string &path);
+    static Analysis read(const std::string &path);
+
+private:
+    Settings settings_;
+};
+
+} // namespace deejay
@@ -0,0 +1,362 @@
+#include "TrackStore.h"
+
+#include "WavFileReader.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace deejay {
+
+namespace {
+constexpr char kCacheMagic[8] = {'D', 'J', 'P', 'C', 'M', 'F', '3', '2'};
+constexpr uint32_t kCacheVersion = 1;
+constexpr size_t kPageBytes = 4096;
+constexpr size_t kDecodeChunkFrames = 1 << 16;
+
+// Fixed 64-byte header so the PCM that follows stays cache-line aligned inside the page-aligned mapping.
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t channelCount;
+    double sampleRate;
+    uint64_t frameCount;
+    uint64_t sourceBytes;
+    int64_t sourceModified;
+    uint8_t reserved[16];
+};
+static_assert(sizeof(CacheHeader) == 64, "cache header layout changed");
+
+struct SourceStamp {
+    uint64_t bytes{0};
+    int64_t modified{0};
+    bool valid{false};
+};
+
+SourceStamp stampOf(const std::string &path) {
+    std::error_code error;
+    SourceStamp stamp;
+    stamp.bytes = std::filesystem::file_size(path, error);
+    if (error) {
+        return stamp;
+    }
+    stamp.modified = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    stamp.valid = !error;
+    return stamp;
+}
+
+bool readHeader(const std::string &path, CacheHeader &header) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        return false;
+    }
+    return std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) == 0 && header.version == kCacheVersion &&
+           header.channelCount > 0;
+}
+
+// A cache entry is current when it matches the source it was built from. Without a readable source (the
+// library moved, the drive is offline) whatever is cached is still the best audio available.
+bool cacheIsCurrent(const std::string &cachePath, const SourceStamp &source) {
+    CacheHeader header{};
+    if (!readHeader(cachePath, header)) {
+        return false;
+    }
+    if (!source.valid) {
+        return true;
+    }
+    return header.sourceBytes == source.bytes && header.sourceModified == source.modified;
+}
+}
+
+MappedTrack::~MappedTrack() {
+#if defined(_WIN32)
+    if (mapping_) {
+        UnmapViewOfFile(mapping_);
+    }
+    if (mappingHandle_) {
+        CloseHandle(mappingHandle_);
+    }
+    if (fileHandle_) {
+        CloseHandle(fileHandle_);
+    }
+#else
+    if (mapping_) {
+        munmap(mapping_, mappingBytes_);
+    }
+#endif
+}
+
+void MappedTrack::populate(uint64_t frame, uint64_t count) const noexcept {
+    if (frame >= frameCount_ || count == 0) {
+        return;
+    }
+    prefetch(frame, count);
+    const auto samplesPerFrame = static_cast<size_t>(channelCount_);
+    const auto *begin = reinterpret_cast<const volatile unsigned char *>(frames_ + frame * samplesPerFrame);
+    const auto *end = reinterpret_cast<const volatile unsigned char *>(
+        frames_ + std::min(frameCount_, frame + count) * samplesPerFrame);
+    // One read per page is enough to fault it in.
+    for (const volatile unsigned char *byte = begin; byte < end; byte += kPageBytes) {
+        (void)*byte;
+    }
+}
+
+void MappedTrack::prefetch(uint64_t frame, uint64_t count) const noexcept {
+#if defined(_WIN32)
+    // Windows has no portable readahead hint for views; populate() still faults pages in on demand.
+    (void)frame;
+    (void)count;
+#else
+    if (frame >= frameCount_ || count == 0) {
+        return;
+    }
+    const auto samplesPerFrame = static_cast<size_t>(channelCount_);
+    const auto base = reinterpret_cast<uintptr_t>(mapping_);
+    auto begin = reinterpret_cast<uintptr_t>(frames_ + frame * samplesPerFrame);
+    const auto end = reinterpret_cast<uintptr_t>(frames_ + std::min(frameCount_, frame + count) * samplesPerFrame);
+    begin = base + ((begin - base) / kPageBytes) * kPageBytes;
+    madvise(reinterpret_cast<void *>(begin), end - begin, MADV_WILLNEED);
+#endif
+}
+
+TrackStore::TrackStore(Settings settings) : settings_(std::move(settings)) {
+    std::error_code error;
+    std::filesystem::create_directories(settings_.cacheDirectory, error);
+    if (error) {
+        throw std::runtime_error("Unable to create track cache directory: " + settings_.cacheDirectory);
+    }
+}
+
+std::string TrackStore::cachePath(const std::string &fileUuid) const {
+    return (std::filesystem::path(settings_.cacheDirectory) / (fileUuid + ".f32")).string();
+}
+
+void TrackStore::prepare(const std::string &fileUuid, const std::string &sourcePath) {
+    const std::string path = cachePath(fileUuid);
+    if (!cacheIsCurrent(path, stampOf(sourcePath))) {
+        buildCacheFile(sourcePath, path);
+    }
+}
+
+std::shared_ptr<const MappedTrack> TrackStore::open(const std::string &fileUuid, const std::string &sourcePath,
+                                                    const std::vector<double> &cueSeconds) {
+    prepare(fileUuid, sourcePath);
+    const std::string path = cachePath(fileUuid);
+
+    std::shared_ptr<MappedTrack> track(new MappedTrack());
+    CacheHeader header{};
+
+#if defined(_WIN32)
+    track->fileHandle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (track->fileHandle_ == INVALID_HANDLE_VALUE) {
+        track->fileHandle_ = nullptr;
+        throw std::runtime_error("Unable to open track cache: " + path);
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(track->fileHandle_, &size);
+    track->mappingBytes_ = static_cast<size_t>(size.QuadPart);
+    track->mappingHandle_ = CreateFileMappingA(track->fileHandle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (track->mappingHandle_) {
+        track->mapping_ = MapViewOfFile(track->mappingHandle_, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!track->mapping_) {
+        throw std::runtime_error("Unable to map track cache: " + path);
+    }
+#else
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Unable to open track cache: " + path);
+    }
+    struct stat info {};
+    if (fstat(descriptor, &info) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("Unable to stat track cache: " + path);
+    }
+    track->mappingBytes_ = static_cast<size_t>(info.st_size);
+    void *mapping = track->mappingBytes_ >= sizeof(CacheHeader)
+                        ? mmap(nullptr, track->mappingBytes_, PROT_READ, MAP_SHARED, descriptor, 0)
+                        : MAP_FAILED;
+    // The mapping keeps the file referenced after the descriptor is closed.
+    ::close(descriptor);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Unable to map track cache: " + path);
+    }
+    track->mapping_ = mapping;
+#endif
+
+    std::memcpy(&header, track->mapping_, sizeof(header));
+    const uint64_t dataBytes = track->mappingBytes_ - sizeof(CacheHeader);
+    const uint64_t frameBytes = static_cast<uint64_t>(header.channelCount) * sizeof(float);
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.channelCount == 0 ||
+        header.frameCount > dataBytes / frameBytes) {
+        throw std::runtime_error("Corrupt track cache: " + path);
+    }
+
+    track->frames_ = reinterpret_cast<const float *>(static_cast<const unsigned char *>(track->mapping_) + sizeof(header));
+    track->channelCount_ = static_cast<int>(header.channelCount);
+    track->sampleRate_ = header.sampleRate;
+    track->frameCount_ = header.frameCount;
+
+    // The start of the track and the cue neighbourhoods must be resident before the deck can play from them;
+    // everything else streams in behind.
+    const auto window = static_cast<uint64_t>(std::max(0.0, settings_.populateSeconds) * header.sampleRate);
+    track->populate(0, window);
+    for (double cue : cueSeconds) {
+        const auto centre = static_cast<uint64_t>(std::max(0.0, cue) * header.sampleRate);
+        const uint64_t start = centre > window / 2 ? centre - window / 2 : 0;
+        track->populate(start, window);
+    }
+    track->prefetch(0, track->frameCount_);
+    return track;
+}
+
+void TrackStore::buildCacheFile(const std::string &sourcePath, const std::string &cachePath) const {
+    WavFileReader reader(sourcePath);
+    const SourceStamp stamp = stampOf(sourcePath);
+
+    // Decode into a temporary and rename it into place, so a reader never maps a half-written entry.
+    const std::string temporaryPath = cachePath + ".tmp";
+    {
+        std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!stream) {
+            throw std::runtime_error("Unable to create track cache: " + temporaryPath);
+        }
+
+        CacheHeader header{};
+        std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+        header.version = kCacheVersion;
+        header.channelCount = static_cast<uint32_t>(reader.channelCount());
+        header.sampleRate = reader.sampleRate();
+        header.sourceBytes = stamp.bytes;
+        header.sourceModified = stamp.modified;
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        std::vector<float> chunk(kDecodeChunkFrames * static_cast<size_t>(reader.channelCount()));
+        while (true) {
+            const size_t frames = reader.readFrames(chunk.data(), kDecodeChunkFrames);
+            if (frames == 0) {
+                break;
+            }
+            stream.write(reinterpret_cast<const char *>(chunk.data()),
+                         static_cast<std::streamsize>(frames * static_cast<size_t>(reader.channelCount()) * sizeof(float)));
+            header.frameCount += frames;
+        }
+
+        stream.seekp(0);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        if (!stream) {
+            throw std::runtime_error("Failed to write track cache: " + temporaryPath);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        throw std::runtime_error("Unable to install track cache: " + cachePath);
+    }
+}
+
+MappedTrackSource::MappedTrackSource(std::shared_ptr<const MappedTrack> track, int channelCount, bool loop)
+    : track_(std::move(track)), channelCount_(channelCount), loop_(loop) {}
+
+uint64_t MappedTrackSource::framesRemaining() noexcept {
+    const uint64_t seek = pendingSeek_.exchange(kNoSeek, std::memory_order_acquire);
+    if (seek != kNoSeek) {
+        position_.store(std::min(seek, track_->frameCount()), std::memory_order_relaxed);
+    }
+    uint64_t position = position_.load(std::memory_order_relaxed);
+    if (position >= track_->frameCount() && loop_) {
+        position = 0;
+        position_.store(0, std::memory_order_relaxed);
+    }
+    return track_->frameCount() - std::min(position, track_->frameCount());
+}
+
+const float *MappedTrackSource::acquire(size_t &frames) noexcept {
+    if (track_->channelCount() != channelCount_) {
+        frames = 0;
+        return nullptr;
+    }
+    const uint64_t remaining = framesRemaining();
+    frames = static_cast<size_t>(std::min<uint64_t>(frames, remaining));
+    if (frames == 0) {
+        return nullptr;
+    }
+    const uint64_t position = position_.load(std::memory_order_relaxed);
+    position_.store(position + frames, std::memory_order_relaxed);
+    return track_->frames() + position * static_cast<uint64_t>(channelCount_);
+}
+
+size_t MappedTrackSource::read(float *interleaved, size_t frames) noexcept {
+    const size_t outChannels = static_cast<size_t>(channelCount_);
+    const size_t trackChannels = static_cast<size_t>(track_->channelCount());
+    size_t delivered = 0;
+    // Loops may wrap inside one request, so copy in contiguous runs.
+    while (delivered < frames) {
+        const uint64_t remaining = framesRemaining();
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(frames - delivered, remaining));
+        if (count == 0) {
+            break;
+        }
+        const uint64_t position = position_.load(std::memory_order_relaxed);
+        const float *source = track_->frames() + position * trackChannels;
+        float *target = interleaved + delivered * outChannels;
+        if (trackChannels == outChannels) {
+            std::copy(source, source + count * outChannels, target);
+        } else {
+            // Same mapping as StreamingSource: extra outputs repeat the last track channel.
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t ch = 0; ch < outChannels; ++ch) {
+                    target[i * outChannels + ch] = source[i * trackChannels + std::min(ch, trackChannels - 1)];
+                }
+            }
+        }
+        position_.store(position + count, std::memory_order_relaxed);
+        delivered += count;
+    }
+    return delivered;
+}
+
+void MappedTrackSource::seek(uint64_t frame) {
+    track_->populate(frame, static_cast<uint64_t>(track_->sampleRate()));
+    pendingSeek_.store(frame, std::memory_order_release);
+}
+
+bool MappedTrackSource::jumpTo(uint64_t frame) noexcept {
+    pendingSeek_.store(frame, std::memory_order_release);
+    return true;
+}
+
+const float *MappedTrackSource::trackFrames(uint64_t &frameCount, uint64_t &position) noexcept {
+    if (track_->channelCount() != channelCount_) {
+        frameCount = 0;
+        position = 0;
+        return nullptr;
+    }
+    framesRemaining();
+    frameCount = track_->frameCount();
+    position = position_.load(std::memory_order_relaxed);
+    return track_->frames();
+}
+
+bool MappedTrackSource::finished() const noexcept {
+    return !loop_ && pendingSeek_.load(std::memory_order_relaxed) == kNoSeek &&
+           position_.load(std::memory_order_relaxed) >= track_->frameCount();
+}
+
+} // namespace deejay
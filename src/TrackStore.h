@@ -0,0 +1,116 @@
+#pragma once
+
+#include "AudioSource.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace deejay {
+
+// Read-only mapping of one pre-decoded cache file: a small header followed by interleaved float32 PCM. The
+// pages are shared with the OS page cache, so opening a track that was played recently costs no decode and
+// no copy.
+class MappedTrack {
+public:
+    ~MappedTrack();
+
+    MappedTrack(const MappedTrack &) = delete;
+    MappedTrack &operator=(const MappedTrack &) = delete;
+
+    int channelCount() const noexcept { return channelCount_; }
+    double sampleRate() const noexcept { return sampleRate_; }
+    uint64_t frameCount() const noexcept { return frameCount_; }
+    const float *frames() const noexcept { return frames_; }
+
+    // Non-realtime: faults in the pages holding [frame, frame + count) so the audio thread reading them later
+    // does not block on disk. Ranges are clamped to the track.
+    void populate(uint64_t frame, uint64_t count) const noexcept;
+    // Non-realtime: asks the kernel to read the range ahead asynchronously and returns immediately.
+    void prefetch(uint64_t frame, uint64_t count) const noexcept;
+
+private:
+    friend class TrackStore;
+    MappedTrack() = default;
+
+    void *mapping_{nullptr};
+    size_t mappingBytes_{0};
+#if defined(_WIN32)
+    void *fileHandle_{nullptr};
+    void *mappingHandle_{nullptr};
+#endif
+    const float *frames_{nullptr};
+    int channelCount_{0};
+    double sampleRate_{0.0};
+    uint64_t frameCount_{0};
+};
+
+// Cache of decoded tracks keyed by the file UUID from the sounds table. The first open() of a track decodes
+// the WAV into <cacheDirectory>/<uuid>.f32; later opens map that file directly. Cache entries record the
+// source size and modification time and are rebuilt when the source changes. Throws std::runtime_error when
+// the source cannot be decoded or the cache cannot be written.
+class TrackStore {
+public:
+    struct Settings {
+        std::string cacheDirectory{"cache/pcm"};
+        // Audio around the track start and every cue point that is faulted in before open() returns.
+        double populateSeconds{2.0};
+    };
+
+    explicit TrackStore(Settings settings);
+
+    // Non-realtime. `cueSeconds` are the cue positions from the metadata table (hot cues, intro/outro marks);
+    // their neighbourhoods are populated synchronously and the rest of the track is prefetched asynchronously.
+    std::shared_ptr<const MappedTrack> open(const std::string &fileUuid, const std::string &sourcePath,
+                                            const std::vector<double> &cueSeconds = {});
+
+    // Non-realtime: builds or refreshes the cache entry like open() but does not map it, for batch preparation.
+    void prepare(const std::string &fileUuid, const std::string &sourcePath);
+
+    std::string cachePath(const std::string &fileUuid) const;
+
+private:
+    void buildCacheFile(const std::string &sourcePath, const std::string &cachePath) const;
+
+    Settings settings_;
+};
+
+// AudioSource over a MappedTrack. When the deck's channel count matches the track, acquire() hands out
+// pointers straight into the mapping, so LatencyCompensatedProcessor::pull feeds the stretcher without a copy.
+class MappedTrackSource : public AudioSource {
+public:
+    MappedTrackSource(std::shared_ptr<const MappedTrack> track, int channelCount, bool loop);
+
+    int channelCount() const noexcept override { return channelCount_; }
+    size_t read(float *interleaved, size_t frames) noexcept override;
+    const float *acquire(size_t &frames) noexcept override;
+
+    // Control thread: moves the play position; the audio thread picks it up at its next read. The target pages
+    // are populated first, so call this off the audio thread.
+    void seek(uint64_t frame);
+    // Audio-thread seek without the populate step; meant for cue points TrackStore prefetched.
+    bool jumpTo(uint64_t frame) noexcept override;
+    // The mapping itself, when its channel layout matches channelCount().
+    const float *trackFrames(uint64_t &frameCount, uint64_t &position) noexcept override;
+    uint64_t position() const noexcept { return position_.load(std::memory_order_relaxed); }
+    bool finished() const noexcept;
+
+    const MappedTrack &track() const noexcept { return *track_; }
+
+private:
+    // Applies a pending seek and handles looping; returns the frames left before the end of the track.
+    uint64_t framesRemaining() noexcept;
+
+    static constexpr uint64_t kNoSeek = ~uint64_t{0};
+
+    std::shared_ptr<const MappedTrack> track_;
+    int channelCount_{0};
+    bool loop_{false};
+    std::atomic<uint64_t> position_{0};
+    std::atomic<uint64_t> pendingSeek_{kNoSeek};
+};
+
+} // namespace deejay
@@ -0,0 +1,94 @@
+#include "VarispeedReader.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace deejay {
+
+namespace {
+// Short filter: scratching needs agility more than a flat top octave.
+constexpr size_t kTaps = 16;
+constexpr size_t kPhases = 128;
+constexpr double kCutoff = 0.9;
+
+size_t windowFrames(size_t maxBlockFrames, size_t taps) {
+    return static_cast<size_t>(std::ceil(static_cast<double>(maxBlockFrames) * VarispeedReader::kMaxRate)) + taps + 2;
+}
+} // namespace
+
+VarispeedReader::VarispeedReader(std::pmr::memory_resource *memory)
+    : filter_(kTaps, kPhases, kCutoff, memory), positions_(memory), gains_(memory), coefficients_(memory),
+      window_(memory) {}
+
+void VarispeedReader::prepare(int channelCount, size_t maxBlockFrames) {
+    channelCount_ = channelCount;
+    maxBlockFrames_ = maxBlockFrames;
+    windowCapacity_ = windowFrames(maxBlockFrames, filter_.taps());
+    positions_.assign(maxBlockFrames, 0.0);
+    gains_.assign(maxBlockFrames, 0.0f);
+    coefficients_.assign(filter_.taps(), 0.0f);
+    window_.assign(windowCapacity_ * static_cast<size_t>(channelCount), 0.0f);
+}
+
+size_t VarispeedReader::memoryBytes(int channelCount, size_t maxBlockFrames) {
+    return PolyphaseSinc::memoryBytes(kTaps, kPhases) + maxBlockFrames * (sizeof(double) + sizeof(float)) +
+           kTaps * sizeof(float) +
+           windowFrames(maxBlockFrames, kTaps) * static_cast<size_t>(channelCount) * sizeof(float);
+}
+
+void VarispeedReader::setRate(double rate) noexcept { rate_ = std::clamp(rate, -kMaxRate, kMaxRate); }
+
+void VarispeedReader::render(const float *track, uint64_t trackFrames, float *output, size_t frames,
+                             double targetRate) noexcept {
+    const auto channels = static_cast<size_t>(channelCount_);
+    frames = std::min(frames, maxBlockFrames_);
+    if (frames == 0) {
+        return;
+    }
+
+    // Positions first, so the span of track the block touches is known before it is copied.
+    const double target = std::clamp(targetRate, -kMaxRate, kMaxRate);
+    const double step = (target - rate_) / static_cast<double>(frames);
+    const auto end = static_cast<double>(trackFrames);
+    double position = std::clamp(position_, 0.0, end);
+    double rate = rate_;
+    double lowest = position;
+    double highest = position;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        positions_[frame] = position;
+        gains_[frame] = static_cast<float>(std::min(1.0, std::abs(rate) / kFullLevelRate));
+        lowest = std::min(lowest, position);
+        highest = std::max(highest, position);
+        rate += step;
+        position = std::clamp(position + rate, 0.0, end);
+    }
+    position_ = position;
+    rate_ = target;
+
+    // Planar copy of [first, first + span); frames outside the track read as silence.
+    const size_t taps = filter_.taps();
+    const auto centre = static_cast<int64_t>(filter_.centre());
+    const int64_t first = static_cast<int64_t>(std::floor(lowest)) - centre;
+    const auto span = std::min(static_cast<size_t>(static_cast<int64_t>(std::floor(highest)) - centre + static_cast<int64_t>(taps) - first),
+                               windowCapacity_);
+    const auto trackEnd = static_cast<int64_t>(trackFrames);
+    for (size_t ch = 0; ch < channels; ++ch) {
+        float *window = window_.data() + ch * windowCapacity_;
+        for (size_t offset = 0; offset < span; ++offset) {
+            const int64_t frame = first + static_cast<int64_t>(offset);
+            window[offset] = frame >= 0 && frame < trackEnd ? track[static_cast<size_t>(frame) * channels + ch] : 0.0f;
+        }
+    }
+
+    for (size_t frame = 0; frame < frames; ++frame) {
+        const double base = std::floor(positions_[frame]);
+        filter_.coefficients(positions_[frame] - base, coefficients_.data());
+        const auto start = static_cast<size_t>(static_cast<int64_t>(base) - centre - first);
+        for (size_t ch = 0; ch < channels; ++ch) {
+            output[frame * channels + ch] =
+                gains_[frame] * PolyphaseSinc::dot(coefficients_.data(), window_.data() + ch * windowCapacity_ + start, taps);
+        }
+    }
+}
+
+} // namespace deejay
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "PolyphaseSinc.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace deejay {
+
+// Vinyl-style playback straight from a decoded track in memory: a read position that moves by a signed,
+// continuously varying rate (track frames per output frame, negative for backwards) and is interpolated with a
+// short PolyphaseSinc filter. The filter reads the track on both sides of the position, so unlike a streaming
+// resampler or the stretcher it adds no latency. Pitch follows rate, as on a turntable, and so does level below
+// kFullLevelRate: like a magnetic cartridge, a slow stylus is quiet and a stopped one silent, rather than
+// holding the last sample as DC. Rates above 1 are not band-limited, so very fast spins alias a little.
+// Realtime-safe after prepare(); all storage comes from `memory`.
+class VarispeedReader {
+public:
+    // Fastest platter speed followed, as a multiple of the track's own rate.
+    static constexpr double kMaxRate = 8.0;
+    // Slowest speed at full level.
+    static constexpr double kFullLevelRate = 0.25;
+
+    explicit VarispeedReader(std::pmr::memory_resource *memory = std::pmr::get_default_resource());
+
+    // Sizes the read window for render() calls of up to maxBlockFrames. Not realtime-safe.
+    void prepare(int channelCount, size_t maxBlockFrames);
+
+    // Upper bound of what construction and prepare() allocate.
+    static size_t memoryBytes(int channelCount, size_t maxBlockFrames);
+
+    // Read position in track frames; set on jog touch from where the deck was heard.
+    void setPosition(double frame) noexcept { position_ = frame; }
+    double position() const noexcept { return position_; }
+    // Jumps the rate without a ramp.
+    void setRate(double rate) noexcept;
+    double rate() const noexcept { return rate_; }
+
+    // Renders `frames` interleaved frames from `track` (`trackFrames` frames, channelCount() wide), moving the
+    // rate linearly from rate() to `targetRate` across the block. The position stops at either end of the track
+    // like a stylus in the lead-in and run-out grooves; frames past the ends are silent.
+    void render(const float *track, uint64_t trackFrames, float *output, size_t frames, double targetRate) noexcept;
+
+    int channelCount() const noexcept { return channelCount_; }
+
+private:
+    PolyphaseSinc filter_;
+    int channelCount_{0};
+    size_t maxBlockFrames_{0};
+    size_t windowCapacity_{0};
+    std::pmr::vector<double> positions_;    // per output frame of the block
+    std::pmr::vector<float> gains_;         // per output frame of the block
+    std::pmr::vector<float> coefficients_;  // blended row for the current output frame
+    std::pmr::vector<float> window_;        // planar copy of the track span the block reads, windowCapacity_ per channel
+    double position_{0.0};
+    double rate_{0.0};
+};
+
+} // namespace deejay
@@ -0,0 +1,133 @@
+#include "WavFileReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace deejay {
+
+namespace {
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+uint16_t readLe16(const unsigned char *bytes) { return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8)); }
+
+uint32_t readLe32(const unsigned char *bytes) {
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+}
+
+WavFileReader::WavFileReader(const std::string &path) : stream_(path, std::ios::binary) {
+    if (!stream_) {
+        throw std::runtime_error("Unable to open WAV file: " + path);
+    }
+    parseHeader();
+}
+
+void WavFileReader::parseHeader() {
+    unsigned char riff[12];
+    if (!stream_.read(reinterpret_cast<char *>(riff), sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 ||
+        std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        throw std::runtime_error("Not a RIFF/WAVE file");
+    }
+
+    bool haveFormat = false;
+    unsigned char chunkHeader[8];
+    while (stream_.read(reinterpret_cast<char *>(chunkHeader), sizeof(chunkHeader))) {
+        const uint32_t chunkSize = readLe32(chunkHeader + 4);
+        if (std::memcmp(chunkHeader, "fmt ", 4) == 0) {
+            std::vector<unsigned char> format(std::max<uint32_t>(chunkSize, 16));
+            stream_.read(reinterpret_cast<char *>(format.data()), chunkSize);
+            uint16_t formatTag = readLe16(format.data());
+            channelCount_ = readLe16(format.data() + 2);
+            sampleRate_ = static_cast<double>(readLe32(format.data() + 4));
+            const uint16_t bitsPerSample = readLe16(format.data() + 14);
+            if (formatTag == kFormatExtensible && chunkSize >= 26) {
+                formatTag = readLe16(format.data() + 24);
+            }
+
+            bytesPerSample_ = bitsPerSample / 8;
+            if (formatTag == kFormatFloat && bitsPerSample == 32) {
+                encoding_ = Encoding::Float32;
+            } else if (formatTag == kFormatPcm && bitsPerSample == 16) {
+                encoding_ = Encoding::Pcm16;
+            } else if (formatTag == kFormatPcm && bitsPerSample == 24) {
+                encoding_ = Encoding::Pcm24;
+            } else if (formatTag == kFormatPcm && bitsPerSample == 32) {
+                encoding_ = Encoding::Pcm32;
+            } else {
+                throw std::runtime_error("Unsupported WAV encoding (" + std::to_string(bitsPerSample) + "-bit, format " +
+                                         std::to_string(formatTag) + ")");
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunkHeader, "data", 4) == 0) {
+            if (!haveFormat || channelCount_ <= 0) {
+                throw std::runtime_error("WAV data chunk precedes a valid fmt chunk");
+            }
+            dataOffset_ = stream_.tellg();
+            totalFrames_ = chunkSize / static_cast<uint32_t>(bytesPerSample_ * channelCount_);
+            return;
+        } else {
+            stream_.seekg(chunkSize, std::ios::cur);
+        }
+
+        // Chunks are padded to an even number of bytes.
+        if (chunkSize & 1u) {
+            stream_.seekg(1, std::ios::cur);
+        }
+    }
+
+    throw std::runtime_error("WAV file has no data chunk");
+}
+
+size_t WavFileReader::readFrames(float *interleaved, size_t frames) {
+    const uint64_t remaining = totalFrames_ - position_;
+    const size_t toRead = static_cast<size_t>(std::min<uint64_t>(frames, remaining));
+    const size_t samples = toRead * static_cast<size_t>(channelCount_);
+    if (toRead == 0) {
+        return 0;
+    }
+
+    raw_.resize(samples * static_cast<size_t>(bytesPerSample_));
+    stream_.read(raw_.data(), static_cast<std::streamsize>(raw_.size()));
+    const auto bytes = reinterpret_cast<const unsigned char *>(raw_.data());
+
+    switch (encoding_) {
+    case Encoding::Float32:
+        std::memcpy(interleaved, bytes, samples * sizeof(float));
+        break;
+    case Encoding::Pcm16:
+        for (size_t i = 0; i < samples; ++i) {
+            interleaved[i] = static_cast<int16_t>(readLe16(bytes + i * 2)) / 32768.0f;
+        }
+        break;
+    case Encoding::Pcm24:
+        for (size_t i = 0; i < samples; ++i) {
+            const unsigned char *sample = bytes + i * 3;
+            const int32_t value = static_cast<int32_t>(static_cast<uint32_t>(sample[0]) << 8 |
+                                                       static_cast<uint32_t>(sample[1]) << 16 |
+                                                       static_cast<uint32_t>(sample[2]) << 24) >>
+                                  8;
+            interleaved[i] = value / 8388608.0f;
+        }
+        break;
+    case Encoding::Pcm32:
+        for (size_t i = 0; i < samples; ++i) {
+            interleaved[i] = static_cast<float>(static_cast<int32_t>(readLe32(bytes + i * 4)) / 2147483648.0);
+        }
+        break;
+    }
+
+    position_ += toRead;
+    return toRead;
+}
+
+void WavFileReader::seek(uint64_t frame) {
+    position_ = std::min(frame, totalFrames_);
+    stream_.clear();
+    stream_.seekg(dataOffset_ + static_cast<std::streamoff>(position_ * static_cast<uint64_t>(bytesPerSample_ * channelCount_)));
+}
+
+} // namespace deejay
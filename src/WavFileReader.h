@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace deejay {
+
+// Streaming RIFF/WAVE decoder for 16/24/32-bit integer PCM and 32-bit float files.
+// Frames are returned as interleaved float32 in [-1, 1]. Throws std::runtime_error on malformed input.
+class WavFileReader {
+public:
+    explicit WavFileReader(const std::string &path);
+
+    double sampleRate() const noexcept { return sampleRate_; }
+    int channelCount() const noexcept { return channelCount_; }
+    uint64_t totalFrames() const noexcept { return totalFrames_; }
+    uint64_t position() const noexcept { return position_; }
+
+    // Decodes up to `frames` frames into `interleaved` (frames * channelCount() floats) and returns the count.
+    size_t readFrames(float *interleaved, size_t frames);
+    void seek(uint64_t frame);
+
+private:
+    enum class Encoding { Pcm16, Pcm24, Pcm32, Float32 };
+
+    void parseHeader();
+
+    std::ifstream stream_;
+    std::vector<char> raw_;
+    std::streamoff dataOffset_{0};
+    double sampleRate_{0.0};
+    int channelCount_{0};
+    int bytesPerSample_{0};
+    Encoding encoding_{Encoding::Pcm16};
+    uint64_t totalFrames_{0};
+    uint64_t position_{0};
+};
+
+} // namespace deejay
@@ -0,0 +1,85 @@
+#include "WavFileWriter.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace deejay {
+
+namespace {
+constexpr uint16_t kFormatFloat = 3;
+constexpr size_t kHeaderBytes = 44;
+
+void putLe16(unsigned char *bytes, uint16_t value) {
+    bytes[0] = static_cast<unsigned char>(value & 0xFF);
+    bytes[1] = static_cast<unsigned char>(value >> 8);
+}
+
+void putLe32(unsigned char *bytes, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+    }
+}
+}
+
+WavFileWriter::WavFileWriter(const std::string &path, double sampleRate, int channelCount)
+    : stream_(path, std::ios::binary | std::ios::trunc), sampleRate_(sampleRate), channelCount_(channelCount) {
+    if (!stream_) {
+        throw std::runtime_error("Unable to create WAV file: " + path);
+    }
+    writeHeader();
+}
+
+WavFileWriter::~WavFileWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw; callers that care about the final flush call close() themselves.
+    }
+}
+
+void WavFileWriter::writeFrames(const float *interleaved, size_t frames) {
+    const size_t bytes = frames * static_cast<size_t>(channelCount_) * sizeof(float);
+    stream_.write(reinterpret_cast<const char *>(interleaved), static_cast<std::streamsize>(bytes));
+    if (!stream_) {
+        throw std::runtime_error("Failed to write WAV data");
+    }
+    framesWritten_ += frames;
+}
+
+void WavFileWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    stream_.seekp(0);
+    writeHeader();
+    stream_.close();
+}
+
+void WavFileWriter::writeHeader() {
+    const auto blockAlign = static_cast<uint16_t>(channelCount_ * static_cast<int>(sizeof(float)));
+    const uint64_t dataBytes = framesWritten_ * blockAlign;
+    // RIFF sizes are 32-bit; saturate rather than wrap for files past 4 GiB.
+    const auto dataSize = static_cast<uint32_t>(std::min<uint64_t>(dataBytes, 0xFFFFFFFFull - kHeaderBytes));
+
+    unsigned char header[kHeaderBytes];
+    std::copy_n("RIFF", 4, header);
+    putLe32(header + 4, static_cast<uint32_t>(dataSize + kHeaderBytes - 8));
+    std::copy_n("WAVEfmt ", 8, header + 8);
+    putLe32(header + 16, 16);
+    putLe16(header + 20, kFormatFloat);
+    putLe16(header + 22, static_cast<uint16_t>(channelCount_));
+    putLe32(header + 24, static_cast<uint32_t>(sampleRate_));
+    putLe32(header + 28, static_cast<uint32_t>(sampleRate_) * blockAlign);
+    putLe16(header + 32, blockAlign);
+    putLe16(header + 34, 32);
+    std::copy_n("data", 4, header + 36);
+    putLe32(header + 40, dataSize);
+
+    stream_.write(reinterpret_cast<const char *>(header), sizeof(header));
+    if (!stream_) {
+        throw std::runtime_error("Failed to write WAV header");
+    }
+}
+
+} // namespace deejay
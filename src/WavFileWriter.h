@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace deejay {
+
+// Writes interleaved float32 frames as a 32-bit float RIFF/WAVE file. The header sizes are patched on close(),
+// which the destructor also calls. Throws std::runtime_error when the file cannot be created or written.
+class WavFileWriter {
+public:
+    WavFileWriter(const std::string &path, double sampleRate, int channelCount);
+    ~WavFileWriter();
+
+    WavFileWriter(const WavFileWriter &) = delete;
+    WavFileWriter &operator=(const WavFileWriter &) = delete;
+
+    void writeFrames(const float *interleaved, size_t frames);
+    void close();
+
+    uint64_t framesWritten() const noexcept { return framesWritten_; }
+    int channelCount() const noexcept { return channelCount_; }
+
+private:
+    void writeHeader();
+
+    std::ofstream stream_;
+    double sampleRate_{0.0};
+    int channelCount_{0};
+    uint64_t framesWritten_{0};
+    bool closed_{false};
+};
+
+} // namespace deejay
@@ -0,0 +1,132 @@
+#include "WaveformPyramid.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace deejay {
+
+namespace {
+
+constexpr char kMagic[4] = {'D', 'J', 'W', 'F'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kLevelAlignment = 64;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t headerBytes;
+    uint32_t bandCount;
+    double sampleRate;
+    uint64_t frameCount;
+    uint32_t levelCount;
+    uint32_t levelFactor;
+    float crossoverHz[2];
+    float bandPeak[WaveformPyramid::kBandCount];
+    uint32_t reserved;
+};
+static_assert(sizeof(FileHeader) == 64, "waveform header layout changed");
+
+struct LevelEntry {
+    uint32_t framesPerBin;
+    uint32_t binCount;
+    uint64_t byteOffset;
+};
+static_assert(sizeof(LevelEntry) == 16, "waveform level table layout changed");
+
+size_t alignUp(size_t bytes) noexcept { return (bytes + kLevelAlignment - 1) / kLevelAlignment * kLevelAlignment; }
+
+} // namespace
+
+void WaveformPyramid::write(const WaveformPyramid &pyramid, const std::string &path) {
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerBytes = sizeof(FileHeader);
+    header.bandCount = kBandCount;
+    header.sampleRate = pyramid.sampleRate;
+    header.frameCount = pyramid.frameCount;
+    header.levelCount = static_cast<uint32_t>(pyramid.levels.size());
+    header.levelFactor = pyramid.levelFactor;
+    std::memcpy(header.crossoverHz, pyramid.crossoverHz.data(), sizeof(header.crossoverHz));
+    std::memcpy(header.bandPeak, pyramid.bandPeak.data(), sizeof(header.bandPeak));
+
+    std::vector<LevelEntry> table(pyramid.levels.size());
+    size_t offset = alignUp(sizeof(FileHeader) + table.size() * sizeof(LevelEntry));
+    for (size_t i = 0; i < table.size(); ++i) {
+        table[i].framesPerBin = pyramid.levels[i].framesPerBin;
+        table[i].binCount = static_cast<uint32_t>(pyramid.levels[i].binCount());
+        table[i].byteOffset = offset;
+        offset = alignUp(offset + pyramid.levels[i].values.size());
+    }
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char *>(table.data()),
+                     static_cast<std::streamsize>(table.size() * sizeof(LevelEntry)));
+        size_t written = sizeof(FileHeader) + table.size() * sizeof(LevelEntry);
+        const char padding[kLevelAlignment] = {};
+        for (size_t i = 0; i < table.size(); ++i) {
+            stream.write(padding, static_cast<std::streamsize>(table[i].byteOffset - written));
+            const auto &values = pyramid.levels[i].values;
+            stream.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size()));
+            written = table[i].byteOffset + values.size();
+        }
+        if (!stream) {
+            throw std::runtime_error("Failed to write waveform file: " + temporary);
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Failed to move waveform file into place: " + path);
+    }
+}
+
+WaveformPyramid WaveformPyramid::read(const std::string &path) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        throw std::runtime_error("Unable to open waveform file: " + path);
+    }
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    FileHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        throw std::runtime_error("Truncated waveform file: " + path);
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.headerBytes != sizeof(FileHeader) || header.bandCount != kBandCount) {
+        throw std::runtime_error("Not a version 1 waveform file: " + path);
+    }
+
+    WaveformPyramid pyramid;
+    pyramid.sampleRate = header.sampleRate;
+    pyramid.frameCount = header.frameCount;
+    pyramid.levelFactor = header.levelFactor;
+    std::memcpy(pyramid.crossoverHz.data(), header.crossoverHz, sizeof(header.crossoverHz));
+    std::memcpy(pyramid.bandPeak.data(), header.bandPeak, sizeof(header.bandPeak));
+
+    if (bytes.size() < sizeof(FileHeader) + static_cast<size_t>(header.levelCount) * sizeof(LevelEntry)) {
+        throw std::runtime_error("Truncated waveform file: " + path);
+    }
+    for (uint32_t i = 0; i < header.levelCount; ++i) {
+        LevelEntry entry{};
+        std::memcpy(&entry, bytes.data() + sizeof(FileHeader) + i * sizeof(LevelEntry), sizeof(entry));
+        const size_t length = static_cast<size_t>(entry.binCount) * kBandCount * 2;
+        if (entry.byteOffset > bytes.size() || bytes.size() - entry.byteOffset < length) {
+            throw std::runtime_error("Truncated waveform file: " + path);
+        }
+        Level level;
+        level.framesPerBin = entry.framesPerBin;
+        const auto *first = reinterpret_cast<const int8_t *>(bytes.data() + entry.byteOffset);
+        level.values.assign(first, first + length);
+        pyramid.levels.push_back(std::move(level));
+    }
+    return pyramid;
+}
+
+} // namespace deejay
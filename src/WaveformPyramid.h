@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace deejay {
+
+// Level-of-detail waveform for deck displays: per band (low, mid, high), the int8 min/max of every bin at a
+// ladder of zoom levels. The file is laid out so a reader can map it and view each level in place as an int8
+// array without parsing (src/engine/waveformMipmap.ts); drawing any zoom touches at most `levelFactor` bins per
+// pixel. TrackAnalyzer builds it in the same pass as its peak pyramid.
+//
+// File layout, little-endian, every level 64-byte aligned:
+//   0   "DJWF", uint32 version (1), uint32 headerBytes (64), uint32 bandCount (3)
+//   16  float64 sampleRate, uint64 frameCount
+//   32  uint32 levelCount, uint32 levelFactor, float32 crossoverHz[2]
+//   48  float32 bandPeak[3], uint32 reserved (0)
+//   64  levelCount x { uint32 framesPerBin, uint32 binCount, uint64 byteOffset }
+//   per level at byteOffset: binCount x bandCount x { int8 min, int8 max }
+// A stored value v stands for v / 127 * bandPeak[band]: each band is scaled to its own peak so quiet highs keep
+// their resolution.
+struct WaveformPyramid {
+    static constexpr uint32_t kBandCount = 3;
+
+    struct Level {
+        uint32_t framesPerBin{0};
+        // binCount * kBandCount * 2 values, bin-major.
+        std::vector<int8_t> values;
+
+        size_t binCount() const noexcept { return values.size() / (kBandCount * 2); }
+    };
+
+    double sampleRate{0.0};
+    uint64_t frameCount{0};
+    uint32_t levelFactor{0};
+    std::array<float, 2> crossoverHz{{0.0f, 0.0f}};
+    std::array<float, kBandCount> bandPeak{{0.0f, 0.0f, 0.0f}};
+    std::vector<Level> levels;
+
+    // Both throw std::runtime_error on I/O errors or malformed files. write() replaces `path` atomically.
+    static void write(const WaveformPyramid &pyramid, const std::string &path);
+    static WaveformPyramid read(const std::string &path);
+};
+
+} // namespace deejay
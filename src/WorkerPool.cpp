@@ -0,0 +1,102 @@
+#include "WorkerPool.h"
+
+#include "Semaphore.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#define DEEJAY_CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define DEEJAY_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define DEEJAY_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace deejay {
+
+WorkerPool::WorkerPool(Settings settings) : settings_(settings) {
+    workers_.resize(settings_.workerCount);
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i].wake = std::make_unique<Semaphore>();
+    }
+
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i].thread = std::thread([this, i] { workerLoop(i); });
+#if defined(__linux__)
+        if (settings_.pinToCores) {
+            const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET((static_cast<unsigned>(settings_.firstCore) + static_cast<unsigned>(i)) % cores, &set);
+            pthread_setaffinity_np(workers_[i].thread.native_handle(), sizeof(set), &set);
+        }
+#endif
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    running_.store(false, std::memory_order_release);
+    for (auto &worker : workers_) {
+        worker.wake->post();
+    }
+    for (auto &worker : workers_) {
+        if (worker.thread.joinable()) {
+            worker.thread.join();
+        }
+    }
+}
+
+void WorkerPool::run(Job job, void *context, size_t jobCount) noexcept {
+    if (jobCount == 0) {
+        return;
+    }
+
+    job_ = job;
+    context_ = context;
+    jobCount_ = jobCount;
+    nextJob_.store(0, std::memory_order_relaxed);
+
+    // Wake no more workers than there are jobs beyond the one the caller takes.
+    const size_t helpers = std::min(workers_.size(), jobCount - 1);
+    activeWorkers_.store(helpers, std::memory_order_relaxed);
+    for (size_t i = 0; i < helpers; ++i) {
+        workers_[i].wake->post();
+    }
+
+    drainJobs();
+
+    // Barrier: wait until every woken worker has left the batch, so the next run() can reuse the batch fields.
+    // What is left at this point is a worker's wake-up plus at most one job each, so spinning here is brief.
+    while (activeWorkers_.load(std::memory_order_acquire) != 0) {
+        DEEJAY_CPU_RELAX();
+    }
+}
+
+void WorkerPool::workerLoop(size_t index) {
+    while (true) {
+        workers_[index].wake->wait();
+        if (!running_.load(std::memory_order_acquire)) {
+            return;
+        }
+        drainJobs();
+        activeWorkers_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void WorkerPool::drainJobs() noexcept {
+    while (true) {
+        const size_t index = nextJob_.fetch_add(1, std::memory_order_acq_rel);
+        if (index >= jobCount_) {
+            return;
+        }
+        job_(context_, index);
+    }
+}
+
+} // namespace deejay
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace deejay {
+
+class Semaphore;
+
+// Fixed pool of worker threads that the audio callback fans jobs out to. run() dispatches a batch of indexed
+// jobs, executes jobs on the calling thread as well, and returns once every job in the batch has finished, so
+// each callback ends at a barrier. Workers park on a semaphore between batches (the same wake-up primitive
+// JACK uses for its process graph), so an idle pool costs no CPU and dispatch never takes a lock.
+class WorkerPool {
+public:
+    using Job = void (*)(void *context, size_t index);
+
+    struct Settings {
+        size_t workerCount{0};  // extra threads besides the caller; 0 runs every job inline
+        bool pinToCores{true};  // pin worker i to core firstCore + i (Linux only, ignored elsewhere)
+        int firstCore{1};       // leave core 0 to the device callback thread by default
+    };
+
+    explicit WorkerPool(Settings settings);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    size_t workerCount() const noexcept { return workers_.size(); }
+
+    // Realtime-safe: runs job(context, i) for every i in [0, jobCount) across the pool and the calling thread.
+    // Must only be called from one thread at a time.
+    void run(Job job, void *context, size_t jobCount) noexcept;
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::unique_ptr<Semaphore> wake;
+    };
+
+    void workerLoop(size_t index);
+    void drainJobs() noexcept;
+
+    Settings settings_;
+    std::vector<Worker> workers_;
+    std::atomic<bool> running_{true};
+
+    // Current batch; written by run() before workers are woken.
+    Job job_{nullptr};
+    void *context_{nullptr};
+    size_t jobCount_{0};
+    alignas(64) std::atomic<size_t> nextJob_{0};
+    alignas(64) std::atomic<size_t> activeWorkers_{0};
+};
+
+} // namespace deejay
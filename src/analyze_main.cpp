@@ -0,0 +1,233 @@
+#include "TrackAnalyzer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct AnalyzeConfig
+{
+    std::size_t threads{0};
+    std::size_t chunkFrames{65'536};
+    double minimumBpm{70.0};
+    double maximumBpm{180.0};
+    std::string outputDir{};
+    std::string output{};
+    std::string waveform{};
+    bool waveforms{true};
+    std::vector<std::string> inputs{};
+};
+
+AnalyzeConfig parseArgs(int argc, char** argv)
+{
+    AnalyzeConfig config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if ((arg == "--threads" || arg == "-j") && i + 1 < argc)
+        {
+            config.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--chunk" && i + 1 < argc)
+        {
+            config.chunkFrames = static_cast<std::size_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--min-bpm" && i + 1 < argc)
+        {
+            config.minimumBpm = std::stod(argv[++i]);
+        }
+        else if (arg == "--max-bpm" && i + 1 < argc)
+        {
+            config.maximumBpm = std::stod(argv[++i]);
+        }
+        else if ((arg == "--output-dir" || arg == "-o") && i + 1 < argc)
+        {
+            config.outputDir = argv[++i];
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            config.output = argv[++i];
+        }
+        else if (arg == "--waveform" && i + 1 < argc)
+        {
+            config.waveform = argv[++i];
+        }
+        else if (arg == "--no-waveform")
+        {
+            config.waveforms = false;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            std::cout << "Usage: deejay_analyze [options] input.wav [input.wav ...]\n"
+                      << "  --threads, -j           Tracks analyzed in parallel (default: all cores)\n"
+                      << "  --chunk                 Frames decoded per read (default: 65536)\n"
+                      << "  --min-bpm, --max-bpm    Tempo search range (default: 70-180)\n"
+                      << "  --output-dir, -o        Directory for analysis files (default: next to the input)\n"
+                      << "  --output                Analysis file for a single input\n"
+                      << "  --waveform              Display waveform file for a single input\n"
+                      << "  --no-waveform           Skip the display waveform\n"
+                      << "  --help, -h              Show this message\n"
+                      << "Writes <name>.dja and <name>.djw per input and prints one JSON line per track.\n";
+            std::exit(0);
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+        else
+        {
+            config.inputs.push_back(arg);
+        }
+    }
+
+    return config;
+}
+
+std::string outputPathFor(const std::string& input, const AnalyzeConfig& config, const std::string& extension)
+{
+    const auto slash = input.find_last_of("/\\");
+    const std::string directory = slash == std::string::npos ? std::string{} : input.substr(0, slash + 1);
+    std::string stem = slash == std::string::npos ? input : input.substr(slash + 1);
+    const auto dot = stem.find_last_of('.');
+    if (dot != std::string::npos && dot > 0)
+    {
+        stem.resize(dot);
+    }
+
+    std::ostringstream name;
+    if (!config.outputDir.empty())
+    {
+        name << config.outputDir;
+        if (config.outputDir.back() != '/' && config.outputDir.back() != '\\')
+        {
+            name << '/';
+        }
+    }
+    else
+    {
+        name << directory;
+    }
+    name << stem << extension;
+    return name.str();
+}
+
+void writeJsonString(std::ostream& json, const std::string& text)
+{
+    json << '"';
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            json << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            json << ' ';
+        }
+        else
+        {
+            json << c;
+        }
+    }
+    json << '"';
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const auto config = parseArgs(argc, argv);
+        if (config.inputs.empty())
+        {
+            throw std::invalid_argument("No input files given (see --help)");
+        }
+        if ((!config.output.empty() || !config.waveform.empty()) && config.inputs.size() != 1)
+        {
+            throw std::invalid_argument("--output and --waveform take exactly one input; use --output-dir for several");
+        }
+        if (config.minimumBpm <= 0.0 || config.maximumBpm < config.minimumBpm)
+        {
+            throw std::invalid_argument("--min-bpm must be positive and not above --max-bpm");
+        }
+
+        deejay::TrackAnalyzer::Settings settings;
+        settings.chunkFrames = config.chunkFrames;
+        settings.threads = config.threads;
+        settings.minimumBpm = config.minimumBpm;
+        settings.maximumBpm = config.maximumBpm;
+        deejay::TrackAnalyzer analyzer(settings);
+
+        std::vector<deejay::TrackAnalyzer::Job> jobs;
+        for (const auto& input : config.inputs)
+        {
+            deejay::TrackAnalyzer::Job job;
+            job.inputPath = input;
+            job.outputPath = config.output.empty() ? outputPathFor(input, config, ".dja") : config.output;
+            if (config.waveforms)
+            {
+                job.waveformPath = config.waveform.empty() ? outputPathFor(input, config, ".djw") : config.waveform;
+            }
+            jobs.push_back(job);
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        const auto results = analyzer.runAll(jobs);
+        const double wallSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        double audioSeconds = 0.0;
+        std::size_t failures = 0;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& result = results[i];
+            const auto& analysis = result.analysis;
+            std::cout << "{\"type\":\"analysis\",\"input\":";
+            writeJsonString(std::cout, jobs[i].inputPath);
+            std::cout << ",\"output\":";
+            writeJsonString(std::cout, jobs[i].outputPath);
+            if (!jobs[i].waveformPath.empty())
+            {
+                std::cout << ",\"waveform\":";
+                writeJsonString(std::cout, jobs[i].waveformPath);
+            }
+            std::cout << ",\"ok\":" << (result.ok ? "true" : "false");
+            if (result.ok)
+            {
+                const double trackSeconds = static_cast<double>(analysis.frameCount) / analysis.sampleRate;
+                audioSeconds += trackSeconds;
+                std::cout << ",\"sampleRate\":" << analysis.sampleRate << ",\"duration\":" << trackSeconds
+                          << ",\"bpm\":" << analysis.bpm << ",\"firstBeatSeconds\":" << analysis.firstBeatSeconds
+                          << ",\"tempoConfidence\":" << analysis.tempoConfidence << ",\"seconds\":" << result.seconds;
+            }
+            else
+            {
+                ++failures;
+                std::cout << ",\"error\":";
+                writeJsonString(std::cout, result.error);
+            }
+            std::cout << "}\n";
+        }
+
+        std::cerr << "Analyzed " << results.size() - failures << "/" << results.size() << " tracks in " << std::fixed
+                  << std::setprecision(2) << wallSeconds << " s (" << std::setprecision(1)
+                  << audioSeconds / std::max(wallSeconds, 1e-9) << "x realtime)" << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
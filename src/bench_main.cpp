@@ -0,0 +1,489 @@
+// Google Benchmark suite for the realtime DSP paths. Every case reports time per input frame, heap allocations
+// per block (counted by the global operator new below) and the p99 wall time of a single block, so regressions
+// in throughput, realtime safety and tail latency show up separately.
+#include "AudioSource.h"
+#include "FractionalDelayLine.h"
+#include "LatencyCompensatedProcessor.h"
+#include "MixerBus.h"
+#include "SamplerEngine.h"
+#include "TimeStretchPitchProcessor.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace
+{
+std::atomic<std::uint64_t> allocationCount{0};
+
+void* countedAllocate(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size == 0 ? 1 : size))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+namespace
+{
+using deejay::FractionalDelayLine;
+using deejay::LatencyCompensatedProcessor;
+using deejay::MixerBus;
+using deejay::SamplerEngine;
+using deejay::TimeStretchPitchProcessor;
+
+constexpr double kSampleRate = 48'000.0;
+// Blocks processed before timing starts, so the stretcher is past its priming phase.
+constexpr int kWarmupBlocks = 64;
+// Upper bound on per-block timings kept for the p99 counter; reserved up front so recording never allocates.
+constexpr std::size_t kMaxTimedBlocks = 1 << 18;
+
+// Endless interleaved source over a fixed buffer, lending its storage the way MappedTrackSource does.
+class LoopSource : public deejay::AudioSource
+{
+public:
+    LoopSource(const std::vector<float>& samples, int channels) : samples_(samples), channels_(channels) {}
+
+    int channelCount() const noexcept override { return channels_; }
+
+    std::size_t read(float* interleaved, std::size_t frames) noexcept override
+    {
+        std::size_t copied = 0;
+        while (copied < frames)
+        {
+            std::size_t chunk = frames - copied;
+            const float* block = acquire(chunk);
+            std::copy(block, block + chunk * static_cast<std::size_t>(channels_),
+                interleaved + copied * static_cast<std::size_t>(channels_));
+            copied += chunk;
+        }
+        return copied;
+    }
+
+    const float* acquire(std::size_t& frames) noexcept override
+    {
+        const std::size_t total = samples_.size() / static_cast<std::size_t>(channels_);
+        frames = std::min(frames, total - position_);
+        const float* block = samples_.data() + position_ * static_cast<std::size_t>(channels_);
+        position_ = (position_ + frames) % total;
+        return block;
+    }
+
+private:
+    const std::vector<float>& samples_;
+    int channels_;
+    std::size_t position_{0};
+};
+
+// Collects per-block timings and allocation counts for one benchmark run and publishes the counters.
+class BlockStats
+{
+public:
+    BlockStats() { timings_.reserve(kMaxTimedBlocks); }
+
+    void begin() noexcept
+    {
+        allocationsAtStart_ = allocationCount.load(std::memory_order_relaxed);
+        blockStart_ = std::chrono::steady_clock::now();
+    }
+
+    void end() noexcept
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - blockStart_;
+        allocations_ += allocationCount.load(std::memory_order_relaxed) - allocationsAtStart_;
+        if (timings_.size() < timings_.capacity())
+        {
+            timings_.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+        }
+    }
+
+    void publish(benchmark::State& state, std::size_t framesPerBlock)
+    {
+        state.counters["per_frame"] = benchmark::Counter(static_cast<double>(framesPerBlock),
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+        state.counters["allocs/block"] = benchmark::Counter(
+            static_cast<double>(allocations_) / static_cast<double>(std::max<std::int64_t>(1, state.iterations())));
+        if (!timings_.empty())
+        {
+            const std::size_t rank = (timings_.size() * 99) / 100;
+            std::nth_element(timings_.begin(), timings_.begin() + static_cast<std::ptrdiff_t>(rank), timings_.end());
+            state.counters["p99_us"] = timings_[std::min(rank, timings_.size() - 1)];
+        }
+    }
+
+private:
+    std::vector<double> timings_;
+    std::chrono::steady_clock::time_point blockStart_{};
+    std::uint64_t allocationsAtStart_{0};
+    std::uint64_t allocations_{0};
+};
+
+std::vector<float> noise(std::size_t samples)
+{
+    std::vector<float> buffer(samples);
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+    for (auto& sample : buffer)
+    {
+        sample = distribution(generator);
+    }
+    return buffer;
+}
+
+// Arguments are {block frames, channels, tempo ratio * 100, high quality}.
+struct CaseArgs
+{
+    std::size_t frames;
+    int channels;
+    double tempoRatio;
+    bool highQuality;
+
+    explicit CaseArgs(const benchmark::State& state)
+        : frames(static_cast<std::size_t>(state.range(0))), channels(static_cast<int>(state.range(1))),
+          tempoRatio(static_cast<double>(state.range(2)) / 100.0), highQuality(state.range(3) != 0)
+    {
+    }
+};
+
+// Stretched output per block can exceed the input (tempo < 1), so leave room for the slowest endpoint setting.
+std::size_t outputCapacityFor(std::size_t frames)
+{
+    return frames * 4 + 1024;
+}
+
+void BM_TimeStretchProcess(benchmark::State& state)
+{
+    const CaseArgs args(state);
+    TimeStretchPitchProcessor::Parameters parameters;
+    parameters.tempoRatio = args.tempoRatio;
+    parameters.quality.highQuality = args.highQuality;
+    TimeStretchPitchProcessor::Options options;
+    options.singleThreaded = true;
+
+    TimeStretchPitchProcessor processor(kSampleRate, args.channels, parameters, options);
+    // The sweep measures the stretcher itself; BM_UnityBypass covers the bypass.
+    processor.setUnityBypass(false);
+    processor.prepare(args.frames);
+
+    const std::size_t capacity = outputCapacityFor(args.frames);
+    const auto input = noise(args.frames * static_cast<std::size_t>(args.channels));
+    std::vector<float> output(capacity * static_cast<std::size_t>(args.channels));
+    std::vector<const float*> inputChannels(static_cast<std::size_t>(args.channels));
+    std::vector<float*> outputChannels(static_cast<std::size_t>(args.channels));
+    for (int ch = 0; ch < args.channels; ++ch)
+    {
+        inputChannels[static_cast<std::size_t>(ch)] = input.data() + static_cast<std::size_t>(ch) * args.frames;
+        outputChannels[static_cast<std::size_t>(ch)] = output.data() + static_cast<std::size_t>(ch) * capacity;
+    }
+
+    for (int i = 0; i < kWarmupBlocks; ++i)
+    {
+        processor.process(inputChannels.data(), args.frames, outputChannels.data(), capacity);
+    }
+
+    BlockStats stats;
+    for (auto _ : state)
+    {
+        stats.begin();
+        benchmark::DoNotOptimize(processor.process(inputChannels.data(), args.frames, outputChannels.data(), capacity));
+        stats.end();
+        benchmark::ClobberMemory();
+    }
+    stats.publish(state, args.frames);
+}
+
+void BM_LatencyCompensatedProcessBlock(benchmark::State& state)
+{
+    const CaseArgs args(state);
+    TimeStretchPitchProcessor::Options options;
+    options.singleThreaded = true;
+
+    LatencyCompensatedProcessor processor(kSampleRate, args.channels, options);
+    LatencyCompensatedProcessor::Controls controls;
+    controls.tempoRatio = args.tempoRatio;
+    processor.updateControls(controls);
+    processor.setUnityBypass(false);
+    processor.prepare(args.frames);
+
+    const std::size_t capacity = outputCapacityFor(args.frames);
+    const auto input = noise(args.frames * static_cast<std::size_t>(args.channels));
+    std::vector<float> output(capacity * static_cast<std::size_t>(args.channels));
+
+    for (int i = 0; i < kWarmupBlocks; ++i)
+    {
+        processor.processBlock(input.data(), args.frames, output.data(), capacity);
+    }
+
+    BlockStats stats;
+    for (auto _ : state)
+    {
+        stats.begin();
+        benchmark::DoNotOptimize(processor.processBlock(input.data(), args.frames, output.data(), capacity));
+        stats.end();
+        benchmark::ClobberMemory();
+    }
+    stats.publish(state, args.frames);
+}
+
+// Pull-mode deck render at unity tempo and pitch with the stretcher running (bypass:0) or bypassed (bypass:1),
+// which is what a deck costs for most of a set.
+void BM_UnityBypass(benchmark::State& state)
+{
+    const auto frames = static_cast<std::size_t>(state.range(0));
+    const auto channels = static_cast<int>(state.range(1));
+    TimeStretchPitchProcessor::Options options;
+    options.singleThreaded = true;
+
+    LatencyCompensatedProcessor processor(kSampleRate, channels, options);
+    processor.setUnityBypass(state.range(2) != 0);
+    processor.prepare(frames);
+
+    const auto input = noise(frames * static_cast<std::size_t>(channels));
+    LoopSource source(input, channels);
+    std::vector<float> output(frames * static_cast<std::size_t>(channels));
+
+    // Long enough for the bypass to engage after priming.
+    for (int i = 0; i < kWarmupBlocks * 4; ++i)
+    {
+        processor.pull(source, output.data(), frames);
+    }
+
+    BlockStats stats;
+    for (auto _ : state)
+    {
+        stats.begin();
+        benchmark::DoNotOptimize(processor.pull(source, output.data(), frames));
+        stats.end();
+        benchmark::ClobberMemory();
+    }
+    stats.publish(state, frames);
+    state.counters["bypassed"] = processor.unityBypassActive() ? 1.0 : 0.0;
+}
+
+// Fused deck summing. ramp:1 moves the crossfader every block, so every deck's gain ramps across the whole block;
+// ramp:0 is the steady state.
+void BM_MixerBus(benchmark::State& state)
+{
+    const auto frames = static_cast<std::size_t>(state.range(0));
+    const auto channels = static_cast<int>(state.range(1));
+    const auto decks = static_cast<std::size_t>(state.range(2));
+    const bool ramp = state.range(3) != 0;
+
+    MixerBus mixer(channels, decks);
+    for (std::size_t deck = 0; deck < decks; ++deck)
+    {
+        mixer.setCrossfaderSide(deck, deck % 2 == 0 ? MixerBus::CrossfaderSide::A : MixerBus::CrossfaderSide::B);
+    }
+    const auto samples = frames * static_cast<std::size_t>(channels);
+    std::vector<std::vector<float>> inputs;
+    std::vector<const float*> deckOutputs;
+    for (std::size_t deck = 0; deck < decks; ++deck)
+    {
+        inputs.push_back(noise(samples));
+        deckOutputs.push_back(inputs.back().data());
+    }
+    std::vector<float> output(samples);
+
+    BlockStats stats;
+    float position = 0.0f;
+    for (auto _ : state)
+    {
+        if (ramp)
+        {
+            position = position > 0.5f ? 0.25f : 0.75f;
+            mixer.setCrossfader(position);
+        }
+        stats.begin();
+        mixer.mix(deckOutputs.data(), output.data(), frames);
+        stats.end();
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    stats.publish(state, frames);
+}
+
+// The latency-compensation delay line, interleaved. ch:3 takes the runtime-channel fallback, the other counts
+// the fixed-channel kernels; glide:1 retargets the delay every block so the read position slews throughout.
+void BM_FractionalDelayLine(benchmark::State& state)
+{
+    const auto frames = static_cast<std::size_t>(state.range(0));
+    const auto channels = static_cast<int>(state.range(1));
+    const bool glide = state.range(2) != 0;
+
+    FractionalDelayLine delay;
+    delay.prepare(channels, 4096);
+    delay.reset(256.5);
+    auto buffer = noise(frames * static_cast<std::size_t>(channels));
+
+    BlockStats stats;
+    double target = 256.5;
+    for (auto _ : state)
+    {
+        if (glide)
+        {
+            target = target > 512.0 ? 256.5 : 1024.25;
+            delay.setTargetDelay(target);
+        }
+        stats.begin();
+        delay.process(buffer.data(), frames);
+        stats.end();
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+    stats.publish(state, frames);
+}
+
+// Sampler with every voice busy on a one-second sound; steal:1 retriggers one voice per block, so the pool is
+// full and every trigger steals.
+void BM_SamplerEngine(benchmark::State& state)
+{
+    const auto frames = static_cast<std::size_t>(state.range(0));
+    const auto voices = static_cast<std::size_t>(state.range(1));
+    const bool steal = state.range(2) != 0;
+
+    SamplerEngine::Settings settings;
+    settings.sampleRate = kSampleRate;
+    settings.channelCount = 2;
+    settings.maxVoices = voices;
+    settings.maxBlockFrames = frames;
+    SamplerEngine sampler(settings);
+    const auto sound = noise(static_cast<std::size_t>(kSampleRate));
+    sampler.loadSound(1, sound.data(), sound.size(), kSampleRate);
+
+    BlockStats stats;
+    std::size_t block = 0;
+    for (auto _ : state)
+    {
+        // Restart the pool once the sound has played out, outside the timed region.
+        if (block++ % (sound.size() / frames) == 0)
+        {
+            sampler.stopAll();
+            for (std::size_t voice = 0; voice < voices; ++voice)
+            {
+                sampler.start(1, 0.5f);
+            }
+        }
+        stats.begin();
+        if (steal)
+        {
+            sampler.start(1, 0.5f);
+        }
+        sampler.render(frames);
+        stats.end();
+        benchmark::DoNotOptimize(sampler.output());
+        benchmark::ClobberMemory();
+    }
+    stats.publish(state, frames);
+    state.counters["stolen"] = static_cast<double>(sampler.stolenVoices());
+}
+
+// Sweeps block sizes 32-4096, mono/stereo, and tempo ratios spanning the range the UI exposes.
+void applySweep(benchmark::internal::Benchmark* benchmark, bool qualityAxis)
+{
+    double minimumTempo = 0.5;
+    double maximumTempo = 2.5;
+    for (const auto& endpoint : TimeStretchPitchProcessor(kSampleRate, 1).describeEndpoints())
+    {
+        if (endpoint.id == "tempo")
+        {
+            minimumTempo = endpoint.minimum;
+            maximumTempo = endpoint.maximum;
+        }
+    }
+    const std::vector<double> tempos{minimumTempo, 1.0, (1.0 + maximumTempo) / 2.0, maximumTempo};
+
+    benchmark->ArgNames({"frames", "ch", "tempo%", "hq"});
+    for (std::int64_t frames : {32, 128, 512, 1024, 4096})
+    {
+        for (std::int64_t channels : {1, 2})
+        {
+            for (double tempo : tempos)
+            {
+                const auto tempoPercent = static_cast<std::int64_t>(std::lround(tempo * 100.0));
+                benchmark->Args({frames, channels, tempoPercent, 1});
+                if (qualityAxis)
+                {
+                    benchmark->Args({frames, channels, tempoPercent, 0});
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_TimeStretchProcess)->Apply([](benchmark::internal::Benchmark* b) { applySweep(b, true); });
+// LatencyCompensatedProcessor has no quality control of its own; it runs the stretcher's default settings.
+BENCHMARK(BM_LatencyCompensatedProcessBlock)->Apply([](benchmark::internal::Benchmark* b) { applySweep(b, false); });
+
+BENCHMARK(BM_UnityBypass)
+    ->ArgNames({"frames", "ch", "bypass"})
+    ->ArgsProduct({{128, 512, 1024}, {1, 2}, {0, 1}});
+
+BENCHMARK(BM_MixerBus)
+    ->ArgNames({"frames", "ch", "decks", "ramp"})
+    ->ArgsProduct({{128, 512}, {1, 2, 4}, {2, 4}, {0, 1}});
+
+BENCHMARK(BM_FractionalDelayLine)
+    ->ArgNames({"frames", "ch", "glide"})
+    ->ArgsProduct({{128, 512}, {1, 2, 3, 4}, {0, 1}});
+
+BENCHMARK(BM_SamplerEngine)
+    ->ArgNames({"frames", "voices", "steal"})
+    ->ArgsProduct({{128, 512}, {8, 32}, {0, 1}});
+
+BENCHMARK_MAIN();
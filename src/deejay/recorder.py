@@ -3,6 +3,10 @@
 This module streams PCM data from the default input device and writes it
 out using libsndfile-backed formats (WAV/FLAC). It also computes a compact
 waveform preview to support quick saving in the database layer.
+
+To record the engine's own master output instead of an input device, run
+``deejay_audio --record PATH``: the C++ ``RecorderTap`` writes the file off the
+audio thread and reports the same preview in its ``recording`` JSON line.
 """
 from __future__ import annotations
 
@@ -1,4 +1,7 @@
+import { CallbackMetricsSnapshot, EngineMetricsParser, LatencyChange, LoadGovernorReport } from './engineMetrics';
 import { ParameterQueue, ParameterValue } from './parameterQueue';
+import { SharedEngineRegion } from './sharedRegion';
+import { WaveformColumns, WaveformMipmap } from './waveformMipmap';
 
 type EngineQueues = {
   deckAQueue: ParameterQueue;
@@ -11,15 +14,45 @@ interface WaveformCache {
   deckB: number[];
 }
 
+export type DeckName = 'deckA' | 'deckB';
+
+export interface WaveformInfo {
+  sampleRate: number;
+  frameCount: number;
+  bandPeaks: number[];
+}
+
+type MetricsListener = (snapshot: CallbackMetricsSnapshot) => void;
+type GovernorListener = (report: LoadGovernorReport) => void;
+type LatencyListener = (change: LatencyChange) => void;
+
 export class EngineBindings {
-  private readonly queues: EngineQueues;
+  private queues: EngineQueues;
   private readonly waveformCache: WaveformCache;
   private recorderEnabled: boolean;
+  private readonly metricsParser: EngineMetricsParser;
+  private readonly metricsListeners: Set<MetricsListener>;
+  private latestMetrics: CallbackMetricsSnapshot | undefined;
+  private readonly governorListeners: Set<GovernorListener>;
+  private latestGovernor: LoadGovernorReport | undefined;
+  private readonly latencyListeners: Set<LatencyListener>;
+  private readonly deckLatencies: Map<number, number>;
+  private sharedRegion: SharedEngineRegion | undefined;
+  private readonly waveforms: Map<DeckName, WaveformMipmap>;
 
   constructor(queues: EngineQueues) {
     this.queues = queues;
     this.recorderEnabled = false;
-    // In lieu of a real engine, generate placeholder waveform values.
+    this.metricsParser = new EngineMetricsParser();
+    this.metricsListeners = new Set();
+    this.latestMetrics = undefined;
+    this.governorListeners = new Set();
+    this.latestGovernor = undefined;
+    this.latencyListeners = new Set();
+    this.deckLatencies = new Map();
+    this.sharedRegion = undefined;
+    this.waveforms = new Map();
+    // Placeholder waveforms for decks that have no analyzed waveform attached.
     this.waveformCache = {
       deckA: this.generateSineWave(2048, 1),
       deckB: this.generateSineWave(2048, 0.5, Math.PI / 3),
@@ -47,6 +80,102 @@ export class EngineBindings {
     return this.waveformCache;
   }
 
+  /**
+   * Attaches the contents of a `.djw` file written by deejay_analyze to `deck`. The bytes are viewed in place,
+   * never copied or parsed beyond the header; throws when they are not a waveform file.
+   */
+  attachWaveform(deck: DeckName, buffer: ArrayBufferLike, byteOffset = 0): void {
+    this.waveforms.set(deck, new WaveformMipmap(buffer, byteOffset));
+  }
+
+  getWaveformInfo(deck: DeckName): WaveformInfo | undefined {
+    const waveform = this.waveforms.get(deck);
+    return waveform
+      ? { sampleRate: waveform.sampleRate, frameCount: waveform.frameCount, bandPeaks: waveform.bandPeaks }
+      : undefined;
+  }
+
+  /** Visible columns of the deck's waveform at any zoom; undefined until one is attached. */
+  getWaveformColumns(
+    deck: DeckName,
+    startFrame: number,
+    framesPerPixel: number,
+    pixels: number,
+  ): WaveformColumns | undefined {
+    return this.waveforms.get(deck)?.columns(startFrame, framesPerPixel, pixels);
+  }
+
+  /**
+   * Feeds raw stdout from the native engine; every callback metrics, load governor and latency change line
+   * updates the latest value of its kind and is forwarded to that kind's listeners.
+   */
+  ingestEngineOutput(chunk: string): void {
+    this.metricsParser.push(chunk).forEach((message) => {
+      if (message.type === 'callbackMetrics') {
+        this.latestMetrics = message.snapshot;
+        this.metricsListeners.forEach((listener) => listener(message.snapshot));
+      } else if (message.type === 'loadGovernor') {
+        this.latestGovernor = message.report;
+        this.governorListeners.forEach((listener) => listener(message.report));
+      } else {
+        this.deckLatencies.set(message.change.deck, message.change.currentSamples);
+        this.latencyListeners.forEach((listener) => listener(message.change));
+      }
+    });
+  }
+
+  getCallbackMetrics(): CallbackMetricsSnapshot | undefined {
+    return this.latestMetrics;
+  }
+
+  onCallbackMetrics(listener: MetricsListener): () => void {
+    this.metricsListeners.add(listener);
+    return () => {
+      this.metricsListeners.delete(listener);
+    };
+  }
+
+  /**
+   * Sends parameter writes straight into the native engine's shared control region from now on. Deck A and B
+   * writes go to the first two deck rings; everything else goes to the transport ring.
+   */
+  attachSharedRegion(region: SharedEngineRegion): void {
+    this.sharedRegion = region;
+    this.queues = {
+      deckAQueue: region.deckCount > 0 ? region.deckQueue(0) : region.transportQueue(),
+      deckBQueue: region.deckCount > 1 ? region.deckQueue(1) : region.transportQueue(),
+      transportQueue: region.transportQueue(),
+    };
+  }
+
+  /** Meters and waveforms are read from the region in place; undefined until one is attached. */
+  getSharedRegion(): SharedEngineRegion | undefined {
+    return this.sharedRegion;
+  }
+
+  getLoadGovernor(): LoadGovernorReport | undefined {
+    return this.latestGovernor;
+  }
+
+  onLoadGovernor(listener: GovernorListener): () => void {
+    this.governorListeners.add(listener);
+    return () => {
+      this.governorListeners.delete(listener);
+    };
+  }
+
+  /** Last total latency the engine reported for a deck; undefined until it first changes. */
+  getDeckLatency(deck: number): number | undefined {
+    return this.deckLatencies.get(deck);
+  }
+
+  onLatencyChanged(listener: LatencyListener): () => void {
+    this.latencyListeners.add(listener);
+    return () => {
+      this.latencyListeners.delete(listener);
+    };
+  }
+
   /**
    * In a production build this would call out to the native audio engine bindings.
    */
@@ -0,0 +1,107 @@
+/**
+ * Snapshot of the native engine's callback instrumentation, as printed by `deejay_audio --metrics-interval`.
+ * Counters are cumulative since the stream started; diff consecutive snapshots for per-interval rates.
+ */
+export interface CallbackMetricsSnapshot {
+  callbacks: number;
+  framesRendered: number;
+  underflows: number;
+  overflows: number;
+  overBudget: number;
+  /** Upper bound of bucket 0 in microseconds; each further bucket doubles, the last one is open-ended. */
+  histogramFirstBucketMicros: number;
+  durationHistogram: number[];
+  lastDurationMicros: number;
+  /** Callback time divided by buffer period; above 1 the callback missed its deadline. */
+  budgetUtilization: number;
+  /** Worst utilization since the previous snapshot. */
+  peakBudgetUtilization: number;
+  outputLatencySeconds: number;
+  outputLatencyDriftSeconds: number;
+}
+
+/** Degradation stage of one deck, mildest first; see LoadGovernor.h. */
+export type LoadGovernorStage = 'full' | 'noFormants' | 'highSpeed' | 'unityBypass';
+
+export interface LoadGovernorDeck {
+  stage: number;
+  stageName: LoadGovernorStage;
+  /** Deck render time over the audio duration it rendered since the previous report. */
+  budgetShare: number;
+  bypassActive: boolean;
+  qualitySwapPending: boolean;
+}
+
+/** Load governor state, printed right after each callback metrics snapshot. Counters are cumulative. */
+export interface LoadGovernorReport {
+  peakBudgetUtilization: number;
+  degradations: number;
+  restorations: number;
+  decks: LoadGovernorDeck[];
+}
+
+/**
+ * A change in one deck's total processing latency (stretcher plus compensation delay), printed when it happens
+ * rather than polled. Sync math can apply `currentSamples - previousSamples` as an incremental correction.
+ */
+export interface LatencyChange {
+  deck: number;
+  previousSamples: number;
+  currentSamples: number;
+  sampleRate: number;
+}
+
+export type EngineMessage =
+  | { type: 'callbackMetrics'; snapshot: CallbackMetricsSnapshot }
+  | { type: 'loadGovernor'; report: LoadGovernorReport }
+  | { type: 'latencyChanged'; change: LatencyChange };
+
+/**
+ * Splits engine stdout into lines and returns the metric messages among them. Other output (the engine's
+ * plain-text status lines) is ignored. Partial trailing lines are kept until the next chunk arrives.
+ */
+export class EngineMetricsParser {
+  private pending = '';
+
+  push(chunk: string): EngineMessage[] {
+    this.pending += chunk;
+    const lines = this.pending.split('\n');
+    this.pending = lines.pop() ?? '';
+
+    const messages: EngineMessage[] = [];
+    lines.forEach((line) => {
+      const message = parseEngineLine(line);
+      if (message) {
+        messages.push(message);
+      }
+    });
+    return messages;
+  }
+}
+
+export function parseEngineLine(line: string): EngineMessage | undefined {
+  const trimmed = line.trim();
+  if (!trimmed.startsWith('{')) {
+    return undefined;
+  }
+  try {
+    const { type, ...payload } = JSON.parse(trimmed) as { type?: string };
+    if (type === 'callbackMetrics') {
+      return { type, snapshot: payload as CallbackMetricsSnapshot };
+    }
+    if (type === 'loadGovernor') {
+      return { type, report: payload as LoadGovernorReport };
+    }
+    if (type === 'latencyChanged') {
+      return { type, change: payload as LatencyChange };
+    }
+    return undefined;
+  } catch {
+    return undefined;
+  }
+}
+
+export function parseMetricsLine(line: string): CallbackMetricsSnapshot | undefined {
+  const message = parseEngineLine(line);
+  return message?.type === 'callbackMetrics' ? message.snapshot : undefined;
+}
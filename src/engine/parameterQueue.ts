@@ -5,13 +5,35 @@ export interface QueuedParameter {
   value: ParameterValue;
 }
 
+/**
+ * Existing memory to lay the queue over instead of allocating a SharedArrayBuffer, e.g. one of the parameter
+ * rings of the engine's shared control region (see sharedRegion.ts). `byteOffset` must be 8-byte aligned.
+ */
+export interface QueueStorage {
+  buffer: ArrayBufferLike;
+  byteOffset: number;
+}
+
+/**
+ * Maps human-readable identifiers to int32 IDs for faster transfer to native code. The engine computes the same
+ * hash for its endpoint keys (deejay_hash_target in EngineAbi.h), so the IDs match on both sides.
+ */
+export function hashTarget(target: string): number {
+  let hash = 0;
+  for (let i = 0; i < target.length; i += 1) {
+    hash = (hash << 5) - hash + target.charCodeAt(i);
+    hash |= 0; // convert to 32-bit integer
+  }
+  return hash;
+}
+
 /**
  * Lock-free single-producer/single-consumer queue implemented with SharedArrayBuffer.
  * The audio engine can poll the shared head/tail without any mutexes.
  */
 export class ParameterQueue {
   private readonly capacity: number;
-  private readonly buffer: SharedArrayBuffer;
+  private readonly buffer: ArrayBufferLike;
   private readonly headIndex: Int32Array;
   private readonly tailIndex: Int32Array;
   private readonly targets: Int32Array;
@@ -20,15 +42,18 @@ export class ParameterQueue {
   private readonly channel: string;
   private stringKey: number;
 
-  constructor(channel: string, capacity = 256) {
+  constructor(channel: string, capacity = 256, storage?: QueueStorage) {
     this.capacity = capacity;
     this.channel = channel;
     // head, tail, and stringKey indexes live in first 3 slots
-    this.buffer = new SharedArrayBuffer((3 + capacity * 2) * Int32Array.BYTES_PER_ELEMENT + capacity * Float64Array.BYTES_PER_ELEMENT);
-    this.headIndex = new Int32Array(this.buffer, 0, 1);
-    this.tailIndex = new Int32Array(this.buffer, Int32Array.BYTES_PER_ELEMENT, 1);
-    this.targets = new Int32Array(this.buffer, Int32Array.BYTES_PER_ELEMENT * 2, capacity);
-    this.values = new Float64Array(this.buffer, Int32Array.BYTES_PER_ELEMENT * (2 + capacity), capacity);
+    this.buffer =
+      storage?.buffer ??
+      new SharedArrayBuffer((3 + capacity * 2) * Int32Array.BYTES_PER_ELEMENT + capacity * Float64Array.BYTES_PER_ELEMENT);
+    const base = storage?.byteOffset ?? 0;
+    this.headIndex = new Int32Array(this.buffer, base, 1);
+    this.tailIndex = new Int32Array(this.buffer, base + Int32Array.BYTES_PER_ELEMENT, 1);
+    this.targets = new Int32Array(this.buffer, base + Int32Array.BYTES_PER_ELEMENT * 2, capacity);
+    this.values = new Float64Array(this.buffer, base + Int32Array.BYTES_PER_ELEMENT * (2 + capacity), capacity);
     this.strings = new Map();
     this.stringKey = 0;
   }
@@ -42,7 +67,7 @@ export class ParameterQueue {
     }
 
     const index = tail;
-    this.targets[index] = this.hashTarget(target);
+    this.targets[index] = hashTarget(target);
     if (typeof value === 'number') {
       this.values[index] = value;
     } else {
@@ -83,19 +108,6 @@ export class ParameterQueue {
     return this.channel;
   }
 
-  /**
-   * Maps human-readable identifiers to int32 IDs for faster transfer to native code.
-   * In this placeholder implementation we simply use a basic hash.
-   */
-  private hashTarget(target: string): number {
-    let hash = 0;
-    for (let i = 0; i < target.length; i += 1) {
-      hash = (hash << 5) - hash + target.charCodeAt(i);
-      hash |= 0; // convert to 32-bit integer
-    }
-    return hash;
-  }
-
   private reverseHash(hash: number): string {
     // In a production system this would map back to a lookup table. Here we preserve the original string in a map.
     return `${this.channel}:${hash}`;
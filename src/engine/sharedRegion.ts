@@ -0,0 +1,173 @@
+import { ParameterQueue } from './parameterQueue';
+
+/** "DJSM", DEEJAY_SHARED_MAGIC in EngineAbi.h. */
+const SHARED_MAGIC = 0x4d534a44;
+const SHARED_VERSION = 1;
+const ENDPOINT_BYTES = 104;
+const ENDPOINT_KEY_BYTES = 32;
+const METER_BYTES = 16;
+const WAVEFORM_HEADER_BYTES = 8;
+
+export type SharedEndpointKind = 'slider' | 'numeric';
+
+/** One DeejayEndpoint record, decoded once when the region is opened. */
+export interface SharedEndpoint {
+  id: number;
+  queue: number;
+  kind: SharedEndpointKind;
+  minimum: number;
+  maximum: number;
+  defaultValue: number;
+  key: string;
+  label: string;
+}
+
+export interface SharedMeter {
+  /** Blocks measured so far; unchanged means no new audio since the last read. */
+  updates: number;
+  peak: number;
+  rms: number;
+}
+
+interface SharedHeader {
+  deckCount: number;
+  endpointCount: number;
+  endpointsOffset: number;
+  queueCount: number;
+  queueCapacity: number;
+  queuesOffset: number;
+  queueStride: number;
+  meterCount: number;
+  metersOffset: number;
+  waveformPoints: number;
+  framesPerWaveformPoint: number;
+  waveformsOffset: number;
+  waveformStride: number;
+}
+
+/**
+ * Reader over the native engine's shared control region (layout in src/EngineAbi.h), for memory exposed to the
+ * renderer as an ArrayBuffer or SharedArrayBuffer, e.g. by a native addon that maps the file passed to
+ * `deejay_audio --shared-memory`. Parameter rings are ordinary ParameterQueues laid over the region; meters and
+ * waveforms are typed-array views into it, so reading them once per UI frame copies and parses nothing.
+ * `byteOffset` must be 8-byte aligned.
+ */
+export class SharedEngineRegion {
+  readonly endpoints: SharedEndpoint[];
+  private readonly header: SharedHeader;
+  private readonly buffer: ArrayBufferLike;
+  private readonly byteOffset: number;
+  private readonly queues: ParameterQueue[];
+  private readonly meterWords: Uint32Array;
+  private readonly meterValues: Float32Array;
+  private readonly waveformCounts: Uint32Array[];
+  private readonly waveformPoints: Float32Array[];
+
+  constructor(buffer: ArrayBufferLike, byteOffset = 0) {
+    this.buffer = buffer;
+    this.byteOffset = byteOffset;
+    const view = new DataView(buffer, byteOffset);
+    if (view.getUint32(0, true) !== SHARED_MAGIC || view.getUint32(4, true) !== SHARED_VERSION) {
+      throw new Error('Not a DeeJay shared control region');
+    }
+    if (view.getUint32(8, true) > buffer.byteLength - byteOffset) {
+      throw new Error('Shared control region is truncated');
+    }
+    const field = (index: number) => view.getUint32(index * 4, true);
+    this.header = {
+      deckCount: field(3),
+      endpointCount: field(4),
+      endpointsOffset: field(5),
+      queueCount: field(6),
+      queueCapacity: field(7),
+      queuesOffset: field(8),
+      queueStride: field(9),
+      meterCount: field(10),
+      metersOffset: field(11),
+      waveformPoints: field(12),
+      framesPerWaveformPoint: field(13),
+      waveformsOffset: field(14),
+      waveformStride: field(15),
+    };
+
+    this.endpoints = this.readEndpoints(view);
+    this.queues = Array.from({ length: this.header.queueCount }).map(
+      (_, index) =>
+        new ParameterQueue(index < this.header.deckCount ? deckChannel(index) : 'transport', this.header.queueCapacity, {
+          buffer,
+          byteOffset: byteOffset + this.header.queuesOffset + index * this.header.queueStride,
+        }),
+    );
+    this.meterWords = new Uint32Array(buffer, byteOffset + this.header.metersOffset, (this.header.meterCount * METER_BYTES) / 4);
+    this.meterValues = new Float32Array(buffer, byteOffset + this.header.metersOffset, (this.header.meterCount * METER_BYTES) / 4);
+    this.waveformCounts = [];
+    this.waveformPoints = [];
+    for (let deck = 0; deck < this.header.deckCount; deck += 1) {
+      const start = byteOffset + this.header.waveformsOffset + deck * this.header.waveformStride;
+      this.waveformCounts.push(new Uint32Array(buffer, start, 1));
+      this.waveformPoints.push(new Float32Array(buffer, start + WAVEFORM_HEADER_BYTES, this.header.waveformPoints));
+    }
+  }
+
+  get deckCount(): number {
+    return this.header.deckCount;
+  }
+
+  get framesPerWaveformPoint(): number {
+    return this.header.framesPerWaveformPoint;
+  }
+
+  /** Ring carrying writes for `deck` (0 is deckA). */
+  deckQueue(deck: number): ParameterQueue {
+    return this.queues[deck];
+  }
+
+  /** Ring carrying transport and master writes. */
+  transportQueue(): ParameterQueue {
+    return this.queues[this.header.deckCount];
+  }
+
+  /** Deck meters are 0..deckCount-1, the master bus is deckCount. */
+  readMeter(index: number): SharedMeter {
+    const word = (index * METER_BYTES) / 4;
+    return {
+      updates: Atomics.load(this.meterWords, word),
+      peak: this.meterValues[word + 1],
+      rms: this.meterValues[word + 2],
+    };
+  }
+
+  /**
+   * The deck's waveform ring in place: point n lives at n % points.length, and `written` points have been
+   * produced so far. Draw from the view directly; do not hold on to values across frames.
+   */
+  waveform(deck: number): { points: Float32Array; written: number } {
+    return { points: this.waveformPoints[deck], written: Atomics.load(this.waveformCounts[deck], 0) };
+  }
+
+  private readEndpoints(view: DataView): SharedEndpoint[] {
+    const decoder = new TextDecoder();
+    const text = (start: number) => {
+      const bytes = new Uint8Array(this.buffer, this.byteOffset + start, ENDPOINT_KEY_BYTES);
+      const end = bytes.indexOf(0);
+      return decoder.decode(bytes.slice(0, end < 0 ? bytes.length : end));
+    };
+    return Array.from({ length: this.header.endpointCount }).map((_, index) => {
+      const start = this.header.endpointsOffset + index * ENDPOINT_BYTES;
+      return {
+        id: view.getInt32(start, true),
+        queue: view.getInt32(start + 4, true),
+        kind: view.getInt32(start + 8, true) === 1 ? 'numeric' : 'slider',
+        minimum: view.getFloat64(start + 16, true),
+        maximum: view.getFloat64(start + 24, true),
+        defaultValue: view.getFloat64(start + 32, true),
+        key: text(start + 40),
+        label: text(start + 40 + ENDPOINT_KEY_BYTES),
+      };
+    });
+  }
+}
+
+function deckChannel(deck: number): string {
+  return `deck${String.fromCharCode(65 + deck)}`;
+}
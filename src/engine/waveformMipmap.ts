@@ -0,0 +1,129 @@
+/** "DJWF", the magic of src/WaveformPyramid.h. */
+const WAVEFORM_MAGIC = 0x46574a44;
+const WAVEFORM_VERSION = 1;
+const HEADER_BYTES = 64;
+const LEVEL_ENTRY_BYTES = 16;
+
+/** Band order in every bin: low, mid, high. */
+export const WAVEFORM_BANDS = ['low', 'mid', 'high'] as const;
+
+export interface WaveformLevel {
+  framesPerBin: number;
+  binCount: number;
+  /** binCount x bands x { min, max }, viewed in place. */
+  values: Int8Array;
+}
+
+/**
+ * Per-pixel reduction of one visible range: pixels x bands x { min, max } in the file's int8 units. Multiply by
+ * `bandPeaks[band] / 127` for linear amplitude.
+ */
+export interface WaveformColumns {
+  pixels: number;
+  bandCount: number;
+  values: Int8Array;
+}
+
+/**
+ * Reader over a band waveform pyramid written by `deejay_analyze` (layout in src/WaveformPyramid.h), for file
+ * contents exposed as an ArrayBuffer or SharedArrayBuffer, read once or mapped by a native addon. Levels are
+ * int8 views into that memory, so opening a track parses only the 64-byte header and the level table, and
+ * drawing at any zoom reads at most `levelFactor` bins per pixel. `byteOffset` must be 8-byte aligned.
+ */
+export class WaveformMipmap {
+  readonly sampleRate: number;
+  readonly frameCount: number;
+  readonly bandCount: number;
+  readonly levelFactor: number;
+  readonly crossoverHz: [number, number];
+  readonly bandPeaks: number[];
+  readonly levels: WaveformLevel[];
+
+  constructor(buffer: ArrayBufferLike, byteOffset = 0) {
+    const view = new DataView(buffer, byteOffset);
+    if (
+      buffer.byteLength - byteOffset < HEADER_BYTES ||
+      view.getUint32(0, true) !== WAVEFORM_MAGIC ||
+      view.getUint32(4, true) !== WAVEFORM_VERSION ||
+      view.getUint32(8, true) !== HEADER_BYTES
+    ) {
+      throw new Error('Not a version 1 DeeJay waveform file');
+    }
+    this.bandCount = view.getUint32(12, true);
+    this.sampleRate = view.getFloat64(16, true);
+    this.frameCount = Number(view.getBigUint64(24, true));
+    const levelCount = view.getUint32(32, true);
+    this.levelFactor = view.getUint32(36, true);
+    this.crossoverHz = [view.getFloat32(40, true), view.getFloat32(44, true)];
+    this.bandPeaks = Array.from({ length: this.bandCount }).map((_, band) => view.getFloat32(48 + band * 4, true));
+
+    if (buffer.byteLength - byteOffset < HEADER_BYTES + levelCount * LEVEL_ENTRY_BYTES) {
+      throw new Error('Waveform file is truncated');
+    }
+    this.levels = Array.from({ length: levelCount }).map((_, index) => {
+      const entry = HEADER_BYTES + index * LEVEL_ENTRY_BYTES;
+      const binCount = view.getUint32(entry + 4, true);
+      const start = Number(view.getBigUint64(entry + 8, true));
+      const length = binCount * this.bandCount * 2;
+      if (start + length > buffer.byteLength - byteOffset) {
+        throw new Error('Waveform file is truncated');
+      }
+      return {
+        framesPerBin: view.getUint32(entry, true),
+        binCount,
+        values: new Int8Array(buffer, byteOffset + start, length),
+      };
+    });
+  }
+
+  /** Coarsest level that still has at least one bin per pixel; the finest one when zoomed in further. */
+  levelFor(framesPerPixel: number): WaveformLevel {
+    let chosen = this.levels[0];
+    for (const level of this.levels) {
+      if (level.framesPerBin <= framesPerPixel) {
+        chosen = level;
+      }
+    }
+    return chosen;
+  }
+
+  /**
+   * Min/max per band of `pixels` columns of `framesPerPixel` frames each, the first starting at `startFrame`.
+   * Columns outside the track are 0. Pass `out` (pixels x bands x 2) to reuse a buffer across frames.
+   */
+  columns(startFrame: number, framesPerPixel: number, pixels: number, out?: Int8Array): WaveformColumns {
+    const stride = this.bandCount * 2;
+    const values = out && out.length >= pixels * stride ? out : new Int8Array(pixels * stride);
+    values.fill(0, 0, pixels * stride);
+    if (this.levels.length === 0 || framesPerPixel <= 0) {
+      return { pixels, bandCount: this.bandCount, values };
+    }
+
+    const level = this.levelFor(framesPerPixel);
+    const bins = level.values;
+    for (let x = 0; x < pixels; x += 1) {
+      const from = startFrame + x * framesPerPixel;
+      const to = from + framesPerPixel;
+      if (to <= 0 || from >= this.frameCount) {
+        continue;
+      }
+      const first = Math.max(0, Math.floor(from / level.framesPerBin));
+      const last = Math.min(level.binCount, Math.max(first + 1, Math.ceil(to / level.framesPerBin)));
+      const column = x * stride;
+      for (let band = 0; band < this.bandCount; band += 1) {
+        let minimum = 127;
+        let maximum = -128;
+        for (let bin = first; bin < last; bin += 1) {
+          const at = bin * stride + band * 2;
+          minimum = Math.min(minimum, bins[at]);
+          maximum = Math.max(maximum, bins[at + 1]);
+        }
+        if (first < last) {
+          values[column + band * 2] = minimum;
+          values[column + band * 2 + 1] = maximum;
+        }
+      }
+    }
+    return { pixels, bandCount: this.bandCount, values };
+  }
+}
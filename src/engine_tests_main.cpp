@@ -0,0 +1,480 @@
+// Behavioural checks for the realtime processors, one CTest per case: `deejay_engine_tests CASE`. Exit status is
+// 0 on success, 1 on failure and 77 (CTest SKIP_RETURN_CODE) for cases that need a Rubber Band build.
+#include "AudioSource.h"
+#include "LatencyCompensatedProcessor.h"
+#include "TimeStretchPitchProcessor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr double kSampleRate = 48000.0;
+constexpr int kPass = 0;
+constexpr int kFail = 1;
+constexpr int kSkip = 77;
+
+using deejay::LatencyCompensatedProcessor;
+using deejay::TimeStretchPitchProcessor;
+using ControlId = LatencyCompensatedProcessor::ControlId;
+
+// In-memory mono track, scratchable and seekable like a decoded deck track.
+class MemoryTrack : public deejay::AudioSource
+{
+public:
+    explicit MemoryTrack(std::vector<float> samples) : samples_(std::move(samples)) {}
+
+    int channelCount() const noexcept override { return 1; }
+
+    bool jumpTo(uint64_t frame) noexcept override
+    {
+        position_ = static_cast<size_t>(std::min<uint64_t>(frame, samples_.size()));
+        return true;
+    }
+
+    const float* trackFrames(uint64_t& frameCount, uint64_t& position) noexcept override
+    {
+        frameCount = samples_.size();
+        position = position_;
+        return samples_.data();
+    }
+
+    size_t read(float* interleaved, size_t frames) noexcept override
+    {
+        frames = std::min<size_t>(frames, samples_.size() - position_);
+        std::copy_n(samples_.data() + position_, frames, interleaved);
+        position_ += frames;
+        return frames;
+    }
+
+private:
+    std::vector<float> samples_;
+    size_t position_{0};
+};
+
+std::vector<float> sine(size_t frames, double frequency = 440.0, float amplitude = 0.5f)
+{
+    std::vector<float> samples(frames);
+    for (size_t i = 0; i < frames; ++i)
+    {
+        const double phase = 2.0 * M_PI * frequency * static_cast<double>(i) / kSampleRate;
+        samples[i] = amplitude * static_cast<float>(std::sin(phase));
+    }
+    return samples;
+}
+
+// Each sample holds its own frame index, so what is heard reads back as the track position.
+std::vector<float> indexRamp(size_t frames)
+{
+    std::vector<float> samples(frames);
+    for (size_t i = 0; i < frames; ++i)
+    {
+        samples[i] = static_cast<float>(i);
+    }
+    return samples;
+}
+
+// Largest step between neighbouring samples from `first` on.
+float largestStep(const std::vector<float>& samples, size_t first)
+{
+    float largest = 0.0f;
+    for (size_t i = std::max<size_t>(first, 1); i < samples.size(); ++i)
+    {
+        largest = std::max(largest, std::abs(samples[i] - samples[i - 1]));
+    }
+    return largest;
+}
+
+// Longest run of (near) silent samples from `first` on.
+size_t longestSilence(const std::vector<float>& samples, size_t first)
+{
+    size_t longest = 0;
+    size_t run = 0;
+    for (size_t i = first; i < samples.size(); ++i)
+    {
+        run = std::abs(samples[i]) < 1e-4f ? run + 1 : 0;
+        longest = std::max(longest, run);
+    }
+    return longest;
+}
+
+// A 440 Hz sine at 0.5 steps by at most 0.029 per sample; a click or gap steps by far more.
+constexpr float kSineStepLimit = 0.06f;
+
+bool expect(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAIL: " << message << std::endl;
+    }
+    return condition;
+}
+
+// user-005: a control change moves the reported latency, which the compensation delay line absorbs. Nothing is
+// re-primed, so a steady input keeps coming out without a burst of silence.
+int latencyAbsorbed()
+{
+    constexpr size_t kBlock = 256;
+    LatencyCompensatedProcessor processor(kSampleRate, 1);
+    processor.prepare(kBlock);
+
+    const std::vector<float> input(kBlock, 1.0f);
+    std::vector<float> output(kBlock);
+    auto run = [&](size_t blocks, float& lowest) {
+        lowest = 1.0f;
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            const size_t written = processor.processBlock(input.data(), kBlock, output.data(), kBlock);
+            if (written != kBlock)
+            {
+                return false;
+            }
+            lowest = std::min(lowest, *std::min_element(output.begin(), output.end()));
+        }
+        return true;
+    };
+
+    float lowest = 0.0f;
+    bool ok = expect(run(64, lowest), "priming block came out short");
+    const size_t before = processor.totalLatencySamples();
+
+    processor.postControl(ControlId::ManualLatency, 64.0);
+    ok &= expect(run(16, lowest), "block after the latency change came out short");
+    ok &= expect(lowest > 0.5f, "silence after a latency change (lowest sample " + std::to_string(lowest) + ")");
+    ok &= expect(processor.totalLatencySamples() == before + 64,
+                 "manual latency not reported: " + std::to_string(before) + " -> " + std::to_string(processor.totalLatencySamples()));
+
+    processor.postControl(ControlId::TempoRatio, 1.05);
+    processor.postControl(ControlId::PitchSemitones, 2.0);
+    ok &= expect(run(64, lowest), "block after the tempo change came out short");
+    ok &= expect(lowest > 0.5f, "silence after a tempo change (lowest sample " + std::to_string(lowest) + ")");
+    return ok ? kPass : kFail;
+}
+
+// user-006: pull() hands out exactly the frames asked for, whatever the block size, with the priming latency
+// spread over as many blocks as it takes instead of arriving as one oversized block.
+int pullBlockSize()
+{
+    constexpr size_t kMaxBlock = 512;
+    const size_t sizes[] = {37, 128, 512, 1, 300};
+    LatencyCompensatedProcessor processor(kSampleRate, 1);
+    processor.prepare(kMaxBlock);
+    MemoryTrack track(std::vector<float>(static_cast<size_t>(kSampleRate) * 10, 1.0f));
+    const size_t latency = processor.totalLatencySamples();
+
+    std::vector<float> heard;
+    std::vector<float> block(kMaxBlock);
+    bool ok = true;
+    for (size_t call = 0; call < 400; ++call)
+    {
+        if (call == 200)
+        {
+            processor.postControl(ControlId::TempoRatio, 1.3);
+        }
+        const size_t frames = sizes[call % std::size(sizes)];
+        const size_t rendered = processor.pull(track, block.data(), frames);
+        ok &= expect(rendered == frames, "pull(" + std::to_string(frames) + ") rendered " + std::to_string(rendered));
+        heard.insert(heard.end(), block.begin(), block.begin() + static_cast<std::ptrdiff_t>(frames));
+    }
+
+    const auto first = static_cast<size_t>(
+        std::find_if(heard.begin(), heard.end(), [](float sample) { return sample > 0.5f; }) - heard.begin());
+#ifdef DEEJAY_HAVE_RUBBERBAND
+    ok &= expect(first >= latency, "output began at frame " + std::to_string(first) + ", inside the latency of " + std::to_string(latency));
+#else
+    ok &= expect(first == latency, "output began at frame " + std::to_string(first) + ", not after the latency of " + std::to_string(latency));
+#endif
+    ok &= expect(*std::min_element(heard.begin() + static_cast<std::ptrdiff_t>(std::min(first + 64, heard.size())), heard.end()) > 0.5f,
+                 "silence after playback started");
+    return ok ? kPass : kFail;
+}
+
+// user-012: a quality change mid-stream builds the replacement stretcher off the audio thread and crossfades to
+// it without a gap or click, after which the reported latency is the new tier's.
+int qualitySwap()
+{
+#ifndef DEEJAY_HAVE_RUBBERBAND
+    std::cerr << "quality swaps need Rubber Band; the stub applies them immediately" << std::endl;
+    return kSkip;
+#else
+    constexpr size_t kBlock = 256;
+    TimeStretchPitchProcessor::Options options;
+    options.singleThreaded = true;
+    TimeStretchPitchProcessor processor(kSampleRate, 1, {}, options);
+    processor.setUnityBypass(false);
+    processor.prepare(kBlock);
+
+    deejay::StretchQuality fast;
+    fast.highQuality = false;
+    TimeStretchPitchProcessor::Parameters fastParameters;
+    fastParameters.quality = fast;
+    TimeStretchPitchProcessor reference(kSampleRate, 1, fastParameters, options);
+    reference.prepare(kBlock);
+
+    const std::vector<float> input = sine(static_cast<size_t>(kSampleRate) * 30);
+    std::vector<float> heard;
+    std::vector<float> block(kBlock);
+    size_t settledBlocks = 0;
+    for (size_t offset = 0; offset + kBlock <= input.size() && settledBlocks < 200; offset += kBlock)
+    {
+        if (offset == 100 * kBlock)
+        {
+            processor.requestQuality(fast);
+        }
+        const float* in = input.data() + offset;
+        float* out = block.data();
+        const size_t written = processor.process(&in, kBlock, &out, kBlock);
+        heard.insert(heard.end(), block.begin(), block.begin() + static_cast<std::ptrdiff_t>(written));
+        if (offset > 100 * kBlock && processor.qualitySwapPending())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // let the builder thread work
+        }
+        else if (offset > 100 * kBlock)
+        {
+            ++settledBlocks;
+        }
+    }
+
+    const size_t warmUp = processor.getLatencySamples() + 4 * kBlock;
+    bool ok = expect(!processor.activeQuality().highQuality, "the fast tier never became active");
+    ok &= expect(processor.getLatencySamples() == reference.getLatencySamples(),
+                 "latency " + std::to_string(processor.getLatencySamples()) + " after the swap, the fast tier reports " +
+                     std::to_string(reference.getLatencySamples()));
+    ok &= expect(heard.size() > warmUp + 200 * kBlock, "too little output");
+    ok &= expect(largestStep(heard, warmUp) < kSineStepLimit, "discontinuity of " + std::to_string(largestStep(heard, warmUp)));
+    ok &= expect(longestSilence(heard, warmUp) < 4, "gap of " + std::to_string(longestSilence(heard, warmUp)) + " frames");
+    return ok ? kPass : kFail;
+#endif
+}
+
+// user-012: a swap that becomes ready while the unity bypass is handing back to the stretcher has to wait for the
+// fade, and the replacement must still see every block from that wait, or the two stretchers are out of step when
+// the crossfade lines them up.
+int qualitySwapDuringBypassFade()
+{
+#ifndef DEEJAY_HAVE_RUBBERBAND
+    std::cerr << "quality swaps need Rubber Band; the stub applies them immediately" << std::endl;
+    return kSkip;
+#else
+    constexpr size_t kBlock = 256;
+    constexpr double kTempo = 1.02;
+    TimeStretchPitchProcessor::Options options;
+    options.singleThreaded = true;
+    TimeStretchPitchProcessor processor(kSampleRate, 1, {}, options);
+    processor.prepare(kBlock);
+
+    const std::vector<float> input = indexRamp(static_cast<size_t>(kSampleRate) * 4);
+    std::vector<float> heard;
+    std::vector<float> block(4 * kBlock);
+    size_t offset = 0;
+    auto run = [&](size_t blocks, bool waitForSwap) {
+        for (size_t done = 0; done < blocks && offset + kBlock <= input.size(); ++done, offset += kBlock)
+        {
+            const float* in = input.data() + offset;
+            float* out = block.data();
+            const size_t written = processor.process(&in, kBlock, &out, block.size());
+            heard.insert(heard.end(), block.begin(), block.begin() + static_cast<std::ptrdiff_t>(written));
+            if (waitForSwap && processor.qualitySwapPending())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1)); // let the builder thread work
+            }
+        }
+    };
+
+    run(100, false);
+    bool ok = expect(processor.unityBypassActive(), "the bypass did not engage at unity");
+
+    // Leave unity, then have the builder reach Ready while the bypass is still priming the stretcher.
+    TimeStretchPitchProcessor::Parameters parameters = processor.getParameters();
+    parameters.tempoRatio = kTempo;
+    processor.setParameters(parameters);
+    run(1, false);
+    deejay::StretchQuality fast;
+    fast.highQuality = false;
+    processor.requestQuality(fast);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    run(1, false); // hands the history over
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    run(400, true);
+
+    ok &= expect(!processor.activeQuality().highQuality, "the fast tier never became active");
+    ok &= expect(!processor.unityBypassActive(), "the bypass is still active off unity");
+
+    double worst = 0.0;
+    for (size_t i = 100 * kBlock; i < heard.size(); ++i)
+    {
+        worst = std::max(worst, std::abs(static_cast<double>(heard[i] - heard[i - 1]) - 1.0 / kTempo));
+    }
+    ok &= expect(worst < 0.25, "heard position stepped by up to " + std::to_string(worst) + " frames off the speed");
+    return ok ? kPass : kFail;
+#endif
+}
+
+// user-014: leaving unity, faster or slower, hands the deck back from the bypass to the stretcher within a few
+// blocks and without a position jump, after which it plays at the new speed; back at unity the bypass takes over
+// again. The reported latency never moves, so everything aligned to it stays put.
+int unityBypass()
+{
+#ifndef DEEJAY_HAVE_RUBBERBAND
+    std::cerr << "the unity bypass needs Rubber Band; the stub has nothing to bypass" << std::endl;
+    return kSkip;
+#else
+    constexpr size_t kBlock = 256;
+    constexpr size_t kPhaseBlocks = 150;
+    constexpr size_t kReleaseBlocks = 16;
+    constexpr size_t kSlopeFrames = 64 * kBlock;
+    LatencyCompensatedProcessor processor(kSampleRate, 1);
+    processor.prepare(kBlock);
+    MemoryTrack track(indexRamp(static_cast<size_t>(kSampleRate) * 10));
+    const size_t latency = processor.totalLatencySamples();
+
+    std::vector<float> heard;
+    std::vector<float> block(kBlock);
+    bool ok = true;
+    const double tempos[] = {1.0, 0.8, 1.0, 0.5, 1.0, 1.25, 1.0, 1.02, 1.0};
+    for (const double tempo : tempos)
+    {
+        processor.postControl(ControlId::TempoRatio, tempo);
+        size_t released = kPhaseBlocks;
+        for (size_t call = 0; call < kPhaseBlocks; ++call)
+        {
+            ok &= expect(processor.pull(track, block.data(), kBlock) == kBlock, "short pull");
+            heard.insert(heard.end(), block.begin(), block.end());
+            if (!processor.unityBypassActive() && released == kPhaseBlocks)
+            {
+                released = call;
+            }
+            if (processor.totalLatencySamples() != latency)
+            {
+                ok = expect(false, "latency moved from " + std::to_string(latency) + " to " +
+                                       std::to_string(processor.totalLatencySamples()) + " at tempo " + std::to_string(tempo));
+                break;
+            }
+        }
+        const std::string at = " at tempo " + std::to_string(tempo);
+        if (tempo == 1.0)
+        {
+            ok &= expect(processor.unityBypassActive(), "bypass inactive" + at);
+        }
+        else
+        {
+            ok &= expect(released < kReleaseBlocks, "bypass still active after " + std::to_string(released) + " blocks" + at);
+        }
+        // Settled playback advances 1 / tempo track frames per frame.
+        const double slope = static_cast<double>(heard.back() - heard[heard.size() - 1 - kSlopeFrames]) / kSlopeFrames;
+        ok &= expect(std::abs(slope - 1.0 / tempo) < 0.005, "heard slope " + std::to_string(slope) + at);
+    }
+
+    // A handover blends two positions moving at different speeds (0.8 to 2 track frames a frame here), and faster
+    // than unity the stretcher starts a little behind the bypass and catches up during the fade, so steps wander
+    // around that range; a jump or a dropout steps far outside it.
+    const size_t warmUp = 2 * latency + 4 * kBlock;
+    float lowest = 1.0f;
+    float highest = 1.0f;
+    for (size_t i = warmUp; i < heard.size(); ++i)
+    {
+        lowest = std::min(lowest, heard[i] - heard[i - 1]);
+        highest = std::max(highest, heard[i] - heard[i - 1]);
+    }
+    ok &= expect(lowest > 0.25f && highest < 3.0f,
+                 "heard position stepped by " + std::to_string(lowest) + " to " + std::to_string(highest) + " frames");
+    return ok ? kPass : kFail;
+#endif
+}
+
+// user-029: touching and releasing the jog at a deck tempo off unity picks up and hands back the heard position
+// without a jump, and the reader plays at the deck's speed (a time ratio of 1.25 is 0.8 track frames a frame).
+int jogTempo()
+{
+#ifndef DEEJAY_HAVE_RUBBERBAND
+    std::cerr << "the stub stretcher ignores tempo, so the deck and the jog reader disagree on speed" << std::endl;
+    return kSkip;
+#else
+    constexpr size_t kBlock = 256;
+    constexpr double kTempo = 1.25;
+    constexpr double kSpeed = 1.0 / kTempo;
+    LatencyCompensatedProcessor processor(kSampleRate, 1);
+    processor.prepare(kBlock);
+    processor.postControl(ControlId::TempoRatio, kTempo);
+
+    MemoryTrack track(indexRamp(static_cast<size_t>(kSampleRate) * 10));
+
+    std::vector<float> heard;
+    std::vector<float> block(kBlock);
+    auto run = [&](size_t blocks) {
+        for (size_t call = 0; call < blocks; ++call)
+        {
+            processor.pull(track, block.data(), kBlock);
+            heard.insert(heard.end(), block.begin(), block.end());
+        }
+    };
+    run(200);
+    const size_t touched = heard.size();
+    processor.postControl(ControlId::JogTouch, 1.0);
+    processor.postControl(ControlId::JogRate, 1.0);
+    run(100);
+    bool ok = expect(processor.jogActive(), "the jog did not engage");
+    processor.postControl(ControlId::JogTouch, 0.0);
+    run(200);
+    ok &= expect(!processor.jogActive(), "the jog did not hand back to the stretcher");
+
+    // Steady playback advances kSpeed frames per frame; a position jump or a reader at the wrong speed shows up as
+    // steps far away from it across the touch and release fades.
+    double worst = 0.0;
+    for (size_t i = touched - kBlock; i < heard.size(); ++i)
+    {
+        worst = std::max(worst, std::abs(static_cast<double>(heard[i] - heard[i - 1]) - kSpeed));
+    }
+    ok &= expect(worst < 0.25, "heard position stepped by up to " + std::to_string(worst) + " frames off the deck speed");
+    return ok ? kPass : kFail;
+#endif
+}
+
+struct Case
+{
+    const char* name;
+    int (*run)();
+};
+
+const Case kCases[] = {
+    {"latency_absorbed", latencyAbsorbed},
+    {"pull_block_size", pullBlockSize},
+    {"quality_swap", qualitySwap},
+    {"quality_swap_bypass_fade", qualitySwapDuringBypassFade},
+    {"unity_bypass", unityBypass},
+    {"jog_tempo", jogTempo},
+};
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: deejay_engine_tests CASE\nCases:";
+        for (const auto& testCase : kCases)
+        {
+            std::cerr << ' ' << testCase.name;
+        }
+        std::cerr << std::endl;
+        return kFail;
+    }
+    for (const auto& testCase : kCases)
+    {
+        if (std::strcmp(testCase.name, argv[1]) == 0)
+        {
+            return testCase.run();
+        }
+    }
+    std::cerr << "Unknown case: " << argv[1] << std::endl;
+    return kFail;
+}
@@ -1,12 +1,60 @@
+#include "CallbackMetrics.h"
+#include "DeckEngine.h"
+#include "EngineControlSurface.h"
+#include "EventScheduler.h"
+#include "LoadGovernor.h"
+#include "MixerBus.h"
+#include "OutputBus.h"
+#include "RecorderTap.h"
+#include "SamplerEngine.h"
+#include "StemCache.h"
+#include "StreamingSource.h"
+#include "TrackStore.h"
+#include "WavFileWriter.h"
+
+#if DEEJAY_HAVE_PORTAUDIO
 #include <portaudio.h>
+#else
+// Offline-only build. The callbacks keep PortAudio's signature so the null device drives exactly the code a sound
+// card would; these mirror the few declarations they use.
+struct PaStreamCallbackTimeInfo
+{
+    double inputBufferAdcTime;
+    double currentTime;
+    double outputBufferDacTime;
+};
+using PaStreamCallbackFlags = unsigned long;
+constexpr PaStreamCallbackFlags paInputUnderflow = 0x1;
+constexpr PaStreamCallbackFlags paInputOverflow = 0x2;
+constexpr PaStreamCallbackFlags paOutputUnderflow = 0x4;
+constexpr PaStreamCallbackFlags paOutputOverflow = 0x8;
+enum PaStreamCallbackResult
+{
+    paContinue = 0,
+    paComplete = 1,
+    paAbort = 2
+};
+#endif
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace
 {
@@ -14,33 +62,379 @@ struct CallbackData
 {
     std::uint64_t framesRendered{};
     int channels{2};
+    // Width of the engine device's frames; wider than `channels` when the cue mix shares the device.
+    int deviceChannels{2};
+    double sampleRate{48'000.0};
+    deejay::DeckEngine* engine{nullptr};
+    deejay::CallbackMetrics* metrics{nullptr};
+    deejay::MixerBus* mixer{nullptr};
+    // engine->deckOutput() of every deck; the buffers never move.
+    const float* const* deckOutputs{nullptr};
+    deejay::EngineControlSurface* surface{nullptr};
+    deejay::EventScheduler* scheduler{nullptr};
+    // Rendered after the decks; its output is the mixer input after the last deck.
+    deejay::SamplerEngine* sampler{nullptr};
+    deejay::RecorderTap* recorder{nullptr};
+    // Headphone cue: a second mix of the same deck outputs. Without a cue bus the master is mixed straight into
+    // the device buffer; with one, both mixes go through their OutputBus for placement and latency alignment.
+    deejay::MixerBus* cueMixer{nullptr};
+    deejay::OutputBus* masterBus{nullptr};
+    deejay::OutputBus* cueBus{nullptr};
 };
 
-int audioCallback(const void* /*input*/, void* output, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* /*timeInfo*/, PaStreamCallbackFlags /*statusFlags*/, void* userData)
+// Applies one scheduled event between two sub-blocks. Deck events naming a deck that does not exist are ignored.
+void applyEvent(CallbackData& callbackData, const deejay::ScheduledEvent& event)
+{
+    using Kind = deejay::ScheduledEvent::Kind;
+    using ControlId = deejay::LatencyCompensatedProcessor::ControlId;
+    auto& engine = *callbackData.engine;
+    auto& mixer = *callbackData.mixer;
+    const bool deckEvent = event.kind != Kind::Crossfader && event.kind != Kind::MasterGain && event.kind != Kind::SamplerTrigger;
+    if (deckEvent && event.deck >= engine.deckCount())
+    {
+        return;
+    }
+    switch (event.kind)
+    {
+    case Kind::TempoRatio:
+        engine.deck(event.deck).setControlTarget(ControlId::TempoRatio, event.value);
+        break;
+    case Kind::PitchSemitones:
+        engine.deck(event.deck).setControlTarget(ControlId::PitchSemitones, event.value);
+        break;
+    case Kind::JogTouch:
+        engine.deck(event.deck).setControlTarget(ControlId::JogTouch, event.value);
+        break;
+    case Kind::JogRate:
+        engine.deck(event.deck).setControlTarget(ControlId::JogRate, event.value);
+        break;
+    case Kind::DeckGain:
+        mixer.setDeckGain(event.deck, static_cast<float>(event.value));
+        break;
+    case Kind::Crossfader:
+        mixer.setCrossfader(static_cast<float>(event.value));
+        break;
+    case Kind::MasterGain:
+        mixer.setMasterGain(static_cast<float>(event.value));
+        break;
+    case Kind::CueJump:
+        if (auto* source = engine.source(event.deck))
+        {
+            // Cue frames are source positions; a keylock stem holds the track stretched by its rendered ratio.
+            source->jumpTo(static_cast<std::uint64_t>(std::max(0.0, event.value * source->renderedTempoRatio())));
+        }
+        break;
+    case Kind::SamplerTrigger:
+        if (callbackData.sampler)
+        {
+            callbackData.sampler->start(static_cast<std::int32_t>(event.value), 1.0f);
+        }
+        break;
+    }
+}
+
+// Records timing and device status for one callback; `started` is taken on entry to the callback.
+void recordMetrics(const CallbackData& callbackData, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, std::chrono::steady_clock::time_point started)
 {
+    if (!callbackData.metrics)
+    {
+        return;
+    }
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const double period = static_cast<double>(framesPerBuffer) / callbackData.sampleRate;
+    // Hosts that do not provide stream timing report zeros; treat those as unknown rather than zero latency.
+    const double outputLatency = timeInfo && timeInfo->outputBufferDacTime > 0.0 ? timeInfo->outputBufferDacTime - timeInfo->currentTime : -1.0;
+    callbackData.metrics->recordCallback(framesPerBuffer, duration, period, (statusFlags & (paOutputUnderflow | paInputUnderflow)) != 0, (statusFlags & (paOutputOverflow | paInputOverflow)) != 0, outputLatency);
+}
+
+int audioCallback(const void* /*input*/, void* output, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData)
+{
+    const auto started = std::chrono::steady_clock::now();
     auto* callbackData = static_cast<CallbackData*>(userData);
-    const auto channels = callbackData ? callbackData->channels : 2;
+    const auto channels = callbackData ? callbackData->deviceChannels : 2;
 
     auto* out = static_cast<float*>(output);
-    const auto samples = framesPerBuffer * static_cast<unsigned long>(channels);
-    std::fill(out, out + samples, 0.0f);
+    if (!callbackData || !callbackData->engine)
+    {
+        const auto samples = framesPerBuffer * static_cast<unsigned long>(channels);
+        std::fill(out, out + samples, 0.0f);
+        return paContinue;
+    }
 
-    if (callbackData)
+    // Decks render in parallel on the engine's pool; each pull yields exactly the requested frame count.
+    auto& engine = *callbackData->engine;
+    if (callbackData->surface)
+    {
+        callbackData->surface->applyControls();
+    }
+    auto* scheduler = callbackData->scheduler;
+    if (scheduler)
     {
-        callbackData->framesRendered += framesPerBuffer;
+        scheduler->publishTimestamp(callbackData->framesRendered, timeInfo ? timeInfo->outputBufferDacTime : 0.0);
+        scheduler->collect();
+    }
+    auto* masterBus = callbackData->masterBus;
+    auto* cueBus = callbackData->cueBus;
+    if (channels != callbackData->channels)
+    {
+        // Device channels neither bus covers stay silent.
+        std::fill(out, out + framesPerBuffer * static_cast<unsigned long>(channels), 0.0f);
+    }
+    std::size_t offset = 0;
+    while (offset < framesPerBuffer)
+    {
+        std::size_t frames = std::min<std::size_t>(framesPerBuffer - offset, engine.maxBlockFrames());
+        // Scheduled events split the block, so each one lands on its own frame rather than the buffer boundary.
+        if (scheduler)
+        {
+            const std::uint64_t position = callbackData->framesRendered + offset;
+            deejay::ScheduledEvent event;
+            while (scheduler->popDue(position, event))
+            {
+                applyEvent(*callbackData, event);
+            }
+            frames = scheduler->framesUntilNext(position, frames);
+        }
+        float* block = out + offset * static_cast<std::size_t>(channels);
+        engine.render(frames);
+        if (callbackData->sampler)
+        {
+            callbackData->sampler->render(frames);
+        }
+        // Both mixes read the same deck outputs; no deck is rendered or copied twice.
+        float* master = masterBus ? masterBus->scratch() : block;
+        callbackData->mixer->mix(callbackData->deckOutputs, master, frames);
+        if (callbackData->surface)
+        {
+            callbackData->surface->publish(master, frames);
+        }
+        if (callbackData->recorder)
+        {
+            callbackData->recorder->capture(master, frames);
+        }
+        const double blockTime = timeInfo && timeInfo->currentTime > 0.0 ? timeInfo->currentTime + static_cast<double>(offset) / callbackData->sampleRate : 0.0;
+        if (masterBus)
+        {
+            masterBus->write(block, frames, blockTime);
+        }
+        if (cueBus)
+        {
+            callbackData->cueMixer->mix(callbackData->deckOutputs, cueBus->scratch(), frames);
+            cueBus->write(block, frames, blockTime);
+        }
+        offset += frames;
     }
 
+    callbackData->framesRendered += framesPerBuffer;
+    recordMetrics(*callbackData, framesPerBuffer, timeInfo, statusFlags, started);
     return paContinue;
 }
 
+// Samples the callback metrics off the audio thread, prints each snapshot as one JSON line on stdout (what
+// EngineBindings parses on the UI side) when printing is enabled, and hands every snapshot to `onSample`.
+class MetricsPublisher
+{
+public:
+    using SampleHandler = std::function<void(const deejay::CallbackMetrics::Snapshot&)>;
+
+    MetricsPublisher(deejay::CallbackMetrics& metrics, unsigned intervalMs, bool print, SampleHandler onSample)
+        : metrics_(metrics), interval_(intervalMs), print_(print), onSample_(std::move(onSample))
+    {
+        if (intervalMs > 0 && (print_ || onSample_))
+        {
+            thread_ = std::thread([this] { run(); });
+        }
+    }
+
+    ~MetricsPublisher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, interval_, [this] { return stopping_; }))
+        {
+            const auto snapshot = metrics_.sample();
+            if (print_)
+            {
+                std::cout << deejay::CallbackMetrics::toJson(snapshot) << std::endl;
+            }
+            if (onSample_)
+            {
+                onSample_(snapshot);
+            }
+        }
+    }
+
+    deejay::CallbackMetrics& metrics_;
+    std::chrono::milliseconds interval_;
+    bool print_{false};
+    SampleHandler onSample_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::thread thread_;
+};
+
+// Drains the latency changes every deck raised since the last call, printing each as a latencyChanged JSON line
+// for the shell's sync logic when `print` is set.
+void drainLatencyChanges(deejay::DeckEngine& engine, double sampleRate, bool print)
+{
+    deejay::LatencyCompensatedProcessor::LatencyChange change;
+    for (std::size_t deck = 0; deck < engine.deckCount(); ++deck)
+    {
+        while (engine.deck(deck).popLatencyChange(change))
+        {
+            if (print)
+            {
+                std::cout << "{\"type\":\"latencyChanged\",\"deck\":" << deck << ",\"previousSamples\":" << change.previousSamples
+                          << ",\"currentSamples\":" << change.currentSamples << ",\"sampleRate\":" << sampleRate << "}" << std::endl;
+            }
+        }
+    }
+}
+
 struct SessionConfig
 {
     double sampleRate{48'000.0};
     unsigned long framesPerBuffer{128};
     double durationSeconds{2.0};
     int channels{2};
+    std::string inputPath;
+    bool loop{false};
+    double tempoRatio{1.0};
+    double pitchSemitones{0.0};
+    int manualLatencySamples{0};
+    std::size_t decks{1};
+    std::size_t workers{0};
+    unsigned metricsIntervalMs{0};
+    bool autoQuality{true};
+    bool unityBypass{true};
+    std::string cacheDir;
+    std::string keylockCacheDir;
+    std::string sharedMemoryPath;
+    std::string fileUuid;
+    std::vector<double> cueSeconds;
+    std::vector<std::string> events;
+    std::string samplerDatabase;
+    std::size_t samplerVoices{8};
+    std::string recordPath;
+    // Headphone cue: decks sent to it, its level, and where it plays. A cue channel puts it on the engine device
+    // starting at that channel; a cue device opens a second stream. Neither leaves the cue mix off.
+    std::vector<std::size_t> pflDecks;
+    double cueGain{1.0};
+    int cueChannel{-1};
+    int cueDevice{-1};
+    bool listDevices{false};
+    // Null device: render --duration-seconds as fast as possible into this WAV file instead of opening a stream,
+    // optionally logging every callback's duration to blockTimingsPath.
+    std::string offlinePath;
+    std::string blockTimingsPath;
 };
 
+// Parses --event SECONDS:KIND:DECK:VALUE, KIND one of tempo, pitch, gain, crossfader, master, cue (VALUE in
+// seconds into the track), sample (VALUE a sampler sound id), touch (1 or 0) or jog (platter speed). SECONDS is
+// stream time from the first callback. Cue jumps early so the new position is heard at SECONDS. Throws
+// std::invalid_argument on malformed specs.
+deejay::ScheduledEvent parseEvent(const std::string& spec, double sampleRate, std::uint64_t cueLead)
+{
+    using Kind = deejay::ScheduledEvent::Kind;
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    for (std::size_t colon = spec.find(':'); colon != std::string::npos; colon = spec.find(':', start))
+    {
+        fields.push_back(spec.substr(start, colon - start));
+        start = colon + 1;
+    }
+    fields.push_back(spec.substr(start));
+    if (fields.size() != 4)
+    {
+        throw std::invalid_argument("--event expects SECONDS:KIND:DECK:VALUE, got " + spec);
+    }
+
+    deejay::ScheduledEvent event;
+    const std::string& kind = fields[1];
+    if (kind == "tempo")
+    {
+        event.kind = Kind::TempoRatio;
+    }
+    else if (kind == "pitch")
+    {
+        event.kind = Kind::PitchSemitones;
+    }
+    else if (kind == "gain")
+    {
+        event.kind = Kind::DeckGain;
+    }
+    else if (kind == "crossfader")
+    {
+        event.kind = Kind::Crossfader;
+    }
+    else if (kind == "master")
+    {
+        event.kind = Kind::MasterGain;
+    }
+    else if (kind == "cue")
+    {
+        event.kind = Kind::CueJump;
+    }
+    else if (kind == "sample")
+    {
+        event.kind = Kind::SamplerTrigger;
+    }
+    else if (kind == "touch")
+    {
+        event.kind = Kind::JogTouch;
+    }
+    else if (kind == "jog")
+    {
+        event.kind = Kind::JogRate;
+    }
+    else
+    {
+        throw std::invalid_argument("Unknown --event kind: " + kind);
+    }
+
+    const double seconds = std::stod(fields[0]);
+    if (seconds < 0.0)
+    {
+        throw std::invalid_argument("--event time must not be negative: " + spec);
+    }
+    const auto frame = static_cast<std::uint64_t>(std::llround(seconds * sampleRate));
+    event.deck = static_cast<std::uint32_t>(std::stoul(fields[2]));
+    event.value = std::stod(fields[3]);
+    if (event.kind == Kind::CueJump)
+    {
+        event.value = std::round(event.value * sampleRate);
+        event.frame = frame > cueLead ? frame - cueLead : 0;
+    }
+    else
+    {
+        event.frame = frame;
+    }
+    return event;
+}
+
+// Cache key for tracks started without a database UUID: the file name without its extension.
+std::string trackKeyFor(const std::string& path)
+{
+    const auto slash = path.find_last_of("/\\");
+    std::string key = slash == std::string::npos ? path : path.substr(slash + 1);
+    const auto dot = key.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? key : key.substr(0, dot);
+}
+
 SessionConfig parseArgs(int argc, char** argv)
 {
     SessionConfig config;
@@ -64,6 +458,110 @@ SessionConfig parseArgs(int argc, char** argv)
         {
             config.channels = std::stoi(argv[++i]);
         }
+        else if ((arg == "--input" || arg == "-i") && i + 1 < argc)
+        {
+            config.inputPath = argv[++i];
+        }
+        else if (arg == "--loop")
+        {
+            config.loop = true;
+        }
+        else if (arg == "--tempo" && i + 1 < argc)
+        {
+            config.tempoRatio = std::stod(argv[++i]);
+        }
+        else if (arg == "--pitch" && i + 1 < argc)
+        {
+            config.pitchSemitones = std::stod(argv[++i]);
+        }
+        else if (arg == "--latency" && i + 1 < argc)
+        {
+            config.manualLatencySamples = std::stoi(argv[++i]);
+        }
+        else if (arg == "--decks" && i + 1 < argc)
+        {
+            config.decks = static_cast<std::size_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--workers" && i + 1 < argc)
+        {
+            config.workers = static_cast<std::size_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--shared-memory" && i + 1 < argc)
+        {
+            config.sharedMemoryPath = argv[++i];
+        }
+        else if (arg == "--cache-dir" && i + 1 < argc)
+        {
+            config.cacheDir = argv[++i];
+        }
+        else if (arg == "--keylock-cache" && i + 1 < argc)
+        {
+            config.keylockCacheDir = argv[++i];
+        }
+        else if (arg == "--uuid" && i + 1 < argc)
+        {
+            config.fileUuid = argv[++i];
+        }
+        else if (arg == "--cue" && i + 1 < argc)
+        {
+            config.cueSeconds.push_back(std::stod(argv[++i]));
+        }
+        else if (arg == "--record" && i + 1 < argc)
+        {
+            config.recordPath = argv[++i];
+        }
+        else if (arg == "--sampler-db" && i + 1 < argc)
+        {
+            config.samplerDatabase = argv[++i];
+        }
+        else if (arg == "--sampler-voices" && i + 1 < argc)
+        {
+            config.samplerVoices = static_cast<std::size_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--event" && i + 1 < argc)
+        {
+            config.events.push_back(argv[++i]);
+        }
+        else if (arg == "--pfl" && i + 1 < argc)
+        {
+            config.pflDecks.push_back(static_cast<std::size_t>(std::stoul(argv[++i])));
+        }
+        else if (arg == "--cue-gain" && i + 1 < argc)
+        {
+            config.cueGain = std::stod(argv[++i]);
+        }
+        else if (arg == "--cue-channel" && i + 1 < argc)
+        {
+            config.cueChannel = std::stoi(argv[++i]);
+        }
+        else if (arg == "--cue-device" && i + 1 < argc)
+        {
+            config.cueDevice = std::stoi(argv[++i]);
+        }
+        else if (arg == "--list-devices")
+        {
+            config.listDevices = true;
+        }
+        else if (arg == "--offline" && i + 1 < argc)
+        {
+            config.offlinePath = argv[++i];
+        }
+        else if (arg == "--block-timings" && i + 1 < argc)
+        {
+            config.blockTimingsPath = argv[++i];
+        }
+        else if (arg == "--metrics-interval" && i + 1 < argc)
+        {
+            config.metricsIntervalMs = static_cast<unsigned>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--no-unity-bypass")
+        {
+            config.unityBypass = false;
+        }
+        else if (arg == "--no-auto-quality")
+        {
+            config.autoQuality = false;
+        }
         else if (arg == "--help" || arg == "-h")
         {
             std::cout << "Usage: deejay_audio [options]\n"
@@ -71,6 +569,37 @@ SessionConfig parseArgs(int argc, char** argv)
                       << "  --sample-rate, -r       Sample rate (default: 48000)\n"
                       << "  --duration-seconds, -d  Run time in seconds (default: 2)\n"
                       << "  --channels              Number of output channels (default: 2)\n"
+                      << "  --input, -i             WAV file to stream (default: 440 Hz test tone)\n"
+                      << "  --loop                  Loop the input file\n"
+                      << "  --tempo                 Time-stretch ratio (default: 1.0)\n"
+                      << "  --pitch                 Pitch shift in semitones (default: 0)\n"
+                      << "  --latency               Manual latency compensation in samples (default: 0)\n"
+                      << "  --decks                 Number of decks rendered in parallel (default: 1)\n"
+                      << "  --workers               Worker threads besides the callback thread (default: decks - 1)\n"
+                      << "  --cache-dir             Play --input from a memory-mapped decode cache in this directory\n"
+                      << "  --keylock-cache         Play --input from a stem pre-rendered at --tempo/--pitch, cached in\n"
+                      << "                          this directory; later tempo/pitch changes stretch only the difference\n"
+                      << "  --uuid                  Cache key (file UUID from the library database; default: file name)\n"
+                      << "  --cue                   Cue point in seconds to prefetch; repeatable\n"
+                      << "  --event                 Schedule SECONDS:KIND:DECK:VALUE sample-accurately; KIND is tempo,\n"
+                      << "                          pitch, gain, crossfader, master, cue (VALUE in seconds), sample\n"
+                      << "                          (VALUE a sound id), touch (jog 1/0) or jog (platter speed, -1 is\n"
+                      << "                          backwards); repeatable. Scratching needs --cache-dir\n"
+                      << "  --record                Record the master output to this float32 WAV file\n"
+                      << "  --sampler-db            Load the sampler's sounds table from this SQLite database\n"
+                      << "  --sampler-voices        Sampler polyphony (default: 8)\n"
+                      << "  --pfl                   Send this deck to the headphone cue mix; repeatable (default: deck 0)\n"
+                      << "  --cue-gain              Cue mix level (default: 1.0)\n"
+                      << "  --cue-channel           Play the cue mix on the output device from this channel on (0-based)\n"
+                      << "  --cue-device            Play the cue mix on this PortAudio device instead (see --list-devices)\n"
+                      << "  --list-devices          Print the PortAudio output devices and exit\n"
+                      << "  --offline               Render to this WAV file on a null device, as fast as possible and\n"
+                      << "                          deterministically, then print throughput and block timing\n"
+                      << "  --block-timings         With --offline, write each callback's duration to this CSV file\n"
+                      << "  --metrics-interval      Print callback metrics as JSON lines every N ms (default: off)\n"
+                      << "  --shared-memory         Map the control region (endpoints, parameter rings, meters, waveforms) at this path\n"
+                      << "  --no-unity-bypass       Keep the stretcher running at unity tempo and pitch\n"
+                      << "  --no-auto-quality       Disable the load governor that lowers stretcher quality under CPU pressure\n"
                       << "  --help, -h              Show this message\n";
             std::exit(0);
         }
@@ -79,6 +608,124 @@ SessionConfig parseArgs(int argc, char** argv)
     return config;
 }
 
+// Running digest of a render: FNV-1a over the sample bits plus peak and RMS, so two builds' outputs can be
+// compared from the summary line alone.
+struct OutputDigest
+{
+    std::uint64_t hash{14'695'981'039'346'656'037ULL};
+    double peak{0.0};
+    double sumSquares{0.0};
+    std::uint64_t samples{0};
+
+    void add(const float* interleaved, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::uint32_t bits = 0;
+            std::memcpy(&bits, &interleaved[i], sizeof(bits));
+            for (int byte = 0; byte < 4; ++byte)
+            {
+                hash = (hash ^ ((bits >> (8 * byte)) & 0xFFU)) * 1'099'511'628'211ULL;
+            }
+            peak = std::max(peak, static_cast<double>(std::fabs(interleaved[i])));
+            sumSquares += static_cast<double>(interleaved[i]) * interleaved[i];
+        }
+        samples += count;
+    }
+};
+
+// Null device: calls audioCallback back to back on this thread, one --frames buffer at a time, with a stream clock
+// that advances by exactly one buffer per call, and writes what it renders to --offline. Streaming sources are
+// refilled synchronously between callbacks instead of by their decode threads, so the output depends only on
+// the arguments and can be diffed across builds. Prints throughput and block timing as one offlineRender line.
+void runOffline(const SessionConfig& config, CallbackData& callbackData, const std::vector<deejay::StreamingSource*>& sources)
+{
+    // Stream times start one second in; PortAudio reports 0 for "unknown", which the buses treat as such.
+    constexpr double kStreamEpochSeconds = 1.0;
+    auto& engine = *callbackData.engine;
+    const auto deviceChannels = static_cast<std::size_t>(callbackData.deviceChannels);
+    const unsigned long framesPerBuffer = config.framesPerBuffer;
+    const auto totalFrames = static_cast<std::uint64_t>(std::llround(config.durationSeconds * config.sampleRate));
+    const double period = static_cast<double>(framesPerBuffer) / config.sampleRate;
+
+    deejay::WavFileWriter writer(config.offlinePath, config.sampleRate, callbackData.deviceChannels);
+    std::vector<float> buffer(framesPerBuffer * deviceChannels);
+    std::vector<double> blockSeconds;
+    blockSeconds.reserve(static_cast<std::size_t>(totalFrames / framesPerBuffer + 1));
+    OutputDigest digest;
+
+    const auto started = std::chrono::steady_clock::now();
+    for (std::uint64_t frame = 0; frame < totalFrames; frame += framesPerBuffer)
+    {
+        for (auto* source : sources)
+        {
+            source->fill();
+        }
+        PaStreamCallbackTimeInfo timeInfo{};
+        timeInfo.currentTime = kStreamEpochSeconds + static_cast<double>(frame) / config.sampleRate;
+        timeInfo.outputBufferDacTime = timeInfo.currentTime;
+        const auto blockStarted = std::chrono::steady_clock::now();
+        audioCallback(nullptr, buffer.data(), framesPerBuffer, &timeInfo, 0, &callbackData);
+        blockSeconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStarted).count());
+
+        // The last buffer is rendered whole, like a device would, but only the requested duration is kept.
+        const auto frames = static_cast<std::size_t>(std::min<std::uint64_t>(framesPerBuffer, totalFrames - frame));
+        digest.add(buffer.data(), frames * deviceChannels);
+        writer.writeFrames(buffer.data(), frames);
+        drainLatencyChanges(engine, config.sampleRate, config.metricsIntervalMs > 0);
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    writer.close();
+
+    if (!config.blockTimingsPath.empty())
+    {
+        std::ofstream timings(config.blockTimingsPath);
+        if (!timings)
+        {
+            throw std::runtime_error("Failed to create block timings file: " + config.blockTimingsPath);
+        }
+        timings << "block,micros\n";
+        for (std::size_t block = 0; block < blockSeconds.size(); ++block)
+        {
+            timings << block << ',' << blockSeconds[block] * 1e6 << '\n';
+        }
+    }
+
+    std::vector<double> sorted = blockSeconds;
+    std::sort(sorted.begin(), sorted.end());
+    const auto percentile = [&sorted](double fraction)
+    {
+        return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(sorted.size())))];
+    };
+    double callbackSeconds = 0.0;
+    std::size_t overBudget = 0;
+    for (const double seconds : blockSeconds)
+    {
+        callbackSeconds += seconds;
+        overBudget += seconds > period ? 1 : 0;
+    }
+    const double audioSeconds = static_cast<double>(totalFrames) / config.sampleRate;
+    std::ostringstream hash;
+    hash << std::hex << std::setw(16) << std::setfill('0') << digest.hash;
+    std::cout << "{\"type\":\"offlineRender\",\"frames\":" << totalFrames << ",\"channels\":" << deviceChannels
+              << ",\"sampleRate\":" << config.sampleRate << ",\"blocks\":" << blockSeconds.size()
+              << ",\"seconds\":" << elapsed << ",\"realtimeFactor\":" << (elapsed > 0.0 ? audioSeconds / elapsed : 0.0)
+              << ",\"blockMeanUs\":" << (blockSeconds.empty() ? 0.0 : callbackSeconds / static_cast<double>(blockSeconds.size()) * 1e6)
+              << ",\"blockP50Us\":" << percentile(0.5) * 1e6 << ",\"blockP99Us\":" << percentile(0.99) * 1e6
+              << ",\"blockMaxUs\":" << (sorted.empty() ? 0.0 : sorted.back() * 1e6) << ",\"overBudget\":" << overBudget
+              << ",\"latencySamples\":" << engine.deck(0).totalLatencySamples() << ",\"peak\":" << digest.peak
+              << ",\"rms\":" << (digest.samples > 0 ? std::sqrt(digest.sumSquares / static_cast<double>(digest.samples)) : 0.0)
+              << ",\"hash\":\"" << hash.str() << "\"}" << std::endl;
+}
+#if DEEJAY_HAVE_PORTAUDIO
+// Callback of a separate cue device: plays what the engine callback queued on the cue bus, resampled to follow
+// the drift between the two cards' clocks.
+int cueCallback(const void*, void* output, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags, void* userData)
+{
+    static_cast<deejay::OutputBus*>(userData)->read(static_cast<float*>(output), framesPerBuffer, timeInfo ? timeInfo->currentTime : 0.0);
+    return paContinue;
+}
+
 void checkPaError(PaError error, const std::string& context)
 {
     if (error != paNoError)
@@ -87,6 +734,103 @@ void checkPaError(PaError error, const std::string& context)
     }
 }
 
+// Plays the session on the default output device (and the cue device, if any) for --duration-seconds.
+void runStreams(const SessionConfig& config, CallbackData& callbackData, deejay::LoadGovernor* governor)
+{
+    auto& engine = *callbackData.engine;
+    auto& metrics = *callbackData.metrics;
+    auto* masterBus = callbackData.masterBus;
+    auto* cueBus = callbackData.cueBus;
+    const int deviceChannels = callbackData.deviceChannels;
+
+    checkPaError(Pa_Initialize(), "Failed to initialize PortAudio");
+
+    PaStream* stream = nullptr;
+    checkPaError(
+        Pa_OpenDefaultStream(&stream, 0, deviceChannels, paFloat32, config.sampleRate, config.framesPerBuffer, audioCallback, &callbackData),
+        "Failed to open default output stream");
+
+    PaStream* cueStream = nullptr;
+    if (cueBus && cueBus->separateDevice())
+    {
+        const PaDeviceInfo* cueInfo = Pa_GetDeviceInfo(config.cueDevice);
+        if (!cueInfo)
+        {
+            throw std::invalid_argument("No such --cue-device: " + std::to_string(config.cueDevice));
+        }
+        PaStreamParameters cueParameters{};
+        cueParameters.device = config.cueDevice;
+        cueParameters.channelCount = config.channels;
+        cueParameters.sampleFormat = paFloat32;
+        cueParameters.suggestedLatency = cueInfo->defaultLowOutputLatency;
+        checkPaError(
+            Pa_OpenStream(&cueStream, nullptr, &cueParameters, config.sampleRate, config.framesPerBuffer, paNoFlag, cueCallback, cueBus),
+            "Failed to open cue output stream");
+    }
+
+    const PaStreamInfo* info = Pa_GetStreamInfo(stream);
+    std::cout << "Opening stream with " << deviceChannels << " channels\n";
+    std::cout << "Sample rate: " << config.sampleRate << " Hz\n";
+    std::cout << "Requested frames per buffer: " << config.framesPerBuffer << "\n";
+    if (info)
+    {
+        std::cout << "Reported output latency: " << info->outputLatency << " seconds\n";
+    }
+
+    checkPaError(Pa_StartStream(stream), "Failed to start stream");
+    if (cueStream)
+    {
+        checkPaError(Pa_StartStream(cueStream), "Failed to start cue stream");
+    }
+    if (cueBus)
+    {
+        // Delay whichever output is heard first by the difference, so master and headphones line up. The cue
+        // ring adds its fill to the cue device's own latency.
+        const PaStreamInfo* cueInfo = cueStream ? Pa_GetStreamInfo(cueStream) : info;
+        const double masterLatency = info ? info->outputLatency : 0.0;
+        const double cueLatency = (cueInfo ? cueInfo->outputLatency : 0.0) + static_cast<double>(cueBus->bufferedFrames()) / config.sampleRate;
+        masterBus->setAlignmentDelay((cueLatency - masterLatency) * config.sampleRate);
+        cueBus->setAlignmentDelay((masterLatency - cueLatency) * config.sampleRate);
+        std::cout << "Cue output: " << (cueStream ? "device " + std::to_string(config.cueDevice) : "channels from " + std::to_string(config.cueChannel))
+                  << ", alignment delay master " << masterBus->alignmentDelay() << " / cue " << cueBus->alignmentDelay() << " frames\n";
+    }
+
+    if (config.durationSeconds > 0.0)
+    {
+        // Load is sampled every 250 ms for the governor even when metrics are not printed; its decisions
+        // are printed alongside the callback metrics.
+        constexpr unsigned kDefaultSampleIntervalMs = 250;
+        const bool printMetrics = config.metricsIntervalMs > 0;
+        // Latency changes are printed whether or not metrics are, since deck sync depends on them.
+        MetricsPublisher::SampleHandler onSample = [&governor, &engine, sampleRate = config.sampleRate, printMetrics](const deejay::CallbackMetrics::Snapshot& snapshot)
+        {
+            if (governor)
+            {
+                governor->update(snapshot);
+                if (printMetrics)
+                {
+                    std::cout << deejay::LoadGovernor::toJson(governor->report()) << std::endl;
+                }
+            }
+            drainLatencyChanges(engine, sampleRate, true);
+        };
+        MetricsPublisher publisher(metrics, printMetrics ? config.metricsIntervalMs : kDefaultSampleIntervalMs, printMetrics, std::move(onSample));
+        const auto sleepDuration = std::chrono::duration<double>(config.durationSeconds);
+        std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(sleepDuration));
+    }
+
+    checkPaError(Pa_StopStream(stream), "Failed to stop stream");
+    checkPaError(Pa_CloseStream(stream), "Failed to close stream");
+    if (cueStream)
+    {
+        checkPaError(Pa_StopStream(cueStream), "Failed to stop cue stream");
+        checkPaError(Pa_CloseStream(cueStream), "Failed to close cue stream");
+        std::cout << "Cue ring underruns/overruns: " << cueBus->underruns() << "/" << cueBus->overruns() << ", clock drift " << cueBus->driftPpm() << " ppm" << std::endl;
+    }
+    checkPaError(Pa_Terminate(), "Failed to terminate PortAudio");
+}
+#endif
+
 } // namespace
 
 int main(int argc, char** argv)
@@ -94,38 +838,305 @@ int main(int argc, char** argv)
     try
     {
         const auto config = parseArgs(argc, argv);
-        CallbackData callbackData{};
-        callbackData.channels = config.channels;
+        if (config.channels <= 0 || config.framesPerBuffer == 0 || config.decks == 0)
+        {
+            throw std::invalid_argument("--channels, --frames and --decks must be positive");
+        }
+        const bool offline = !config.offlinePath.empty();
+#if !DEEJAY_HAVE_PORTAUDIO
+        if (!offline)
+        {
+            throw std::invalid_argument("Built without PortAudio; only --offline rendering is available");
+        }
+#else
+        if (config.listDevices)
+        {
+            checkPaError(Pa_Initialize(), "Failed to initialize PortAudio");
+            for (PaDeviceIndex device = 0; device < Pa_GetDeviceCount(); ++device)
+            {
+                const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(device);
+                if (deviceInfo && deviceInfo->maxOutputChannels > 0)
+                {
+                    std::cout << device << ": " << deviceInfo->name << " (" << deviceInfo->maxOutputChannels << " output channels"
+                              << (device == Pa_GetDefaultOutputDevice() ? ", default" : "") << ")\n";
+                }
+            }
+            Pa_Terminate();
+            return 0;
+        }
+#endif
+        if (offline && config.cueDevice >= 0)
+        {
+            throw std::invalid_argument("--cue-device needs a live device; render the cue with --cue-channel offline");
+        }
+        if (config.cueChannel >= 0 && config.cueDevice >= 0)
+        {
+            throw std::invalid_argument("--cue-channel and --cue-device are mutually exclusive");
+        }
+        const bool cueEnabled = config.cueChannel >= 0 || config.cueDevice >= 0;
 
-        checkPaError(Pa_Initialize(), "Failed to initialize PortAudio");
+        deejay::DeckEngine::Settings engineSettings;
+        engineSettings.sampleRate = config.sampleRate;
+        engineSettings.channelCount = config.channels;
+        engineSettings.deckCount = config.decks;
+        engineSettings.maxBlockFrames = config.framesPerBuffer;
+        engineSettings.unityBypass = config.unityBypass;
+        engineSettings.pool.workerCount = config.workers > 0 ? config.workers : config.decks - 1;
+        deejay::DeckEngine engine(engineSettings);
 
-        PaStream* stream = nullptr;
-        checkPaError(
-            Pa_OpenDefaultStream(&stream, 0, config.channels, paFloat32, config.sampleRate, config.framesPerBuffer, audioCallback, &callbackData),
-            "Failed to open default output stream");
+        // With a cache directory every deck plays the pre-decoded track straight from its mapping; otherwise each
+        // deck streams the input file, or a test tone of its own pitch when no file is given.
+        // A keylock cache goes one step further and maps the track already stretched to the planned controls.
+        std::shared_ptr<const deejay::MappedTrack> cachedTrack;
+        bool keylockStem = false;
+        if (!config.keylockCacheDir.empty() && !config.inputPath.empty())
+        {
+            const auto loadStarted = std::chrono::steady_clock::now();
+            deejay::StemCache::Settings stemSettings;
+            stemSettings.cacheDirectory = config.keylockCacheDir;
+            deejay::StemCache stems(stemSettings);
+            deejay::StemCache::Request request;
+            request.fileUuid = config.fileUuid.empty() ? trackKeyFor(config.inputPath) : config.fileUuid;
+            request.sourcePath = config.inputPath;
+            request.tempoRatio = config.tempoRatio;
+            request.pitchSemitones = config.pitchSemitones;
+            const bool rendered = !stems.contains(request);
+            cachedTrack = stems.open(request, config.cueSeconds);
+            keylockStem = true;
+            const auto loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStarted).count();
+            std::cout << "Keylock stem ready in " << loadMs << " ms (" << cachedTrack->frameCount() << " frames, "
+                      << (rendered ? "rendered" : "cached") << ")\n";
+        }
+        else if (!config.cacheDir.empty() && !config.inputPath.empty())
+        {
+            const auto loadStarted = std::chrono::steady_clock::now();
+            deejay::TrackStore::Settings storeSettings;
+            storeSettings.cacheDirectory = config.cacheDir;
+            deejay::TrackStore store(storeSettings);
+            cachedTrack = store.open(config.fileUuid.empty() ? trackKeyFor(config.inputPath) : config.fileUuid, config.inputPath, config.cueSeconds);
+            const auto loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStarted).count();
+            std::cout << "Track ready in " << loadMs << " ms (" << cachedTrack->frameCount() << " frames cached)\n";
+        }
+
+        std::vector<std::unique_ptr<deejay::StreamingSource>> sources;
+        std::vector<std::unique_ptr<deejay::MappedTrackSource>> mappedSources;
+        for (std::size_t deck = 0; deck < config.decks; ++deck)
+        {
+            double sourceSampleRate = config.sampleRate;
+            deejay::AudioSource* source = nullptr;
+            if (cachedTrack)
+            {
+                if (keylockStem)
+                {
+                    mappedSources.push_back(std::make_unique<deejay::StemSource>(cachedTrack, config.channels, config.loop, config.tempoRatio, config.pitchSemitones));
+                }
+                else
+                {
+                    mappedSources.push_back(std::make_unique<deejay::MappedTrackSource>(cachedTrack, config.channels, config.loop));
+                }
+                sourceSampleRate = cachedTrack->sampleRate();
+                source = mappedSources.back().get();
+            }
+            else
+            {
+                deejay::StreamingSource::Settings sourceSettings;
+                sourceSettings.path = config.inputPath;
+                sourceSettings.channelCount = config.channels;
+                sourceSettings.sampleRate = config.sampleRate;
+                sourceSettings.loop = config.loop;
+                sourceSettings.toneFrequency = 440.0 * (1.0 + 0.25 * static_cast<double>(deck));
+                sources.push_back(std::make_unique<deejay::StreamingSource>(sourceSettings));
+                sourceSampleRate = sources.back()->sourceSampleRate();
+                source = sources.back().get();
+            }
+            if (sourceSampleRate != config.sampleRate && deck == 0)
+            {
+                std::cerr << "Warning: input is " << sourceSampleRate << " Hz but the stream runs at "
+                          << config.sampleRate << " Hz; playback speed will differ.\n";
+            }
+
+            auto& processor = engine.deck(deck);
+            processor.updateControls({config.tempoRatio, config.pitchSemitones, config.manualLatencySamples});
+            processor.prepare(config.framesPerBuffer);
+            engine.setSource(deck, source);
+            // Offline, the null device refills the sources itself between callbacks.
+            if (!offline && !sources.empty() && source == sources.back().get())
+            {
+                sources.back()->start();
+            }
+        }
+
+        deejay::CallbackMetrics metrics;
+        std::unique_ptr<deejay::LoadGovernor> governor;
+        // Its decisions follow wall-clock load, which would make offline renders differ from run to run.
+        if (config.autoQuality && !offline)
+        {
+            governor = std::make_unique<deejay::LoadGovernor>(engine, config.sampleRate);
+        }
+        std::unique_ptr<deejay::SamplerEngine> sampler;
+        if (!config.samplerDatabase.empty())
+        {
+            deejay::SamplerEngine::Settings samplerSettings;
+            samplerSettings.sampleRate = config.sampleRate;
+            samplerSettings.channelCount = config.channels;
+            samplerSettings.maxVoices = config.samplerVoices;
+            samplerSettings.maxBlockFrames = config.framesPerBuffer;
+            sampler = std::make_unique<deejay::SamplerEngine>(samplerSettings);
+            std::cout << "Sampler: " << sampler->loadSounds(config.samplerDatabase) << " sound(s), "
+                      << config.samplerVoices << " voice(s)\n";
+        }
+
+        // Every deck is Thru at unity gain, and the master gain keeps the sum of all decks in range. The sampler
+        // is one more Thru input after the decks.
+        deejay::MixerBus mixer(config.channels, engine.deckCount() + (sampler ? 1 : 0));
+        mixer.setMasterGain(1.0f / static_cast<float>(engine.deckCount()));
+        mixer.reset();
+        std::vector<const float*> deckOutputs;
+        for (std::size_t deck = 0; deck < engine.deckCount(); ++deck)
+        {
+            deckOutputs.push_back(engine.deckOutput(deck));
+        }
+        if (sampler)
+        {
+            deckOutputs.push_back(sampler->output());
+        }
+
+        // The cue mix is the PFL decks at the cue level, crossfader ignored; the sampler input stays silent.
+        std::unique_ptr<deejay::MixerBus> cueMixer;
+        std::unique_ptr<deejay::OutputBus> masterBus;
+        std::unique_ptr<deejay::OutputBus> cueBus;
+        int deviceChannels = config.channels;
+        if (cueEnabled)
+        {
+            cueMixer = std::make_unique<deejay::MixerBus>(config.channels, deckOutputs.size());
+            for (std::size_t input = 0; input < deckOutputs.size(); ++input)
+            {
+                const bool pfl = config.pflDecks.empty() ? input == 0 : std::find(config.pflDecks.begin(), config.pflDecks.end(), input) != config.pflDecks.end();
+                cueMixer->setDeckGain(input, pfl && input < engine.deckCount() ? 1.0f : 0.0f);
+            }
+            cueMixer->setMasterGain(static_cast<float>(config.cueGain));
+            cueMixer->reset();
+
+            deviceChannels = config.cueChannel >= 0 ? std::max(config.channels, config.cueChannel + config.channels) : config.channels;
+            deejay::OutputBus::Settings busSettings;
+            busSettings.channelCount = config.channels;
+            busSettings.deviceChannels = deviceChannels;
+            busSettings.sampleRate = config.sampleRate;
+            busSettings.maxBlockFrames = engine.maxBlockFrames();
+            masterBus = std::make_unique<deejay::OutputBus>(busSettings);
+            if (config.cueDevice >= 0)
+            {
+                busSettings.deviceChannels = config.channels;
+                busSettings.separateDevice = true;
+                busSettings.targetFillFrames = 2 * std::max<std::size_t>(config.framesPerBuffer, engine.maxBlockFrames());
+                busSettings.ringFrames = 8 * busSettings.targetFillFrames;
+            }
+            else
+            {
+                busSettings.firstChannel = config.cueChannel;
+            }
+            cueBus = std::make_unique<deejay::OutputBus>(busSettings);
+        }
+
+        // Shells attach to the same file (e.g. under /dev/shm); the layout is described in EngineAbi.h.
+        std::unique_ptr<deejay::EngineControlSurface> surface;
+        std::unique_ptr<deejay::SharedMemoryFile> sharedMemory;
+        if (!config.sharedMemoryPath.empty())
+        {
+            surface = std::make_unique<deejay::EngineControlSurface>(engine, mixer);
+            sharedMemory = std::make_unique<deejay::SharedMemoryFile>(config.sharedMemoryPath, surface->requiredBytes());
+            surface->attach(sharedMemory->data(), sharedMemory->size());
+        }
 
-        const PaStreamInfo* info = Pa_GetStreamInfo(stream);
-        std::cout << "Opening stream with " << config.channels << " channels\n";
-        std::cout << "Sample rate: " << config.sampleRate << " Hz\n";
-        std::cout << "Requested frames per buffer: " << config.framesPerBuffer << "\n";
-        if (info)
+        // Events go in before the stream starts, so none of them can be late.
+        std::unique_ptr<deejay::EventScheduler> scheduler;
+        if (!config.events.empty())
         {
-            std::cout << "Reported output latency: " << info->outputLatency << " seconds\n";
+            scheduler = std::make_unique<deejay::EventScheduler>(config.sampleRate, std::max<std::size_t>(256, config.events.size()));
+            const auto cueLead = static_cast<std::uint64_t>(engine.deck(0).totalLatencySamples());
+            for (const auto& spec : config.events)
+            {
+                scheduler->schedule(parseEvent(spec, config.sampleRate, cueLead));
+            }
         }
 
-        checkPaError(Pa_StartStream(stream), "Failed to start stream");
+        std::unique_ptr<deejay::RecorderTap> recorder;
+        if (!config.recordPath.empty())
+        {
+            deejay::RecorderTap::Settings recorderSettings;
+            recorderSettings.path = config.recordPath;
+            recorderSettings.sampleRate = config.sampleRate;
+            recorderSettings.channelCount = config.channels;
+            recorder = std::make_unique<deejay::RecorderTap>(recorderSettings);
+        }
 
-        if (config.durationSeconds > 0.0)
+        CallbackData callbackData{};
+        callbackData.channels = config.channels;
+        callbackData.sampleRate = config.sampleRate;
+        callbackData.engine = &engine;
+        callbackData.metrics = &metrics;
+        callbackData.mixer = &mixer;
+        callbackData.deckOutputs = deckOutputs.data();
+        callbackData.surface = surface.get();
+        callbackData.scheduler = scheduler.get();
+        callbackData.sampler = sampler.get();
+        callbackData.recorder = recorder.get();
+        callbackData.deviceChannels = deviceChannels;
+        callbackData.cueMixer = cueMixer.get();
+        callbackData.masterBus = masterBus.get();
+        callbackData.cueBus = cueBus.get();
+
+        std::cout << "Decks: " << engine.deckCount() << " on " << engineSettings.pool.workerCount << " worker thread(s)\n";
+        std::cout << "Processor latency: " << engine.deck(0).totalLatencySamples() << " samples\n";
+        const auto& arena = engine.deckArena(0);
+        std::cout << "Deck arena: " << arena.usedBytes() / 1024 << "/" << arena.capacity() / 1024 << " KiB per deck"
+                  << (arena.locked() ? ", locked" : ", not locked") << (arena.overflowBytes() > 0 ? ", overflowed to heap" : "") << "\n";
+        // Latency established while the decks were set up is covered by the line above; report only later changes.
+        drainLatencyChanges(engine, config.sampleRate, false);
+
+        if (offline)
+        {
+            std::vector<deejay::StreamingSource*> streamingSources;
+            for (auto& source : sources)
+            {
+                streamingSources.push_back(source.get());
+            }
+            runOffline(config, callbackData, streamingSources);
+        }
+        else
         {
-            const auto sleepDuration = std::chrono::duration<double>(config.durationSeconds);
-            std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(sleepDuration));
+#if DEEJAY_HAVE_PORTAUDIO
+            runStreams(config, callbackData, governor.get());
+#endif
+        }
+        if (recorder)
+        {
+            recorder->stop();
+            std::cout << deejay::RecorderTap::toJson(recorder->report()) << std::endl;
+        }
+        std::uint64_t underruns = 0;
+        for (auto& source : sources)
+        {
+            source->stop();
+            underruns += source->underrunCount();
         }
 
-        checkPaError(Pa_StopStream(stream), "Failed to stop stream");
-        checkPaError(Pa_CloseStream(stream), "Failed to close stream");
-        checkPaError(Pa_Terminate(), "Failed to terminate PortAudio");
+        std::cout << "Rendered approximately " << callbackData.framesRendered << " frames." << std::endl;
+        std::cout << "Source underruns: " << underruns << std::endl;
 
-        std::cout << "Rendered approximately " << callbackData.framesRendered << " frames of silence." << std::endl;
+        const auto summary = metrics.sample();
+        std::cout << "Device underflows/overflows: " << summary.underflows << "/" << summary.overflows
+                  << ", callbacks over budget: " << summary.overBudget << " of " << summary.callbacks << std::endl;
+        if (scheduler)
+        {
+            std::cout << "Scheduled events: " << scheduler->pendingCount() << " still pending, " << scheduler->lateEvents()
+                      << " late, " << scheduler->droppedEvents() << " dropped" << std::endl;
+        }
+        if (governor)
+        {
+            std::cout << "Load governor: " << governor->report().degradations << " degradation(s), "
+                      << governor->report().restorations << " restoration(s)" << std::endl;
+        }
     }
     catch (const std::exception& ex)
     {
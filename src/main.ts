@@ -1,6 +1,35 @@
-import { app, BrowserWindow } from 'electron';
+import { app, BrowserWindow, ipcMain } from 'electron';
+import { ChildProcess, spawn } from 'child_process';
+import { promises as fs } from 'fs';
 import * as path from 'path';
 
+const METRICS_INTERVAL_MS = 250;
+
+let engineProcess: ChildProcess | undefined;
+
+/**
+ * Launches the native engine named by DEEJAY_ENGINE_PATH (extra switches in DEEJAY_ENGINE_ARGS) and forwards its
+ * stdout, including the callback metrics lines, to the window's preload bindings.
+ */
+function startEngine(win: BrowserWindow): void {
+  const enginePath = process.env.DEEJAY_ENGINE_PATH;
+  if (!enginePath || engineProcess) {
+    return;
+  }
+
+  const extraArgs = (process.env.DEEJAY_ENGINE_ARGS ?? '').split(' ').filter((arg) => arg.length > 0);
+  engineProcess = spawn(enginePath, ['--metrics-interval', String(METRICS_INTERVAL_MS), ...extraArgs]);
+  engineProcess.stdout?.setEncoding('utf8');
+  engineProcess.stdout?.on('data', (chunk: string) => {
+    if (!win.isDestroyed()) {
+      win.webContents.send('engine:stdout', chunk);
+    }
+  });
+  engineProcess.on('exit', () => {
+    engineProcess = undefined;
+  });
+}
+
 function createWindow(): void {
   const win = new BrowserWindow({
     width: 1280,
@@ -12,9 +41,12 @@ function createWindow(): void {
   });
 
   win.loadFile(path.join(__dirname, 'renderer', 'index.html'));
+  win.webContents.once('did-finish-load', () => startEngine(win));
 }
 
 app.whenReady().then(() => {
+  // Analyzed waveforms are handed to the renderer as raw bytes, read once per track load; see waveformMipmap.ts.
+  ipcMain.handle('waveform:read', (_event, filePath: string) => fs.readFile(filePath));
   createWindow();
 
   app.on('activate', () => {
@@ -24,6 +56,10 @@ app.whenReady().then(() => {
   });
 });
 
+app.on('will-quit', () => {
+  engineProcess?.kill();
+});
+
 app.on('window-all-closed', () => {
   if (process.platform !== 'darwin') {
     app.quit();
@@ -1,6 +1,7 @@
-import { contextBridge } from 'electron';
+import { contextBridge, ipcRenderer } from 'electron';
 import { ParameterQueue } from './engine/parameterQueue';
-import { EngineBindings } from './engine/engineBindings';
+import { DeckName, EngineBindings } from './engine/engineBindings';
+import { CallbackMetricsSnapshot, LatencyChange, LoadGovernorReport } from './engine/engineMetrics';
 
 const deckAQueue = new ParameterQueue('deckA');
 const deckBQueue = new ParameterQueue('deckB');
@@ -12,6 +13,11 @@ const engine = new EngineBindings({
   transportQueue,
 });
 
+// The main process runs the native engine and forwards its stdout here.
+ipcRenderer.on('engine:stdout', (_event, chunk: string) => {
+  engine.ingestEngineOutput(chunk);
+});
+
 contextBridge.exposeInMainWorld('audio', {
   sendParameter: (target: string, value: number | string) => {
     engine.enqueueParameter(target, value);
@@ -23,4 +29,22 @@ contextBridge.exposeInMainWorld('audio', {
     engine.toggleRecorder();
   },
   getWaveformCache: () => engine.getWaveformCache(),
+  loadWaveform: async (deck: DeckName, filePath: string) => {
+    try {
+      const bytes: Uint8Array = await ipcRenderer.invoke('waveform:read', filePath);
+      engine.attachWaveform(deck, bytes.buffer, bytes.byteOffset);
+      return true;
+    } catch {
+      return false;
+    }
+  },
+  getWaveformInfo: (deck: DeckName) => engine.getWaveformInfo(deck),
+  getWaveformColumns: (deck: DeckName, startFrame: number, framesPerPixel: number, pixels: number) =>
+    engine.getWaveformColumns(deck, startFrame, framesPerPixel, pixels),
+  getCallbackMetrics: () => engine.getCallbackMetrics(),
+  onCallbackMetrics: (listener: (snapshot: CallbackMetricsSnapshot) => void) => engine.onCallbackMetrics(listener),
+  getLoadGovernor: () => engine.getLoadGovernor(),
+  onLoadGovernor: (listener: (report: LoadGovernorReport) => void) => engine.onLoadGovernor(listener),
+  getDeckLatency: (deck: number) => engine.getDeckLatency(deck),
+  onLatencyChanged: (listener: (change: LatencyChange) => void) => engine.onLatencyChanged(listener),
 });
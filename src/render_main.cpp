@@ -0,0 +1,256 @@
+#include "OfflineRenderer.h"
+#include "StemCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct BatchConfig
+{
+    double tempoRatio{1.0};
+    double pitchSemitones{0.0};
+    bool fast{false};
+    std::size_t threads{0};
+    std::size_t chunkFrames{65'536};
+    std::string outputDir{};
+    std::string stemCacheDir{};
+    std::string fileUuid{};
+    std::vector<std::string> inputs{};
+};
+
+BatchConfig parseArgs(int argc, char** argv)
+{
+    BatchConfig config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--tempo" && i + 1 < argc)
+        {
+            config.tempoRatio = std::stod(argv[++i]);
+        }
+        else if (arg == "--pitch" && i + 1 < argc)
+        {
+            config.pitchSemitones = std::stod(argv[++i]);
+        }
+        else if ((arg == "--threads" || arg == "-j") && i + 1 < argc)
+        {
+            config.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--chunk" && i + 1 < argc)
+        {
+            config.chunkFrames = static_cast<std::size_t>(std::stoul(argv[++i]));
+        }
+        else if ((arg == "--output-dir" || arg == "-o") && i + 1 < argc)
+        {
+            config.outputDir = argv[++i];
+        }
+        else if (arg == "--stem-cache" && i + 1 < argc)
+        {
+            config.stemCacheDir = argv[++i];
+        }
+        else if (arg == "--uuid" && i + 1 < argc)
+        {
+            config.fileUuid = argv[++i];
+        }
+        else if (arg == "--fast")
+        {
+            config.fast = true;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            std::cout << "Usage: deejay_render [options] input.wav [input.wav ...]\n"
+                      << "  --tempo                 Time-stretch ratio (default: 1.0)\n"
+                      << "  --pitch                 Pitch shift in semitones (default: 0)\n"
+                      << "  --threads, -j           Tracks rendered in parallel (default: all cores)\n"
+                      << "  --chunk                 Frames per study/process call (default: 65536)\n"
+                      << "  --output-dir, -o        Directory for rendered files (default: next to the input)\n"
+                      << "  --fast                  Trade quality for speed (previews)\n"
+                      << "  --stem-cache            Prepare keylock stems in this cache directory instead (see\n"
+                      << "                          deejay_audio --keylock-cache); stems that are current are kept\n"
+                      << "  --uuid                  Stem cache key for a single input (default: file name)\n"
+                      << "  --help, -h              Show this message\n"
+                      << "Outputs are written as <name>_t<tempo>_p<pitch>.wav (float32).\n";
+            std::exit(0);
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+        else
+        {
+            config.inputs.push_back(arg);
+        }
+    }
+
+    return config;
+}
+
+// Stem cache key for inputs given without a UUID: the file name without its extension, as deejay_audio uses.
+std::string trackKeyFor(const std::string& path)
+{
+    const auto slash = path.find_last_of("/\\");
+    std::string key = slash == std::string::npos ? path : path.substr(slash + 1);
+    const auto dot = key.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? key : key.substr(0, dot);
+}
+
+// Renders missing keylock stems into the cache and reports each one; returns the number of failures.
+std::size_t prepareStems(const BatchConfig& config)
+{
+    deejay::StemCache::Settings settings;
+    settings.cacheDirectory = config.stemCacheDir;
+    settings.quality.highQuality = !config.fast;
+    settings.chunkFrames = config.chunkFrames;
+    settings.threads = config.threads;
+    deejay::StemCache stems(settings);
+
+    std::vector<deejay::StemCache::Request> requests;
+    for (const auto& input : config.inputs)
+    {
+        deejay::StemCache::Request request;
+        request.fileUuid = config.fileUuid.empty() ? trackKeyFor(input) : config.fileUuid;
+        request.sourcePath = input;
+        request.tempoRatio = config.tempoRatio;
+        request.pitchSemitones = config.pitchSemitones;
+        requests.push_back(request);
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto results = stems.prepareAll(requests);
+    const double wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::size_t failures = 0;
+    std::size_t rendered = 0;
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& result = results[i];
+        if (!result.ok)
+        {
+            ++failures;
+            std::cerr << "Failed: " << requests[i].sourcePath << ": " << result.error << '\n';
+            continue;
+        }
+        rendered += result.rendered ? 1 : 0;
+        std::cout << stems.cachePath(requests[i]) << ": " << (result.rendered ? "rendered" : "current") << '\n';
+    }
+
+    std::cout << "Prepared " << results.size() - failures << "/" << results.size() << " stems (" << rendered
+              << " rendered) in " << std::fixed << std::setprecision(2) << wallSeconds << " s" << std::endl;
+    return failures;
+}
+
+std::string outputPathFor(const std::string& input, const BatchConfig& config)
+{
+    const auto slash = input.find_last_of("/\\");
+    const std::string directory = slash == std::string::npos ? std::string{} : input.substr(0, slash + 1);
+    std::string stem = slash == std::string::npos ? input : input.substr(slash + 1);
+    const auto dot = stem.find_last_of('.');
+    if (dot != std::string::npos && dot > 0)
+    {
+        stem.resize(dot);
+    }
+
+    std::ostringstream name;
+    if (!config.outputDir.empty())
+    {
+        name << config.outputDir;
+        if (config.outputDir.back() != '/' && config.outputDir.back() != '\\')
+        {
+            name << '/';
+        }
+    }
+    else
+    {
+        name << directory;
+    }
+    name << stem << "_t" << config.tempoRatio << "_p" << config.pitchSemitones << ".wav";
+    return name.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const auto config = parseArgs(argc, argv);
+        if (config.inputs.empty())
+        {
+            throw std::invalid_argument("No input files given (see --help)");
+        }
+        if (config.tempoRatio <= 0.0)
+        {
+            throw std::invalid_argument("--tempo must be positive");
+        }
+        if (!config.fileUuid.empty() && config.inputs.size() != 1)
+        {
+            throw std::invalid_argument("--uuid takes exactly one input");
+        }
+        if (!config.stemCacheDir.empty())
+        {
+            return prepareStems(config) == 0 ? 0 : 1;
+        }
+
+        deejay::OfflineRenderer::Settings settings;
+        settings.chunkFrames = config.chunkFrames;
+        settings.threads = config.threads;
+        deejay::OfflineRenderer renderer(settings);
+
+        std::vector<deejay::OfflineRenderer::Job> jobs;
+        for (const auto& input : config.inputs)
+        {
+            deejay::OfflineRenderer::Job job;
+            job.inputPath = input;
+            job.outputPath = outputPathFor(input, config);
+            job.tempoRatio = config.tempoRatio;
+            job.pitchSemitones = config.pitchSemitones;
+            job.quality.highQuality = !config.fast;
+            jobs.push_back(job);
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        const auto results = renderer.renderAll(jobs);
+        const double wallSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        double audioSeconds = 0.0;
+        std::size_t failures = 0;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& result = results[i];
+            if (!result.ok)
+            {
+                ++failures;
+                std::cerr << "Failed: " << jobs[i].inputPath << ": " << result.error << '\n';
+                continue;
+            }
+            const double trackSeconds = static_cast<double>(result.inputFrames) / result.sampleRate;
+            audioSeconds += trackSeconds;
+            std::cout << jobs[i].outputPath << ": " << result.outputFrames << " frames, " << std::fixed
+                      << std::setprecision(1) << trackSeconds / std::max(result.seconds, 1e-9) << "x realtime\n"
+                      << std::defaultfloat;
+        }
+
+        std::cout << "Rendered " << results.size() - failures << "/" << results.size() << " tracks in " << std::fixed
+                  << std::setprecision(2) << wallSeconds << " s (" << std::setprecision(1)
+                  << audioSeconds / std::max(wallSeconds, 1e-9) << "x realtime)" << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
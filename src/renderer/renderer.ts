@@ -5,6 +5,8 @@ type Track = {
   bpm: number;
   key: string;
   duration: string;
+  /** `.djw` file from deejay_analyze; the deck shows a placeholder without one. */
+  waveformPath?: string;
 };
 
 const library: Track[] = [
@@ -45,6 +47,9 @@ function loadTrack(deck: 'deckA' | 'deckB', track: Track): void {
   deckMetadata[deck] = track;
   updateMetadata(deck, track);
   window.audio.sendParameter(`${deck}.load`, track.id);
+  if (track.waveformPath) {
+    window.audio.loadWaveform(deck, track.waveformPath).then(() => renderWaveforms());
+  }
 }
 
 function updateMetadata(deck: 'deckA' | 'deckB', track: Track | null): void {
@@ -126,10 +131,41 @@ function drawWaveform(canvasId: string, samples: number[]): void {
   ctx.stroke();
 }
 
+const bandColors = ['#e53e3e', '#ecc94b', '#4fd1c5'];
+
+/** Whole-track overview from the analyzed band waveform: one column per pixel, bands overlaid low to high. */
+function drawBandWaveform(canvasId: string, deck: 'deckA' | 'deckB'): boolean {
+  const canvas = document.getElementById(canvasId) as HTMLCanvasElement | null;
+  const info = window.audio.getWaveformInfo(deck);
+  if (!canvas || !info || info.frameCount === 0) return false;
+  const ctx = canvas.getContext('2d');
+  const columns = window.audio.getWaveformColumns(deck, 0, info.frameCount / canvas.width, canvas.width);
+  if (!ctx || !columns) return false;
+
+  ctx.clearRect(0, 0, canvas.width, canvas.height);
+  const mid = canvas.height / 2;
+  const loudest = Math.max(...info.bandPeaks, 1e-9);
+  const stride = columns.bandCount * 2;
+  for (let band = 0; band < columns.bandCount; band += 1) {
+    const scale = (info.bandPeaks[band] / loudest / 127) * mid;
+    ctx.fillStyle = bandColors[band % bandColors.length];
+    for (let x = 0; x < columns.pixels; x += 1) {
+      const minimum = columns.values[x * stride + band * 2];
+      const maximum = columns.values[x * stride + band * 2 + 1];
+      ctx.fillRect(x, mid - maximum * scale, 1, Math.max(1, (maximum - minimum) * scale));
+    }
+  }
+  return true;
+}
+
 function renderWaveforms(): void {
   const cache = window.audio.getWaveformCache();
-  drawWaveform('waveformA', cache.deckA);
-  drawWaveform('waveformB', cache.deckB);
+  if (!drawBandWaveform('waveformA', 'deckA')) {
+    drawWaveform('waveformA', cache.deckA);
+  }
+  if (!drawBandWaveform('waveformB', 'deckB')) {
+    drawWaveform('waveformB', cache.deckB);
+  }
 }
 
 function boot(): void {
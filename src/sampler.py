@@ -5,6 +5,11 @@ or quantized to a beat grid derived from an external deck clock. Sounds are
 fetched from a SQLite ``sounds`` table and rendered with lightweight envelope
 shaping to avoid clicks. Polyphony is handled via a voice allocator that will
 steal the oldest voice when the limit is exceeded.
+
+This implementation renders in Python and is meant for tests and offline use.
+The engine plays the same ``sounds`` table on the audio thread with
+``SamplerEngine`` (``deejay_audio --sampler-db``), which uses the same envelope
+and stealing policy.
 """
 from __future__ import annotations
 
@@ -1,3 +1,7 @@
+import type { DeckName, WaveformInfo } from '../engine/engineBindings';
+import type { CallbackMetricsSnapshot, LatencyChange, LoadGovernorReport } from '../engine/engineMetrics';
+import type { WaveformColumns } from '../engine/waveformMipmap';
+
 declare global {
   interface Window {
     audio: {
@@ -5,6 +9,21 @@ declare global {
       triggerSampler: (slot: number) => void;
       toggleRecorder: () => void;
       getWaveformCache: () => { deckA: number[]; deckB: number[] };
+      /** Loads an analyzed `.djw` waveform for the deck; false when it cannot be read. */
+      loadWaveform: (deck: DeckName, filePath: string) => Promise<boolean>;
+      getWaveformInfo: (deck: DeckName) => WaveformInfo | undefined;
+      getWaveformColumns: (
+        deck: DeckName,
+        startFrame: number,
+        framesPerPixel: number,
+        pixels: number,
+      ) => WaveformColumns | undefined;
+      getCallbackMetrics: () => CallbackMetricsSnapshot | undefined;
+      onCallbackMetrics: (listener: (snapshot: CallbackMetricsSnapshot) => void) => () => void;
+      getLoadGovernor: () => LoadGovernorReport | undefined;
+      onLoadGovernor: (listener: (report: LoadGovernorReport) => void) => () => void;
+      getDeckLatency: (deck: number) => number | undefined;
+      onLatencyChanged: (listener: (change: LatencyChange) => void) => () => void;
     };
   }
 }
@@ -1,15 +1,17 @@
 import json
 import os
+import struct
 import sys
 import tempfile
 import time
+import wave
 from pathlib import Path
-from unittest import TestCase
+from unittest import TestCase, skipUnless
 
 ROOT = Path(__file__).resolve().parents[1]
 sys.path.insert(0, str(ROOT))
 
-from deejay.analysis import BackgroundAnalyzer  # noqa: E402
+from deejay.analysis import BackgroundAnalyzer, read_analysis_cache  # noqa: E402
 
 
 class BackgroundAnalyzerTests(TestCase):
@@ -61,3 +63,91 @@ class BackgroundAnalyzerTests(TestCase):
         self.assertLess(elapsed, 0.05)
         self.assertEqual(cached.updated_at, timestamp)
         self.assertTrue(cached.waveform_path.exists())
+
+
+class AnalysisCacheReaderTests(TestCase):
+    def test_reads_header_and_levels(self):
+        header = struct.pack("<4sIdQIIddfI", b"DJAN", 1, 48000.0, 300, 2, 2, 128.0, 0.25, 3.5, 0)
+        shapes = struct.pack("<IIII", 64, 5, 256, 2)
+        fine = struct.pack("<15h", *[-1, 2, 3] * 4, -32767, 32767, 100)
+        coarse = struct.pack("<6h", -4, 5, 6, -32767, 32767, 100)
+        with tempfile.TemporaryDirectory() as tmp:
+            path = Path(tmp) / "track.dja"
+            path.write_bytes(header + shapes + fine + coarse)
+            cache = read_analysis_cache(path)
+
+        self.assertEqual(cache.sample_rate, 48000.0)
+        self.assertEqual(cache.frame_count, 300)
+        self.assertEqual(cache.channels, 2)
+        self.assertEqual(cache.bpm, 128.0)
+        self.assertAlmostEqual(cache.tempo_confidence, 3.5)
+        self.assertEqual([level.frames_per_bin for level in cache.levels], [64, 256])
+        self.assertEqual(list(cache.levels[0].maximum), [2, 2, 2, 2, 32767])
+        self.assertEqual(list(cache.levels[1].minimum), [-4, -32767])
+        self.assertEqual(cache.beat_grid(3), [0.25, 0.719, 1.188])
+
+    def test_rejects_foreign_and_truncated_files(self):
+        header = struct.pack("<4sIdQIIddfI", b"DJAN", 1, 48000.0, 64, 1, 1, 0.0, 0.0, 0.0, 0)
+        with tempfile.TemporaryDirectory() as tmp:
+            path = Path(tmp) / "track.dja"
+            path.write_bytes(b"RIFF" + header[4:])
+            with self.assertRaises(ValueError):
+                read_analysis_cache(path)
+            path.write_bytes(header + struct.pack("<II", 64, 1))
+            with self.assertRaises(ValueError):
+                read_analysis_cache(path)
+
+
+def _built_analyzer():
+    candidates = [os.environ.get("DEEJAY_ANALYZER_PATH")]
+    candidates.append(str(ROOT / "build" / "deejay_analyze"))
+    for candidate in candidates:
+        if candidate and os.access(candidate, os.X_OK):
+            return Path(candidate)
+    return None
+
+
+@skipUnless(_built_analyzer(), "deejay_analyze has not been built")
+class NativeAnalyzerTests(TestCase):
+    def setUp(self):
+        self.tmpdir = tempfile.TemporaryDirectory()
+        root = Path(self.tmpdir.name)
+        self.audio_file = root / "clicks.wav"
+        sample_rate, bpm, seconds = 22050, 120.0, 20
+        frames = [0] * (sample_rate * seconds)
+        beat = int(sample_rate * 60.0 / bpm)
+        for start in range(sample_rate // 4, len(frames), beat):
+            for i in range(200):
+                if start + i < len(frames):
+                    frames[start + i] = int(20000 * (1.0 - i / 200.0) * (1 if i % 2 else -1))
+        with wave.open(str(self.audio_file), "wb") as out:
+            out.setnchannels(1)
+            out.setsampwidth(2)
+            out.setframerate(sample_rate)
+            out.writeframes(struct.pack(f"<{len(frames)}h", *frames))
+        self.analyzer = BackgroundAnalyzer(
+            cache_dir=root / "cache",
+            db_path=root / "analysis.sqlite",
+            analyzer_path=_built_analyzer(),
+        )
+
+    def tearDown(self):
+        self.analyzer.shutdown()
+        self.tmpdir.cleanup()
+
+    def test_wav_is_analyzed_into_binary_cache(self):
+        result = self.analyzer.analyze_track("clicks", self.audio_file).result(timeout=30)
+
+        self.assertEqual(result.peaks_path.suffix, ".dja")
+        self.assertEqual(result.peaks_path, result.beatgrid_path)
+        cache = read_analysis_cache(result.peaks_path)
+        self.assertEqual(cache.sample_rate, 22050.0)
+        self.assertAlmostEqual(cache.bpm, 120.0, delta=0.05)
+        self.assertAlmostEqual(cache.first_beat_seconds, 0.25, delta=0.02)
+        self.assertEqual(cache.levels[0].frames_per_bin, 64)
+        self.assertGreater(max(cache.levels[0].maximum), 19000)
+
+        header = result.waveform_path.read_bytes()[:64]
+        magic, version, header_bytes, bands = struct.unpack_from("<4sIII", header)
+        self.assertEqual((magic, version, header_bytes, bands), (b"DJWF", 1, 64, 3))
+        self.assertEqual(struct.unpack_from("<Q", header, 24)[0], 22050 * 20)
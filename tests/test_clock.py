@@ -0,0 +1,39 @@
+import json
+import unittest
+
+from deejay.clock import MasterClock
+
+
+class MasterClockLatencyTests(unittest.TestCase):
+    def test_engine_latency_lines_reach_subscribers(self) -> None:
+        clock = MasterClock(sample_rate=48_000, buffer_size=512)
+        seen = []
+        unsubscribe = clock.on_latency_changed(lambda *change: seen.append(change))
+
+        line = json.dumps(
+            {"type": "latencyChanged", "deck": 1, "previousSamples": 480, "currentSamples": 2048, "sampleRate": 48000}
+        )
+        self.assertTrue(clock.handle_engine_line(line))
+        self.assertFalse(clock.handle_engine_line('{"type":"callbackMetrics","callbacks":3}'))
+        self.assertFalse(clock.handle_engine_line("Processor latency: 480 samples"))
+        self.assertEqual(seen, [(1, 480, 2048)])
+
+        unsubscribe()
+        clock.notify_latency_change(1, 2048, 1024)
+        self.assertEqual(len(seen), 1)
+        self.assertEqual(clock.deck_latency[1], 1024)
+
+    def test_alignment_uses_reported_latency(self) -> None:
+        clock = MasterClock(sample_rate=48_000, buffer_size=512)
+        clock.notify_latency_change(0, 0, 480)
+        clock.notify_latency_change(1, 0, 2048)
+
+        self.assertEqual(clock.schedule_frame(48_000, 1), 48_000 - 2048)
+        self.assertEqual(clock.schedule_frame(100, 1), 0)
+        self.assertEqual(clock.schedule_frame(100, 2), 100)
+        self.assertEqual(clock.latency_offset(0), 2048 - 480)
+        self.assertEqual(clock.latency_offset(1), 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
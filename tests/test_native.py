@@ -0,0 +1,199 @@
+import math
+import struct
+import sys
+import tempfile
+import threading
+import wave
+from array import array
+from pathlib import Path
+from unittest import TestCase, skipUnless
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT))
+
+from deejay import dsp  # noqa: E402
+from deejay.clock import MasterClock  # noqa: E402
+from deejay.deck import Deck  # noqa: E402
+
+native = dsp.native
+
+
+def ramp(frames: int, channels: int = 1) -> array:
+    return array("f", [(i // channels) / frames for i in range(frames * channels)])
+
+
+def zeros(frames: int, channels: int = 1) -> array:
+    return array("f", bytes(4 * frames * channels))
+
+
+@skipUnless(native, "the deejay._native extension has not been built")
+class TimeStretchPitchProcessorTests(TestCase):
+    def test_writes_into_the_callers_buffer(self):
+        processor = native.TimeStretchPitchProcessor(48000, 2, max_block_frames=256)
+        source = ramp(4096, 2)
+        output = zeros(8192, 2)
+        view = memoryview(output)
+
+        written = processor.process(source, view)
+
+        self.assertLessEqual(written, 8192)
+        if not native.HAVE_RUBBERBAND:
+            # The stub is a plain copy, landing in the array behind the memoryview.
+            self.assertEqual(written, 4096)
+            self.assertEqual(output[: 2 * 4096], source)
+
+    def test_rejects_buffers_that_are_not_writable_float32_frames(self):
+        processor = native.TimeStretchPitchProcessor(48000, 2)
+        with self.assertRaises(TypeError):
+            processor.process(array("d", [0.0] * 8), zeros(4, 2))
+        with self.assertRaises(BufferError):
+            processor.process(zeros(4, 2), bytes(32))
+        with self.assertRaises(ValueError):
+            processor.process(array("f", [0.0] * 3), zeros(4, 2))
+        with self.assertRaises(ValueError):
+            native.TimeStretchPitchProcessor(48000, 0)
+
+    def test_parameters_round_trip(self):
+        processor = native.TimeStretchPitchProcessor(44100, 1, tempo_ratio=1.25, pitch_semitones=-3.0)
+        self.assertEqual((processor.tempo_ratio, processor.pitch_semitones), (1.25, -3.0))
+        processor.set_parameters(pitch_semitones=2.0)
+        self.assertEqual((processor.tempo_ratio, processor.pitch_semitones), (1.25, 2.0))
+        self.assertIn("tempo", [endpoint["id"] for endpoint in processor.endpoints()])
+
+    @skipUnless(native and native.HAVE_RUBBERBAND, "the stub stretcher does not change tempo")
+    def test_time_ratio_of_two_doubles_the_output(self):
+        # tempo_ratio is a time ratio: 2.0 plays at half speed.
+        processor = native.TimeStretchPitchProcessor(48000, 1, tempo_ratio=2.0, max_block_frames=512)
+        output = zeros(4096)
+        written = 0
+        for _ in range(200):
+            written += processor.process(ramp(512), output)
+        self.assertAlmostEqual(written, 200 * 1024, delta=processor.latency_samples + 4096)
+
+
+@skipUnless(native, "the deejay._native extension has not been built")
+class LatencyCompensatedProcessorTests(TestCase):
+    def test_pull_reads_the_track_in_place(self):
+        processor = native.LatencyCompensatedProcessor(48000, 2, max_block_frames=128)
+        track = ramp(1000, 2)
+        latency = processor.total_latency_samples
+        output = zeros(latency + 300, 2)
+
+        rendered, position = processor.pull(track, 0, output)
+
+        self.assertEqual(rendered, latency + 300)
+        self.assertGreater(position, 0)
+        if not native.HAVE_RUBBERBAND:
+            self.assertEqual(position, 300)
+            self.assertEqual(output[2 * latency :], track[: 2 * 300])
+
+    def test_pull_flushes_the_tail_past_the_end_of_the_track(self):
+        processor = native.LatencyCompensatedProcessor(48000, 1, max_block_frames=64)
+        track = array("f", [0.5 + i / 200 for i in range(100)])
+        latency = processor.total_latency_samples
+        output = zeros(2 * latency + 4096)
+        rendered, position = processor.pull(track, 0, output)
+        self.assertEqual((rendered, position), (len(output), 100))
+        if native.HAVE_RUBBERBAND:
+            self.assertGreater(max(output), 0.5)
+        else:
+            self.assertEqual(output[latency : latency + 100], track)
+            self.assertEqual(max(output[latency + 100 :]), 0.0)
+
+    def test_manual_latency_is_reported(self):
+        processor = native.LatencyCompensatedProcessor(48000, 1)
+        base = processor.total_latency_samples
+        processor.update_controls(manual_latency_samples=64)
+        processor.process(ramp(256), zeros(256))
+        self.assertEqual(processor.total_latency_samples, base + 64)
+        self.assertEqual(processor.controls["manual_latency_samples"], 64)
+
+    def test_controls_are_posted_by_endpoint_id(self):
+        processor = native.LatencyCompensatedProcessor(48000, 2)
+        ids = [endpoint["id"] for endpoint in processor.control_endpoints()]
+        self.assertEqual(ids[:3], ["tempo", "pitch", "manualLatency"])
+        self.assertTrue(processor.post_control("tempo", 1.1))
+        self.assertEqual(processor.controls["tempo_ratio"], 1.1)
+        with self.assertRaises(KeyError):
+            processor.post_control("crossfader", 0.5)
+
+    def test_jog_scratches_from_the_track(self):
+        processor = native.LatencyCompensatedProcessor(48000, 1, max_block_frames=256)
+        track = array("f", [math.sin(i * 0.05) for i in range(48000)])
+        output = zeros(256)
+        position = 0
+        for _ in range(8):
+            _, position = processor.pull(track, position, output)
+        processor.post_control("jogTouch", 1.0)
+        processor.post_control("jogRate", 0.0)
+        for _ in range(8):
+            _, position = processor.pull(track, position, output)
+        self.assertTrue(processor.jog_active)
+        # A held platter is silent.
+        self.assertEqual(max(abs(sample) for sample in output), 0.0)
+
+    def test_processors_run_concurrently_on_python_threads(self):
+        track = ramp(48000, 2)
+        results = {}
+
+        def render(index):
+            processor = native.LatencyCompensatedProcessor(48000, 2, max_block_frames=512)
+            output = zeros(processor.total_latency_samples + 20000, 2)
+            results[index] = processor.pull(track, 0, output)
+
+        threads = [threading.Thread(target=render, args=(index,)) for index in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(len(results), 4)
+        self.assertEqual(len(set(results.values())), 1)
+
+
+@skipUnless(native, "the deejay._native extension has not been built")
+class NativeDeckTests(TestCase):
+    def setUp(self):
+        self.tmpdir = tempfile.TemporaryDirectory()
+        self.audio_file = Path(self.tmpdir.name) / "tone.wav"
+        frames = [int(16000 * math.sin(i * 0.05)) for i in range(4800)]
+        with wave.open(str(self.audio_file), "wb") as handle:
+            handle.setnchannels(1)
+            handle.setsampwidth(2)
+            handle.setframerate(48000)
+            handle.writeframes(struct.pack(f"<{len(frames)}h", *frames))
+
+    def tearDown(self):
+        self.tmpdir.cleanup()
+
+    def test_read_wav_decodes_to_float32(self):
+        sample_rate, channels, data = native.read_wav(str(self.audio_file))
+        samples = memoryview(data).cast("f")
+        self.assertEqual((sample_rate, channels, len(samples)), (48000.0, 1, 4800))
+        self.assertAlmostEqual(samples[10], 16000 * math.sin(0.5) / 32768.0, places=4)
+
+    def test_deck_renders_real_audio(self):
+        clock = MasterClock(sample_rate=48_000, buffer_size=256)
+        deck = Deck(name="A", clock=clock)
+        deck.load(self.audio_file)
+        clock.frame_counter = deck.play()
+
+        result = deck.process()
+
+        self.assertEqual(len(result.samples), 256)
+        self.assertEqual(deck.position_frames, result.stretched_frames)
+        if not native.HAVE_RUBBERBAND:
+            self.assertAlmostEqual(result.samples[10], 16000 * math.sin(0.5) / 32768.0, places=4)
+
+    @skipUnless(native and native.HAVE_RUBBERBAND, "the stub stretcher does not change tempo")
+    def test_deck_tempo_is_a_playback_speed(self):
+        clock = MasterClock(sample_rate=48_000, buffer_size=256)
+        deck = Deck(name="A", clock=clock)
+        deck.load(self.audio_file)
+        deck.tempo_ratio = 1.25
+        clock.frame_counter = deck.play()
+        deck.process()  # primes the latency
+
+        start = deck.position_frames
+        for _ in range(5):
+            deck.process()
+        self.assertAlmostEqual(deck.position_frames - start, 5 * 320, delta=256)